@@ -0,0 +1,92 @@
+#ifndef ASM_H
+#define ASM_H
+
+#include <stdio.h>
+
+// 结构化汇编指令流：codegen 的 emit() 先把每行 AT&T 文本解析成 AsmInsn，
+// 经过窥孔优化等处理后再统一输出为文本。
+
+// 寄存器编号与 x86-64 编码一致
+enum {
+    REG_RAX = 0, REG_RCX, REG_RDX, REG_RBX, REG_RSP, REG_RBP, REG_RSI, REG_RDI,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+    REG_RIP,
+    REG_XMM0, REG_XMM15 = REG_XMM0 + 15,   // SSE 寄存器（宽度 16），编号不与通用寄存器重叠
+    REG_NONE = -1
+};
+
+typedef enum {
+    ASM_INSN,
+    ASM_LABEL,
+    ASM_DIRECTIVE
+} AsmLineKind;
+
+typedef enum {
+    OPND_NONE,
+    OPND_REG,       // %eax：reg + size
+    OPND_IMM,       // $5 / $sym：imm 或 sym
+    OPND_MEM,       // disp(base,index,scale) / sym(%rip)
+    OPND_SYM,       // 跳转/调用目标
+    OPND_RAW        // 无法识别的写法，原样保留
+} AsmOperandKind;
+
+typedef struct {
+    AsmOperandKind kind;
+    int reg;            // REG 的寄存器或 MEM 的基址寄存器
+    int index;          // MEM 的变址寄存器
+    int scale;
+    int size;           // 寄存器宽度（字节）
+    long imm;           // IMM 的值或 MEM 的位移
+    char* sym;          // 符号名（IMM/MEM/SYM）或 RAW 文本
+    int indirect;       // jmp *%rax / call *...
+} AsmOperand;
+
+#define ASM_MAX_OPERANDS 3
+
+typedef struct {
+    AsmLineKind kind;
+    char mnemonic[16];
+    AsmOperand ops[ASM_MAX_OPERANDS];
+    int nops;
+    char* text;         // 标签名（不含冒号）或伪指令全文
+    int deleted;
+} AsmInsn;
+
+typedef struct {
+    AsmInsn* items;
+    int count;
+    int cap;
+} AsmList;
+
+// 指令流
+AsmList* asm_list_create(void);
+void asm_list_free(AsmList* list);
+void asm_list_clear(AsmList* list);
+void asm_list_truncate(AsmList* list, int count);
+void asm_list_append_line(AsmList* list, const char* line);
+void asm_list_insert_line(AsmList* list, int index, const char* line);
+void asm_list_print(AsmList* list, FILE* out);
+void asm_list_take(AsmList* dst, AsmList* src);
+void asm_list_take_from(AsmList* dst, AsmList* src, int start);
+
+// 单行解析与输出
+int asm_parse_line(const char* line, AsmInsn* insn);
+void asm_insn_free(AsmInsn* insn);
+void asm_format_operand(const AsmOperand* op, char* buffer, size_t size);
+void asm_format_insn(const AsmInsn* insn, char* buffer, size_t size);
+const char* asm_reg_name(int reg, int size);
+
+// 指令性质
+int asm_is(const AsmInsn* insn, const char* mnemonic);
+int asm_is_reg(const AsmOperand* op, int reg);
+int asm_same_operand(const AsmOperand* a, const AsmOperand* b);
+int asm_operand_uses_reg(const AsmOperand* op, int reg);
+int asm_is_jump(const AsmInsn* insn);
+int asm_is_cond_jump(const AsmInsn* insn);
+const char* asm_invert_cc(const char* cc);
+
+// 窥孔优化（peephole.c）
+int peephole_optimize(AsmList* list);
+void peephole_print_stats(FILE* out);
+
+#endif // ASM_H
@@ -3,12 +3,15 @@
 #define CODEGEN_H
 
 #include "parser.h"
+#include "asm.h"
+#include "ir.h"
 #include <stdio.h>
 
 // 简单符号表项
 typedef struct SymbolEntry {
     char* name;
     int offset;
+    int size;               // 局部数组的元素个数，标量为 0
     struct SymbolEntry* next;
 } SymbolEntry;
 
@@ -18,6 +21,61 @@ typedef struct {
     int label_count;
     SymbolEntry* symbol_table;
     int stack_offset;
+    AsmList* lines;         // 待输出的结构化指令
+    int optimize;           // 输出前运行窥孔优化
+    AsmList* program;       // 非空时收集整个程序的指令流（交给内置汇编器），不写文本
+    int push_depth;         // 当前函数内表达式临时压栈的 8 字节个数
+    int return_label;       // 当前函数尾声的标签
+    int temp_depth;         // 表达式求值中占用的临时寄存器数
+    int omit_frame_pointer; // 叶函数省略帧指针（-fomit-frame-pointer）
+    int omit_frame;         // 当前函数是否省略了帧指针
+    int frame_size;         // 省略帧指针时 subq 的大小
+    FrameLayout frame;      // 当前函数的栈槽分配
+    int has_frame;
+    int frame_vars;         // 统计：变量数与实际使用的栈槽数
+    int frame_slots;
+    int promote_locals;     // 访问最频繁的栈槽改放被调用者保存的寄存器（-fno-promote-locals 关闭）
+    int* slot_regs;         // 当前函数每个栈槽所在的寄存器，REG_NONE 表示留在栈上
+    int promoted_vars;      // 统计：放进寄存器的变量数、寄存器分配次数（各函数之和）与涉及的函数数
+    int promoted_slots;
+    int promoted_functions;
+    ASTNode* function;      // 正在生成的函数
+    int errors;             // 未声明的变量等错误数，非 0 时不输出结果
+    int* param_offsets;     // 各参数的帧内偏移（尾调用时写回）
+    int nparams;
+    int tail_label;         // 自递归尾调用跳回的入口标签，-1 表示没有
+    const char* accumulator_op; // 累加器变换的运算符（"+" 或 "*"），NULL 表示不做
+    int accumulator_offset;
+    int tail_calls;         // 统计：消除的尾调用数
+    int unroll_factor;      // 计数 for 循环的展开倍数：0 不展开，1 只做完全展开
+    int unrolled_full;      // 统计：完全展开与部分展开的循环数
+    int unrolled_partial;
+    int break_label;        // 当前 switch 的结束标签（break 跳到这里），-1 表示不在 switch 内
+    int switch_tables;      // 统计：用跳转表与二分比较树实现的 switch 数
+    int switch_trees;
+    int if_convert;         // 简单的 if/else 赋值改用 cmov（-fno-if-conversion 关闭）
+    int if_conversions;     // 统计：改成 cmov 的 if 语句数
+    int reorder_blocks;     // 按静态分支预测安排代码布局（-fno-reorder-blocks 关闭）
+    AsmList* cold;          // 当前函数中预测很少执行的代码，放到函数末尾（ret 之后）
+    int rotated_loops;      // 统计：条件放到循环底部的循环数与移到函数末尾的冷分支数
+    int cold_blocks;
+    int profile_generate;   // 插入剖析计数器，main 返回时写出（-fprofile-generate）
+    const char* profile_path;   // 生成的程序写入的剖析文件
+    int profile_points;     // 计数点个数与源码结构校验和（profile_number 的结果）
+    unsigned profile_sum;
+    int profile_decisions;  // 统计：按剖析数据决定的布局与展开
+    int instrument_functions;   // 函数入口/尾声记录调用次数与 rdtsc 周期，main 返回时写出平面剖析
+    const char* instrument_path;
+    char** instrumented;    // 已插桩的函数名，下标就是函数表中的行
+    int ninstrumented;
+    int instrument_offset;  // 当前函数保存入口时间戳的栈槽（其上 8 字节是被调用者周期的累计值）
+    ASTNode** arrays;       // 当前函数的局部数组声明及其帧内区域（函数开始时统一分配）
+    int* array_offsets;
+    int narrays;
+    ASTNode** global_arrays;    // 顶层的数组声明，放在 .bss
+    int nglobal_arrays;
+    int vectorize;          // 计数 for 循环用 SSE2 一次处理 4 个元素（-fno-tree-vectorize 关闭）
+    int vectorized;         // 统计：向量化的循环数
 } CodeGenerator;
 // 函数声明
 // 函数声明
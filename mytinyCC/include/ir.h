@@ -0,0 +1,150 @@
+#ifndef IR_H
+#define IR_H
+
+#include "parser.h"
+#include <stdio.h>
+
+// 三地址中间表示：每个函数降级为基本块组成的控制流图（CFG）。
+// 局部变量先以 IR_LOAD / IR_STORE 访问，ssa_construct() 之后改写为 SSA 值与 phi。
+
+typedef enum {
+    IR_CONST,         // imm
+    IR_UNDEF,         // 未初始化变量的入口值
+    IR_PARAM,         // 第 imm 个参数的入口值
+    IR_LOAD,          // 读局部变量 var（仅 SSA 构造前）
+    IR_STORE,         // 写局部变量 var = args[0]（仅 SSA 构造前）
+    IR_LOAD_GLOBAL,   // 读全局变量 name
+    IR_STORE_GLOBAL,  // 写全局变量 name = args[0]
+    IR_LOAD_ELEMENT,  // 读数组元素 name[args[0]]
+    IR_STORE_ELEMENT, // 写数组元素 name[args[0]] = args[1]
+    IR_BINOP,         // args[0] opname args[1]
+    IR_UNOP,          // opname args[0]
+    IR_CALL,          // name(args...)
+    IR_COPY,          // args[0]
+    IR_PHI,           // args[i] 对应 block->preds[i]
+    IR_JUMP,          // goto targets[0]
+    IR_BRANCH,        // if (args[0]) targets[0] else targets[1]
+    IR_RETURN,        // return args[0]（nargs 可为 0）
+    IR_NOP
+} IROpcode;
+
+typedef struct IRInstr IRInstr;
+typedef struct IRBlock IRBlock;
+
+struct IRInstr {
+    IROpcode op;
+    int id;
+    char opname[4];
+    int imm;
+    int var;
+    char* name;
+
+    IRInstr** args;
+    int nargs;
+    IRBlock* targets[2];
+
+    IRBlock* block;
+    ASTNode* origin;        // 产生该值的 AST 节点（表达式或分支语句；store 为赋值或声明）
+    IRInstr* prev;
+    IRInstr* next;
+
+    // def-use 链，由 ir_compute_uses() 建立
+    IRInstr** users;
+    int nusers;
+    int cap_users;
+};
+
+struct IRBlock {
+    int id;
+    IRInstr* first;
+    IRInstr* last;
+
+    IRBlock** preds;
+    int npreds;
+    int cap_preds;
+    IRBlock* succs[2];
+    int nsuccs;
+
+    // 支配信息，由 ssa_compute_dominators() 建立
+    int rpo;                // 逆后序编号，-1 表示从入口不可达
+    IRBlock* idom;
+    IRBlock** dom_children;
+    int ndom_children;
+    int cap_dom_children;
+    IRBlock** df;
+    int ndf;
+    int cap_df;
+
+    ASTNode* origin;        // 产生该块的语句（if/while/for）
+};
+
+typedef struct {
+    char* name;
+    ASTNode* ast;
+
+    IRBlock** blocks;
+    int nblocks;
+    int cap_blocks;
+    IRBlock* entry;
+    IRBlock** rpo_order;
+    int nrpo;
+
+    char** vars;            // 局部变量名（前 nparams 个为参数）
+    int nvars;
+    int cap_vars;
+    int nparams;
+
+    IRInstr** instrs;       // 按编号索引的全部指令（含已删除的）
+    int ninstrs;
+    int cap_instrs;
+    int in_ssa;
+} IRFunction;
+
+// 构建与释放
+IRFunction* ir_build_function(ASTNode* function);
+void ir_free_function(IRFunction* fn);
+void ir_dump_function(IRFunction* fn, FILE* out);
+
+// CFG 工具
+void ir_compute_cfg(IRFunction* fn);
+void ir_compute_uses(IRFunction* fn);
+int ir_var_index(IRFunction* fn, const char* name);
+IRInstr* ir_new_instr(IRFunction* fn, IROpcode op);
+void ir_insert_before(IRInstr* pos, IRInstr* instr);
+void ir_append(IRBlock* block, IRInstr* instr);
+void ir_remove(IRInstr* instr);
+int ir_is_terminator(IRInstr* instr);
+
+// 32 位整数常量求值，不可折叠（除零、溢出陷阱、越界移位）时返回 0
+int ir_fold_binary(const char* op, int a, int b, int* result);
+int ir_fold_unary(const char* op, int a, int* result);
+
+// SSA（ssa.c）
+void ssa_compute_dominators(IRFunction* fn);
+void ssa_compute_frontiers(IRFunction* fn);
+int ssa_dominates(IRBlock* a, IRBlock* b);
+void ssa_construct(IRFunction* fn);
+
+// 稀疏条件常量传播（sccp.c）
+int sccp_optimize_program(ASTNode* program, int verbose);
+
+// 栈帧布局（frame.c）：活跃区间不相交的局部变量共用栈槽
+typedef struct {
+    char** names;       // 变量名（前几个为参数）
+    int* slots;         // 每个变量的栈槽编号
+    int* weights;       // 每个栈槽的访问权重（读写次数，每层循环乘 8）
+    int count;
+    int nslots;
+} FrameLayout;
+
+#define FRAME_MAX_LOOP_DEPTH 4      // 权重只区分到 4 层循环
+
+int frame_layout_function(ASTNode* function, FrameLayout* layout);
+int frame_layout_slot(const FrameLayout* layout, const char* name);
+void frame_layout_free(FrameLayout* layout);
+
+// 变量活跃性（frame.c）：返回每个块出口处的活跃变量集 live_out[block->id][var]
+unsigned char** ir_liveness(IRFunction* fn);
+void ir_free_liveness(IRFunction* fn, unsigned char** live_out);
+
+#endif // IR_H
@@ -0,0 +1,16 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "x86.h"
+
+// 进程内 JIT：把内置汇编器产生的目标文件装入 mmap 的内存，
+// 处理重定位后即可直接调用其中的函数（tinycc --run）。
+
+typedef struct JitModule JitModule;
+
+// 装载目标文件；外部符号（如 libc 函数）通过 dlsym 解析。失败返回 NULL
+JitModule* jit_load(const ObjectFile* obj, char* error, size_t error_size);
+void* jit_lookup(JitModule* module, const char* name);
+void jit_free(JitModule* module);
+
+#endif // JIT_H
@@ -0,0 +1,87 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "parser.h"
+
+// AST 层面的优化 pass，在 parse_program 之后、generate_assembly 之前运行。
+// 每个 pass 返回本次所做的改写次数。
+
+// 常量折叠与代数化简（fold.c）
+int fold_constants(ASTNode* program);
+
+// 小函数内联（inline.c）：返回展开的调用点数
+int inline_functions(ASTNode* program);
+
+// 过程间常量传播与函数特化（ipcp.c）：所有调用点传同一常量的形参改为局部常量，返回改写的形参数；
+// 改签名要看到全部调用点，只在 whole_program（--run）时做，单独编译时原函数保持不变。
+// clone 为真时为部分调用点的常量实参克隆特化版本，specialized 记克隆数
+int ipcp_optimize_program(ASTNode* program, int whole_program, int clone, int* specialized);
+
+// 编译期求值（consteval.c）：实参全是常量的纯函数调用在编译期解释执行，换成结果的字面量，
+// 返回替换的调用数
+int evaluate_pure_calls(ASTNode* program);
+
+// 全局值编号（gvn.c）：被支配的重复算术表达式改为读取首次计算存下的临时变量，返回替换的表达式数
+int gvn_optimize_program(ASTNode* program);
+
+// 循环不变代码外提与归纳变量强度削减（loop.c）：返回外提的表达式数，reduced 记削减的乘法数。
+// unroll 为真时，代码生成会完全展开的小循环保持原样
+int loop_optimize_program(ASTNode* program, int unroll, int* reduced);
+
+// 循环展开的规模限制
+#define UNROLL_FULL_TRIPS 16        // 完全展开的最大迭代次数
+#define UNROLL_FULL_BUDGET 128      // 完全展开后循环体节点总数的上限
+#define UNROLL_BODY_BUDGET 32       // 部分展开的循环体节点数上限
+
+// switch 的实现方式：至少这么多个 case、且值域不超过 case 数的这么多倍时用跳转表
+#define SWITCH_TABLE_MIN_CASES 4
+#define SWITCH_TABLE_DENSITY 3
+#define SWITCH_LINEAR_CASES 3       // 比较树中不超过这么多个 case 时直接逐个比较
+
+// if 转换：两个分支的值各自不超过这么多个节点时才无条件地都算出来再 cmov
+#define IF_CONVERT_BUDGET 8
+
+// 计数 for 循环：条件为 var op bound（bound 是常量或循环内不写的变量），
+// 循环内 var 只在顶层有一处 var = var ± step，且步长方向与比较一致
+typedef struct {
+    const char* var;
+    const char* op;         // 规范成 var op bound 后的比较运算符
+    ASTNode* bound;
+    int step;
+    int size;               // 循环体（含更新表达式）的节点数
+    int trips;              // 初值与边界都是常量时的迭代次数，超过 UNROLL_FULL_TRIPS 或未知时为 -1
+    int full_unroll;        // 满足完全展开的限制
+} CountedLoop;
+
+int counted_loop(ASTNode* loop, CountedLoop* info);
+
+// 死代码消除（dce.c）：死存储、无用表达式语句、return 之后的语句，以及 main 不可达的函数。
+// 只有 whole_program 为真（--run，这个翻译单元就是整个程序）时才删函数：
+// 单独编译（-c/-S）时其他目标文件可能调用它们
+typedef struct {
+    int stores;
+    int expressions;
+    int statements;
+    int functions;
+} DeadCodeStats;
+
+int eliminate_dead_code(ASTNode* program, int whole_program, DeadCodeStats* stats);
+
+// 基于剖析的优化（profile.c）。计数点是函数、if、while、for，每个两个计数器：
+// [0] 执行次数（函数为调用次数），[1] then 分支或循环体的执行次数
+
+// 给计数点编号，返回个数；sum 得到源码结构的校验和
+int profile_number(ASTNode* program, unsigned* sum);
+// 读入剖析文件并累加其中的全部记录，返回记录（运行）数；失败返回 -1 并写 error
+int profile_load(const char* path, int npoints, unsigned sum, char* error, size_t size);
+// 节点的计数器，没有剖析数据时返回 -1
+long long profile_count(const ASTNode* node, int which);
+void profile_free(void);
+
+// 剖析数据驱动的决策
+#define PROFILE_COLD_PERCENT 10         // then 分支执行比例不超过此值（或不低于 100 减此值）时另一侧按冷分支布局
+#define PROFILE_BIASED_PERCENT 95       // 方向这么稳定的分支保留跳转，不做 if 转换
+#define PROFILE_HOT_CALLS 1000          // 调用次数达到此值的函数放宽内联预算
+#define PROFILE_HOT_INLINE_BUDGET 64
+
+#endif // OPTIMIZE_H
@@ -21,7 +21,12 @@ typedef enum {
     AST_IDENTIFIER,
     AST_LITERAL,
     AST_CALL,
-    AST_DECLARATION
+    AST_DECLARATION,
+    AST_SWITCH,
+    AST_CASE,
+    AST_BREAK,
+    AST_INDEX,              // a[i]：data.element
+    AST_INDEX_ASSIGNMENT    // a[i] = v：data.element，value 为写入的值
 } ASTNodeType;
 
 // Forward declaration
@@ -32,6 +37,7 @@ struct ASTNode {
     ASTNodeType type;
     int line;
     int column;
+    int profile_id;     // 剖析计数点编号（从 1 起，见 profile.c），0 表示不计数
     
     // Node connections
     ASTNode* left;
@@ -57,6 +63,16 @@ struct ASTNode {
             ASTNode* body;
         } while_stmt;
         
+        struct {
+            ASTNode* condition;
+            ASTNode* body;          // 块；case 标签是块中语句链上的 AST_CASE 节点
+        } switch_stmt;
+
+        struct {
+            int value;
+            int is_default;
+        } case_label;
+
         struct {
             ASTNode* init;
             ASTNode* condition;
@@ -84,7 +100,14 @@ struct ASTNode {
             char* name;
             char* type;
             ASTNode* initializer;
+            int array_size;     // 数组元素个数，标量为 0
         } declaration;
+
+        struct {
+            char* name;
+            ASTNode* index;
+            ASTNode* value;
+        } element;
         
         struct {
             char* value;
@@ -101,6 +124,13 @@ typedef struct {
     Token current_token;
     Token peek_token;
     int error_count;
+    int in_switch;      // break 只能出现在 switch 中（循环不支持 break）
+    char** scope_names;     // 当前函数里可见的局部变量：源码中的名字与 AST 里的名字（内层同名变量改名为 x.N）
+    char** scope_renamed;
+    int scope_count;
+    int scope_capacity;
+    int scope_start;        // 最内层作用域在栈中的起点
+    int renamed;            // 改名用的计数器
 } Parser;
 
 // Function declarations
@@ -117,6 +147,7 @@ ASTNode* parse_statement(Parser* parser);
 ASTNode* parse_if(Parser* parser);
 ASTNode* parse_while(Parser* parser);
 ASTNode* parse_for(Parser* parser);
+ASTNode* parse_switch(Parser* parser);
 ASTNode* parse_block(Parser* parser);
 ASTNode* parse_return(Parser* parser);
 ASTNode* parse_expression(Parser* parser);
@@ -129,6 +160,19 @@ ASTNode* parse_declaration(Parser* parser);
 
 void parser_free(Parser* parser);
 
+// AST utilities
+void replace_node(ASTNode* dst, ASTNode* src);
+ASTNode* copy_node(ASTNode* node);
+void make_literal_node(ASTNode* node, int value);
+void make_empty_block(ASTNode* node);
+int node_has_side_effects(ASTNode* node);
+int node_is_constant(ASTNode* node, int* value);
+int same_expr(ASTNode* a, ASTNode* b);
+ASTNode* copy_expr(ASTNode* node);
+int node_declares(ASTNode* node, const char* name);
+void node_visit_calls(ASTNode* node, void (*visit)(ASTNode* call, void* data), void* data);
+int program_find_function(ASTNode* program, const char* name);
+
 // Utility functions
 void advance_token(Parser* parser);
 int match_token(Parser* parser, TokenType type);
@@ -0,0 +1,69 @@
+#ifndef X86_H
+#define X86_H
+
+#include "asm.h"
+#include <stdio.h>
+
+// 内置汇编器：把结构化指令流直接编码成 x86-64 机器码，
+// 结果既可以写成可重定位的 ELF64 .o（elf.c），也可以交给 JIT 装载。
+
+typedef enum {
+    OBJ_SEC_TEXT,
+    OBJ_SEC_DATA,
+    OBJ_SEC_RODATA,
+    OBJ_SEC_BSS,
+    OBJ_SEC_COUNT
+} ObjSectionId;
+
+// 与 ELF 的 R_X86_64_* 编号一致
+typedef enum {
+    RELOC_ABS64 = 1,    // R_X86_64_64
+    RELOC_PC32 = 2,     // R_X86_64_PC32
+    RELOC_PLT32 = 4,    // R_X86_64_PLT32
+    RELOC_ABS32 = 10,   // R_X86_64_32
+    RELOC_ABS32S = 11   // R_X86_64_32S
+} ObjRelocType;
+
+typedef struct {
+    long offset;        // 在所属段内的偏移
+    int type;           // ObjRelocType
+    int symbol;         // ObjectFile.symbols 下标
+    long addend;
+} ObjReloc;
+
+typedef struct {
+    const char* name;
+    unsigned char* data;    // .bss 没有数据，只有 size
+    long size;
+    long cap;
+    int align;
+    ObjReloc* relocs;
+    int nrelocs;
+    int cap_relocs;
+} ObjSection;
+
+typedef struct {
+    char* name;
+    int section;        // ObjSectionId，未定义符号为 -1
+    long value;
+    int global;
+    int local_label;    // .L 开头的标签不进入符号表
+} ObjSymbol;
+
+typedef struct {
+    ObjSection sections[OBJ_SEC_COUNT];
+    ObjSymbol* symbols;
+    int nsymbols;
+    int cap_symbols;
+    int relaxed_branches;   // 被放宽成 rel32 的跳转数
+} ObjectFile;
+
+// 汇编整个指令流，失败时返回 0 并在 error 中给出原因
+int x86_assemble(AsmList* list, ObjectFile* obj, char* error, size_t error_size);
+void obj_free(ObjectFile* obj);
+int obj_find_symbol(const ObjectFile* obj, const char* name);
+
+// 写出 ELF64 可重定位目标文件（elf.c）
+int elf_write_object(const ObjectFile* obj, FILE* out);
+
+#endif // X86_H
@@ -0,0 +1,400 @@
+#include "asm.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* reg_names[4][17] = {
+    { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+      "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rip" },
+    { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+      "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d", NULL },
+    { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+      "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w", NULL },
+    { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+      "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b", NULL },
+};
+static const int reg_sizes[4] = { 8, 4, 2, 1 };
+static const char* xmm_names[16] = {
+    "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+    "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15",
+};
+
+const char* asm_reg_name(int reg, int size) {
+    if (size == 16) return reg >= REG_XMM0 && reg <= REG_XMM15 ? xmm_names[reg - REG_XMM0] : "?";
+    for (int s = 0; s < 4; s++) {
+        if (reg_sizes[s] == size && reg >= 0 && reg <= REG_RIP) return reg_names[s][reg];
+    }
+    return "?";
+}
+
+static int lookup_reg(const char* name, int* reg, int* size) {
+    for (int r = 0; r < 16; r++) {
+        if (strcmp(xmm_names[r], name) == 0) {
+            *reg = REG_XMM0 + r;
+            *size = 16;
+            return 1;
+        }
+    }
+    for (int s = 0; s < 4; s++) {
+        for (int r = 0; r <= REG_RIP; r++) {
+            if (reg_names[s][r] && strcmp(reg_names[s][r], name) == 0) {
+                *reg = r;
+                *size = reg_sizes[s];
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+AsmList* asm_list_create(void) {
+    AsmList* list = calloc(1, sizeof(AsmList));
+    return list;
+}
+
+void asm_insn_free(AsmInsn* insn) {
+    for (int i = 0; i < ASM_MAX_OPERANDS; i++) {
+        free(insn->ops[i].sym);
+        insn->ops[i].sym = NULL;
+    }
+    free(insn->text);
+    insn->text = NULL;
+}
+
+void asm_list_clear(AsmList* list) {
+    for (int i = 0; i < list->count; i++) {
+        asm_insn_free(&list->items[i]);
+    }
+    list->count = 0;
+}
+
+// 丢弃下标 count 之后的条目
+void asm_list_truncate(AsmList* list, int count) {
+    for (int i = count; i < list->count; i++) {
+        asm_insn_free(&list->items[i]);
+    }
+    if (count < list->count) list->count = count;
+}
+
+void asm_list_free(AsmList* list) {
+    if (!list) return;
+    asm_list_clear(list);
+    free(list->items);
+    free(list);
+}
+
+static char* trim(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+static int parse_number(const char* s, long* value) {
+    if (!*s) return 0;
+    char* end;
+    *value = strtol(s, &end, 0);
+    return *end == '\0';
+}
+
+static int parse_reg_token(const char* s, int* reg, int* size) {
+    if (*s != '%') return 0;
+    return lookup_reg(s + 1, reg, size);
+}
+
+static void parse_operand(char* text, AsmOperand* op) {
+    memset(op, 0, sizeof(*op));
+    op->reg = REG_NONE;
+    op->index = REG_NONE;
+    char* original = strdup(trim(text));
+    char* s = trim(text);
+
+    if (*s == '*') {
+        op->indirect = 1;
+        s = trim(s + 1);
+    }
+
+    if (*s == '%') {
+        if (parse_reg_token(s, &op->reg, &op->size)) {
+            op->kind = OPND_REG;
+            free(original);
+            return;
+        }
+    } else if (*s == '$') {
+        op->kind = OPND_IMM;
+        if (!parse_number(s + 1, &op->imm)) op->sym = strdup(s + 1);
+        free(original);
+        return;
+    } else {
+        char* paren = strchr(s, '(');
+        if (paren && s[strlen(s) - 1] == ')') {
+            op->kind = OPND_MEM;
+            op->scale = 1;
+            *paren = '\0';
+            char* disp = trim(s);
+            if (*disp && !parse_number(disp, &op->imm)) {
+                // sym+8(%rip)：符号加常量偏移
+                char* offset = strpbrk(disp + 1, "+-");
+                if (offset && parse_number(offset, &op->imm)) *offset = '\0';
+                else op->imm = 0;
+                op->sym = strdup(disp);
+            }
+
+            char* inner = paren + 1;
+            inner[strlen(inner) - 1] = '\0';
+            char* parts[3] = { inner, NULL, NULL };
+            int nparts = 1;
+            for (char* p = inner; *p && nparts < 3; p++) {
+                if (*p == ',') {
+                    *p = '\0';
+                    parts[nparts++] = p + 1;
+                }
+            }
+            int size;
+            char* base = trim(parts[0]);
+            if (*base && !parse_reg_token(base, &op->reg, &size)) goto raw;
+            if (nparts > 1) {
+                char* index = trim(parts[1]);
+                if (*index && !parse_reg_token(index, &op->index, &size)) goto raw;
+            }
+            if (nparts > 2) {
+                long scale;
+                if (!parse_number(trim(parts[2]), &scale)) goto raw;
+                op->scale = (int)scale;
+            }
+            free(original);
+            return;
+        }
+        if (*s) {
+            op->kind = OPND_SYM;
+            op->sym = strdup(s);
+            free(original);
+            return;
+        }
+    }
+
+raw:
+    free(op->sym);
+    memset(op, 0, sizeof(*op));
+    op->kind = OPND_RAW;
+    op->reg = REG_NONE;
+    op->index = REG_NONE;
+    op->sym = original;
+}
+
+// 解析一行 AT&T 汇编，空行返回 0
+int asm_parse_line(const char* line, AsmInsn* insn) {
+    memset(insn, 0, sizeof(*insn));
+    char* copy = strdup(line);
+    char* s = trim(copy);
+    if (!*s) {
+        free(copy);
+        return 0;
+    }
+
+    size_t len = strlen(s);
+    if (s[len - 1] == ':' && !strpbrk(s, " \t")) {
+        insn->kind = ASM_LABEL;
+        s[len - 1] = '\0';
+        insn->text = strdup(s);
+    } else if (s[0] == '.') {
+        insn->kind = ASM_DIRECTIVE;
+        insn->text = strdup(s);
+    } else {
+        insn->kind = ASM_INSN;
+        char* rest = s;
+        while (*rest && !isspace((unsigned char)*rest)) rest++;
+        if (*rest) *rest++ = '\0';
+        strncpy(insn->mnemonic, s, sizeof(insn->mnemonic) - 1);
+
+        // 按顶层逗号切分操作数（括号内的逗号不算）
+        rest = trim(rest);
+        int depth = 0;
+        char* start = rest;
+        for (char* p = rest; ; p++) {
+            if (*p == '(') depth++;
+            else if (*p == ')') depth--;
+            if ((*p == ',' && depth == 0) || *p == '\0') {
+                int at_end = *p == '\0';
+                *p = '\0';
+                if (*trim(start) && insn->nops < ASM_MAX_OPERANDS) {
+                    parse_operand(start, &insn->ops[insn->nops++]);
+                }
+                if (at_end) break;
+                start = p + 1;
+            }
+        }
+    }
+    free(copy);
+    return 1;
+}
+
+void asm_list_append_line(AsmList* list, const char* line) {
+    AsmInsn insn;
+    if (!asm_parse_line(line, &insn)) return;
+    if (list->count >= list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 64;
+        list->items = realloc(list->items, sizeof(AsmInsn) * list->cap);
+    }
+    list->items[list->count++] = insn;
+}
+
+void asm_list_insert_line(AsmList* list, int index, const char* line) {
+    asm_list_append_line(list, line);
+    if (index >= list->count - 1) return;
+    AsmInsn insn = list->items[list->count - 1];
+    memmove(&list->items[index + 1], &list->items[index], sizeof(AsmInsn) * (list->count - 1 - index));
+    list->items[index] = insn;
+}
+
+void asm_format_operand(const AsmOperand* op, char* buffer, size_t size) {
+    const char* star = op->indirect ? "*" : "";
+    switch (op->kind) {
+        case OPND_REG:
+            snprintf(buffer, size, "%s%%%s", star, asm_reg_name(op->reg, op->size));
+            break;
+        case OPND_IMM:
+            if (op->sym) snprintf(buffer, size, "$%s", op->sym);
+            else snprintf(buffer, size, "$%ld", op->imm);
+            break;
+        case OPND_MEM: {
+            char disp[64] = "";
+            char inner[64] = "";
+            if (op->sym && op->imm) snprintf(disp, sizeof(disp), "%s%+ld", op->sym, op->imm);
+            else if (op->sym) snprintf(disp, sizeof(disp), "%s", op->sym);
+            else if (op->imm || (op->reg == REG_NONE && op->index == REG_NONE)) {
+                snprintf(disp, sizeof(disp), "%ld", op->imm);
+            }
+            if (op->index != REG_NONE) {
+                snprintf(inner, sizeof(inner), "(%s%s,%%%s,%d)",
+                         op->reg != REG_NONE ? "%" : "",
+                         op->reg != REG_NONE ? asm_reg_name(op->reg, 8) : "",
+                         asm_reg_name(op->index, 8), op->scale);
+            } else if (op->reg != REG_NONE) {
+                snprintf(inner, sizeof(inner), "(%%%s)", asm_reg_name(op->reg, 8));
+            }
+            snprintf(buffer, size, "%s%s%s", star, disp, inner);
+            break;
+        }
+        case OPND_SYM:
+            snprintf(buffer, size, "%s%s", star, op->sym);
+            break;
+        case OPND_RAW:
+            snprintf(buffer, size, "%s", op->sym);
+            break;
+        default:
+            buffer[0] = '\0';
+            break;
+    }
+}
+
+void asm_format_insn(const AsmInsn* insn, char* buffer, size_t size) {
+    if (insn->kind == ASM_LABEL) {
+        snprintf(buffer, size, "%s:", insn->text);
+        return;
+    }
+    if (insn->kind == ASM_DIRECTIVE) {
+        snprintf(buffer, size, "%s", insn->text);
+        return;
+    }
+    size_t used = (size_t)snprintf(buffer, size, "    %s", insn->mnemonic);
+    for (int i = 0; i < insn->nops && used < size; i++) {
+        char operand[128];
+        asm_format_operand(&insn->ops[i], operand, sizeof(operand));
+        used += (size_t)snprintf(buffer + used, size - used, "%s%s", i ? ", " : " ", operand);
+    }
+}
+
+void asm_list_print(AsmList* list, FILE* out) {
+    char buffer[256];
+    for (int i = 0; i < list->count; i++) {
+        if (list->items[i].deleted) continue;
+        asm_format_insn(&list->items[i], buffer, sizeof(buffer));
+        fprintf(out, "%s\n", buffer);
+    }
+}
+
+// 把 src 中未删除的条目移到 dst 末尾，src 变为空
+void asm_list_take(AsmList* dst, AsmList* src) {
+    asm_list_take_from(dst, src, 0);
+}
+
+// 把 src 中从 start 开始的条目移到 dst 末尾，src 截断到 start
+void asm_list_take_from(AsmList* dst, AsmList* src, int start) {
+    for (int i = start; i < src->count; i++) {
+        AsmInsn* insn = &src->items[i];
+        if (insn->deleted) {
+            asm_insn_free(insn);
+            continue;
+        }
+        if (dst->count >= dst->cap) {
+            dst->cap = dst->cap ? dst->cap * 2 : 64;
+            dst->items = realloc(dst->items, sizeof(AsmInsn) * dst->cap);
+        }
+        dst->items[dst->count++] = *insn;
+    }
+    if (start < src->count) src->count = start;
+}
+
+int asm_is(const AsmInsn* insn, const char* mnemonic) {
+    return insn->kind == ASM_INSN && strcmp(insn->mnemonic, mnemonic) == 0;
+}
+
+int asm_is_reg(const AsmOperand* op, int reg) {
+    return op->kind == OPND_REG && !op->indirect && op->reg == reg;
+}
+
+int asm_same_operand(const AsmOperand* a, const AsmOperand* b) {
+    if (a->kind != b->kind || a->indirect != b->indirect) return 0;
+    switch (a->kind) {
+        case OPND_REG:
+            return a->reg == b->reg && a->size == b->size;
+        case OPND_IMM:
+            if (a->sym || b->sym) return a->sym && b->sym && strcmp(a->sym, b->sym) == 0;
+            return a->imm == b->imm;
+        case OPND_MEM:
+            if ((a->sym != NULL) != (b->sym != NULL)) return 0;
+            if (a->sym && strcmp(a->sym, b->sym) != 0) return 0;
+            return a->reg == b->reg && a->index == b->index && a->scale == b->scale &&
+                   a->imm == b->imm;
+        case OPND_SYM:
+        case OPND_RAW:
+            return strcmp(a->sym, b->sym) == 0;
+        default:
+            return 1;
+    }
+}
+
+// 操作数是否读取/引用了寄存器 reg（任意宽度，含内存寻址中的基址与变址）
+int asm_operand_uses_reg(const AsmOperand* op, int reg) {
+    switch (op->kind) {
+        case OPND_REG:
+            return op->reg == reg;
+        case OPND_MEM:
+            return op->reg == reg || op->index == reg;
+        case OPND_RAW:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int asm_is_jump(const AsmInsn* insn) {
+    return insn->kind == ASM_INSN && insn->mnemonic[0] == 'j';
+}
+
+int asm_is_cond_jump(const AsmInsn* insn) {
+    return asm_is_jump(insn) && strcmp(insn->mnemonic, "jmp") != 0;
+}
+
+const char* asm_invert_cc(const char* cc) {
+    static const char* pairs[][2] = {
+        { "e", "ne" }, { "l", "ge" }, { "le", "g" }, { "b", "ae" }, { "be", "a" },
+        { "z", "nz" }, { "s", "ns" }, { "o", "no" }, { "p", "np" },
+    };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        if (strcmp(cc, pairs[i][0]) == 0) return pairs[i][1];
+        if (strcmp(cc, pairs[i][1]) == 0) return pairs[i][0];
+    }
+    return NULL;
+}
@@ -3,7 +3,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include "codegen.h"
+#include "optimize.h"
+
+// 条件跳转：表达式求值与语句生成都会用到，定义在后面
+static void generate_condition(CodeGenerator* codegen, ASTNode* node, int label, int jump_if);
 
 
 
@@ -11,6 +16,25 @@
 
 static SymbolEntry* symbol_list = NULL;
 
+// -fprofile-generate：计数器数组与写出剖析记录的例程（都是本文件内的局部符号）
+#define PROFILE_COUNTERS "__tinycc_profile"
+#define PROFILE_DUMP "__tinycc_profile_dump"
+// -finstrument-functions：每个函数一行 {调用次数, 总周期, 自身周期, 已输出}，被调用者周期的累计值，写出例程
+#define FUNCTION_TABLE "__tinycc_functions"
+#define FUNCTION_CALLEE_CYCLES "__tinycc_callee_cycles"
+#define FUNCTION_DUMP "__tinycc_functions_dump"
+#define FUNCTION_ENTRY_SIZE 32
+
+// System V AMD64 整数参数寄存器
+static const char* arg_regs64[6] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
+static const char* arg_regs32[6] = { "edi", "esi", "edx", "ecx", "r8d", "r9d" };
+
+// 被调用者保存的寄存器（rbp 由序言/尾声单独处理）
+static const int callee_saved[5] = { REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15 };
+
+// 栈槽放进寄存器的最小访问权重：低于它时省下的访存抵不过序言/尾声里的保存与恢复
+#define PROMOTE_MIN_WEIGHT 3
+
 // 初始化代码生成器
 CodeGenerator* codegen_init(FILE* output) {
     CodeGenerator* codegen = malloc(sizeof(CodeGenerator));
@@ -23,22 +47,90 @@ CodeGenerator* codegen_init(FILE* output) {
     codegen->label_count = 0;
     codegen->symbol_table = NULL;
     codegen->stack_offset = 0;
+    codegen->lines = asm_list_create();
+    codegen->optimize = 0;
+    codegen->program = NULL;
+    codegen->push_depth = 0;
+    codegen->return_label = -1;
+    codegen->temp_depth = 0;
+    codegen->function = NULL;
+    codegen->errors = 0;
+    codegen->param_offsets = NULL;
+    codegen->nparams = 0;
+    codegen->tail_label = -1;
+    codegen->accumulator_op = NULL;
+    codegen->accumulator_offset = 0;
+    codegen->tail_calls = 0;
+    codegen->unroll_factor = 0;
+    codegen->unrolled_full = 0;
+    codegen->unrolled_partial = 0;
+    codegen->break_label = -1;
+    codegen->switch_tables = 0;
+    codegen->switch_trees = 0;
+    codegen->if_convert = 0;
+    codegen->if_conversions = 0;
+    codegen->reorder_blocks = 0;
+    codegen->cold = asm_list_create();
+    codegen->rotated_loops = 0;
+    codegen->cold_blocks = 0;
+    codegen->profile_generate = 0;
+    codegen->profile_path = NULL;
+    codegen->profile_points = 0;
+    codegen->profile_sum = 0;
+    codegen->profile_decisions = 0;
+    codegen->instrument_functions = 0;
+    codegen->instrument_path = NULL;
+    codegen->instrumented = NULL;
+    codegen->ninstrumented = 0;
+    codegen->instrument_offset = 0;
+    codegen->omit_frame_pointer = 0;
+    codegen->omit_frame = 0;
+    codegen->frame_size = 0;
+    codegen->has_frame = 0;
+    codegen->frame_vars = 0;
+    codegen->frame_slots = 0;
+    codegen->promote_locals = 0;
+    codegen->slot_regs = NULL;
+    codegen->promoted_vars = 0;
+    codegen->promoted_slots = 0;
+    codegen->promoted_functions = 0;
+    codegen->arrays = NULL;
+    codegen->array_offsets = NULL;
+    codegen->narrays = 0;
+    codegen->global_arrays = NULL;
+    codegen->nglobal_arrays = 0;
+    codegen->vectorize = 0;
+    codegen->vectorized = 0;
     
     return codegen;
 }
 
+// 释放符号表（变量按函数作用域，每个函数开始时清空）
+static void clear_variables(void) {
+    SymbolEntry* current = symbol_list;
+    while (current) {
+        SymbolEntry* next = current->next;
+        free(current->name);
+        free(current);
+        current = next;
+    }
+    symbol_list = NULL;
+}
+
 // 释放代码生成器
 void codegen_free(CodeGenerator* codegen) {
     if (codegen) {
-        // 释放符号表
-        SymbolEntry* current = symbol_list;
-        while (current) {
-            SymbolEntry* next = current->next;
-            free(current->name);
-            free(current);
-            current = next;
-        }
-        symbol_list = NULL;
+        clear_variables();
+        asm_list_free(codegen->lines);
+        asm_list_free(codegen->program);
+        asm_list_free(codegen->cold);
+        for (int i = 0; i < codegen->ninstrumented; i++) {
+            free(codegen->instrumented[i]);
+        }
+        free(codegen->instrumented);
+        free(codegen->arrays);
+        free(codegen->array_offsets);
+        free(codegen->global_arrays);
         free(codegen);
     }
 }
@@ -48,13 +140,27 @@ static int get_new_label(CodeGenerator* codegen) {
     return codegen->label_count++;
 }
 
-// 输出汇编代码
+// 输出汇编代码（先解析进指令流，flush_lines 时统一写出）
 static void emit(CodeGenerator* codegen, const char* format, ...) {
+    char line[256];
     va_list args;
     va_start(args, format);
-    vfprintf(codegen->output, format, args);
+    vsnprintf(line, sizeof(line), format, args);
     va_end(args);
-    fprintf(codegen->output, "\n");
+    asm_list_append_line(codegen->lines, line);
+}
+
+// 对缓冲的指令做窥孔优化后写出（或并入整个程序的指令流）
+static void flush_lines(CodeGenerator* codegen) {
+    if (codegen->optimize) {
+        peephole_optimize(codegen->lines);
+    }
+    if (codegen->program) {
+        asm_list_take(codegen->program, codegen->lines);
+        return;
+    }
+    asm_list_print(codegen->lines, codegen->output);
+    asm_list_clear(codegen->lines);
 }
 
 // 获取变量在栈中的偏移
@@ -66,7 +172,10 @@ static int get_variable_offset(CodeGenerator* codegen, const char* name) {
         }
         current = current->next;
     }
-    return 0; // 未找到变量
+    fprintf(stderr, "Error: '%s' undeclared in function %s\n", name,
+            codegen->function ? codegen->function->data.function.name : "(top level)");
+    codegen->errors++;
+    return 0;
 }
 
 // 添加变量到符号表
@@ -74,10 +183,560 @@ static void add_variable(CodeGenerator* codegen, const char* name, int offset) {
     SymbolEntry* entry = malloc(sizeof(SymbolEntry));
     entry->name = strdup(name);
     entry->offset = offset;
+    entry->size = 0;
     entry->next = symbol_list;
     symbol_list = entry;
 }
 
+// 局部变量的栈槽偏移：有帧布局时按着色结果共用槽位，否则每个声明新开一个
+static int allocate_slot(CodeGenerator* codegen, const char* name) {
+    if (codegen->has_frame) {
+        int slot = frame_layout_slot(&codegen->frame, name);
+        if (slot >= 0) return -4 * (slot + 1);
+    }
+    codegen->stack_offset -= 4;
+    return codegen->stack_offset;
+}
+
+// 帧内偏移对应的内存操作数。offset 以 %rbp 为基准（局部变量为负，栈参数从 16 起）；
+// 省略帧指针时以入口 %rsp（返回地址所在处）为基准换算成 %rsp 相对地址，
+// 并计入表达式临时压栈造成的偏移
+static const char* frame_operand(CodeGenerator* codegen, int offset, char* buffer, size_t size) {
+    if (!codegen->omit_frame) {
+        snprintf(buffer, size, "%d(%%rbp)", offset);
+    } else {
+        int from_entry = offset > 0 ? offset - 8 : offset;
+        snprintf(buffer, size, "%d(%%rsp)", codegen->frame_size + codegen->push_depth * 8 + from_entry);
+    }
+    return buffer;
+}
+
+// 变量所在的寄存器：帧布局里它的栈槽分到了寄存器时返回该寄存器，否则 REG_NONE
+static int variable_register(CodeGenerator* codegen, const char* name) {
+    if (!codegen->has_frame || !codegen->slot_regs) return REG_NONE;
+    int slot = frame_layout_slot(&codegen->frame, name);
+    return slot >= 0 ? codegen->slot_regs[slot] : REG_NONE;
+}
+
+static const char* variable_operand(CodeGenerator* codegen, const char* name, char* buffer, size_t size) {
+    int reg = variable_register(codegen, name);
+    if (reg != REG_NONE) {
+        snprintf(buffer, size, "%%%s", asm_reg_name(reg, 4));
+        return buffer;
+    }
+    return frame_operand(codegen, get_variable_offset(codegen, name), buffer, size);
+}
+
+// ---- 数组 ----
+// 局部数组在函数开始时统一分配帧内区域（帧大小要在生成函数体之前确定），符号表项记下元素个数；
+// 不在符号表里的数组名是 .bss 中的全局数组
+
+static int local_array(const char* name, int* offset) {
+    for (SymbolEntry* entry = symbol_list; entry; entry = entry->next) {
+        if (entry->size > 0 && strcmp(entry->name, name) == 0) {
+            *offset = entry->offset;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 数组首地址装入 64 位寄存器 reg
+static void load_array_address(CodeGenerator* codegen, const char* name, const char* reg) {
+    char operand[32];
+    int offset;
+    if (local_array(name, &offset)) {
+        emit(codegen, "    leaq %s, %%%s", frame_operand(codegen, offset, operand, sizeof(operand)), reg);
+    } else {
+        emit(codegen, "    leaq %s(%%rip), %%%s", name, reg);
+    }
+}
+
+// 函数体中的局部数组声明（完全展开会重复生成同一个声明，所以按节点分配一次）
+static void collect_arrays(CodeGenerator* codegen, ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_DECLARATION:
+                if (node->data.declaration.array_size) {
+                    codegen->arrays = realloc(codegen->arrays, sizeof(ASTNode*) * (codegen->narrays + 1));
+                    codegen->array_offsets = realloc(codegen->array_offsets, sizeof(int) * (codegen->narrays + 1));
+                    codegen->stack_offset = (codegen->stack_offset - 4 * node->data.declaration.array_size) & ~15;
+                    codegen->arrays[codegen->narrays] = node;
+                    codegen->array_offsets[codegen->narrays++] = codegen->stack_offset;
+                }
+                break;
+            case AST_BLOCK:
+                collect_arrays(codegen, node->left);
+                break;
+            case AST_IF:
+                collect_arrays(codegen, node->data.if_stmt.then_branch);
+                collect_arrays(codegen, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                collect_arrays(codegen, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                collect_arrays(codegen, node->data.for_stmt.init);
+                collect_arrays(codegen, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                collect_arrays(codegen, node->data.switch_stmt.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// 表达式求值用的临时压栈，记录深度以便在调用前保持 16 字节对齐
+static void push_rax(CodeGenerator* codegen) {
+    emit(codegen, "    pushq %%rax");
+    codegen->push_depth++;
+}
+
+static void pop_rax(CodeGenerator* codegen) {
+    emit(codegen, "    popq %%rax");
+    codegen->push_depth--;
+}
+
+static void pop_reg(CodeGenerator* codegen, const char* reg) {
+    emit(codegen, "    popq %%%s", reg);
+    codegen->push_depth--;
+}
+
+// System V AMD64 调用：前 6 个整数参数依次放在 rdi/rsi/rdx/rcx/r8/r9，其余从右到左压栈。
+// 参数从右到左求值并压栈，再把前 6 个弹进寄存器，剩下的正好是栈上参数的布局。
+// call 时 %rsp 必须 16 字节对齐，需要时先补 8 字节。
+static void generate_call(CodeGenerator* codegen, ASTNode* node) {
+    ASTNode* args[64];
+    int nargs = 0;
+    for (ASTNode* arg = node->data.call.args; arg && nargs < 64; arg = arg->next) {
+        args[nargs++] = arg;
+    }
+
+    int nstack = nargs > 6 ? nargs - 6 : 0;
+    int pad = (codegen->push_depth + nstack) % 2 ? 8 : 0;
+    if (pad) {
+        emit(codegen, "    subq $8, %%rsp");
+        codegen->push_depth++;
+    }
+    for (int i = nargs - 1; i >= 0; i--) {
+        generate_expression(codegen, args[i]);
+        push_rax(codegen);
+    }
+    for (int i = 0; i < nargs && i < 6; i++) {
+        pop_reg(codegen, arg_regs64[i]);
+    }
+
+    emit(codegen, "    call %s", node->data.call.name);
+
+    int cleanup = nstack * 8 + pad;
+    if (cleanup) {
+        emit(codegen, "    addq $%d, %%rsp", cleanup);
+        codegen->push_depth -= cleanup / 8;
+    }
+}
+
+// 关系运算符对应的条件码
+static const char* relational_cc(const char* op) {
+    static const char* ops[6] = { "<", "<=", ">", ">=", "==", "!=" };
+    static const char* ccs[6] = { "l", "le", "g", "ge", "e", "ne" };
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(op, ops[i]) == 0) return ccs[i];
+    }
+    return NULL;
+}
+
+// 条件取反（a < b 不成立即 a >= b）
+static const char* negate_cc(const char* cc) {
+    static const char* pairs[6][2] = {
+        { "l", "ge" }, { "le", "g" }, { "g", "le" }, { "ge", "l" }, { "e", "ne" }, { "ne", "e" },
+    };
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(cc, pairs[i][0]) == 0) return pairs[i][1];
+    }
+    return cc;
+}
+
+// 交换比较的两个操作数（a < b 即 b > a）
+static const char* swap_cc(const char* cc) {
+    static const char* pairs[6][2] = {
+        { "l", "g" }, { "le", "ge" }, { "g", "l" }, { "ge", "le" }, { "e", "e" }, { "ne", "ne" },
+    };
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(cc, pairs[i][0]) == 0) return pairs[i][1];
+    }
+    return cc;
+}
+
+static int is_number(ASTNode* node) {
+    return node && node->type == AST_LITERAL && node->data.literal.value_type == TOK_NUMBER;
+}
+
+// 可以直接作为指令操作数的表达式：整数常量（立即数）或变量（栈槽）
+static const char* simple_operand(CodeGenerator* codegen, ASTNode* node, char* buffer, size_t size) {
+    if (is_number(node)) {
+        snprintf(buffer, size, "$%s", node->data.literal.value);
+        return buffer;
+    }
+    if (node && node->type == AST_IDENTIFIER) {
+        return variable_operand(codegen, node->data.identifier, buffer, size);
+    }
+    return NULL;
+}
+
+// 表达式是否有副作用（调用或赋值）；calls_only 时只看调用
+static int has_side_effects(ASTNode* node, int calls_only) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_CALL:
+            return 1;
+        case AST_ASSIGNMENT:
+            return !calls_only || has_side_effects(node->left, calls_only);
+        case AST_INDEX:
+            return has_side_effects(node->data.element.index, calls_only);
+        case AST_INDEX_ASSIGNMENT:
+            return !calls_only || has_side_effects(node->data.element.index, calls_only) ||
+                   has_side_effects(node->data.element.value, calls_only);
+        case AST_BINARY_OP:
+            if (!calls_only && strcmp(node->data.binary.operator, "=") == 0) return 1;
+            return has_side_effects(node->data.binary.left, calls_only) ||
+                   has_side_effects(node->data.binary.right, calls_only);
+        case AST_UNARY_OP:
+            return has_side_effects(node->data.unary.operand, calls_only);
+        default:
+            return 0;
+    }
+}
+
+// 表达式是否含赋值（值编号存临时变量的 (t = a * b) 也是）
+static int has_assignment(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+        case AST_INDEX_ASSIGNMENT:
+            return 1;
+        case AST_INDEX:
+            return has_assignment(node->data.element.index);
+        case AST_BINARY_OP:
+            return has_assignment(node->data.binary.left) || has_assignment(node->data.binary.right);
+        case AST_UNARY_OP:
+            return has_assignment(node->data.unary.operand);
+        case AST_CALL:
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) {
+                if (has_assignment(arg)) return 1;
+            }
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+// Sethi–Ullman 标号：求值子树需要的临时寄存器数。能直接作为右操作数的叶子不占寄存器；
+// 含调用的子树记为很大，让它先求值，临时值就不必跨调用保存。
+#define NEED_CALL 100
+
+static int register_need(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_CALL:
+            return NEED_CALL;
+        case AST_UNARY_OP:
+            return register_need(node->data.unary.operand);
+        case AST_ASSIGNMENT:
+            return register_need(node->left);
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT: {
+            int index = register_need(node->data.element.index);
+            int value = register_need(node->data.element.value);
+            int need = index > value ? index : value;
+            return need > 1 ? need : 1;
+        }
+        case AST_BINARY_OP: {
+            ASTNode* right = node->data.binary.right;
+            int l = register_need(node->data.binary.left);
+            int r = is_number(right) || (right && right->type == AST_IDENTIFIER) ? 0 : register_need(right);
+            return l == r ? l + 1 : (l > r ? l : r);
+        }
+        default:
+            return 1;
+    }
+}
+
+// 表达式临时值用的调用者保存寄存器。参数寄存器只在调用前一刻才装入参数，
+// 而持有临时值期间不会求值含调用的子树，所以它们也可以用。
+static const char* temp_regs[] = { "r11d", "r10d", "r9d", "r8d", "esi", "edi" };
+#define NUM_TEMP_REGS 6
+
+// 准备二元运算的操作数：一个操作数求值到 %eax，返回另一个的位置（立即数、栈槽、临时寄存器或 %ecx），
+// 之后由调用者生成 "op 返回值, %eax"。swapped 为 NULL 时 %eax 中总是左操作数；
+// 否则允许 %eax 中是右操作数，此时置 *swapped = 1。held 表示占用了临时寄存器，用完要 release_temp。
+// 优化时按 Sethi–Ullman 标号先算需要寄存器多的一侧（至少一侧无副作用且都不含赋值时才调换求值顺序），
+// 后算的一侧不含调用时先算出的值放在寄存器里，否则压栈。
+static const char* generate_operands(CodeGenerator* codegen, ASTNode* left, ASTNode* right,
+                                     char* buffer, size_t size, int* swapped, int* held) {
+    *held = 0;
+    if (swapped) *swapped = 0;
+    const char* operand = simple_operand(codegen, right, buffer, size);
+    if (operand) {
+        generate_expression(codegen, left);
+        return operand;
+    }
+    if (swapped && !has_assignment(right) && (operand = simple_operand(codegen, left, buffer, size))) {
+        generate_expression(codegen, right);
+        *swapped = 1;
+        return operand;
+    }
+
+    if (!codegen->optimize) {
+        generate_expression(codegen, left);
+        push_rax(codegen);
+        generate_expression(codegen, right);
+        emit(codegen, "    movl %%eax, %%ecx");
+        pop_rax(codegen);
+        return "%ecx";
+    }
+
+    // 含赋值的一侧不调换：栈槽共享按从左到右的求值顺序计算活跃区间，
+    // 先写了赋值目标会覆盖另一侧还要读的、与它共用栈槽的变量
+    int reorder_safe = (!has_side_effects(left, 0) || !has_side_effects(right, 0)) &&
+                       !has_assignment(left) && !has_assignment(right);
+    int right_first = reorder_safe && register_need(right) >= register_need(left);
+    ASTNode* first = right_first ? right : left;
+    ASTNode* second = right_first ? left : right;
+
+    if (!has_side_effects(second, 1) && codegen->temp_depth < NUM_TEMP_REGS) {
+        const char* reg = temp_regs[codegen->temp_depth];
+        generate_expression(codegen, first);
+        emit(codegen, "    movl %%eax, %%%s", reg);
+        codegen->temp_depth++;
+        generate_expression(codegen, second);
+        snprintf(buffer, size, "%%%s", reg);
+        if (right_first || swapped) {
+            if (!right_first) *swapped = 1;
+            *held = 1;
+            return buffer;
+        }
+        // 左操作数在寄存器、右操作数在 %eax，而运算不可交换：换到 %ecx
+        codegen->temp_depth--;
+        emit(codegen, "    movl %%eax, %%ecx");
+        emit(codegen, "    movl %s, %%eax", buffer);
+        return "%ecx";
+    }
+
+    generate_expression(codegen, first);
+    push_rax(codegen);
+    generate_expression(codegen, second);
+    if (right_first) {
+        pop_reg(codegen, "rcx");
+    } else {
+        emit(codegen, "    movl %%eax, %%ecx");
+        pop_rax(codegen);
+    }
+    return "%ecx";
+}
+
+static void release_temp(CodeGenerator* codegen, int held) {
+    if (held) codegen->temp_depth--;
+}
+
+// 比较 left 与 right 并设置标志位，返回使“left op right”成立的条件码。
+// 常量和变量直接作为 cmp 的操作数，循环头 i < 10 只需 cmpl + jcc 两条指令。
+static const char* generate_compare(CodeGenerator* codegen, ASTNode* left, ASTNode* right, const char* cc) {
+    char lhs[32], rhs[32];
+    if (is_number(right) && !is_number(left) && simple_operand(codegen, left, lhs, sizeof(lhs))) {
+        emit(codegen, "    cmpl %s, %s", simple_operand(codegen, right, rhs, sizeof(rhs)), lhs);
+        return cc;
+    }
+    if (is_number(left) && !is_number(right) && simple_operand(codegen, right, lhs, sizeof(lhs))) {
+        emit(codegen, "    cmpl %s, %s", simple_operand(codegen, left, rhs, sizeof(rhs)), lhs);
+        return swap_cc(cc);
+    }
+    int swapped, held;
+    const char* operand = generate_operands(codegen, left, right, rhs, sizeof(rhs), &swapped, &held);
+    emit(codegen, "    cmpl %s, %%eax", operand);
+    release_temp(codegen, held);
+    return swapped ? swap_cc(cc) : cc;
+}
+
+// 条件上下文的代码生成：条件的真假等于 jump_if 时跳到 label，否则顺序执行。
+// 关系运算直接生成 cmp + jcc，&&、|| 和 ! 生成短路的跳转代码，不把布尔值物化到 %eax。
+static void generate_condition(CodeGenerator* codegen, ASTNode* node, int label, int jump_if) {
+    if (!node) return;
+
+    if (is_number(node)) {
+        // 常量条件：要么总是跳转，要么总不跳转
+        if ((atoi(node->data.literal.value) != 0) == jump_if) {
+            emit(codegen, "    jmp .L%d", label);
+        }
+        return;
+    }
+
+    if (node->type == AST_UNARY_OP && strcmp(node->data.unary.operator, "!") == 0) {
+        generate_condition(codegen, node->data.unary.operand, label, !jump_if);
+        return;
+    }
+
+    if (node->type == AST_BINARY_OP) {
+        const char* op = node->data.binary.operator;
+        if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) {
+            int is_and = op[0] == '&';
+            if (is_and != jump_if) {
+                // a && b 为假 / a || b 为真：任一操作数满足就跳转
+                generate_condition(codegen, node->data.binary.left, label, jump_if);
+                generate_condition(codegen, node->data.binary.right, label, jump_if);
+            } else {
+                // a && b 为真 / a || b 为假：左操作数不满足时跳过右操作数
+                int skip_label = get_new_label(codegen);
+                generate_condition(codegen, node->data.binary.left, skip_label, !jump_if);
+                generate_condition(codegen, node->data.binary.right, label, jump_if);
+                emit(codegen, ".L%d:", skip_label);
+            }
+            return;
+        }
+
+        const char* cc = relational_cc(op);
+        if (cc) {
+            cc = generate_compare(codegen, node->data.binary.left, node->data.binary.right, cc);
+            emit(codegen, "    j%s .L%d", jump_if ? cc : negate_cc(cc), label);
+            return;
+        }
+    }
+
+    // 其他表达式：求值后与 0 比较
+    generate_expression(codegen, node);
+    emit(codegen, "    testl %%eax, %%eax");
+    emit(codegen, "    %s .L%d", jump_if ? "jne" : "je", label);
+}
+
+// 整数常量的值；不是 32 位整数常量时返回 0
+static int int_literal_value(ASTNode* node, int32_t* value) {
+    if (!is_number(node) || strchr(node->data.literal.value, '.')) return 0;
+    long long v = strtoll(node->data.literal.value, NULL, 10);
+    if (v < INT32_MIN || v > INT32_MAX) return 0;
+    *value = (int32_t)v;
+    return 1;
+}
+
+// 帧内 offset 处的 int 数组按寄存器 index（64 位下标）变址的内存操作数
+static const char* indexed_frame_operand(CodeGenerator* codegen, int offset, const char* index,
+                                         char* buffer, size_t size) {
+    frame_operand(codegen, offset, buffer, size);
+    char* paren = strrchr(buffer, ')');
+    snprintf(paren, size - (size_t)(paren - buffer), ",%%%s,4)", index);
+    return buffer;
+}
+
+// 元素 name[index] 的内存操作数，index 是放着 64 位下标的寄存器；全局数组的首地址先装入 %rdx
+static const char* element_operand(CodeGenerator* codegen, const char* name, const char* index,
+                                   char* buffer, size_t size) {
+    int offset;
+    if (local_array(name, &offset)) return indexed_frame_operand(codegen, offset, index, buffer, size);
+    load_array_address(codegen, name, "rdx");
+    snprintf(buffer, size, "(%%rdx,%%%s,4)", index);
+    return buffer;
+}
+
+// 下标是常量时元素直接作为内存操作数
+static const char* constant_element(CodeGenerator* codegen, ASTNode* node, char* buffer, size_t size) {
+    int32_t index;
+    int offset;
+    if (!int_literal_value(node->data.element.index, &index) || index < -(1 << 28) || index > (1 << 28)) return NULL;
+    if (local_array(node->data.element.name, &offset)) {
+        return frame_operand(codegen, offset + 4 * index, buffer, size);
+    }
+    if (index == 0) snprintf(buffer, size, "%s(%%rip)", node->data.element.name);
+    else snprintf(buffer, size, "%s%+d(%%rip)", node->data.element.name, 4 * index);
+    return buffer;
+}
+
+// 有符号 32 位除以常量 d（|d| >= 2）的魔数与移位量（Hacker's Delight 10-1）
+static void signed_magic(int32_t d, int32_t* magic, int* shift) {
+    const uint32_t two31 = 0x80000000u;
+    uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+    uint32_t t = two31 + ((uint32_t)d >> 31);
+    uint32_t anc = t - 1 - t % ad;
+    uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;
+    uint32_t delta;
+    int p = 31;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    *magic = (int32_t)(d < 0 ? 0u - (q2 + 1) : q2 + 1);
+    *shift = p - 32;
+}
+
+// 被除数在 %eax 中，除以常量 d 后商或余数留在 %eax。
+// 2 的幂用移位加符号修正（向零取整），其余用乘法取高位（Granlund–Montgomery）。
+// d 不能为 0 或 INT32_MIN（这两种仍用 idivl）。
+static void generate_div_by_constant(CodeGenerator* codegen, int32_t d, int is_mod) {
+    uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+
+    if (ad == 1) {
+        if (is_mod) {
+            emit(codegen, "    movl $0, %%eax");
+        } else if (d < 0) {
+            emit(codegen, "    negl %%eax");
+        }
+        return;
+    }
+
+    if ((ad & (ad - 1)) == 0) {
+        int k = 0;
+        while ((1u << k) != ad) k++;
+        // 负数先加上 2^k - 1，算术右移才是向零取整
+        if (is_mod) emit(codegen, "    movl %%eax, %%ecx");
+        emit(codegen, "    movl %%eax, %%edx");
+        if (k > 1) emit(codegen, "    sarl $31, %%edx");
+        emit(codegen, "    shrl $%d, %%edx", 32 - k);
+        emit(codegen, "    addl %%edx, %%eax");
+        if (is_mod) {
+            // 余数 = x - 向零取整到 2^k 的倍数，符号随被除数
+            emit(codegen, "    andl $%d, %%eax", -(int32_t)ad);
+            emit(codegen, "    subl %%eax, %%ecx");
+            emit(codegen, "    movl %%ecx, %%eax");
+        } else {
+            emit(codegen, "    sarl $%d, %%eax", k);
+            if (d < 0) emit(codegen, "    negl %%eax");
+        }
+        return;
+    }
+
+    int32_t magic;
+    int shift;
+    signed_magic(d, &magic, &shift);
+    emit(codegen, "    movl %%eax, %%ecx");
+    emit(codegen, "    movl $%d, %%edx", magic);
+    emit(codegen, "    imull %%edx");
+    // 魔数与除数符号不同时修正高 32 位
+    if (d > 0 && magic < 0) emit(codegen, "    addl %%ecx, %%edx");
+    if (d < 0 && magic > 0) emit(codegen, "    subl %%ecx, %%edx");
+    if (shift > 0) emit(codegen, "    sarl $%d, %%edx", shift);
+    // 商为负时加 1，得到向零取整的结果
+    emit(codegen, "    movl %%edx, %%eax");
+    emit(codegen, "    shrl $31, %%eax");
+    emit(codegen, "    addl %%edx, %%eax");
+    if (is_mod) {
+        emit(codegen, "    imull $%d, %%eax, %%eax", d);
+        emit(codegen, "    subl %%eax, %%ecx");
+        emit(codegen, "    movl %%ecx, %%eax");
+    }
+}
+
 // 生成表达式代码
 static void generate_expression(CodeGenerator* codegen, ASTNode* node) {
     if (!node) return;
@@ -96,57 +755,127 @@ static void generate_expression(CodeGenerator* codegen, ASTNode* node) {
         case AST_IDENTIFIER:
             // 从栈中加载变量
             {
-                int offset = get_variable_offset(codegen, node->data.identifier);
-                emit(codegen, "    movl %d(%%rbp), %%eax", offset);
+                char operand[32];
+                emit(codegen, "    movl %s, %%eax",
+                     variable_operand(codegen, node->data.identifier, operand, sizeof(operand)));
             }
             break;
             
         case AST_BINARY_OP:
-            // 生成左操作数
-            generate_expression(codegen, node->data.binary.left);
-            emit(codegen, "    pushl %%eax");
-            
-            // 生成右操作数
-            generate_expression(codegen, node->data.binary.right);
-            emit(codegen, "    movl %%eax, %%ebx");
-            emit(codegen, "    popl %%eax");
-            
-            // 执行二元操作
-            if (strcmp(node->data.binary.operator, "+") == 0) {
-                emit(codegen, "    addl %%ebx, %%eax");
-            } else if (strcmp(node->data.binary.operator, "-") == 0) {
-                emit(codegen, "    subl %%ebx, %%eax");
-            } else if (strcmp(node->data.binary.operator, "*") == 0) {
-                emit(codegen, "    imull %%ebx, %%eax");
-            } else if (strcmp(node->data.binary.operator, "/") == 0) {
-                emit(codegen, "    cltd");
-                emit(codegen, "    idivl %%ebx");
-            } else if (strcmp(node->data.binary.operator, "<") == 0) {
-                emit(codegen, "    cmpl %%ebx, %%eax");
-                emit(codegen, "    setl %%al");
-                emit(codegen, "    movzbl %%al, %%eax");
-            } else if (strcmp(node->data.binary.operator, ">") == 0) {
-                emit(codegen, "    cmpl %%ebx, %%eax");
-                emit(codegen, "    setg %%al");
-                emit(codegen, "    movzbl %%al, %%eax");
-            } else if (strcmp(node->data.binary.operator, "==") == 0) {
-                emit(codegen, "    cmpl %%ebx, %%eax");
-                emit(codegen, "    sete %%al");
-                emit(codegen, "    movzbl %%al, %%eax");
-            } else if (strcmp(node->data.binary.operator, "=") == 0) {
+            // 短路求值的逻辑运算
+            if (strcmp(node->data.binary.operator, "&&") == 0 ||
+                strcmp(node->data.binary.operator, "||") == 0) {
+                int false_label = get_new_label(codegen);
+                int end_label = get_new_label(codegen);
+
+                generate_condition(codegen, node, false_label, 0);
+                emit(codegen, "    movl $1, %%eax");
+                emit(codegen, "    jmp .L%d", end_label);
+                emit(codegen, ".L%d:", false_label);
+                emit(codegen, "    movl $0, %%eax");
+                emit(codegen, ".L%d:", end_label);
+                break;
+            }
+
+            // 除以常量：避免 20~40 周期的 idivl
+            {
+                int32_t divisor;
+                int is_div = strcmp(node->data.binary.operator, "/") == 0;
+                int is_mod = strcmp(node->data.binary.operator, "%") == 0;
+                if (codegen->optimize && (is_div || is_mod) &&
+                    int_literal_value(node->data.binary.right, &divisor) &&
+                    divisor != 0 && divisor != INT32_MIN) {
+                    generate_expression(codegen, node->data.binary.left);
+                    generate_div_by_constant(codegen, divisor, is_mod);
+                    break;
+                }
+            }
+
+            if (strcmp(node->data.binary.operator, "=") == 0) {
                 // 赋值操作
                 generate_expression(codegen, node->data.binary.right);
                 if (node->data.binary.left->type == AST_IDENTIFIER) {
-                    int offset = get_variable_offset(codegen, node->data.binary.left->data.identifier);
-                    emit(codegen, "    movl %%eax, %d(%%rbp)", offset);
+                    char operand[32];
+                    emit(codegen, "    movl %%eax, %s",
+                         variable_operand(codegen, node->data.binary.left->data.identifier,
+                                          operand, sizeof(operand)));
+                }
+                break;
+            }
+
+            // 关系运算：比较后把条件物化为 0/1
+            {
+                const char* cc = relational_cc(node->data.binary.operator);
+                if (cc) {
+                    cc = generate_compare(codegen, node->data.binary.left, node->data.binary.right, cc);
+                    emit(codegen, "    set%s %%al", cc);
+                    emit(codegen, "    movzbl %%al, %%eax");
+                    break;
                 }
             }
+
+            {
+                const char* op = node->data.binary.operator;
+                int commutative = strcmp(op, "+") == 0 || strcmp(op, "*") == 0 || strcmp(op, "&") == 0 ||
+                                  strcmp(op, "|") == 0 || strcmp(op, "^") == 0;
+                char buffer[32];
+                int swapped, held;
+                const char* operand = generate_operands(codegen, node->data.binary.left, node->data.binary.right,
+                                                        buffer, sizeof(buffer),
+                                                        commutative ? &swapped : NULL, &held);
+
+                // 执行二元操作：%eax op operand
+                if (strcmp(op, "+") == 0) {
+                    emit(codegen, "    addl %s, %%eax", operand);
+                } else if (strcmp(op, "-") == 0) {
+                    emit(codegen, "    subl %s, %%eax", operand);
+                } else if (strcmp(op, "*") == 0) {
+                    emit(codegen, "    imull %s, %%eax", operand);
+                } else if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+                    // idivl 不接受立即数
+                    if (operand[0] == '$') {
+                        emit(codegen, "    movl %s, %%ecx", operand);
+                        operand = "%ecx";
+                    }
+                    emit(codegen, "    cltd");
+                    emit(codegen, "    idivl %s", operand);
+                    if (op[0] == '%') emit(codegen, "    movl %%edx, %%eax");
+                } else if (strcmp(op, "&") == 0) {
+                    emit(codegen, "    andl %s, %%eax", operand);
+                } else if (strcmp(op, "|") == 0) {
+                    emit(codegen, "    orl %s, %%eax", operand);
+                } else if (strcmp(op, "^") == 0) {
+                    emit(codegen, "    xorl %s, %%eax", operand);
+                } else if (strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) {
+                    // 移位次数是立即数或者在 %cl 中
+                    const char* mnemonic = op[0] == '<' ? "sall" : "sarl";
+                    if (operand[0] == '$') {
+                        emit(codegen, "    %s %s, %%eax", mnemonic, operand);
+                    } else {
+                        if (strcmp(operand, "%ecx") != 0) emit(codegen, "    movl %s, %%ecx", operand);
+                        emit(codegen, "    %s %%cl, %%eax", mnemonic);
+                    }
+                }
+                release_temp(codegen, held);
+            }
+            break;
+
+        case AST_ASSIGNMENT:
+            // x = expr（parse_expression 生成的赋值节点）
+            {
+                generate_expression(codegen, node->left);
+                char operand[32];
+                emit(codegen, "    movl %%eax, %s",
+                     variable_operand(codegen, node->data.identifier, operand, sizeof(operand)));
+            }
             break;
             
         case AST_UNARY_OP:
             generate_expression(codegen, node->data.unary.operand);
             if (strcmp(node->data.unary.operator, "-") == 0) {
                 emit(codegen, "    negl %%eax");
+            } else if (strcmp(node->data.unary.operator, "~") == 0) {
+                emit(codegen, "    notl %%eax");
             } else if (strcmp(node->data.unary.operator, "!") == 0) {
                 emit(codegen, "    cmpl $0, %%eax");
                 emit(codegen, "    sete %%al");
@@ -155,19 +884,46 @@ static void generate_expression(CodeGenerator* codegen, ASTNode* node) {
             break;
             
         case AST_CALL:
-            // 简单的函数调用实现
-            // 生成参数（如果有）
-            if (node->data.call.args) {
-                generate_expression(codegen, node->data.call.args);
-                emit(codegen, "    pushl %%eax");
+            generate_call(codegen, node);
+            break;
+
+        case AST_INDEX:
+            {
+                char operand[64];
+                if (!constant_element(codegen, node, operand, sizeof(operand))) {
+                    generate_expression(codegen, node->data.element.index);
+                    emit(codegen, "    cltq");
+                    element_operand(codegen, node->data.element.name, "rax", operand, sizeof(operand));
+                }
+                emit(codegen, "    movl %s, %%eax", operand);
             }
-            
-            // 调用函数
-            emit(codegen, "    call %s", node->data.call.name);
-            
-            // 清理栈（如果有参数）
-            if (node->data.call.args) {
-                emit(codegen, "    addl $4, %%esp");
+            break;
+
+        case AST_INDEX_ASSIGNMENT:
+            // 写入的值留在 %eax 作为表达式的值
+            {
+                ASTNode* index = node->data.element.index;
+                ASTNode* value = node->data.element.value;
+                char operand[64];
+                if (constant_element(codegen, node, operand, sizeof(operand))) {
+                    generate_expression(codegen, value);
+                    emit(codegen, "    movl %%eax, %s", operand);
+                    break;
+                }
+                // 下标是变量时先算值再读下标；值里有赋值就保持下标先求值（栈槽共享按这个顺序算活跃区间）
+                if (index->type == AST_IDENTIFIER && !has_assignment(value)) {
+                    generate_expression(codegen, value);
+                    emit(codegen, "    movslq %s, %%rcx",
+                         variable_operand(codegen, index->data.identifier, operand, sizeof(operand)));
+                } else {
+                    generate_expression(codegen, index);
+                    push_rax(codegen);
+                    generate_expression(codegen, value);
+                    pop_reg(codegen, "rcx");
+                    emit(codegen, "    movslq %%ecx, %%rcx");
+                }
+                emit(codegen, "    movl %%eax, %s",
+                     element_operand(codegen, node->data.element.name, "rcx", operand, sizeof(operand)));
             }
             break;
             
@@ -176,6 +932,1163 @@ static void generate_expression(CodeGenerator* codegen, ASTNode* node) {
     }
 }
 
+// 对当前函数自身的调用，且实参个数与形参一致
+static int is_self_call(CodeGenerator* codegen, ASTNode* node) {
+    if (!node || node->type != AST_CALL || !codegen->function) return 0;
+    if (strcmp(node->data.call.name, codegen->function->data.function.name) != 0) return 0;
+    int nargs = 0;
+    for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) nargs++;
+    return nargs == codegen->nparams;
+}
+
+static int calls_self(CodeGenerator* codegen, ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_CALL:
+            if (strcmp(node->data.call.name, codegen->function->data.function.name) == 0) return 1;
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) {
+                if (calls_self(codegen, arg)) return 1;
+            }
+            return 0;
+        case AST_BINARY_OP:
+            return calls_self(codegen, node->data.binary.left) || calls_self(codegen, node->data.binary.right);
+        case AST_UNARY_OP:
+            return calls_self(codegen, node->data.unary.operand);
+        case AST_ASSIGNMENT:
+            return calls_self(codegen, node->left);
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT:
+            return calls_self(codegen, node->data.element.index) || calls_self(codegen, node->data.element.value);
+        default:
+            return 0;
+    }
+}
+
+// 累加器模式 return x op f(...)（op 为 + 或 *，x 中不再调用 f）：返回 op，并给出调用与另一个操作数
+static const char* accumulator_split(CodeGenerator* codegen, ASTNode* expr, ASTNode** call, ASTNode** other) {
+    if (!expr || expr->type != AST_BINARY_OP) return NULL;
+    const char* op = expr->data.binary.operator;
+    if (strcmp(op, "+") != 0 && strcmp(op, "*") != 0) return NULL;
+    ASTNode* left = expr->data.binary.left;
+    ASTNode* right = expr->data.binary.right;
+    if (is_self_call(codegen, right) && !calls_self(codegen, left)) {
+        *call = right;
+        *other = left;
+    } else if (is_self_call(codegen, left) && !calls_self(codegen, right)) {
+        *call = left;
+        *other = right;
+    } else {
+        return NULL;
+    }
+    return op;
+}
+
+// 扫描函数体的 return：统计自递归尾调用，并确定能否做累加器变换
+// （所有累加器模式的运算符一致，且没有不带值的 return）
+static void scan_returns(CodeGenerator* codegen, ASTNode* node, int* tail_calls, const char** op, int* ok) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_RETURN: {
+                ASTNode* call;
+                ASTNode* other;
+                const char* split;
+                if (!node->left) {
+                    *ok = 0;
+                } else if (is_self_call(codegen, node->left)) {
+                    (*tail_calls)++;
+                } else if ((split = accumulator_split(codegen, node->left, &call, &other))) {
+                    if (*op && strcmp(*op, split) != 0) *ok = 0;
+                    *op = split;
+                }
+                break;
+            }
+            case AST_BLOCK:
+                scan_returns(codegen, node->left, tail_calls, op, ok);
+                break;
+            case AST_IF:
+                scan_returns(codegen, node->data.if_stmt.then_branch, tail_calls, op, ok);
+                scan_returns(codegen, node->data.if_stmt.else_branch, tail_calls, op, ok);
+                break;
+            case AST_WHILE:
+                scan_returns(codegen, node->data.while_stmt.body, tail_calls, op, ok);
+                break;
+            case AST_FOR:
+                scan_returns(codegen, node->data.for_stmt.body, tail_calls, op, ok);
+                break;
+            case AST_SWITCH:
+                scan_returns(codegen, node->data.switch_stmt.body, tail_calls, op, ok);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// 累加器运算：%eax = acc op %eax
+static void apply_accumulator(CodeGenerator* codegen) {
+    char operand[32];
+    emit(codegen, "    %s %s, %%eax", strcmp(codegen->accumulator_op, "+") == 0 ? "addl" : "imull",
+         frame_operand(codegen, codegen->accumulator_offset, operand, sizeof(operand)));
+}
+
+// 第 index 个参数的位置：分到的寄存器或参数槽
+static const char* param_operand(CodeGenerator* codegen, int index, char* buffer, size_t size) {
+    int i = 0;
+    for (ASTNode* param = codegen->function->data.function.params; param; param = param->next) {
+        if (param->type != AST_DECLARATION) continue;
+        if (i++ == index) {
+            int reg = variable_register(codegen, param->data.declaration.name);
+            if (reg == REG_NONE) break;
+            snprintf(buffer, size, "%%%s", asm_reg_name(reg, 4));
+            return buffer;
+        }
+    }
+    return frame_operand(codegen, codegen->param_offsets[index], buffer, size);
+}
+
+// 自递归尾调用：实参全部求值压栈后再写回参数槽（实参可能读到旧的参数值），然后跳回函数入口
+static void generate_tail_call(CodeGenerator* codegen, ASTNode* call) {
+    ASTNode* args[64];
+    int nargs = 0;
+    for (ASTNode* arg = call->data.call.args; arg && nargs < 64; arg = arg->next) {
+        args[nargs++] = arg;
+    }
+    for (int i = nargs - 1; i >= 0; i--) {
+        generate_expression(codegen, args[i]);
+        push_rax(codegen);
+    }
+    for (int i = 0; i < nargs; i++) {
+        char operand[32];
+        pop_rax(codegen);
+        emit(codegen, "    movl %%eax, %s", param_operand(codegen, i, operand, sizeof(operand)));
+    }
+    emit(codegen, "    jmp .L%d", codegen->tail_label);
+    codegen->tail_calls++;
+}
+
+// ---- 剖析 ----
+
+// 计数点的计数器加一（-fprofile-generate），只插在语句边界上：改写标志位，不用寄存器
+static void profile_increment(CodeGenerator* codegen, ASTNode* node, int which) {
+    if (!codegen->profile_generate || !node || node->profile_id <= 0) return;
+    emit(codegen, "    addq $1, %s+%d(%%rip)", PROFILE_COUNTERS, (2 * (node->profile_id - 1) + which) * 8);
+}
+
+// 剖析数据中的冷分支：then 分支很少执行时为 1，几乎总是执行且有 else 时为 2，比例居中时为 0
+// （不调整布局）；if 从未执行过时 then 分支按冷分支处理。没有这个 if 的数据时返回 -1
+static int profile_cold_branch(ASTNode* node) {
+    long long executed = profile_count(node, 0);
+    long long taken = profile_count(node, 1);
+    if (executed < 0 || taken < 0) return -1;
+    if (taken * 100 <= executed * PROFILE_COLD_PERCENT) return 1;
+    if (node->data.if_stmt.else_branch && taken * 100 >= executed * (100 - PROFILE_COLD_PERCENT)) return 2;
+    return 0;
+}
+
+// 剖析数据显示方向几乎固定的 if：预测正确的跳转比 cmov 便宜（cmov 要等两边的值都算出来）
+static int profile_biased(ASTNode* node) {
+    long long executed = profile_count(node, 0);
+    long long taken = profile_count(node, 1);
+    if (executed <= 0 || taken < 0) return 0;
+    return taken * 100 >= executed * PROFILE_BIASED_PERCENT ||
+           (executed - taken) * 100 >= executed * PROFILE_BIASED_PERCENT;
+}
+
+// 剖析数据下是否展开循环：循环体从未执行过的不展开；平均每次进入不到 factor 次迭代的
+// 不做部分展开（主循环一轮都进不去，只多出代码）。没有数据时不限制
+static int profile_allows_unroll(ASTNode* node, int factor) {
+    long long entries = profile_count(node, 0);
+    long long iterations = profile_count(node, 1);
+    if (entries < 0 || iterations < 0) return 1;
+    return iterations > 0 && iterations >= entries * factor;
+}
+
+// 计数器数组，以及 main 返回前调用的写出例程：追加一条记录（记录头一行，之后每行一个计数器）
+// 到剖析文件。例程保存 %rax（main 的返回值），三次压栈后调用点按 16 字节对齐
+static void generate_profile_support(CodeGenerator* codegen) {
+    int ncounters = 2 * codegen->profile_points;
+    int path_label = get_new_label(codegen);
+    int mode_label = get_new_label(codegen);
+    int header_label = get_new_label(codegen);
+    int format_label = get_new_label(codegen);
+    int loop_label = get_new_label(codegen);
+    int done_label = get_new_label(codegen);
+
+    emit(codegen, "%s:", PROFILE_DUMP);
+    emit(codegen, "    pushq %%rbx");
+    emit(codegen, "    pushq %%r12");
+    emit(codegen, "    pushq %%rax");
+    emit(codegen, "    leaq .L%d(%%rip), %%rdi", path_label);
+    emit(codegen, "    leaq .L%d(%%rip), %%rsi", mode_label);
+    emit(codegen, "    call fopen");
+    emit(codegen, "    testq %%rax, %%rax");
+    emit(codegen, "    je .L%d", done_label);
+    emit(codegen, "    movq %%rax, %%rbx");
+    emit(codegen, "    leaq .L%d(%%rip), %%rdi", header_label);
+    emit(codegen, "    movq %%rbx, %%rsi");
+    emit(codegen, "    call fputs");
+    emit(codegen, "    xorl %%r12d, %%r12d");
+    emit(codegen, ".L%d:", loop_label);
+    emit(codegen, "    leaq %s(%%rip), %%rax", PROFILE_COUNTERS);
+    emit(codegen, "    movq (%%rax,%%r12,8), %%rdx");
+    emit(codegen, "    leaq .L%d(%%rip), %%rsi", format_label);
+    emit(codegen, "    movq %%rbx, %%rdi");
+    emit(codegen, "    xorl %%eax, %%eax");
+    emit(codegen, "    call fprintf");
+    emit(codegen, "    addq $1, %%r12");
+    emit(codegen, "    cmpq $%d, %%r12", ncounters);
+    emit(codegen, "    jl .L%d", loop_label);
+    emit(codegen, "    movq %%rbx, %%rdi");
+    emit(codegen, "    call fclose");
+    emit(codegen, ".L%d:", done_label);
+    emit(codegen, "    popq %%rax");
+    emit(codegen, "    popq %%r12");
+    emit(codegen, "    popq %%rbx");
+    emit(codegen, "    ret");
+
+    emit(codegen, ".section .rodata");
+    emit(codegen, ".L%d:", path_label);
+    emit(codegen, "    .string \"%s\"", codegen->profile_path);
+    emit(codegen, ".L%d:", mode_label);
+    emit(codegen, "    .string \"a\"");
+    emit(codegen, ".L%d:", header_label);
+    emit(codegen, "    .string \"tinycc-profile %d %u\\n\"", codegen->profile_points, codegen->profile_sum);
+    emit(codegen, ".L%d:", format_label);
+    emit(codegen, "    .string \"%%ld\\n\"");
+
+    emit(codegen, ".section .bss");
+    emit(codegen, ".p2align 3");
+    emit(codegen, "%s:", PROFILE_COUNTERS);
+    emit(codegen, "    .zero %d", ncounters ? ncounters * 8 : 8);
+    emit(codegen, ".section .text");
+    flush_lines(codegen);
+}
+
+// ---- 函数级剖析 ----
+
+// 时间戳计数器读到 %rax（rdtsc 的结果在 edx:eax，改写 %rdx）
+static void read_timestamp(CodeGenerator* codegen) {
+    emit(codegen, "    rdtsc");
+    emit(codegen, "    shlq $32, %%rdx");
+    emit(codegen, "    orq %%rdx, %%rax");
+}
+
+// 函数入口（参数已存入栈槽，%rax、%rdx 空闲）：调用次数加一，记下入口时间戳与此刻被调用者周期的累计值
+static void generate_instrument_entry(CodeGenerator* codegen, int index) {
+    char operand[32];
+    emit(codegen, "    addq $1, %s+%d(%%rip)", FUNCTION_TABLE, index * FUNCTION_ENTRY_SIZE);
+    emit(codegen, "    movq %s(%%rip), %%rax", FUNCTION_CALLEE_CYCLES);
+    emit(codegen, "    movq %%rax, %s",
+         frame_operand(codegen, codegen->instrument_offset + 8, operand, sizeof(operand)));
+    read_timestamp(codegen);
+    emit(codegen, "    movq %%rax, %s", frame_operand(codegen, codegen->instrument_offset, operand, sizeof(operand)));
+}
+
+// 函数尾声（%rax 是返回值，暂存在 %r8）：经过的周期计入总周期；减去这期间被调用者累计增加的部分
+// 就是自身周期。随后把累计值改成入口时的值加上本次的总周期，调用者看到的就是整个调用的开销。
+// 递归调用的总周期会重复计入，自身周期不会
+static void generate_instrument_exit(CodeGenerator* codegen, int index) {
+    char operand[32];
+    emit(codegen, "    movq %%rax, %%r8");
+    read_timestamp(codegen);
+    emit(codegen, "    subq %s, %%rax", frame_operand(codegen, codegen->instrument_offset, operand, sizeof(operand)));
+    emit(codegen, "    addq %%rax, %s+%d(%%rip)", FUNCTION_TABLE, index * FUNCTION_ENTRY_SIZE + 8);
+    emit(codegen, "    movq %s, %%rdx",
+         frame_operand(codegen, codegen->instrument_offset + 8, operand, sizeof(operand)));
+    emit(codegen, "    movq %s(%%rip), %%rcx", FUNCTION_CALLEE_CYCLES);
+    emit(codegen, "    subq %%rdx, %%rcx");
+    emit(codegen, "    addq %%rax, %%rdx");
+    emit(codegen, "    movq %%rdx, %s(%%rip)", FUNCTION_CALLEE_CYCLES);
+    emit(codegen, "    subq %%rcx, %%rax");
+    emit(codegen, "    addq %%rax, %s+%d(%%rip)", FUNCTION_TABLE, index * FUNCTION_ENTRY_SIZE + 16);
+    emit(codegen, "    movq %%r8, %%rax");
+}
+
+// 函数表、函数名，以及 main 返回前调用的写出例程：按自身周期从高到低（每次挑出最大的一行）
+// 把被调用过的函数写成平面剖析。例程保存 %rax（main 的返回值），连同 %rbp 七次压栈后调用点对齐
+static void generate_function_profile_support(CodeGenerator* codegen) {
+    int nfunctions = codegen->ninstrumented;
+    int path_label = get_new_label(codegen);
+    int mode_label = get_new_label(codegen);
+    int header_label = get_new_label(codegen);
+    int format_label = get_new_label(codegen);
+    int names_label = get_new_label(codegen);
+    int next_label = get_new_label(codegen);
+    int scan_label = get_new_label(codegen);
+    int take_label = get_new_label(codegen);
+    int skip_label = get_new_label(codegen);
+    int pick_label = get_new_label(codegen);
+    int close_label = get_new_label(codegen);
+    int done_label = get_new_label(codegen);
+
+    emit(codegen, "%s:", FUNCTION_DUMP);
+    emit(codegen, "    pushq %%rbp");
+    emit(codegen, "    pushq %%rbx");
+    emit(codegen, "    pushq %%r12");
+    emit(codegen, "    pushq %%r13");
+    emit(codegen, "    pushq %%r14");
+    emit(codegen, "    pushq %%r15");
+    emit(codegen, "    pushq %%rax");
+    emit(codegen, "    leaq .L%d(%%rip), %%rdi", path_label);
+    emit(codegen, "    leaq .L%d(%%rip), %%rsi", mode_label);
+    emit(codegen, "    call fopen");
+    emit(codegen, "    testq %%rax, %%rax");
+    emit(codegen, "    je .L%d", done_label);
+    emit(codegen, "    movq %%rax, %%rbx");
+    emit(codegen, "    leaq .L%d(%%rip), %%rdi", header_label);
+    emit(codegen, "    movq %%rbx, %%rsi");
+    emit(codegen, "    call fputs");
+    // %r12：已处理的行数；%r13：自身周期最大的未输出行（-1 表示还没有），%r15 是它的自身周期
+    emit(codegen, "    xorl %%r12d, %%r12d");
+    emit(codegen, ".L%d:", next_label);
+    emit(codegen, "    cmpq $%d, %%r12", nfunctions);
+    emit(codegen, "    jge .L%d", close_label);
+    emit(codegen, "    movq $-1, %%r13");
+    emit(codegen, "    xorl %%r14d, %%r14d");
+    emit(codegen, ".L%d:", scan_label);
+    emit(codegen, "    cmpq $%d, %%r14", nfunctions);
+    emit(codegen, "    jge .L%d", pick_label);
+    emit(codegen, "    movq %%r14, %%rax");
+    emit(codegen, "    shlq $5, %%rax");
+    emit(codegen, "    leaq %s(%%rip), %%rcx", FUNCTION_TABLE);
+    emit(codegen, "    addq %%rcx, %%rax");
+    emit(codegen, "    cmpq $0, 24(%%rax)");
+    emit(codegen, "    jne .L%d", skip_label);
+    emit(codegen, "    testq %%r13, %%r13");
+    emit(codegen, "    js .L%d", take_label);
+    emit(codegen, "    cmpq %%r15, 16(%%rax)");
+    emit(codegen, "    jbe .L%d", skip_label);
+    emit(codegen, ".L%d:", take_label);
+    emit(codegen, "    movq %%r14, %%r13");
+    emit(codegen, "    movq 16(%%rax), %%r15");
+    emit(codegen, ".L%d:", skip_label);
+    emit(codegen, "    addq $1, %%r14");
+    emit(codegen, "    jmp .L%d", scan_label);
+    emit(codegen, ".L%d:", pick_label);
+    emit(codegen, "    addq $1, %%r12");
+    emit(codegen, "    movq %%r13, %%rax");
+    emit(codegen, "    shlq $5, %%rax");
+    emit(codegen, "    leaq %s(%%rip), %%rcx", FUNCTION_TABLE);
+    emit(codegen, "    addq %%rcx, %%rax");
+    emit(codegen, "    movq $1, 24(%%rax)");
+    emit(codegen, "    cmpq $0, (%%rax)");
+    emit(codegen, "    je .L%d", next_label);
+    // fprintf(file, format, 调用次数, 自身周期, 总周期, 函数名)
+    emit(codegen, "    leaq .L%d(%%rip), %%rcx", names_label);
+    emit(codegen, "    movslq (%%rcx,%%r13,4), %%r9");
+    emit(codegen, "    addq %%rcx, %%r9");
+    emit(codegen, "    movq 8(%%rax), %%r8");
+    emit(codegen, "    movq 16(%%rax), %%rcx");
+    emit(codegen, "    movq (%%rax), %%rdx");
+    emit(codegen, "    leaq .L%d(%%rip), %%rsi", format_label);
+    emit(codegen, "    movq %%rbx, %%rdi");
+    emit(codegen, "    xorl %%eax, %%eax");
+    emit(codegen, "    call fprintf");
+    emit(codegen, "    jmp .L%d", next_label);
+    emit(codegen, ".L%d:", close_label);
+    emit(codegen, "    movq %%rbx, %%rdi");
+    emit(codegen, "    call fclose");
+    emit(codegen, ".L%d:", done_label);
+    emit(codegen, "    popq %%rax");
+    emit(codegen, "    popq %%r15");
+    emit(codegen, "    popq %%r14");
+    emit(codegen, "    popq %%r13");
+    emit(codegen, "    popq %%r12");
+    emit(codegen, "    popq %%rbx");
+    emit(codegen, "    popq %%rbp");
+    emit(codegen, "    ret");
+
+    // 函数名按到表头的偏移索引
+    emit(codegen, ".section .rodata");
+    emit(codegen, ".p2align 2");
+    emit(codegen, ".L%d:", names_label);
+    int first_name = codegen->label_count;
+    codegen->label_count += nfunctions;
+    for (int i = 0; i < nfunctions; i++) {
+        emit(codegen, "    .long .L%d-.L%d", first_name + i, names_label);
+    }
+    for (int i = 0; i < nfunctions; i++) {
+        emit(codegen, ".L%d:", first_name + i);
+        emit(codegen, "    .string \"%s\"", codegen->instrumented[i]);
+    }
+    emit(codegen, ".L%d:", path_label);
+    emit(codegen, "    .string \"%s\"", codegen->instrument_path);
+    emit(codegen, ".L%d:", mode_label);
+    emit(codegen, "    .string \"w\"");
+    emit(codegen, ".L%d:", header_label);
+    emit(codegen, "    .string \"# flat profile: rdtsc cycles, total includes callees\\n"
+                  "#        calls      self-cycles     total-cycles  function\\n\"");
+    emit(codegen, ".L%d:", format_label);
+    emit(codegen, "    .string \"%%14lu %%16lu %%16lu  %%s\\n\"");
+
+    emit(codegen, ".section .bss");
+    emit(codegen, ".p2align 3");
+    emit(codegen, "%s:", FUNCTION_CALLEE_CYCLES);
+    emit(codegen, "    .zero 8");
+    emit(codegen, "%s:", FUNCTION_TABLE);
+    emit(codegen, "    .zero %d", nfunctions ? nfunctions * FUNCTION_ENTRY_SIZE : 8);
+    emit(codegen, ".section .text");
+    flush_lines(codegen);
+}
+
+// 循环体加更新表达式：展开时每份迭代都这样生成
+static void generate_iteration(CodeGenerator* codegen, ASTNode* node) {
+    profile_increment(codegen, node, 1);
+    if (node->data.for_stmt.body) {
+        generate_code(codegen, node->data.for_stmt.body);
+    }
+    if (node->data.for_stmt.update) {
+        generate_expression(codegen, node->data.for_stmt.update);
+    }
+}
+
+// 完全展开：迭代次数是编译期已知的小常量，循环体原样重复，没有比较和跳转
+static void generate_full_unroll(CodeGenerator* codegen, ASTNode* node, int trips) {
+    if (node->data.for_stmt.init) {
+        generate_code(codegen, node->data.for_stmt.init);
+    }
+    for (int i = 0; i < trips; i++) {
+        generate_iteration(codegen, node);
+    }
+    codegen->unrolled_full++;
+}
+
+// 部分展开：主循环每轮连做 factor 次迭代，入口检查 var + (factor-1)*step 仍满足循环条件
+// （符号扩展到 64 位再比较，不会溢出），这一轮里每次迭代的条件就都成立；
+// 剩下不足 factor 次的迭代交给原样的余数循环
+static int generate_unrolled_for(CodeGenerator* codegen, ASTNode* node, const CountedLoop* counted) {
+    int64_t span = (int64_t)(codegen->unroll_factor - 1) * counted->step;
+    if (span < INT32_MIN || span > INT32_MAX) return 0;
+
+    int main_label = get_new_label(codegen);
+    int rest_label = get_new_label(codegen);
+    int end_label = get_new_label(codegen);
+    char operand[32];
+    int bound;
+
+    if (node->data.for_stmt.init) {
+        generate_code(codegen, node->data.for_stmt.init);
+    }
+    emit(codegen, ".L%d:", main_label);
+    emit(codegen, "    movslq %s, %%rax", variable_operand(codegen, counted->var, operand, sizeof(operand)));
+    emit(codegen, "    addq $%lld, %%rax", (long long)span);
+    if (node_is_constant(counted->bound, &bound)) {
+        emit(codegen, "    cmpq $%d, %%rax", bound);
+    } else {
+        emit(codegen, "    movslq %s, %%rcx",
+             variable_operand(codegen, counted->bound->data.identifier, operand, sizeof(operand)));
+        emit(codegen, "    cmpq %%rcx, %%rax");
+    }
+    emit(codegen, "    j%s .L%d", negate_cc(relational_cc(counted->op)), rest_label);
+    for (int i = 0; i < codegen->unroll_factor; i++) {
+        generate_iteration(codegen, node);
+    }
+    emit(codegen, "    jmp .L%d", main_label);
+
+    emit(codegen, ".L%d:", rest_label);
+    generate_condition(codegen, node->data.for_stmt.condition, end_label, 0);
+    generate_iteration(codegen, node);
+    emit(codegen, "    jmp .L%d", rest_label);
+    emit(codegen, ".L%d:", end_label);
+    codegen->unrolled_partial++;
+    return 1;
+}
+
+// ---- 循环向量化 ----
+// 步长为 1 的计数 for 循环（i < n 或 i <= n），循环体只有数组元素赋值时用 SSE2 每轮处理 4 个元素，
+// 剩下不足 4 次的迭代交给原样的标量循环。赋值的值由元素读取、循环不变量（变量和常量）
+// 与 + - * & | ^ 组成；下标是 i + c 或 i ± v（v 是循环不变的变量）。
+// 向量化后每条语句先做完 4 次迭代再执行下一条，同一数组的两次访问（至少一次是写）
+// 按这个顺序前者在后者之前，若后者的下标比前者大 1~3，原来的读写顺序就被颠倒了：
+// 距离是常量时不向量化，含变量时运行时检查，不安全就直接走标量循环。不同的数组不会重叠。
+
+#define VECTOR_WIDTH 4
+#define VECTOR_MAX_ACCESSES 32
+#define VECTOR_MAX_INVARIANTS 8
+#define VECTOR_MAX_BASES 6
+
+// 数组首地址加上变量偏移后放进寄存器的基址（全局数组，或下标含变量的访问）
+static const char* vector_base_regs[VECTOR_MAX_BASES] = { "rsi", "rdi", "r8", "r9", "r10", "r11" };
+
+typedef struct {
+    const char* array;
+    int offset;             // 下标为 i + offset + sign * var
+    const char* var;        // 没有变量偏移时为 NULL
+    int sign;
+    int store;
+    int base;               // vector_base_regs 中的基址，-1 表示局部数组直接按帧内地址变址
+} VectorAccess;
+
+typedef struct {
+    CodeGenerator* codegen;
+    const char* var;        // 归纳变量
+    VectorAccess accesses[VECTOR_MAX_ACCESSES];    // 按向量化后的执行顺序
+    int naccesses;
+    ASTNode* invariants[VECTOR_MAX_INVARIANTS];    // 第 k 个广播到 %xmm(15-k)
+    int ninvariants;
+    VectorAccess* bases[VECTOR_MAX_BASES];
+    int nbases;
+    int temps;              // 可用的临时 xmm 寄存器数（从 %xmm0 起）
+    int failed;
+} VectorLoop;
+
+static int is_variable(ASTNode* node, const char* name) {
+    return node && node->type == AST_IDENTIFIER && strcmp(node->data.identifier, name) == 0;
+}
+
+static int same_offset_var(const VectorAccess* a, const VectorAccess* b) {
+    if (!a->var || !b->var) return a->var == b->var;
+    return a->sign == b->sign && strcmp(a->var, b->var) == 0;
+}
+
+// 下标 i、i ± c、c + i、i ± v、v + i
+static int vector_index(VectorLoop* v, ASTNode* index, VectorAccess* access) {
+    access->offset = 0;
+    access->var = NULL;
+    access->sign = 1;
+    if (is_variable(index, v->var)) return 1;
+    if (index->type != AST_BINARY_OP) return 0;
+    int minus = strcmp(index->data.binary.operator, "-") == 0;
+    if (!minus && strcmp(index->data.binary.operator, "+") != 0) return 0;
+    ASTNode* other = index->data.binary.right;
+    if (!is_variable(index->data.binary.left, v->var)) {
+        if (minus || !is_variable(other, v->var)) return 0;
+        other = index->data.binary.left;
+    }
+    int32_t c;
+    if (int_literal_value(other, &c)) {
+        if (c < -(1 << 20) || c > (1 << 20)) return 0;
+        access->offset = minus ? -c : c;
+        return 1;
+    }
+    if (other->type != AST_IDENTIFIER || is_variable(other, v->var)) return 0;
+    access->var = other->data.identifier;
+    access->sign = minus ? -1 : 1;
+    return 1;
+}
+
+static int add_access(VectorLoop* v, ASTNode* element, int store) {
+    if (v->naccesses == VECTOR_MAX_ACCESSES) return 0;
+    VectorAccess* access = &v->accesses[v->naccesses];
+    if (!vector_index(v, element->data.element.index, access)) return 0;
+    access->array = element->data.element.name;
+    access->store = store;
+    access->base = -1;
+    int offset;
+    if (access->var || !local_array(access->array, &offset)) {
+        for (int b = 0; b < v->nbases && access->base < 0; b++) {
+            if (strcmp(v->bases[b]->array, access->array) == 0 && same_offset_var(v->bases[b], access)) {
+                access->base = b;
+            }
+        }
+        if (access->base < 0) {
+            if (v->nbases == VECTOR_MAX_BASES) return 0;
+            access->base = v->nbases;
+            v->bases[v->nbases++] = access;
+        }
+    }
+    v->naccesses++;
+    return 1;
+}
+
+static int same_invariant(ASTNode* a, ASTNode* b) {
+    if (a->type != b->type) return 0;
+    if (a->type == AST_IDENTIFIER) return strcmp(a->data.identifier, b->data.identifier) == 0;
+    return atoi(a->data.literal.value) == atoi(b->data.literal.value);
+}
+
+static int invariant_register(VectorLoop* v, ASTNode* node) {
+    for (int k = 0; k < v->ninvariants; k++) {
+        if (same_invariant(v->invariants[k], node)) return 15 - k;
+    }
+    return -1;
+}
+
+// 赋值的值：记下其中的元素读取与循环不变量
+static int vector_value(VectorLoop* v, ASTNode* node) {
+    int32_t value;
+    switch (node->type) {
+        case AST_LITERAL:
+        case AST_IDENTIFIER:
+            if (node->type == AST_LITERAL ? !int_literal_value(node, &value) : is_variable(node, v->var)) return 0;
+            if (invariant_register(v, node) >= 0) return 1;
+            if (v->ninvariants == VECTOR_MAX_INVARIANTS) return 0;
+            v->invariants[v->ninvariants++] = node;
+            return 1;
+        case AST_INDEX:
+            return add_access(v, node, 0);
+        case AST_BINARY_OP: {
+            static const char* ops[] = { "+", "-", "*", "&", "|", "^" };
+            int known = 0;
+            for (int i = 0; i < 6; i++) {
+                if (strcmp(node->data.binary.operator, ops[i]) == 0) known = 1;
+            }
+            return known && vector_value(v, node->data.binary.left) && vector_value(v, node->data.binary.right);
+        }
+        default:
+            return 0;
+    }
+}
+
+// 循环体（不含更新语句）的每条语句都是元素赋值
+static int vector_body(VectorLoop* v, ASTNode* loop) {
+    ASTNode* body = loop->data.for_stmt.body;
+    ASTNode* update = loop->data.for_stmt.update;
+    if (update && (update->type != AST_ASSIGNMENT || strcmp(update->data.identifier, v->var) != 0)) return 0;
+    int statements = 0;
+    for (ASTNode* s = body->type == AST_BLOCK ? body->left : body; s; s = s->next) {
+        // 循环优化挪进循环体末尾的更新语句（counted_loop 已确认它是唯一的 i = i + 1）
+        if (!update && !s->next && s->type == AST_ASSIGNMENT && strcmp(s->data.identifier, v->var) == 0) break;
+        if (s->type != AST_INDEX_ASSIGNMENT) return 0;
+        if (!vector_value(v, s->data.element.value) || !add_access(v, s, 1)) return 0;
+        statements++;
+        if (body->type != AST_BLOCK) break;
+    }
+    return statements > 0;
+}
+
+static const char* vector_address(VectorLoop* v, VectorAccess* access, char* buffer, size_t size) {
+    if (access->base >= 0) {
+        snprintf(buffer, size, "%d(%%%s,%%rcx,4)", 4 * access->offset, vector_base_regs[access->base]);
+        return buffer;
+    }
+    int offset;
+    local_array(access->array, &offset);
+    return indexed_frame_operand(v->codegen, offset + 4 * access->offset, "rcx", buffer, size);
+}
+
+// 4 个元素的值算进 xmm 寄存器，返回寄存器号。next 是第一个空闲的临时寄存器，
+// 循环不变量直接用广播好的寄存器；超出可用寄存器时置 failed
+static int vector_expression(VectorLoop* v, ASTNode* node, int* access, int next) {
+    CodeGenerator* codegen = v->codegen;
+    char operand[64];
+    if (next + 1 > v->temps) {
+        v->failed = 1;
+        return 0;
+    }
+    if (node->type == AST_INDEX) {
+        emit(codegen, "    movdqu %s, %%xmm%d", vector_address(v, &v->accesses[(*access)++], operand, sizeof(operand)),
+             next);
+        return next;
+    }
+    if (node->type != AST_BINARY_OP) return invariant_register(v, node);
+
+    const char* op = node->data.binary.operator;
+    ASTNode* left = node->data.binary.left;
+    ASTNode* right = node->data.binary.right;
+    int left_reg = vector_expression(v, left, access, next);
+    if (left_reg != next) {
+        emit(codegen, "    movdqa %%xmm%d, %%xmm%d", left_reg, next);
+    }
+    int right_reg = vector_expression(v, right, access, next + 1);
+    if (strcmp(op, "*") == 0) {
+        // SSE2 没有 32 位乘法（pmulld 是 SSE4.1）：偶数、奇数元素分别用 pmuludq 得到 64 位积，取低 32 位交错合并
+        int t1 = next + 2, t2 = next + 3;
+        if (t2 + 1 > v->temps) {
+            v->failed = 1;
+            return next;
+        }
+        emit(codegen, "    pshufd $245, %%xmm%d, %%xmm%d", next, t1);
+        emit(codegen, "    pmuludq %%xmm%d, %%xmm%d", right_reg, next);
+        emit(codegen, "    pshufd $245, %%xmm%d, %%xmm%d", right_reg, t2);
+        emit(codegen, "    pmuludq %%xmm%d, %%xmm%d", t2, t1);
+        emit(codegen, "    pshufd $8, %%xmm%d, %%xmm%d", next, next);
+        emit(codegen, "    pshufd $8, %%xmm%d, %%xmm%d", t1, t1);
+        emit(codegen, "    punpckldq %%xmm%d, %%xmm%d", t1, next);
+        return next;
+    }
+    static const char* ops[5][2] = { { "+", "paddd" }, { "-", "psubd" }, { "&", "pand" }, { "|", "por" }, { "^", "pxor" } };
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(op, ops[i][0]) == 0) emit(codegen, "    %s %%xmm%d, %%xmm%d", ops[i][1], right_reg, next);
+    }
+    return next;
+}
+
+// 下标差 (q 的下标) - (p 的下标) - 1 算进 %rax，无符号比较小于 3 即距离为 1~3
+static void vector_alias_check(CodeGenerator* codegen, VectorAccess* p, VectorAccess* q, int scalar_label) {
+    char operand[32];
+    emit(codegen, "    movq $%d, %%rax", q->offset - p->offset - 1);
+    if (q->var) {
+        emit(codegen, "    movslq %s, %%rdx", variable_operand(codegen, q->var, operand, sizeof(operand)));
+        emit(codegen, "    %s %%rdx, %%rax", q->sign > 0 ? "addq" : "subq");
+    }
+    if (p->var) {
+        emit(codegen, "    movslq %s, %%rdx", variable_operand(codegen, p->var, operand, sizeof(operand)));
+        emit(codegen, "    %s %%rdx, %%rax", p->sign > 0 ? "subq" : "addq");
+    }
+    emit(codegen, "    cmpq $%d, %%rax", VECTOR_WIDTH - 1);
+    emit(codegen, "    jb .L%d", scalar_label);
+}
+
+static int generate_vectorized_for(CodeGenerator* codegen, ASTNode* node, const CountedLoop* counted) {
+    if (counted->step != 1 || counted->op[0] != '<') return 0;
+    if (counted->trips >= 0 && counted->trips < VECTOR_WIDTH) return 0;
+    int inclusive = strcmp(counted->op, "<=") == 0;
+    int bound = 0;
+    int constant_bound = node_is_constant(counted->bound, &bound);
+    if (constant_bound && inclusive && bound == INT32_MAX) return 0;
+
+    VectorLoop v;
+    memset(&v, 0, sizeof(v));
+    v.codegen = codegen;
+    v.var = counted->var;
+    if (!vector_body(&v, node)) return 0;
+    v.temps = 16 - v.ninvariants;
+
+    // 常量距离的依赖在编译期判定
+    for (int q = 0; q < v.naccesses; q++) {
+        for (int p = 0; p < q; p++) {
+            VectorAccess* a = &v.accesses[p];
+            VectorAccess* b = &v.accesses[q];
+            if ((!a->store && !b->store) || strcmp(a->array, b->array) != 0 || !same_offset_var(a, b)) continue;
+            int distance = b->offset - a->offset;
+            if (distance > 0 && distance < VECTOR_WIDTH) return 0;
+        }
+    }
+
+    int start = codegen->lines->count;
+    int vector_label = get_new_label(codegen);
+    int scalar_label = get_new_label(codegen);
+    char operand[64];
+
+    if (node->data.for_stmt.init) {
+        generate_code(codegen, node->data.for_stmt.init);
+    }
+    for (int q = 0; q < v.naccesses; q++) {
+        for (int p = 0; p < q; p++) {
+            VectorAccess* a = &v.accesses[p];
+            VectorAccess* b = &v.accesses[q];
+            if ((!a->store && !b->store) || strcmp(a->array, b->array) != 0 || same_offset_var(a, b)) continue;
+            vector_alias_check(codegen, a, b, scalar_label);
+        }
+    }
+
+    // %rcx 是 64 位的 i，%rdx 是向量部分的终点 i + (剩余次数向下取整到 4 的倍数)
+    emit(codegen, "    movslq %s, %%rcx", variable_operand(codegen, v.var, operand, sizeof(operand)));
+    if (constant_bound) {
+        emit(codegen, "    movq $%d, %%rdx", bound + inclusive);
+    } else {
+        emit(codegen, "    movslq %s, %%rdx",
+             variable_operand(codegen, counted->bound->data.identifier, operand, sizeof(operand)));
+        if (inclusive) emit(codegen, "    addq $1, %%rdx");
+    }
+    emit(codegen, "    movq %%rdx, %%rax");
+    emit(codegen, "    subq %%rcx, %%rax");
+    emit(codegen, "    cmpq $%d, %%rax", VECTOR_WIDTH);
+    emit(codegen, "    jl .L%d", scalar_label);
+    emit(codegen, "    andq $%d, %%rax", -VECTOR_WIDTH);
+    emit(codegen, "    addq %%rcx, %%rax");
+    emit(codegen, "    movq %%rax, %%rdx");
+
+    for (int b = 0; b < v.nbases; b++) {
+        VectorAccess* base = v.bases[b];
+        load_array_address(codegen, base->array, vector_base_regs[b]);
+        if (base->var) {
+            emit(codegen, "    movslq %s, %%rax", variable_operand(codegen, base->var, operand, sizeof(operand)));
+            if (base->sign < 0) emit(codegen, "    negq %%rax");
+            emit(codegen, "    leaq (%%%s,%%rax,4), %%%s", vector_base_regs[b], vector_base_regs[b]);
+        }
+    }
+    for (int k = 0; k < v.ninvariants; k++) {
+        ASTNode* inv = v.invariants[k];
+        if (inv->type == AST_LITERAL) {
+            emit(codegen, "    movl $%s, %%eax", inv->data.literal.value);
+            emit(codegen, "    movd %%eax, %%xmm%d", 15 - k);
+        } else {
+            emit(codegen, "    movd %s, %%xmm%d", variable_operand(codegen, inv->data.identifier, operand, sizeof(operand)),
+                 15 - k);
+        }
+        emit(codegen, "    pshufd $0, %%xmm%d, %%xmm%d", 15 - k, 15 - k);
+    }
+
+    emit(codegen, ".L%d:", vector_label);
+    ASTNode* body = node->data.for_stmt.body;
+    int access = 0;
+    for (ASTNode* s = body->type == AST_BLOCK ? body->left : body; s && s->type == AST_INDEX_ASSIGNMENT; s = s->next) {
+        int reg = vector_expression(&v, s->data.element.value, &access, 0);
+        emit(codegen, "    movdqu %%xmm%d, %s", reg, vector_address(&v, &v.accesses[access++], operand, sizeof(operand)));
+        if (body->type != AST_BLOCK) break;
+    }
+    if (v.failed) {
+        asm_list_truncate(codegen->lines, start);
+        return 0;
+    }
+    emit(codegen, "    addq $%d, %%rcx", VECTOR_WIDTH);
+    emit(codegen, "    cmpq %%rdx, %%rcx");
+    emit(codegen, "    jl .L%d", vector_label);
+    emit(codegen, "    movl %%ecx, %s", variable_operand(codegen, v.var, operand, sizeof(operand)));
+
+    // 标量循环从当前的 i 接着做完剩下的迭代（别名检查不通过时是全部迭代）
+    emit(codegen, ".L%d:", scalar_label);
+    ASTNode* init = node->data.for_stmt.init;
+    int unroll_factor = codegen->unroll_factor;
+    node->data.for_stmt.init = NULL;
+    codegen->vectorize = 0;
+    codegen->unroll_factor = 0;
+    generate_statement(codegen, node);
+    node->data.for_stmt.init = init;
+    codegen->vectorize = 1;
+    codegen->unroll_factor = unroll_factor;
+    codegen->vectorized++;
+    return 1;
+}
+
+// if 分支里唯一的一条赋值语句（单独一条或只有一条语句的块）
+static ASTNode* single_assignment(ASTNode* node) {
+    if (node && node->type == AST_BLOCK && node->left && !node->left->next) node = node->left;
+    return node && node->type == AST_ASSIGNMENT ? node : NULL;
+}
+
+// 可以无条件求值的小表达式：只读局部变量和常量，没有调用、赋值、短路运算，
+// 也没有除法（b != 0 ? a / b : 0 提前求值会陷入）
+static int cheap_value(ASTNode* node, int* budget) {
+    if (!node || --*budget < 0) return 0;
+    switch (node->type) {
+        case AST_LITERAL:
+            return is_number(node);
+        case AST_IDENTIFIER:
+            return 1;
+        case AST_UNARY_OP:
+            return cheap_value(node->data.unary.operand, budget);
+        case AST_BINARY_OP: {
+            const char* op = node->data.binary.operator;
+            if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0 || strcmp(op, "&&") == 0 ||
+                strcmp(op, "||") == 0 || strcmp(op, "=") == 0) return 0;
+            return cheap_value(node->data.binary.left, budget) && cheap_value(node->data.binary.right, budget);
+        }
+        default:
+            return 0;
+    }
+}
+
+// 条件能否只用一次比较算进标志位：没有副作用，也没有需要跳转的 && 和 ||
+static int flag_condition(ASTNode* node) {
+    while (node->type == AST_UNARY_OP && strcmp(node->data.unary.operator, "!") == 0) {
+        node = node->data.unary.operand;
+    }
+    if (is_number(node) || has_side_effects(node, 0)) return 0;
+    if (node->type == AST_BINARY_OP) {
+        const char* op = node->data.binary.operator;
+        if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0) return 0;
+    }
+    return 1;
+}
+
+// 设置标志位，返回条件成立时的条件码
+static const char* generate_flags(CodeGenerator* codegen, ASTNode* node) {
+    if (node->type == AST_UNARY_OP && strcmp(node->data.unary.operator, "!") == 0) {
+        return negate_cc(generate_flags(codegen, node->data.unary.operand));
+    }
+    if (node->type == AST_BINARY_OP) {
+        const char* cc = relational_cc(node->data.binary.operator);
+        if (cc) return generate_compare(codegen, node->data.binary.left, node->data.binary.right, cc);
+    }
+    generate_expression(codegen, node);
+    emit(codegen, "    testl %%eax, %%eax");
+    return "ne";
+}
+
+// 比较只用到立即数和栈槽（generate_compare 的第一种形式），不会改写 %eax
+static int compare_keeps_eax(CodeGenerator* codegen, ASTNode* node) {
+    char buffer[32];
+    while (node->type == AST_UNARY_OP && strcmp(node->data.unary.operator, "!") == 0) {
+        node = node->data.unary.operand;
+    }
+    if (node->type != AST_BINARY_OP || !relational_cc(node->data.binary.operator)) return 0;
+    ASTNode* left = node->data.binary.left;
+    ASTNode* right = node->data.binary.right;
+    if (is_number(left) == is_number(right)) return 0;
+    return simple_operand(codegen, is_number(left) ? right : left, buffer, sizeof(buffer)) != NULL;
+}
+
+// 值放进 cmov 能用的位置：变量直接用栈槽，其余先算进一个临时寄存器
+static const char* cmov_source(CodeGenerator* codegen, ASTNode* value, char* buffer, size_t size) {
+    if (value->type == AST_IDENTIFIER) return variable_operand(codegen, value->data.identifier, buffer, size);
+    generate_expression(codegen, value);
+    snprintf(buffer, size, "%%%s", temp_regs[codegen->temp_depth++]);
+    emit(codegen, "    movl %%eax, %s", buffer);
+    return buffer;
+}
+
+// if 转换：if (c) x = a; else x = b;（或没有 else，此时 b 就是 x）在两个值都便宜且无副作用时，
+// 先把 a、b 算好，比较之后 movl b, %eax + cmovcc a, %eax，去掉难以预测的条件跳转
+static int generate_if_conversion(CodeGenerator* codegen, ASTNode* node) {
+    ASTNode* then_assign = single_assignment(node->data.if_stmt.then_branch);
+    ASTNode* else_assign = single_assignment(node->data.if_stmt.else_branch);
+    if (!then_assign || (node->data.if_stmt.else_branch && !else_assign)) return 0;
+    const char* target = then_assign->data.identifier;
+    if (else_assign && strcmp(else_assign->data.identifier, target) != 0) return 0;
+    if (!flag_condition(node->data.if_stmt.condition)) return 0;
+
+    ASTNode* then_value = then_assign->left;
+    ASTNode* else_value = else_assign ? else_assign->left : NULL;
+    int then_budget = IF_CONVERT_BUDGET;
+    int else_budget = IF_CONVERT_BUDGET;
+    if (!cheap_value(then_value, &then_budget) || (else_value && !cheap_value(else_value, &else_budget))) return 0;
+
+    char then_buffer[32], else_buffer[32], operand[32];
+    const char* else_operand = NULL;
+    // 比较不改写 %eax 时 b 直接算进 %eax，否则 b 也要先放进临时寄存器，比较之后再 movl（不改标志位）
+    int else_first = else_value && compare_keeps_eax(codegen, node->data.if_stmt.condition);
+    int needed = (then_value->type != AST_IDENTIFIER) +
+                 (else_value && !else_first && !is_number(else_value) && else_value->type != AST_IDENTIFIER);
+    if (codegen->temp_depth + needed > NUM_TEMP_REGS) return 0;
+
+    int saved_depth = codegen->temp_depth;
+    const char* then_operand = cmov_source(codegen, then_value, then_buffer, sizeof(then_buffer));
+    if (else_first) {
+        generate_expression(codegen, else_value);
+    } else if (!else_value) {
+        else_operand = variable_operand(codegen, target, else_buffer, sizeof(else_buffer));
+    } else if (!(else_operand = simple_operand(codegen, else_value, else_buffer, sizeof(else_buffer)))) {
+        else_operand = cmov_source(codegen, else_value, else_buffer, sizeof(else_buffer));
+    }
+    const char* cc = generate_flags(codegen, node->data.if_stmt.condition);
+    if (else_operand) emit(codegen, "    movl %s, %%eax", else_operand);
+    emit(codegen, "    cmov%s %s, %%eax", cc, then_operand);
+    emit(codegen, "    movl %%eax, %s", variable_operand(codegen, target, operand, sizeof(operand)));
+    codegen->temp_depth = saved_depth;
+    codegen->if_conversions++;
+    return 1;
+}
+
+// ---- 静态分支预测与代码布局 ----
+
+// 语句的每条路径都以 return 结束
+static int always_returns(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_RETURN:
+            return 1;
+        case AST_BLOCK:
+            for (ASTNode* stmt = node->left; stmt; stmt = stmt->next) {
+                if (always_returns(stmt)) return 1;
+            }
+            return 0;
+        case AST_IF:
+            return always_returns(node->data.if_stmt.then_branch) && always_returns(node->data.if_stmt.else_branch);
+        default:
+            return 0;
+    }
+}
+
+// 与 0 比较的条件按错误检查处理：x == 0、x < 0、x <= 0 预测为假，反过来的比较预测为真。
+// 返回 -1（很可能为假）、1（很可能为真）或 0（没有判断）
+static int predict_zero_compare(ASTNode* node) {
+    if (node->type == AST_UNARY_OP && strcmp(node->data.unary.operator, "!") == 0) {
+        ASTNode* operand = node->data.unary.operand;
+        if (operand->type == AST_BINARY_OP && relational_cc(operand->data.binary.operator)) {
+            return -predict_zero_compare(operand);
+        }
+        return -1;  // !x 就是 x == 0
+    }
+    if (node->type != AST_BINARY_OP) return 0;
+    const char* cc = relational_cc(node->data.binary.operator);
+    if (!cc) return 0;
+    int32_t value;
+    if (int_literal_value(node->data.binary.right, &value) && value == 0) {
+        // 已经是 x op 0
+    } else if (int_literal_value(node->data.binary.left, &value) && value == 0) {
+        cc = swap_cc(cc);
+    } else {
+        return 0;
+    }
+    if (strcmp(cc, "e") == 0 || strcmp(cc, "l") == 0 || strcmp(cc, "le") == 0) return -1;
+    return 1;
+}
+
+// 预测 if 的哪个分支很少执行：1 表示 then，2 表示 else，0 表示不调整。
+// 一定 return 的分支（提前返回、错误处理）预测为不执行；都不返回时再看条件是否是与 0 的比较
+static int predict_cold_branch(ASTNode* node) {
+    ASTNode* then_branch = node->data.if_stmt.then_branch;
+    ASTNode* else_branch = node->data.if_stmt.else_branch;
+    int then_returns = always_returns(then_branch);
+    int else_returns = always_returns(else_branch);
+    if (then_returns != else_returns) return then_returns ? 1 : 2;
+    if (then_returns) return 0;
+    int prediction = predict_zero_compare(node->data.if_stmt.condition);
+    if (prediction < 0) return 1;
+    if (prediction > 0 && else_branch) return 2;
+    return 0;
+}
+
+// 生成 if 的一个分支，then 分支先累加剖析计数
+static void generate_if_branch(CodeGenerator* codegen, ASTNode* node, ASTNode* branch) {
+    if (branch == node->data.if_stmt.then_branch) profile_increment(codegen, node, 1);
+    generate_code(codegen, branch);
+}
+
+// 生成冷分支：.Lcold: 分支代码，然后跳回 if 之后；整段移到函数末尾
+static void generate_cold_block(CodeGenerator* codegen, ASTNode* node, ASTNode* branch, int cold_label, int end_label) {
+    int start = codegen->lines->count;
+    emit(codegen, ".L%d:", cold_label);
+    generate_if_branch(codegen, node, branch);
+    if (!always_returns(branch)) emit(codegen, "    jmp .L%d", end_label);
+    asm_list_take_from(codegen->cold, codegen->lines, start);
+    codegen->cold_blocks++;
+}
+
+// 一个分支预测为很少执行时：条件跳到函数末尾的冷分支，可能执行的分支顺序落下，不用跳转。
+// 有剖析数据时按实测的比例，否则用静态预测
+static int generate_predicted_if(CodeGenerator* codegen, ASTNode* node) {
+    int cold = profile_cold_branch(node);
+    if (cold >= 0) {
+        codegen->profile_decisions++;
+    } else {
+        cold = predict_cold_branch(node);
+    }
+    if (!cold) return 0;
+    int cold_label = get_new_label(codegen);
+    int end_label = get_new_label(codegen);
+    ASTNode* hot_branch = cold == 1 ? node->data.if_stmt.else_branch : node->data.if_stmt.then_branch;
+    ASTNode* cold_branch = cold == 1 ? node->data.if_stmt.then_branch : node->data.if_stmt.else_branch;
+
+    generate_condition(codegen, node->data.if_stmt.condition, cold_label, cold == 1);
+    if (hot_branch) generate_if_branch(codegen, node, hot_branch);
+    emit(codegen, ".L%d:", end_label);
+    generate_cold_block(codegen, node, cold_branch, cold_label, end_label);
+    return 1;
+}
+
+// 循环轮转：先跳到底部的条件，条件成立时跳回循环体。回边预测为跳转，每轮只有一条条件跳转；
+// 循环体入口是热点，按 16 字节对齐（对齐填充在 jmp 之后，不会执行）。剖析数据显示循环体
+// 从未执行过时不对齐
+static void generate_rotated_loop(CodeGenerator* codegen, ASTNode* loop, ASTNode* condition, ASTNode* body,
+                                  ASTNode* update) {
+    int body_label = get_new_label(codegen);
+    int cond_label = get_new_label(codegen);
+    emit(codegen, "    jmp .L%d", cond_label);
+    if (profile_count(loop, 1) != 0) emit(codegen, ".p2align 4");
+    emit(codegen, ".L%d:", body_label);
+    profile_increment(codegen, loop, 1);
+    if (body) generate_code(codegen, body);
+    if (update) generate_expression(codegen, update);
+    emit(codegen, ".L%d:", cond_label);
+    if (condition) {
+        generate_condition(codegen, condition, body_label, 1);
+    } else {
+        emit(codegen, "    jmp .L%d", body_label);
+    }
+    codegen->rotated_loops++;
+}
+
+// switch 的一个 case 标签
+typedef struct {
+    int value;
+    int label;
+} SwitchCase;
+
+static int compare_cases(const void* a, const void* b) {
+    int x = ((const SwitchCase*)a)->value;
+    int y = ((const SwitchCase*)b)->value;
+    return x < y ? -1 : x > y;
+}
+
+// 跳转表：%eax 减去最小值后无符号比较一次就完成了上下界检查，
+// 再从 .rodata 中取出相对表头的 32 位偏移，加上表头地址间接跳转
+static void generate_jump_table(CodeGenerator* codegen, const SwitchCase* cases, int ncases, int default_label) {
+    int table_label = get_new_label(codegen);
+    int min = cases[0].value;
+    int range = (int)((int64_t)cases[ncases - 1].value - min + 1);
+
+    if (min != 0) {
+        emit(codegen, "    subl $%d, %%eax", min);
+    } else {
+        // 清零 %rax 的高 32 位，下面要把它当作 64 位下标
+        emit(codegen, "    movl %%eax, %%eax");
+    }
+    emit(codegen, "    cmpl $%d, %%eax", range - 1);
+    emit(codegen, "    ja .L%d", default_label);
+    emit(codegen, "    leaq .L%d(%%rip), %%rcx", table_label);
+    emit(codegen, "    movslq (%%rcx,%%rax,4), %%rax");
+    emit(codegen, "    addq %%rcx, %%rax");
+    emit(codegen, "    jmp *%%rax");
+
+    emit(codegen, ".section .rodata");
+    emit(codegen, ".p2align 2");
+    emit(codegen, ".L%d:", table_label);
+    int next = 0;
+    for (int i = 0; i < range; i++) {
+        int label = default_label;
+        if (next < ncases && cases[next].value - min == i) label = cases[next++].label;
+        emit(codegen, ".long .L%d-.L%d", label, table_label);
+    }
+    emit(codegen, ".text");
+    codegen->switch_tables++;
+}
+
+// 二分比较树：按中间值比较，相等直接跳到 case，否则只在一半的 case 里继续找
+static void generate_case_tree(CodeGenerator* codegen, const SwitchCase* cases, int ncases, int default_label) {
+    if (ncases <= SWITCH_LINEAR_CASES) {
+        for (int i = 0; i < ncases; i++) {
+            emit(codegen, "    cmpl $%d, %%eax", cases[i].value);
+            emit(codegen, "    je .L%d", cases[i].label);
+        }
+        emit(codegen, "    jmp .L%d", default_label);
+        return;
+    }
+    int mid = ncases / 2;
+    int upper_label = get_new_label(codegen);
+    emit(codegen, "    cmpl $%d, %%eax", cases[mid].value);
+    emit(codegen, "    je .L%d", cases[mid].label);
+    emit(codegen, "    jg .L%d", upper_label);
+    generate_case_tree(codegen, cases, mid, default_label);
+    emit(codegen, ".L%d:", upper_label);
+    generate_case_tree(codegen, cases + mid + 1, ncases - mid - 1, default_label);
+}
+
+// switch：case 足够稠密时用跳转表，否则用二分比较树；之后按原顺序生成语句，
+// case 标签处放标签（没有 break 的 case 自然落到下一个）
+static void generate_switch(CodeGenerator* codegen, ASTNode* node) {
+    ASTNode* body = node->data.switch_stmt.body;
+    int end_label = get_new_label(codegen);
+    int default_label = end_label;
+    int ncases = 0;
+    for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_CASE && !stmt->data.case_label.is_default) ncases++;
+    }
+    SwitchCase* cases = malloc(sizeof(SwitchCase) * (ncases ? ncases : 1));
+    int* labels = malloc(sizeof(int) * (ncases + 1));
+    int index = 0;
+    int nlabels = 0;
+    for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+        if (stmt->type != AST_CASE) continue;
+        int label = get_new_label(codegen);
+        labels[nlabels++] = label;
+        if (stmt->data.case_label.is_default) {
+            default_label = label;
+        } else {
+            cases[index].value = stmt->data.case_label.value;
+            cases[index++].label = label;
+        }
+    }
+    qsort(cases, ncases, sizeof(SwitchCase), compare_cases);
+
+    generate_expression(codegen, node->data.switch_stmt.condition);
+    int64_t range = ncases ? (int64_t)cases[ncases - 1].value - cases[0].value + 1 : 0;
+    if (ncases >= SWITCH_TABLE_MIN_CASES && range <= (int64_t)ncases * SWITCH_TABLE_DENSITY) {
+        generate_jump_table(codegen, cases, ncases, default_label);
+    } else {
+        generate_case_tree(codegen, cases, ncases, default_label);
+        if (ncases) codegen->switch_trees++;
+    }
+
+    int saved_break = codegen->break_label;
+    codegen->break_label = end_label;
+    nlabels = 0;
+    for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+        if (stmt->type == AST_CASE) {
+            emit(codegen, ".L%d:", labels[nlabels++]);
+        } else {
+            generate_code(codegen, stmt);
+        }
+    }
+    codegen->break_label = saved_break;
+    emit(codegen, ".L%d:", end_label);
+    free(cases);
+    free(labels);
+}
+
 // 生成语句代码
 static void generate_statement(CodeGenerator* codegen, ASTNode* node) {
     if (!node) return;
@@ -193,17 +2106,18 @@ static void generate_statement(CodeGenerator* codegen, ASTNode* node) {
             break;
             
         case AST_IF:
+            profile_increment(codegen, node, 0);
+            if (codegen->if_convert && !profile_biased(node) && generate_if_conversion(codegen, node)) break;
+            if (codegen->reorder_blocks && generate_predicted_if(codegen, node)) break;
             {
                 int else_label = get_new_label(codegen);
                 int end_label = get_new_label(codegen);
                 
-                // 生成条件表达式
-                generate_expression(codegen, node->data.if_stmt.condition);
-                emit(codegen, "    cmpl $0, %%eax");
-                emit(codegen, "    je .L%d", else_label);
+                // 条件不成立时跳到 else
+                generate_condition(codegen, node->data.if_stmt.condition, else_label, 0);
                 
                 // 生成then分支
-                generate_code(codegen, node->data.if_stmt.then_branch);
+                generate_if_branch(codegen, node, node->data.if_stmt.then_branch);
                 emit(codegen, "    jmp .L%d", end_label);
                 
                 // else分支
@@ -217,17 +2131,22 @@ static void generate_statement(CodeGenerator* codegen, ASTNode* node) {
             break;
             
         case AST_WHILE:
+            profile_increment(codegen, node, 0);
+            if (codegen->reorder_blocks) {
+                generate_rotated_loop(codegen, node, node->data.while_stmt.condition, node->data.while_stmt.body,
+                                      NULL);
+                break;
+            }
             {
                 int loop_label = get_new_label(codegen);
                 int end_label = get_new_label(codegen);
                 
                 emit(codegen, ".L%d:", loop_label);
-                // 生成条件表达式
-                generate_expression(codegen, node->data.while_stmt.condition);
-                emit(codegen, "    cmpl $0, %%eax");
-                emit(codegen, "    je .L%d", end_label);
+                // 条件不成立时跳出循环
+                generate_condition(codegen, node->data.while_stmt.condition, end_label, 0);
                 
                 // 生成循环体
+                profile_increment(codegen, node, 1);
                 generate_code(codegen, node->data.while_stmt.body);
                 emit(codegen, "    jmp .L%d", loop_label);
                 
@@ -237,24 +2156,45 @@ static void generate_statement(CodeGenerator* codegen, ASTNode* node) {
             
         case AST_FOR:
             {
-                int loop_label = get_new_label(codegen);
-                int end_label = get_new_label(codegen);
-                
+                CountedLoop counted;
+                profile_increment(codegen, node, 0);
+                int is_counted = counted_loop(node, &counted);
+                if (is_counted && codegen->vectorize && generate_vectorized_for(codegen, node, &counted)) break;
+                if (codegen->unroll_factor > 0 && is_counted) {
+                    if (profile_count(node, 0) >= 0) codegen->profile_decisions++;
+                    if (counted.full_unroll && profile_allows_unroll(node, 1)) {
+                        generate_full_unroll(codegen, node, counted.trips);
+                        break;
+                    }
+                    if (codegen->unroll_factor > 1 && counted.size <= UNROLL_BODY_BUDGET &&
+                        profile_allows_unroll(node, codegen->unroll_factor) &&
+                        generate_unrolled_for(codegen, node, &counted)) {
+                        break;
+                    }
+                }
+
                 // 初始化
                 if (node->data.for_stmt.init) {
                     generate_code(codegen, node->data.for_stmt.init);
                 }
+                if (codegen->reorder_blocks) {
+                    generate_rotated_loop(codegen, node, node->data.for_stmt.condition, node->data.for_stmt.body,
+                                          node->data.for_stmt.update);
+                    break;
+                }
+
+                int loop_label = get_new_label(codegen);
+                int end_label = get_new_label(codegen);
                 
                 emit(codegen, ".L%d:", loop_label);
                 
                 // 条件检查
                 if (node->data.for_stmt.condition) {
-                    generate_expression(codegen, node->data.for_stmt.condition);
-                    emit(codegen, "    cmpl $0, %%eax");
-                    emit(codegen, "    je .L%d", end_label);
+                    generate_condition(codegen, node->data.for_stmt.condition, end_label, 0);
                 }
                 
                 // 循环体
+                profile_increment(codegen, node, 1);
                 if (node->data.for_stmt.body) {
                     generate_code(codegen, node->data.for_stmt.body);
                 }
@@ -269,12 +2209,44 @@ static void generate_statement(CodeGenerator* codegen, ASTNode* node) {
             }
             break;
             
+        case AST_SWITCH:
+            generate_switch(codegen, node);
+            break;
+
+        case AST_BREAK:
+            emit(codegen, "    jmp .L%d", codegen->break_label);
+            break;
+
+        case AST_CASE:
+            // 标签由 generate_switch 放置
+            break;
+
         case AST_RETURN:
+            if (codegen->tail_label >= 0 && node->left) {
+                ASTNode* call;
+                ASTNode* other;
+                if (is_self_call(codegen, node->left)) {
+                    generate_tail_call(codegen, node->left);
+                    break;
+                }
+                if (codegen->accumulator_op && accumulator_split(codegen, node->left, &call, &other)) {
+                    // acc = acc op x，再尾调用
+                    char operand[32];
+                    generate_expression(codegen, other);
+                    apply_accumulator(codegen);
+                    emit(codegen, "    movl %%eax, %s",
+                         frame_operand(codegen, codegen->accumulator_offset, operand, sizeof(operand)));
+                    generate_tail_call(codegen, call);
+                    break;
+                }
+            }
             if (node->left) {
                 generate_expression(codegen, node->left);
+                // 累加器变换后，非递归的 return e 返回 acc op e
+                if (codegen->accumulator_op) apply_accumulator(codegen);
             }
-            emit(codegen, "    leave");
-            emit(codegen, "    ret");
+            // 统一经由函数尾声返回（恢复被调用者保存的寄存器）
+            emit(codegen, "    jmp .L%d", codegen->return_label);
             break;
             
         case AST_EXPRESSION:
@@ -293,56 +2265,322 @@ static void generate_declaration(CodeGenerator* codegen, ASTNode* node) {
     
     switch (node->type) {
         case AST_DECLARATION:
-            // 为变量分配栈空间
-            codegen->stack_offset -= 4; // 假设int为4字节
-            add_variable(codegen, node->data.declaration.name, codegen->stack_offset);
+            if (node->data.declaration.array_size) {
+                // 全局数组最后统一放进 .bss；局部数组的区域在函数开始时已经分配
+                if (!codegen->function) {
+                    codegen->global_arrays = realloc(codegen->global_arrays,
+                                                     sizeof(ASTNode*) * (codegen->nglobal_arrays + 1));
+                    codegen->global_arrays[codegen->nglobal_arrays++] = node;
+                    break;
+                }
+                for (int i = 0; i < codegen->narrays; i++) {
+                    if (codegen->arrays[i] != node) continue;
+                    add_variable(codegen, node->data.declaration.name, codegen->array_offsets[i]);
+                    symbol_list->size = node->data.declaration.array_size;
+                }
+                break;
+            }
+            // 为变量分配栈空间（int 为 4 字节）
+            {
+                int offset = allocate_slot(codegen, node->data.declaration.name);
+                add_variable(codegen, node->data.declaration.name, offset);
             
-            // 如果有初始化表达式
-            if (node->data.declaration.initializer) {
-                generate_expression(codegen, node->data.declaration.initializer);
-                emit(codegen, "    movl %%eax, %d(%%rbp)", codegen->stack_offset);
+                // 如果有初始化表达式
+                if (node->data.declaration.initializer) {
+                    char operand[32];
+                    generate_expression(codegen, node->data.declaration.initializer);
+                    emit(codegen, "    movl %%eax, %s",
+                         variable_operand(codegen, node->data.declaration.name, operand, sizeof(operand)));
+                }
             }
             break;
+        default:
+            break;
+    }
+}
+
+// 函数体（包括移到末尾的冷代码）中用到的被调用者保存寄存器
+static int used_callee_saved(AsmList* lines, int start, AsmList* cold, int* regs) {
+    int count = 0;
+    for (int r = 0; r < 5; r++) {
+        int used = 0;
+        for (int i = start; i < lines->count + cold->count && !used; i++) {
+            AsmInsn* insn = i < lines->count ? &lines->items[i] : &cold->items[i - lines->count];
+            if (insn->kind != ASM_INSN) continue;
+            for (int k = 0; k < insn->nops; k++) {
+                if (insn->ops[k].kind != OPND_RAW && asm_operand_uses_reg(&insn->ops[k], callee_saved[r])) {
+                    used = 1;
+                }
+            }
+        }
+        if (used) regs[count++] = callee_saved[r];
+    }
+    return count;
+}
+
+// 函数体中是否有调用（没有调用的叶函数可以省略帧指针）
+static int contains_call(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_CALL:
+                return 1;
+            case AST_BINARY_OP:
+                if (contains_call(node->data.binary.left) || contains_call(node->data.binary.right)) return 1;
+                break;
+            case AST_UNARY_OP:
+                if (contains_call(node->data.unary.operand)) return 1;
+                break;
+            case AST_DECLARATION:
+                if (contains_call(node->data.declaration.initializer)) return 1;
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                if (contains_call(node->data.element.index) || contains_call(node->data.element.value)) return 1;
+                break;
+            case AST_IF:
+                if (contains_call(node->data.if_stmt.condition) ||
+                    contains_call(node->data.if_stmt.then_branch) ||
+                    contains_call(node->data.if_stmt.else_branch)) return 1;
+                break;
+            case AST_WHILE:
+                if (contains_call(node->data.while_stmt.condition) ||
+                    contains_call(node->data.while_stmt.body)) return 1;
+                break;
+            case AST_FOR:
+                if (contains_call(node->data.for_stmt.init) || contains_call(node->data.for_stmt.condition) ||
+                    contains_call(node->data.for_stmt.update) || contains_call(node->data.for_stmt.body)) return 1;
+                break;
+            case AST_SWITCH:
+                if (contains_call(node->data.switch_stmt.condition) ||
+                    contains_call(node->data.switch_stmt.body)) return 1;
+                break;
+            default:
+                if (contains_call(node->left)) return 1;
+                break;
+        }
+    }
+    return 0;
+}
+
+// 寄存器提升：按访问权重从大到小把栈槽分给被调用者保存的寄存器，槽里的变量就一直放在寄存器中。
+// 语言里没有取地址运算，局部变量和参数都不会逃逸，每个槽都可以提升；
+// 共用一个槽的变量活跃区间不相交，也就可以共用一个寄存器
+static void assign_registers(CodeGenerator* codegen) {
+    free(codegen->slot_regs);
+    codegen->slot_regs = NULL;
+    if (!codegen->has_frame || !codegen->promote_locals) return;
+    FrameLayout* frame = &codegen->frame;
+    codegen->slot_regs = malloc(sizeof(int) * (frame->nslots + 1));
+    for (int s = 0; s < frame->nslots; s++) {
+        codegen->slot_regs[s] = REG_NONE;
+    }
+    for (int r = 0; r < 5; r++) {
+        int best = -1;
+        for (int s = 0; s < frame->nslots; s++) {
+            if (codegen->slot_regs[s] != REG_NONE || frame->weights[s] < PROMOTE_MIN_WEIGHT) continue;
+            if (best < 0 || frame->weights[s] > frame->weights[best]) best = s;
+        }
+        if (best < 0) break;
+        codegen->slot_regs[best] = callee_saved[r];
+        codegen->promoted_slots++;
+        if (r == 0) codegen->promoted_functions++;
+    }
+    for (int v = 0; v < frame->count; v++) {
+        if (frame->names[v][0] != '.' && codegen->slot_regs[frame->slots[v]] != REG_NONE) codegen->promoted_vars++;
     }
 }
 
+static int promoted_any(CodeGenerator* codegen) {
+    if (!codegen->slot_regs) return 0;
+    for (int s = 0; s < codegen->frame.nslots; s++) {
+        if (codegen->slot_regs[s] != REG_NONE) return 1;
+    }
+    return 0;
+}
+
 // 生成函数代码
 static void generate_function(CodeGenerator* codegen, ASTNode* node) {
     if (!node || node->type != AST_FUNCTION) return;
-    
-    // 函数标签
-    emit(codegen, ".globl %s", node->data.function.name);
+
+    // 帧布局：按活跃区间给局部变量着色分槽
+    codegen->has_frame = codegen->optimize && frame_layout_function(node, &codegen->frame);
+    if (codegen->has_frame) {
+        codegen->frame_vars += codegen->frame.count;
+        codegen->frame_slots += codegen->frame.nslots;
+    }
+    assign_registers(codegen);
+    // 省略帧指针需要在生成函数体之前就确定帧大小，只对有帧布局的叶函数启用
+    // 插桩时 main 在尾声里调用剖析写出例程，不是叶函数；用到被调用者保存的寄存器时要在帧里保存它们
+    int is_main = strcmp(node->data.function.name, "main") == 0;
+    int profile_dump = codegen->profile_generate && is_main;
+    int function_dump = codegen->instrument_functions && is_main;
+    codegen->omit_frame = codegen->omit_frame_pointer && codegen->has_frame && !profile_dump && !function_dump &&
+                          !promoted_any(codegen) && !contains_call(node->data.function.body);
+    int instrument_index = -1;
+    if (codegen->instrument_functions) {
+        instrument_index = codegen->ninstrumented++;
+        codegen->instrumented = realloc(codegen->instrumented, sizeof(char*) * codegen->ninstrumented);
+        codegen->instrumented[instrument_index] = strdup(node->data.function.name);
+    }
+    int function_start = codegen->lines->count;
+    codegen->function = node;
+    codegen->nparams = 0;
+    for (ASTNode* param = node->data.function.params; param; param = param->next) {
+        if (param->type == AST_DECLARATION) codegen->nparams++;
+    }
+    codegen->param_offsets = calloc(codegen->nparams + 1, sizeof(int));
+
+retry:
+    // 函数标签；IPCP 的克隆（名字带 '.'）只在本翻译单元内调用，不导出，免得与别的目标文件里的克隆重名
+    if (!strchr(node->data.function.name, '.')) emit(codegen, ".globl %s", node->data.function.name);
     emit(codegen, "%s:", node->data.function.name);
     
     // 函数序言
-    emit(codegen, "    pushq %%rbp");
-    emit(codegen, "    movq %%rsp, %%rbp");
+    if (!codegen->omit_frame) {
+        emit(codegen, "    pushq %%rbp");
+        emit(codegen, "    movq %%rsp, %%rbp");
+    }
+    // 栈帧大小要等函数体生成完才知道，subq 和寄存器保存稍后插入这里
+    int prologue_at = codegen->lines->count;
     
-    // 重置栈偏移
-    codegen->stack_offset = 0;
+    // 重置栈偏移和符号表
+    codegen->stack_offset = codegen->has_frame ? -4 * codegen->frame.nslots : 0;
+    if (instrument_index >= 0) {
+        // 入口时间戳与被调用者周期累计值，两个 8 字节槽
+        codegen->stack_offset = (codegen->stack_offset - 16) & ~7;
+        codegen->instrument_offset = codegen->stack_offset;
+    }
+    codegen->narrays = 0;
+    collect_arrays(codegen, node->data.function.body);
+    codegen->frame_size = (-codegen->stack_offset + 7) & ~7;
+    codegen->push_depth = 0;
+    codegen->return_label = get_new_label(codegen);
+    clear_variables();
     
-    // 处理参数
+    // 处理参数：前 6 个从寄存器存入栈槽，其余在调用者栈帧 16(%rbp) 起每 8 字节一个；
+    // 提升到寄存器的参数在这里装进它的寄存器
     if (node->data.function.params) {
-        // 参数处理逻辑
         ASTNode* param = node->data.function.params;
-        int param_offset = 8; // 参数从rbp+8开始
+        int index = 0;
         while (param) {
             if (param->type == AST_DECLARATION) {
-                add_variable(codegen, param->data.declaration.name, param_offset);
-                param_offset += 4;
+                char operand[32];
+                const char* name = param->data.declaration.name;
+                if (index < 6) {
+                    int offset = allocate_slot(codegen, name);
+                    add_variable(codegen, name, offset);
+                    codegen->param_offsets[index] = offset;
+                    emit(codegen, "    movl %%%s, %s", arg_regs32[index],
+                         variable_operand(codegen, name, operand, sizeof(operand)));
+                } else {
+                    add_variable(codegen, name, 16 + (index - 6) * 8);
+                    codegen->param_offsets[index] = 16 + (index - 6) * 8;
+                    int reg = variable_register(codegen, name);
+                    if (reg != REG_NONE) {
+                        emit(codegen, "    movl %s, %%%s",
+                             frame_operand(codegen, codegen->param_offsets[index], operand, sizeof(operand)),
+                             asm_reg_name(reg, 4));
+                    }
+                }
+                index++;
             }
             param = param->next;
         }
     }
     
+    // 调用计数在尾调用的入口标签之前：只统计真正的调用
+    profile_increment(codegen, node, 0);
+    if (instrument_index >= 0) generate_instrument_entry(codegen, instrument_index);
+
+    // 自递归尾调用：参数存好之后放入口标签，尾调用写回参数后跳到这里。
+    // 累加器变换把 return x op f(...) 也变成尾调用，累加器在入口之前初始化为单位元。
+    codegen->tail_label = -1;
+    codegen->accumulator_op = NULL;
+    if (codegen->optimize) {
+        int tail_calls = 0;
+        int ok = 1;
+        const char* op = NULL;
+        scan_returns(codegen, node->data.function.body, &tail_calls, &op, &ok);
+        if (op && ok) {
+            char operand[32];
+            codegen->accumulator_op = op;
+            codegen->accumulator_offset = allocate_slot(codegen, "");
+            emit(codegen, "    movl $%d, %s", strcmp(op, "+") == 0 ? 0 : 1,
+                 frame_operand(codegen, codegen->accumulator_offset, operand, sizeof(operand)));
+        }
+        if (tail_calls || codegen->accumulator_op) {
+            codegen->tail_label = get_new_label(codegen);
+            emit(codegen, ".L%d:", codegen->tail_label);
+        }
+    }
+
     // 生成函数体
     if (node->data.function.body) {
         generate_code(codegen, node->data.function.body);
     }
     
-    // 函数结尾（如果没有显式return）
-    emit(codegen, "    leave");
+    // 被调用者保存寄存器放在局部变量下方（8 字节对齐）
+    int saved[5];
+    int nsaved = used_callee_saved(codegen->lines, prologue_at, codegen->cold, saved);
+    if (nsaved && codegen->omit_frame) {
+        // 省略帧指针时帧大小已经用在了地址里，退回到常规栈帧重新生成
+        asm_list_truncate(codegen->lines, function_start);
+        asm_list_clear(codegen->cold);
+        codegen->omit_frame = 0;
+        goto retry;
+    }
+    int save_base = -((-codegen->stack_offset + 7) & ~7);
+    char line[64];
+    char operand[32];
+    int at = prologue_at;
+    int frame_size;
+    if (codegen->omit_frame) {
+        // 叶函数内没有调用，不需要 16 字节对齐
+        frame_size = codegen->frame_size;
+    } else {
+        // 帧大小按 16 字节对齐，保证调用点 %rsp 对齐
+        frame_size = (-save_base + nsaved * 8 + 15) & ~15;
+    }
+    if (frame_size) {
+        snprintf(line, sizeof(line), "    subq $%d, %%rsp", frame_size);
+        asm_list_insert_line(codegen->lines, at++, line);
+    }
+    for (int i = 0; i < nsaved; i++) {
+        snprintf(line, sizeof(line), "    movq %%%s, %s", asm_reg_name(saved[i], 8),
+                 frame_operand(codegen, save_base - 8 * (i + 1), operand, sizeof(operand)));
+        asm_list_insert_line(codegen->lines, at++, line);
+    }
+    
+    // 函数尾声（没有显式 return 时落到这里）
+    emit(codegen, ".L%d:", codegen->return_label);
+    if (instrument_index >= 0) generate_instrument_exit(codegen, instrument_index);
+    if (profile_dump) emit(codegen, "    call %s", PROFILE_DUMP);
+    if (function_dump) emit(codegen, "    call %s", FUNCTION_DUMP);
+    for (int i = 0; i < nsaved; i++) {
+        emit(codegen, "    movq %s, %%%s",
+             frame_operand(codegen, save_base - 8 * (i + 1), operand, sizeof(operand)),
+             asm_reg_name(saved[i], 8));
+    }
+    if (codegen->omit_frame) {
+        if (frame_size) emit(codegen, "    addq $%d, %%rsp", frame_size);
+    } else {
+        emit(codegen, "    leave");
+    }
     emit(codegen, "    ret");
+    // 冷代码放在 ret 之后，不占用热路径的指令缓存
+    asm_list_take(codegen->lines, codegen->cold);
+
+    if (codegen->has_frame) frame_layout_free(&codegen->frame);
+    codegen->has_frame = 0;
+    free(codegen->slot_regs);
+    codegen->slot_regs = NULL;
+    codegen->omit_frame = 0;
+    free(codegen->param_offsets);
+    codegen->param_offsets = NULL;
+    codegen->function = NULL;
+    codegen->tail_label = -1;
+    codegen->accumulator_op = NULL;
+    flush_lines(codegen);
 }
 
 // 主要的代码生成函数
@@ -384,8 +2622,23 @@ void generate_assembly(CodeGenerator* codegen, ASTNode* ast) {
     
     // 生成代码
     generate_code(codegen, ast);
+    if (codegen->profile_generate) generate_profile_support(codegen);
+    if (codegen->instrument_functions) generate_function_profile_support(codegen);
+    
+    // 全局数组：本文件内的符号，零初始化
+    if (codegen->nglobal_arrays) {
+        emit(codegen, ".section .bss");
+        for (int i = 0; i < codegen->nglobal_arrays; i++) {
+            emit(codegen, ".p2align 4");
+            emit(codegen, "%s:", codegen->global_arrays[i]->data.declaration.name);
+            emit(codegen, "    .zero %d", 4 * codegen->global_arrays[i]->data.declaration.array_size);
+        }
+        emit(codegen, ".section .text");
+    }
     
     // 如果需要，可以添加数据段
     emit(codegen, ".section .data");
     // 这里可以添加字符串字面量等
+
+    flush_lines(codegen);
 }
\ No newline at end of file
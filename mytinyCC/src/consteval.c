@@ -0,0 +1,459 @@
+#include "optimize.h"
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 编译期求值：纯函数（只读写自己的参数和局部变量、不用字符串、只调用纯函数）在实参全是
+// 整数字面量时，由 AST 解释器执行这次调用，把 AST_CALL 换成结果的字面量。
+// 算术与 fold.c 一样经由 ir_fold_binary / ir_fold_unary，运行时会陷入的运算（除零等）不求值；
+// 读未初始化的变量、没有返回值就结束、超出步数或递归深度时同样放弃，调用保持原样。
+
+#define CONSTEVAL_FUEL 1000000          // 每个调用点的解释步数上限
+#define CONSTEVAL_TOTAL_FUEL 10000000   // 整个程序的解释步数上限，防止大量调用点拖慢编译
+#define CONSTEVAL_MAX_DEPTH 256         // 解释器内的调用深度上限
+
+typedef struct {
+    ASTNode* function;
+    int pure;
+} PureFunction;
+
+typedef struct {
+    const char* name;
+    int value;
+    int defined;
+} Binding;
+
+enum { FLOW_NORMAL, FLOW_BREAK, FLOW_RETURN, FLOW_ABORT };
+
+static ASTNode* root;          // 正在处理的 AST_PROGRAM
+static PureFunction* functions;
+static int nfuncs;
+
+// 解释器状态：变量绑定栈，frame 是当前调用的第一个绑定
+static Binding* env;
+static int nenv;
+static int cap_env;
+static int frame;
+static int depth;
+static long fuel;
+static long total_fuel;
+
+static int is_local(ASTNode* function, const char* name) {
+    return node_declares(function->data.function.params, name) || node_declares(function->data.function.body, name);
+}
+
+// node（及其 next 链）只访问 function 的局部变量、只调用当前仍视为纯的函数
+static int pure_code(ASTNode* function, ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_LITERAL:
+                if (node->data.literal.value_type != TOK_NUMBER) return 0;
+                break;
+            case AST_IDENTIFIER:
+                if (!is_local(function, node->data.identifier)) return 0;
+                break;
+            case AST_ASSIGNMENT:
+                if (!is_local(function, node->data.identifier) || !pure_code(function, node->left)) return 0;
+                break;
+            case AST_CALL: {
+                int callee = program_find_function(root, node->data.call.name);
+                if (callee < 0 || !functions[callee].pure) return 0;
+                if (!pure_code(function, node->data.call.args)) return 0;
+                break;
+            }
+            case AST_BINARY_OP:
+                if (!pure_code(function, node->data.binary.left) ||
+                    !pure_code(function, node->data.binary.right)) return 0;
+                break;
+            case AST_UNARY_OP:
+                if (!pure_code(function, node->data.unary.operand)) return 0;
+                break;
+            case AST_DECLARATION:
+                if (node->data.declaration.array_size) return 0;
+                if (!pure_code(function, node->data.declaration.initializer)) return 0;
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                // 数组元素不在解释器的绑定里
+                return 0;
+            case AST_IF:
+                if (!pure_code(function, node->data.if_stmt.condition) ||
+                    !pure_code(function, node->data.if_stmt.then_branch) ||
+                    !pure_code(function, node->data.if_stmt.else_branch)) return 0;
+                break;
+            case AST_WHILE:
+                if (!pure_code(function, node->data.while_stmt.condition) ||
+                    !pure_code(function, node->data.while_stmt.body)) return 0;
+                break;
+            case AST_FOR:
+                if (!pure_code(function, node->data.for_stmt.init) ||
+                    !pure_code(function, node->data.for_stmt.condition) ||
+                    !pure_code(function, node->data.for_stmt.update) ||
+                    !pure_code(function, node->data.for_stmt.body)) return 0;
+                break;
+            case AST_SWITCH:
+                if (!pure_code(function, node->data.switch_stmt.condition) ||
+                    !pure_code(function, node->data.switch_stmt.body)) return 0;
+                break;
+            default:
+                if (!pure_code(function, node->left)) return 0;
+                break;
+        }
+    }
+    return 1;
+}
+
+// 先假定有定义的函数都是纯的，再反复剔除不满足条件的，直到不动点（互相递归的纯函数保留）
+static void find_pure_functions(void) {
+    for (int i = 0; i < nfuncs; i++) functions[i].pure = functions[i].function->data.function.body != NULL;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < nfuncs; i++) {
+            if (!functions[i].pure) continue;
+            if (!pure_code(functions[i].function, functions[i].function->data.function.body)) {
+                functions[i].pure = 0;
+                changed = 1;
+            }
+        }
+    }
+}
+
+static int has_assignment(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+            case AST_INDEX_ASSIGNMENT:
+                return 1;
+            case AST_INDEX:
+                if (has_assignment(node->data.element.index)) return 1;
+                break;
+            case AST_BINARY_OP:
+                if (has_assignment(node->data.binary.left) || has_assignment(node->data.binary.right)) return 1;
+                break;
+            case AST_UNARY_OP:
+                if (has_assignment(node->data.unary.operand)) return 1;
+                break;
+            case AST_CALL:
+                if (has_assignment(node->data.call.args)) return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+// 当前调用内由内向外查找绑定
+static Binding* lookup(const char* name) {
+    for (int i = nenv - 1; i >= frame; i--) {
+        if (strcmp(env[i].name, name) == 0) return &env[i];
+    }
+    return NULL;
+}
+
+static void bind(const char* name, int value, int defined) {
+    if (nenv == cap_env) {
+        cap_env = cap_env ? cap_env * 2 : 64;
+        env = realloc(env, sizeof(Binding) * cap_env);
+    }
+    env[nenv].name = name;
+    env[nenv].value = value;
+    env[nenv].defined = defined;
+    nenv++;
+}
+
+static int exec_stmt(ASTNode* node, int* result);
+static int call_function(ASTNode* call, int* value);
+
+// 求表达式的值，无法在编译期确定时返回 0
+static int eval_expr(ASTNode* node, int* value) {
+    if (!node || --fuel < 0) return 0;
+    switch (node->type) {
+        case AST_LITERAL:
+            return node_is_constant(node, value);
+        case AST_IDENTIFIER: {
+            Binding* binding = lookup(node->data.identifier);
+            if (!binding || !binding->defined) return 0;
+            *value = binding->value;
+            return 1;
+        }
+        case AST_ASSIGNMENT: {
+            if (!eval_expr(node->left, value)) return 0;
+            Binding* binding = lookup(node->data.identifier);
+            if (!binding) return 0;
+            binding->value = *value;
+            binding->defined = 1;
+            return 1;
+        }
+        case AST_BINARY_OP: {
+            const char* op = node->data.binary.operator;
+            int left, right;
+            if (!eval_expr(node->data.binary.left, &left)) return 0;
+            // && 与 || 短路
+            if ((strcmp(op, "&&") == 0 && !left) || (strcmp(op, "||") == 0 && left)) {
+                *value = left != 0;
+                return 1;
+            }
+            if (!eval_expr(node->data.binary.right, &right)) return 0;
+            return ir_fold_binary(op, left, right, value);
+        }
+        case AST_UNARY_OP: {
+            int operand;
+            if (!eval_expr(node->data.unary.operand, &operand)) return 0;
+            return ir_fold_unary(node->data.unary.operator, operand, value);
+        }
+        case AST_CALL:
+            return call_function(node, value);
+        default:
+            return 0;
+    }
+}
+
+// 执行语句链，遇到 break、return 或放弃时停下
+static int exec_list(ASTNode* stmt, int* result) {
+    for (; stmt; stmt = stmt->next) {
+        int flow = exec_stmt(stmt, result);
+        if (flow != FLOW_NORMAL) return flow;
+    }
+    return FLOW_NORMAL;
+}
+
+// 循环体的控制流：break 结束循环，return 与放弃向外传
+static int loop_body(ASTNode* body, int* result, int* done) {
+    int flow = exec_stmt(body, result);
+    if (flow == FLOW_BREAK) {
+        *done = 1;
+        return FLOW_NORMAL;
+    }
+    if (flow != FLOW_NORMAL) *done = 1;
+    return flow;
+}
+
+static int exec_stmt(ASTNode* node, int* result) {
+    if (!node) return FLOW_NORMAL;
+    if (--fuel < 0) return FLOW_ABORT;
+    int value;
+    switch (node->type) {
+        case AST_BLOCK: {
+            int mark = nenv;
+            int flow = exec_list(node->left, result);
+            nenv = mark;
+            return flow;
+        }
+        case AST_DECLARATION:
+            if (!node->data.declaration.initializer) {
+                bind(node->data.declaration.name, 0, 0);
+                return FLOW_NORMAL;
+            }
+            if (!eval_expr(node->data.declaration.initializer, &value)) return FLOW_ABORT;
+            bind(node->data.declaration.name, value, 1);
+            return FLOW_NORMAL;
+        case AST_IF:
+            if (!eval_expr(node->data.if_stmt.condition, &value)) return FLOW_ABORT;
+            return exec_stmt(value ? node->data.if_stmt.then_branch : node->data.if_stmt.else_branch, result);
+        case AST_WHILE: {
+            int done = 0;
+            while (!done) {
+                if (!eval_expr(node->data.while_stmt.condition, &value)) return FLOW_ABORT;
+                if (!value) break;
+                int flow = loop_body(node->data.while_stmt.body, result, &done);
+                if (flow != FLOW_NORMAL) return flow;
+            }
+            return FLOW_NORMAL;
+        }
+        case AST_FOR: {
+            int mark = nenv;
+            int flow = exec_stmt(node->data.for_stmt.init, result);
+            int done = flow != FLOW_NORMAL;
+            while (!done) {
+                if (node->data.for_stmt.condition) {
+                    if (!eval_expr(node->data.for_stmt.condition, &value)) {
+                        flow = FLOW_ABORT;
+                        break;
+                    }
+                    if (!value) break;
+                }
+                flow = loop_body(node->data.for_stmt.body, result, &done);
+                if (done) break;
+                if (node->data.for_stmt.update && !eval_expr(node->data.for_stmt.update, &value)) {
+                    flow = FLOW_ABORT;
+                    break;
+                }
+            }
+            nenv = mark;
+            return flow;
+        }
+        case AST_SWITCH: {
+            // 从匹配的 case（没有则 default）开始顺序执行，直到 break
+            if (!eval_expr(node->data.switch_stmt.condition, &value)) return FLOW_ABORT;
+            ASTNode* start = NULL;
+            for (ASTNode* stmt = node->data.switch_stmt.body->left; stmt; stmt = stmt->next) {
+                if (stmt->type != AST_CASE) continue;
+                if (stmt->data.case_label.is_default) {
+                    if (!start) start = stmt;
+                } else if (stmt->data.case_label.value == value) {
+                    start = stmt;
+                    break;
+                }
+            }
+            int mark = nenv;
+            int flow = exec_list(start, result);
+            nenv = mark;
+            return flow == FLOW_BREAK ? FLOW_NORMAL : flow;
+        }
+        case AST_BREAK:
+            return FLOW_BREAK;
+        case AST_CASE:
+            return FLOW_NORMAL;
+        case AST_RETURN:
+            if (!node->left || !eval_expr(node->left, result)) return FLOW_ABORT;
+            return FLOW_RETURN;
+        default:
+            return eval_expr(node, &value) ? FLOW_NORMAL : FLOW_ABORT;
+    }
+}
+
+// 解释执行一次调用。实参里有赋值时求值顺序由代码生成决定，不求值
+static int call_function(ASTNode* call, int* value) {
+    int callee = program_find_function(root, call->data.call.name);
+    if (callee < 0 || !functions[callee].pure || depth >= CONSTEVAL_MAX_DEPTH) return 0;
+    if (has_assignment(call->data.call.args)) return 0;
+    ASTNode* function = functions[callee].function;
+
+    int nargs = 0, nparams = 0;
+    for (ASTNode* arg = call->data.call.args; arg; arg = arg->next) nargs++;
+    for (ASTNode* param = function->data.function.params; param; param = param->next) nparams++;
+    if (nargs != nparams) return 0;
+
+    int* args = malloc(sizeof(int) * (nargs ? nargs : 1));
+    int i = 0;
+    for (ASTNode* arg = call->data.call.args; arg; arg = arg->next, i++) {
+        if (!eval_expr(arg, &args[i])) {
+            free(args);
+            return 0;
+        }
+    }
+
+    int saved_frame = frame;
+    int mark = nenv;
+    frame = nenv;
+    i = 0;
+    for (ASTNode* param = function->data.function.params; param; param = param->next, i++) {
+        bind(param->data.declaration.name, args[i], 1);
+    }
+    free(args);
+
+    depth++;
+    int flow = exec_stmt(function->data.function.body, value);
+    depth--;
+    nenv = mark;
+    frame = saved_frame;
+    return flow == FLOW_RETURN;
+}
+
+// 实参全是整数字面量的纯函数调用
+static int constant_call(ASTNode* call) {
+    int callee = program_find_function(root, call->data.call.name);
+    if (callee < 0 || !functions[callee].pure) return 0;
+    for (ASTNode* arg = call->data.call.args; arg; arg = arg->next) {
+        if (!node_is_constant(arg, NULL)) return 0;
+    }
+    return 1;
+}
+
+// 自内向外替换：内层调用换成字面量后，外层调用的实参也可能全是常量
+static int fold_calls(ASTNode* node) {
+    int count = 0;
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_CALL: {
+                count += fold_calls(node->data.call.args);
+                if (!constant_call(node) || total_fuel <= 0) break;
+                fuel = total_fuel < CONSTEVAL_FUEL ? total_fuel : CONSTEVAL_FUEL;
+                long start = fuel;
+                nenv = frame = depth = 0;
+                int value;
+                int ok = call_function(node, &value);
+                total_fuel -= start - (fuel > 0 ? fuel : 0);
+                if (ok) {
+                    make_literal_node(node, value);
+                    count++;
+                }
+                break;
+            }
+            case AST_ASSIGNMENT:
+                count += fold_calls(node->left);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                count += fold_calls(node->data.element.index);
+                count += fold_calls(node->data.element.value);
+                break;
+            case AST_BINARY_OP:
+                count += fold_calls(node->data.binary.left);
+                count += fold_calls(node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                count += fold_calls(node->data.unary.operand);
+                break;
+            case AST_DECLARATION:
+                count += fold_calls(node->data.declaration.initializer);
+                break;
+            case AST_IF:
+                count += fold_calls(node->data.if_stmt.condition);
+                count += fold_calls(node->data.if_stmt.then_branch);
+                count += fold_calls(node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                count += fold_calls(node->data.while_stmt.condition);
+                count += fold_calls(node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                count += fold_calls(node->data.for_stmt.init);
+                count += fold_calls(node->data.for_stmt.condition);
+                count += fold_calls(node->data.for_stmt.update);
+                count += fold_calls(node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                count += fold_calls(node->data.switch_stmt.condition);
+                count += fold_calls(node->data.switch_stmt.body);
+                break;
+            default:
+                count += fold_calls(node->left);
+                break;
+        }
+    }
+    return count;
+}
+
+int evaluate_pure_calls(ASTNode* program) {
+    if (!program) return 0;
+
+    root = program;
+    nfuncs = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) nfuncs++;
+    }
+    if (nfuncs == 0) return 0;
+    functions = calloc(nfuncs, sizeof(PureFunction));
+    int i = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) functions[i++].function = node;
+    }
+    find_pure_functions();
+
+    total_fuel = CONSTEVAL_TOTAL_FUEL;
+    int count = 0;
+    for (i = 0; i < nfuncs; i++) {
+        count += fold_calls(functions[i].function->data.function.body);
+    }
+
+    free(env);
+    env = NULL;
+    nenv = cap_env = 0;
+    free(functions);
+    functions = NULL;
+    nfuncs = 0;
+    return count;
+}
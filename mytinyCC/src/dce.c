@@ -0,0 +1,306 @@
+#include "optimize.h"
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 死代码消除：
+//   函数内：块中 return（switch 中还有 break）之后的语句不可达，直接丢弃；没有副作用的表达式语句删除（有副作用的
+//   只留下带副作用的部分）；在 IR 上做活跃性分析，写入后不会再被读取的局部变量赋值（死存储）
+//   去掉写入，只留右侧的求值。几项互相暴露机会，迭代到不再变化。
+//   全程序（--run）：从 main 出发沿调用图（AST_CALL）标记可达函数，删除其余函数。
+//   单独编译（-c/-S）时即使有 main 也不删函数：其中的函数可能被别的目标文件调用。
+
+static DeadCodeStats* stats;
+static int changes;
+
+// ---- 不可达语句与无用表达式 ----
+
+// 语句一定以 return 或 break 离开，不会落到下一条语句
+static int never_falls_through(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_RETURN:
+        case AST_BREAK:
+            return 1;
+        case AST_BLOCK:
+            for (ASTNode* stmt = node->left; stmt; stmt = stmt->next) {
+                if (never_falls_through(stmt)) return 1;
+            }
+            return 0;
+        case AST_IF:
+            return never_falls_through(node->data.if_stmt.then_branch) &&
+                   never_falls_through(node->data.if_stmt.else_branch);
+        default:
+            return 0;
+    }
+}
+
+static int is_expression(ASTNode* node) {
+    switch (node->type) {
+        case AST_BINARY_OP:
+        case AST_UNARY_OP:
+        case AST_IDENTIFIER:
+        case AST_LITERAL:
+        case AST_CALL:
+        case AST_ASSIGNMENT:
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// 值不被使用的表达式：整个没有副作用时返回 1（可删除）；否则剥掉没有副作用的外层运算
+static int strip_unused(ASTNode* node) {
+    if (!node_has_side_effects(node)) return 1;
+    if (node->type == AST_BINARY_OP) {
+        const char* op = node->data.binary.operator;
+        // 短路运算的右侧是否求值取决于左侧，不能拆开
+        if (strcmp(op, "&&") == 0 || strcmp(op, "||") == 0 || strcmp(op, "=") == 0) return 0;
+        ASTNode* keep = NULL;
+        if (!node_has_side_effects(node->data.binary.left)) {
+            keep = node->data.binary.right;
+            node->data.binary.right = NULL;
+        } else if (!node_has_side_effects(node->data.binary.right)) {
+            keep = node->data.binary.left;
+            node->data.binary.left = NULL;
+        }
+        if (!keep) return 0;
+        replace_node(node, keep);
+        changes++;
+        return strip_unused(node);
+    }
+    if (node->type == AST_INDEX) {
+        // 读出的元素没人用，只留下标的求值
+        ASTNode* keep = node->data.element.index;
+        node->data.element.index = NULL;
+        replace_node(node, keep);
+        changes++;
+        return strip_unused(node);
+    }
+    if (node->type == AST_UNARY_OP) {
+        ASTNode* keep = node->data.unary.operand;
+        node->data.unary.operand = NULL;
+        replace_node(node, keep);
+        changes++;
+        return strip_unused(node);
+    }
+    return 0;
+}
+
+static void clean_block(ASTNode** link);
+
+static void clean_statement(ASTNode* node) {
+    switch (node->type) {
+        case AST_BLOCK:
+            clean_block(&node->left);
+            break;
+        case AST_IF:
+            if (node->data.if_stmt.then_branch) clean_statement(node->data.if_stmt.then_branch);
+            if (node->data.if_stmt.else_branch) clean_statement(node->data.if_stmt.else_branch);
+            break;
+        case AST_WHILE:
+            if (node->data.while_stmt.body) clean_statement(node->data.while_stmt.body);
+            break;
+        case AST_FOR:
+            if (node->data.for_stmt.body) clean_statement(node->data.for_stmt.body);
+            break;
+        case AST_SWITCH:
+            clean_statement(node->data.switch_stmt.body);
+            break;
+        default:
+            // if/循环体位置上单独的一条表达式语句：无用时改成空块
+            if (is_expression(node) && strip_unused(node)) {
+                make_empty_block(node);
+                stats->expressions++;
+                changes++;
+            }
+            break;
+    }
+}
+
+// 清理语句链：删掉无用的表达式语句，以及 return/break 之后直到下一个 case 标签的语句（声明除外）
+static void clean_block(ASTNode** link) {
+    while (*link) {
+        ASTNode* stmt = *link;
+        if (is_expression(stmt) && strip_unused(stmt)) {
+            *link = stmt->next;
+            stmt->next = NULL;
+            destroy_node(stmt);
+            stats->expressions++;
+            changes++;
+            continue;
+        }
+        clean_statement(stmt);
+        if (never_falls_through(stmt)) {
+            ASTNode** dead_link = &stmt->next;
+            while (*dead_link && (*dead_link)->type != AST_CASE) {
+                ASTNode* dead = *dead_link;
+                if (dead->type == AST_DECLARATION) {
+                    // 变量的作用域到块尾为止，后面 case 的语句还可能用它：声明保留，只去掉执行不到的初始化
+                    if (dead->data.declaration.initializer) {
+                        destroy_node(dead->data.declaration.initializer);
+                        dead->data.declaration.initializer = NULL;
+                        stats->statements++;
+                        changes++;
+                    }
+                    dead_link = &dead->next;
+                    continue;
+                }
+                *dead_link = dead->next;
+                dead->next = NULL;
+                destroy_node(dead);
+                stats->statements++;
+                changes++;
+            }
+        }
+        link = &stmt->next;
+    }
+}
+
+// ---- 死存储 ----
+
+static void kill_store(ASTNode* node) {
+    if (node->type == AST_ASSIGNMENT) {
+        // x = e 的值就是 e：去掉写入，表达式原样保留（作为语句时再由 clean_block 处理）
+        ASTNode* value = node->left;
+        node->left = NULL;
+        replace_node(node, value);
+    } else if (node->type == AST_DECLARATION) {
+        // 声明本身要保留（后面的赋值还要用到这个变量），只去掉无副作用的初始化
+        if (node_has_side_effects(node->data.declaration.initializer)) return;
+        destroy_node(node->data.declaration.initializer);
+        node->data.declaration.initializer = NULL;
+    } else {
+        return;
+    }
+    stats->stores++;
+    changes++;
+}
+
+static void remove_dead_stores(ASTNode* function) {
+    IRFunction* fn = ir_build_function(function);
+    unsigned char** live_out = ir_liveness(fn);
+    unsigned char* live = malloc(fn->nvars + 1);
+    ASTNode** dead = NULL;
+    int ndead = 0;
+    int cap_dead = 0;
+
+    // 块内从后向前：store 时变量不活跃就是死存储（不可达的块交给 clean_block）
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* block = fn->rpo_order[i];
+        memcpy(live, live_out[block->id], fn->nvars);
+        for (IRInstr* instr = block->last; instr; instr = instr->prev) {
+            if (instr->op == IR_STORE) {
+                if (!live[instr->var] && instr->origin) {
+                    if (ndead == cap_dead) {
+                        cap_dead = cap_dead ? cap_dead * 2 : 8;
+                        dead = realloc(dead, sizeof(ASTNode*) * cap_dead);
+                    }
+                    dead[ndead++] = instr->origin;
+                }
+                live[instr->var] = 0;
+            } else if (instr->op == IR_LOAD) {
+                live[instr->var] = 1;
+            }
+        }
+    }
+    free(live);
+    ir_free_liveness(fn, live_out);
+    ir_free_function(fn);
+
+    for (int i = 0; i < ndead; i++) {
+        kill_store(dead[i]);
+    }
+    free(dead);
+}
+
+// ---- 不可达函数 ----
+
+typedef struct {
+    ASTNode** functions;
+    unsigned char* reachable;
+    int count;
+    int* work;
+    int nwork;
+} CallGraph;
+
+static void mark_function(CallGraph* g, const char* name) {
+    for (int i = 0; i < g->count; i++) {
+        if (!g->reachable[i] && strcmp(g->functions[i]->data.function.name, name) == 0) {
+            g->reachable[i] = 1;
+            g->work[g->nwork++] = i;
+        }
+    }
+}
+
+static void mark_call(ASTNode* call, void* data) {
+    mark_function(data, call->data.call.name);
+}
+
+static void remove_unreachable_functions(ASTNode* program) {
+    CallGraph g;
+    int has_main = 0;
+    g.count = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION) continue;
+        g.count++;
+        if (node->data.function.body && strcmp(node->data.function.name, "main") == 0) has_main = 1;
+    }
+    if (!has_main) return;
+
+    g.functions = malloc(sizeof(ASTNode*) * g.count);
+    g.reachable = calloc(g.count, 1);
+    g.work = malloc(sizeof(int) * g.count);
+    g.nwork = 0;
+    int index = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) g.functions[index++] = node;
+    }
+    mark_function(&g, "main");
+    while (g.nwork > 0) {
+        ASTNode* function = g.functions[g.work[--g.nwork]];
+        node_visit_calls(function->data.function.body, mark_call, &g);
+    }
+
+    ASTNode** link = &program->left;
+    index = 0;
+    while (*link) {
+        ASTNode* node = *link;
+        if (node->type == AST_FUNCTION && !g.reachable[index++]) {
+            *link = node->next;
+            node->next = NULL;
+            if (node->data.function.body) stats->functions++;
+            destroy_node(node);
+            continue;
+        }
+        link = &node->next;
+    }
+    free(g.functions);
+    free(g.reachable);
+    free(g.work);
+}
+
+int eliminate_dead_code(ASTNode* program, int whole_program, DeadCodeStats* result) {
+    DeadCodeStats local;
+    memset(&local, 0, sizeof(local));
+    stats = result ? result : &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!program || program->type != AST_PROGRAM) return 0;
+
+    int total = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION || !node->data.function.body) continue;
+        do {
+            changes = 0;
+            clean_block(&node->data.function.body->left);
+            remove_dead_stores(node);
+            total += changes;
+        } while (changes);
+    }
+    if (whole_program) remove_unreachable_functions(program);
+    total += stats->functions;
+    stats = NULL;
+    return total;
+}
@@ -0,0 +1,206 @@
+#include "x86.h"
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ELF64 可重定位目标文件写出。
+// 文件布局：ELF 头 | 各段内容 | .rela.* | .symtab | .strtab | .shstrtab | 段头表
+// （.note.GNU-stack 为空段，不占文件内容）
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t cap;
+} Buffer;
+
+static void buf_reserve(Buffer* b, size_t extra) {
+    if (b->size + extra <= b->cap) return;
+    while (b->size + extra > b->cap) b->cap = b->cap ? b->cap * 2 : 256;
+    b->data = realloc(b->data, b->cap);
+}
+
+static size_t buf_append(Buffer* b, const void* data, size_t len) {
+    buf_reserve(b, len);
+    size_t at = b->size;
+    if (data) memcpy(b->data + at, data, len);
+    else memset(b->data + at, 0, len);
+    b->size += len;
+    return at;
+}
+
+static void buf_align(Buffer* b, size_t align) {
+    while (b->size % align) buf_append(b, "", 1);
+}
+
+static Elf64_Word add_string(Buffer* strtab, const char* s) {
+    return (Elf64_Word)buf_append(strtab, s, strlen(s) + 1);
+}
+
+typedef struct {
+    Elf64_Shdr headers[16];
+    int count;
+} SectionTable;
+
+static int add_section(SectionTable* table, Buffer* shstrtab, const char* name, Elf64_Word type,
+                       Elf64_Xword flags, Elf64_Xword align) {
+    Elf64_Shdr* sh = &table->headers[table->count];
+    memset(sh, 0, sizeof(*sh));
+    sh->sh_name = add_string(shstrtab, name);
+    sh->sh_type = type;
+    sh->sh_flags = flags;
+    sh->sh_addralign = align;
+    return table->count++;
+}
+
+int elf_write_object(const ObjectFile* obj, FILE* out) {
+    static const Elf64_Xword section_flags[OBJ_SEC_COUNT] = {
+        SHF_ALLOC | SHF_EXECINSTR, SHF_ALLOC | SHF_WRITE, SHF_ALLOC, SHF_ALLOC | SHF_WRITE,
+    };
+    Buffer file = { 0 }, symtab = { 0 }, strtab = { 0 }, shstrtab = { 0 };
+    SectionTable table;
+    int shndx[OBJ_SEC_COUNT] = { 0 };
+    int sec_sym[OBJ_SEC_COUNT] = { 0 };
+    int rela_index[OBJ_SEC_COUNT] = { 0 };
+
+    table.count = 0;
+    add_section(&table, &shstrtab, "", SHT_NULL, 0, 0);
+    add_string(&strtab, "");
+
+    // 与 as 一致：.text/.data/.bss 总是存在，.rodata 只在有内容时输出
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        const ObjSection* sec = &obj->sections[s];
+        if (s == OBJ_SEC_RODATA && sec->size == 0) continue;
+        shndx[s] = add_section(&table, &shstrtab, sec->name,
+                               s == OBJ_SEC_BSS ? SHT_NOBITS : SHT_PROGBITS,
+                               section_flags[s], sec->align > 0 ? sec->align : 1);
+    }
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (!shndx[s] || obj->sections[s].nrelocs == 0) continue;
+        char name[32];
+        snprintf(name, sizeof(name), ".rela%s", obj->sections[s].name);
+        rela_index[s] = add_section(&table, &shstrtab, name, SHT_RELA, SHF_INFO_LINK, 8);
+    }
+    // 空的 .note.GNU-stack 告诉链接器不需要可执行栈
+    add_section(&table, &shstrtab, ".note.GNU-stack", SHT_PROGBITS, 0, 1);
+    int symtab_index = add_section(&table, &shstrtab, ".symtab", SHT_SYMTAB, 0, 8);
+    int strtab_index = add_section(&table, &shstrtab, ".strtab", SHT_STRTAB, 0, 1);
+    int shstrtab_index = add_section(&table, &shstrtab, ".shstrtab", SHT_STRTAB, 0, 1);
+
+    // 符号表：空符号、段符号、局部符号、全局符号（ELF 要求局部在前）
+    int* elf_index = calloc(obj->nsymbols + 1, sizeof(int));
+    Elf64_Sym sym;
+    memset(&sym, 0, sizeof(sym));
+    buf_append(&symtab, &sym, sizeof(sym));
+    int nsyms = 1;
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (!shndx[s]) continue;
+        memset(&sym, 0, sizeof(sym));
+        sym.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+        sym.st_shndx = (Elf64_Section)shndx[s];
+        buf_append(&symtab, &sym, sizeof(sym));
+        sec_sym[s] = nsyms++;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < obj->nsymbols; i++) {
+            const ObjSymbol* os = &obj->symbols[i];
+            if (os->local_label) continue;
+            int global = os->global || os->section < 0;
+            if (global != pass) continue;
+            memset(&sym, 0, sizeof(sym));
+            sym.st_name = add_string(&strtab, os->name);
+            sym.st_info = ELF64_ST_INFO(global ? STB_GLOBAL : STB_LOCAL, STT_NOTYPE);
+            sym.st_shndx = os->section >= 0 ? (Elf64_Section)shndx[os->section] : SHN_UNDEF;
+            sym.st_value = os->section >= 0 ? (Elf64_Addr)os->value : 0;
+            buf_append(&symtab, &sym, sizeof(sym));
+            elf_index[i] = nsyms++;
+        }
+        if (pass == 0) table.headers[symtab_index].sh_info = (Elf64_Word)nsyms;
+    }
+
+    // 段内容
+    Elf64_Ehdr eh;
+    memset(&eh, 0, sizeof(eh));
+    buf_append(&file, &eh, sizeof(eh));
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (!shndx[s]) continue;
+        const ObjSection* sec = &obj->sections[s];
+        Elf64_Shdr* sh = &table.headers[shndx[s]];
+        buf_align(&file, sh->sh_addralign);
+        sh->sh_offset = file.size;
+        sh->sh_size = (Elf64_Xword)sec->size;
+        if (s != OBJ_SEC_BSS) buf_append(&file, sec->data, sec->size);
+    }
+
+    // 重定位：与 as 一样，已定义的局部符号（含不进符号表的 .L 标签）改为相对所在段的段符号
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (!rela_index[s]) continue;
+        const ObjSection* sec = &obj->sections[s];
+        Elf64_Shdr* sh = &table.headers[rela_index[s]];
+        buf_align(&file, 8);
+        sh->sh_offset = file.size;
+        sh->sh_size = sizeof(Elf64_Rela) * sec->nrelocs;
+        sh->sh_entsize = sizeof(Elf64_Rela);
+        sh->sh_link = (Elf64_Word)symtab_index;
+        sh->sh_info = (Elf64_Word)shndx[s];
+        for (int r = 0; r < sec->nrelocs; r++) {
+            const ObjReloc* reloc = &sec->relocs[r];
+            const ObjSymbol* os = &obj->symbols[reloc->symbol];
+            Elf64_Rela rela;
+            long addend = reloc->addend;
+            int index = elf_index[reloc->symbol];
+            if (os->section >= 0 && !os->global) {
+                index = sec_sym[os->section];
+                addend += os->value;
+            }
+            rela.r_offset = (Elf64_Addr)reloc->offset;
+            rela.r_info = ELF64_R_INFO(index, reloc->type);
+            rela.r_addend = addend;
+            buf_append(&file, &rela, sizeof(rela));
+        }
+    }
+
+    Elf64_Shdr* sh = &table.headers[symtab_index];
+    buf_align(&file, 8);
+    sh->sh_offset = file.size;
+    sh->sh_size = symtab.size;
+    sh->sh_entsize = sizeof(Elf64_Sym);
+    sh->sh_link = (Elf64_Word)strtab_index;
+    buf_append(&file, symtab.data, symtab.size);
+
+    sh = &table.headers[strtab_index];
+    sh->sh_offset = file.size;
+    sh->sh_size = strtab.size;
+    buf_append(&file, strtab.data, strtab.size);
+
+    sh = &table.headers[shstrtab_index];
+    sh->sh_offset = file.size;
+    sh->sh_size = shstrtab.size;
+    buf_append(&file, shstrtab.data, shstrtab.size);
+
+    buf_align(&file, 8);
+    size_t shoff = buf_append(&file, table.headers, sizeof(Elf64_Shdr) * table.count);
+
+    // ELF 头
+    memcpy(eh.e_ident, ELFMAG, SELFMAG);
+    eh.e_ident[EI_CLASS] = ELFCLASS64;
+    eh.e_ident[EI_DATA] = ELFDATA2LSB;
+    eh.e_ident[EI_VERSION] = EV_CURRENT;
+    eh.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    eh.e_type = ET_REL;
+    eh.e_machine = EM_X86_64;
+    eh.e_version = EV_CURRENT;
+    eh.e_shoff = shoff;
+    eh.e_ehsize = sizeof(Elf64_Ehdr);
+    eh.e_shentsize = sizeof(Elf64_Shdr);
+    eh.e_shnum = (Elf64_Half)table.count;
+    eh.e_shstrndx = (Elf64_Half)shstrtab_index;
+    memcpy(file.data, &eh, sizeof(eh));
+
+    int ok = fwrite(file.data, 1, file.size, out) == file.size;
+    free(file.data);
+    free(symtab.data);
+    free(strtab.data);
+    free(shstrtab.data);
+    free(elf_index);
+    return ok;
+}
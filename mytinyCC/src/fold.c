@@ -0,0 +1,249 @@
+#include "optimize.h"
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 常量折叠与代数化简：字面量运算直接求值，x+0 / x*1 / x*0 / x-x 等恒等式化简，
+// 常量条件的 if/while/for 只保留活跃的一侧。
+
+static int changes;
+
+static int is_literal(ASTNode* node, int value) {
+    int v;
+    return node_is_constant(node, &v) && v == value;
+}
+
+// 用二元节点的一个子节点替换整个节点
+static void keep_child(ASTNode* node, int keep_left) {
+    ASTNode* child;
+    if (keep_left) {
+        child = node->data.binary.left;
+        node->data.binary.left = NULL;
+    } else {
+        child = node->data.binary.right;
+        node->data.binary.right = NULL;
+    }
+    replace_node(node, child);
+    changes++;
+}
+
+static void fold_literal(ASTNode* node, int value) {
+    make_literal_node(node, value);
+    changes++;
+}
+
+static void fold_expr(ASTNode* node);
+
+static void fold_binary(ASTNode* node) {
+    fold_expr(node->data.binary.left);
+    fold_expr(node->data.binary.right);
+
+    const char* op = node->data.binary.operator;
+    ASTNode* left = node->data.binary.left;
+    ASTNode* right = node->data.binary.right;
+    int a, b, result;
+    int left_const = node_is_constant(left, &a);
+    int right_const = node_is_constant(right, &b);
+
+    if (left_const && right_const) {
+        if (ir_fold_binary(op, a, b, &result)) fold_literal(node, result);
+        return;
+    }
+
+    // 短路运算：左侧为常量时右侧不会被求值（或结果只取决于右侧真假）
+    if (strcmp(op, "&&") == 0 && left_const) {
+        if (!a) fold_literal(node, 0);
+        return;
+    }
+    if (strcmp(op, "||") == 0 && left_const) {
+        if (a) fold_literal(node, 1);
+        return;
+    }
+
+    if (strcmp(op, "+") == 0) {
+        if (is_literal(right, 0)) keep_child(node, 1);
+        else if (is_literal(left, 0)) keep_child(node, 0);
+    } else if (strcmp(op, "-") == 0) {
+        if (is_literal(right, 0)) keep_child(node, 1);
+        else if (!node_has_side_effects(left) && same_expr(left, right)) fold_literal(node, 0);
+    } else if (strcmp(op, "*") == 0) {
+        if (is_literal(right, 1)) keep_child(node, 1);
+        else if (is_literal(left, 1)) keep_child(node, 0);
+        else if ((is_literal(right, 0) && !node_has_side_effects(left)) ||
+                 (is_literal(left, 0) && !node_has_side_effects(right))) fold_literal(node, 0);
+    } else if (strcmp(op, "/") == 0) {
+        if (is_literal(right, 1)) keep_child(node, 1);
+    } else if (strcmp(op, "%") == 0) {
+        if (is_literal(right, 1) && !node_has_side_effects(left)) fold_literal(node, 0);
+    } else if (strcmp(op, "&") == 0) {
+        if ((is_literal(right, 0) && !node_has_side_effects(left)) ||
+            (is_literal(left, 0) && !node_has_side_effects(right))) fold_literal(node, 0);
+        else if (is_literal(right, -1)) keep_child(node, 1);
+        else if (is_literal(left, -1)) keep_child(node, 0);
+    } else if (strcmp(op, "|") == 0 || strcmp(op, "^") == 0) {
+        if (is_literal(right, 0)) keep_child(node, 1);
+        else if (is_literal(left, 0)) keep_child(node, 0);
+        else if (op[0] == '^' && !node_has_side_effects(left) && same_expr(left, right)) {
+            fold_literal(node, 0);
+        }
+    } else if (strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) {
+        if (is_literal(right, 0)) keep_child(node, 1);
+    } else if (strcmp(op, "==") == 0 || strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0) {
+        if (!node_has_side_effects(left) && same_expr(left, right)) fold_literal(node, 1);
+    } else if (strcmp(op, "!=") == 0 || strcmp(op, "<") == 0 || strcmp(op, ">") == 0) {
+        if (!node_has_side_effects(left) && same_expr(left, right)) fold_literal(node, 0);
+    }
+}
+
+// 表达式的 next 链只出现在调用参数中，调用方负责摘开语句间的 next
+static void fold_expr(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_BINARY_OP:
+                fold_binary(node);
+                break;
+
+            case AST_UNARY_OP: {
+                fold_expr(node->data.unary.operand);
+                ASTNode* operand = node->data.unary.operand;
+                int a, result;
+                if (node_is_constant(operand, &a)) {
+                    if (ir_fold_unary(node->data.unary.operator, a, &result)) {
+                        fold_literal(node, result);
+                    }
+                } else if (operand && operand->type == AST_UNARY_OP &&
+                           strcmp(node->data.unary.operator, operand->data.unary.operator) == 0 &&
+                           strcmp(node->data.unary.operator, "!") != 0) {
+                    // - - x => x, ~ ~ x => x
+                    ASTNode* inner = operand->data.unary.operand;
+                    operand->data.unary.operand = NULL;
+                    replace_node(node, inner);
+                    changes++;
+                }
+                break;
+            }
+
+            case AST_ASSIGNMENT:
+                fold_expr(node->left);
+                break;
+
+            case AST_CALL:
+                fold_expr(node->data.call.args);
+                break;
+
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                fold_expr(node->data.element.index);
+                fold_expr(node->data.element.value);
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+// 折叠单个表达式（不沿 next 链处理兄弟语句）
+static void fold_single_expr(ASTNode* node) {
+    if (!node) return;
+    ASTNode* next = node->next;
+    node->next = NULL;
+    fold_expr(node);
+    node->next = next;
+}
+
+static void fold_stmt(ASTNode* node);
+
+static void fold_stmt_list(ASTNode* node) {
+    for (; node; node = node->next) {
+        fold_stmt(node);
+    }
+}
+
+static void fold_stmt(ASTNode* node) {
+    int value;
+    switch (node->type) {
+        case AST_BLOCK:
+            fold_stmt_list(node->left);
+            break;
+
+        case AST_DECLARATION:
+            fold_single_expr(node->data.declaration.initializer);
+            break;
+
+        case AST_IF:
+            fold_single_expr(node->data.if_stmt.condition);
+            if (node_is_constant(node->data.if_stmt.condition, &value)) {
+                ASTNode* live;
+                if (value) {
+                    live = node->data.if_stmt.then_branch;
+                    node->data.if_stmt.then_branch = NULL;
+                } else {
+                    live = node->data.if_stmt.else_branch;
+                    node->data.if_stmt.else_branch = NULL;
+                }
+                if (live) replace_node(node, live);
+                else make_empty_block(node);
+                changes++;
+                fold_stmt(node);
+                break;
+            }
+            if (node->data.if_stmt.then_branch) fold_stmt(node->data.if_stmt.then_branch);
+            if (node->data.if_stmt.else_branch) fold_stmt(node->data.if_stmt.else_branch);
+            break;
+
+        case AST_WHILE:
+            fold_single_expr(node->data.while_stmt.condition);
+            if (node_is_constant(node->data.while_stmt.condition, &value) && !value) {
+                make_empty_block(node);
+                changes++;
+                break;
+            }
+            if (node->data.while_stmt.body) fold_stmt(node->data.while_stmt.body);
+            break;
+
+        case AST_FOR:
+            if (node->data.for_stmt.init) fold_stmt(node->data.for_stmt.init);
+            fold_single_expr(node->data.for_stmt.condition);
+            if (node_is_constant(node->data.for_stmt.condition, &value) && !value) {
+                ASTNode* init = node->data.for_stmt.init;
+                node->data.for_stmt.init = NULL;
+                if (init) replace_node(node, init);
+                else make_empty_block(node);
+                changes++;
+                break;
+            }
+            fold_single_expr(node->data.for_stmt.update);
+            if (node->data.for_stmt.body) fold_stmt(node->data.for_stmt.body);
+            break;
+
+        case AST_SWITCH:
+            fold_single_expr(node->data.switch_stmt.condition);
+            fold_stmt(node->data.switch_stmt.body);
+            break;
+
+        case AST_CASE:
+        case AST_BREAK:
+            break;
+
+        case AST_RETURN:
+            fold_single_expr(node->left);
+            break;
+
+        case AST_FUNCTION:
+            if (node->data.function.body) fold_stmt(node->data.function.body);
+            break;
+
+        default:
+            fold_single_expr(node);
+            break;
+    }
+}
+
+int fold_constants(ASTNode* program) {
+    if (!program) return 0;
+    changes = 0;
+    if (program->type == AST_PROGRAM) fold_stmt_list(program->left);
+    else fold_stmt(program);
+    return changes;
+}
@@ -0,0 +1,232 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 栈帧布局：在（非 SSA 的）IR 上做变量活跃性分析，建立干涉图，
+// 再按变量顺序贪心着色，活跃区间不相交的局部变量共用同一个 4 字节栈槽。
+// 每个槽再记一个访问权重（读写次数，每层循环乘 8），代码生成把权重最大的几个槽放进寄存器。
+
+typedef struct {
+    unsigned char* bits;
+    int n;
+} VarSet;
+
+static VarSet set_new(int n) {
+    VarSet s;
+    s.n = n;
+    s.bits = calloc(n ? n : 1, 1);
+    return s;
+}
+
+static int set_union(VarSet* dst, const VarSet* src) {
+    int changed = 0;
+    for (int i = 0; i < dst->n; i++) {
+        if (src->bits[i] && !dst->bits[i]) {
+            dst->bits[i] = 1;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// 块内从后向前扫描：store 杀死变量，load 使其活跃
+static void block_transfer(IRBlock* block, VarSet* live, unsigned char* interfere, int nvars) {
+    for (IRInstr* instr = block->last; instr; instr = instr->prev) {
+        if (instr->op == IR_STORE) {
+            int v = instr->var;
+            if (interfere) {
+                for (int u = 0; u < nvars; u++) {
+                    if (u != v && live->bits[u]) {
+                        interfere[v * nvars + u] = 1;
+                        interfere[u * nvars + v] = 1;
+                    }
+                }
+            }
+            live->bits[v] = 0;
+        } else if (instr->op == IR_LOAD) {
+            live->bits[instr->var] = 1;
+        }
+    }
+}
+
+// 活跃变量数据流，逆后序的逆序迭代到不动点
+unsigned char** ir_liveness(IRFunction* fn) {
+    int nvars = fn->nvars;
+    VarSet* live_in = malloc(sizeof(VarSet) * (fn->nblocks ? fn->nblocks : 1));
+    VarSet* live_out = malloc(sizeof(VarSet) * (fn->nblocks ? fn->nblocks : 1));
+    for (int b = 0; b < fn->nblocks; b++) {
+        live_in[b] = set_new(nvars);
+        live_out[b] = set_new(nvars);
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = fn->nrpo - 1; i >= 0; i--) {
+            IRBlock* block = fn->rpo_order[i];
+            VarSet* out = &live_out[block->id];
+            for (int s = 0; s < block->nsuccs; s++) {
+                changed |= set_union(out, &live_in[block->succs[s]->id]);
+            }
+            VarSet in = set_new(nvars);
+            memcpy(in.bits, out->bits, nvars);
+            block_transfer(block, &in, NULL, nvars);
+            changed |= set_union(&live_in[block->id], &in);
+            free(in.bits);
+        }
+    }
+
+    unsigned char** result = malloc(sizeof(unsigned char*) * (fn->nblocks ? fn->nblocks : 1));
+    for (int b = 0; b < fn->nblocks; b++) {
+        result[b] = live_out[b].bits;
+        free(live_in[b].bits);
+    }
+    free(live_in);
+    free(live_out);
+    return result;
+}
+
+void ir_free_liveness(IRFunction* fn, unsigned char** live_out) {
+    for (int b = 0; b < fn->nblocks; b++) {
+        free(live_out[b]);
+    }
+    free(live_out);
+}
+
+// 各块所在的循环层数：回边 b -> h（h 支配 b）确定以 h 为头的自然循环，
+// 从 b 沿前驱逆向走到 h 为止经过的块都在循环里
+static int* loop_depths(IRFunction* fn) {
+    int* depth = calloc(fn->nblocks + 1, sizeof(int));
+    unsigned char* in_loop = malloc(fn->nblocks + 1);
+    IRBlock** work = malloc(sizeof(IRBlock*) * (fn->nblocks + 1));
+    ssa_compute_dominators(fn);
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* header = fn->rpo_order[i];
+        memset(in_loop, 0, fn->nblocks + 1);
+        int nwork = 0;
+        for (int p = 0; p < header->npreds; p++) {
+            IRBlock* latch = header->preds[p];
+            if (ssa_dominates(header, latch) && !in_loop[latch->id]) {
+                in_loop[latch->id] = 1;
+                work[nwork++] = latch;
+            }
+        }
+        if (nwork == 0) continue;
+        in_loop[header->id] = 1;
+        while (nwork > 0) {
+            IRBlock* block = work[--nwork];
+            for (int p = 0; p < block->npreds; p++) {
+                IRBlock* pred = block->preds[p];
+                if (pred->rpo >= 0 && !in_loop[pred->id]) {
+                    in_loop[pred->id] = 1;
+                    work[nwork++] = pred;
+                }
+            }
+        }
+        for (int b = 0; b < fn->nblocks; b++) {
+            if (in_loop[b]) depth[b]++;
+        }
+    }
+    free(work);
+    free(in_loop);
+    return depth;
+}
+
+// 槽的访问权重：短路求值的隐藏变量不在栈上，不计
+static void compute_weights(IRFunction* fn, FrameLayout* layout) {
+    int* depth = loop_depths(fn);
+    layout->weights = calloc(layout->nslots + 1, sizeof(int));
+    for (int v = 0; v < fn->nparams; v++) {
+        layout->weights[layout->slots[v]]++;
+    }
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* block = fn->rpo_order[i];
+        int d = depth[block->id] < FRAME_MAX_LOOP_DEPTH ? depth[block->id] : FRAME_MAX_LOOP_DEPTH;
+        for (IRInstr* instr = block->first; instr; instr = instr->next) {
+            if (instr->op != IR_LOAD && instr->op != IR_STORE) continue;
+            if (fn->vars[instr->var][0] == '.') continue;
+            layout->weights[layout->slots[instr->var]] += 1 << (3 * d);
+        }
+    }
+    free(depth);
+}
+
+static void compute_layout(IRFunction* fn, FrameLayout* layout) {
+    int nvars = fn->nvars;
+    unsigned char** live_out = ir_liveness(fn);
+
+    // 干涉图：定值点与当时活跃的变量互相干涉
+    unsigned char* interfere = calloc((size_t)nvars * nvars + 1, 1);
+    VarSet entry = set_new(nvars);
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* block = fn->rpo_order[i];
+        VarSet live = set_new(nvars);
+        memcpy(live.bits, live_out[block->id], nvars);
+        block_transfer(block, &live, interfere, nvars);
+        if (block == fn->entry) memcpy(entry.bits, live.bits, nvars);
+        free(live.bits);
+    }
+    // 入口处同时存在的值：参数（序言中写入）以及在入口活跃（可能未初始化就读取）的变量
+    if (fn->entry) {
+        for (int u = 0; u < nvars; u++) {
+            for (int v = u + 1; v < nvars; v++) {
+                int u_at_entry = u < fn->nparams || entry.bits[u];
+                int v_at_entry = v < fn->nparams || entry.bits[v];
+                if (u_at_entry && v_at_entry) {
+                    interfere[u * nvars + v] = 1;
+                    interfere[v * nvars + u] = 1;
+                }
+            }
+        }
+    }
+
+    // 贪心着色：取第一个与已着色邻居都不冲突的槽
+    layout->count = nvars;
+    layout->names = malloc(sizeof(char*) * (nvars ? nvars : 1));
+    layout->slots = malloc(sizeof(int) * (nvars ? nvars : 1));
+    layout->nslots = 0;
+    unsigned char* taken = calloc(nvars + 1, 1);
+    for (int v = 0; v < nvars; v++) {
+        memset(taken, 0, nvars + 1);
+        for (int u = 0; u < v; u++) {
+            if (interfere[v * nvars + u]) taken[layout->slots[u]] = 1;
+        }
+        int slot = 0;
+        while (taken[slot]) slot++;
+        layout->names[v] = strdup(fn->vars[v]);
+        layout->slots[v] = slot;
+        if (slot + 1 > layout->nslots) layout->nslots = slot + 1;
+    }
+
+    free(taken);
+    free(interfere);
+    free(entry.bits);
+    ir_free_liveness(fn, live_out);
+    compute_weights(fn, layout);
+}
+
+int frame_layout_function(ASTNode* function, FrameLayout* layout) {
+    memset(layout, 0, sizeof(*layout));
+    IRFunction* fn = ir_build_function(function);
+    if (!fn) return 0;
+    compute_layout(fn, layout);
+    ir_free_function(fn);
+    return 1;
+}
+
+int frame_layout_slot(const FrameLayout* layout, const char* name) {
+    for (int i = 0; i < layout->count; i++) {
+        if (strcmp(layout->names[i], name) == 0) return layout->slots[i];
+    }
+    return -1;
+}
+
+void frame_layout_free(FrameLayout* layout) {
+    for (int i = 0; i < layout->count; i++) {
+        free(layout->names[i]);
+    }
+    free(layout->names);
+    free(layout->slots);
+    free(layout->weights);
+    memset(layout, 0, sizeof(*layout));
+}
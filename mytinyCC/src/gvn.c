@@ -0,0 +1,361 @@
+#include "optimize.h"
+#include "ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 全局值编号与公共子表达式消除：在 SSA 上沿支配树先序给每个值编号，运算符与操作数编号都相同的
+// 算术运算算出的是同一个值。被支配的重复计算改为读取支配它的那次计算存下的临时变量：
+//   值编号：常量按值；复制取源值的编号；phi 的参数编号全都相同时取该编号；可交换运算的两个
+//   操作数按编号排序；参数、调用、全局变量与数组元素的读取等各自一个新编号（可能被调用或写元素改写）。
+//   写回 AST：首次计算 e 原地改成 (__gvnN = e)，被支配的重复计算换成 __gvnN，函数开头声明 __gvnN。
+//   只替换最大的重复子表达式，被替换的子树里不再查找。
+// 只处理算术运算：比较留在条件里直接生成 cmp + jcc。有多个实参的调用里的计算不作为首次计算
+// （实参从右到左求值）。
+
+typedef struct {
+    char op[4];
+    int left;               // 操作数的值编号（一元运算 right 为 -1）
+    int right;
+    IRInstr* leader;        // 首次计算
+} ValueEntry;
+
+typedef struct {
+    ASTNode* node;          // 重复计算的表达式节点
+    ASTNode* leader;        // 支配它的首次计算
+} Redundant;
+
+typedef struct {
+    int value;
+    int vn;
+} Constant;
+
+typedef struct {
+    ASTNode* node;
+    int leader;             // Leader 数组下标
+} Use;
+
+typedef struct {
+    ASTNode* node;          // 首次计算的表达式节点
+    char* temp;             // 临时变量名，第一次被替换时才分配
+} Leader;
+
+typedef struct {
+    IRFunction* fn;
+    int* vn;                // 按指令编号
+    int next_vn;
+    ValueEntry* table;      // 作用域栈：进入支配树子树时压入，离开时弹出
+    int ntable;
+    int cap_table;
+    Constant* constants;    // 常量值 -> 值编号（线性查找）
+    int nconstants;
+    int cap_constants;
+
+    Redundant* redundant;
+    int nredundant;
+    int cap_redundant;
+    Leader* leaders;
+    int nleaders;
+    int cap_leaders;
+
+    int in_arguments;       // 改写时所在的多实参调用层数
+    ASTNode* decls;         // 新临时变量的声明
+    Use* uses;              // 待换成临时变量的重复计算（遍历结束后再替换，以免释放仍在表中的节点）
+    int nuses;
+    int cap_uses;
+} GVN;
+
+static int temp_counter;
+
+#define GVN_PUSH(arr, count, cap, item) do {                         \
+        if ((count) >= (cap)) {                                      \
+            (cap) = (cap) ? (cap) * 2 : 16;                          \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap));          \
+        }                                                            \
+        (arr)[(count)++] = (item);                                   \
+    } while (0)
+
+static int is_arithmetic(const char* op) {
+    static const char* ops[] = { "+", "-", "*", "/", "%", "&", "|", "^", "<<", ">>" };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(op, ops[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_commutative(const char* op) {
+    return strcmp(op, "+") == 0 || strcmp(op, "*") == 0 || strcmp(op, "&") == 0 ||
+           strcmp(op, "|") == 0 || strcmp(op, "^") == 0;
+}
+
+static int constant_number(GVN* g, int value) {
+    for (int i = 0; i < g->nconstants; i++) {
+        if (g->constants[i].value == value) return g->constants[i].vn;
+    }
+    Constant c = { value, g->next_vn };
+    GVN_PUSH(g->constants, g->nconstants, g->cap_constants, c);
+    return g->next_vn++;
+}
+
+// 能作为首次计算或被替换的表达式节点：算术运算，或者取负、按位取反
+static int rewritable(ASTNode* node) {
+    if (!node) return 0;
+    if (node->type == AST_BINARY_OP) return is_arithmetic(node->data.binary.operator);
+    if (node->type == AST_UNARY_OP) {
+        return strcmp(node->data.unary.operator, "-") == 0 || strcmp(node->data.unary.operator, "~") == 0;
+    }
+    return 0;
+}
+
+// 算术运算的值编号：作用域内已有相同的 (op, 左, 右) 时记下重复计算
+static int number_operation(GVN* g, IRInstr* instr, int left, int right) {
+    if (right >= 0 && is_commutative(instr->opname) && right < left) {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    for (int i = g->ntable - 1; i >= 0; i--) {
+        ValueEntry* e = &g->table[i];
+        if (e->left != left || e->right != right || strcmp(e->op, instr->opname) != 0) continue;
+        if (rewritable(instr->origin) && rewritable(e->leader->origin)) {
+            Redundant r = { instr->origin, e->leader->origin };
+            GVN_PUSH(g->redundant, g->nredundant, g->cap_redundant, r);
+        }
+        return g->vn[e->leader->id];
+    }
+    // 只有 AST 中的运算才能作为首次计算（短路求值内部生成的运算没有对应节点）
+    if (rewritable(instr->origin)) {
+        ValueEntry e;
+        strcpy(e.op, instr->opname);
+        e.left = left;
+        e.right = right;
+        e.leader = instr;
+        GVN_PUSH(g->table, g->ntable, g->cap_table, e);
+    }
+    return g->next_vn++;
+}
+
+static int value_number(GVN* g, IRInstr* instr) {
+    switch (instr->op) {
+        case IR_CONST:
+            return constant_number(g, instr->imm);
+        case IR_COPY:
+            return instr->args[0] ? g->vn[instr->args[0]->id] : g->next_vn++;
+        case IR_PHI: {
+            // 参数编号全都相同（回边上的参数在此之前还没编号，不会相同）
+            int same = -1;
+            for (int i = 0; i < instr->nargs; i++) {
+                IRInstr* arg = instr->args[i];
+                if (!arg || arg == instr) continue;
+                int v = g->vn[arg->id];
+                if (v < 0 || (same >= 0 && v != same)) return g->next_vn++;
+                same = v;
+            }
+            return same >= 0 ? same : g->next_vn++;
+        }
+        case IR_BINOP:
+            if (!is_arithmetic(instr->opname)) return g->next_vn++;
+            return number_operation(g, instr, g->vn[instr->args[0]->id], g->vn[instr->args[1]->id]);
+        case IR_UNOP:
+            if (strcmp(instr->opname, "-") != 0 && strcmp(instr->opname, "~") != 0) return g->next_vn++;
+            return number_operation(g, instr, g->vn[instr->args[0]->id], -1);
+        default:
+            return g->next_vn++;
+    }
+}
+
+static void number_block(GVN* g, IRBlock* block) {
+    int scope = g->ntable;
+    for (IRInstr* instr = block->first; instr; instr = instr->next) {
+        g->vn[instr->id] = value_number(g, instr);
+    }
+    for (int i = 0; i < block->ndom_children; i++) {
+        number_block(g, block->dom_children[i]);
+    }
+    g->ntable = scope;
+}
+
+// ---- 写回 AST ----
+
+static ASTNode* find_redundant(GVN* g, ASTNode* node) {
+    for (int i = 0; i < g->nredundant; i++) {
+        if (g->redundant[i].node == node) return g->redundant[i].leader;
+    }
+    return NULL;
+}
+
+static int find_leader(GVN* g, ASTNode* node) {
+    for (int i = 0; i < g->nleaders; i++) {
+        if (g->leaders[i].node == node) return i;
+    }
+    return -1;
+}
+
+static int is_leader(GVN* g, ASTNode* node) {
+    for (int i = 0; i < g->nredundant; i++) {
+        if (g->redundant[i].leader == node) return 1;
+    }
+    return 0;
+}
+
+// 首次计算原地改成 (__gvnN = e)：节点地址不变，原来的表达式移到新节点里
+static void save_leader(GVN* g, Leader* leader) {
+    char name[32];
+    snprintf(name, sizeof(name), "__gvn%d", temp_counter++);
+    leader->temp = strdup(name);
+
+    ASTNode* node = leader->node;
+    ASTNode* expr = create_node(node->type);
+    *expr = *node;
+    expr->next = NULL;
+    ASTNode* next = node->next;
+    memset(node, 0, sizeof(*node));
+    node->type = AST_ASSIGNMENT;
+    node->line = expr->line;
+    node->column = expr->column;
+    node->data.identifier = strdup(name);
+    node->left = expr;
+    node->next = next;
+
+    ASTNode* decl = create_node(AST_DECLARATION);
+    decl->line = expr->line;
+    decl->column = expr->column;
+    decl->data.declaration.name = strdup(name);
+    decl->data.declaration.type = COPY_STRING("int");
+    decl->next = g->decls;
+    g->decls = decl;
+}
+
+// for 的更新语句 i = i ± c
+static int induction_step(ASTNode* update) {
+    if (!update || update->type != AST_ASSIGNMENT || !update->left || update->left->type != AST_BINARY_OP) return 0;
+    ASTNode* expr = update->left;
+    const char* op = expr->data.binary.operator;
+    return (strcmp(op, "+") == 0 || strcmp(op, "-") == 0) && expr->data.binary.left->type == AST_IDENTIFIER &&
+           strcmp(expr->data.binary.left->data.identifier, update->data.identifier) == 0 &&
+           expr->data.binary.right->type == AST_LITERAL;
+}
+
+// 按求值顺序（与降级到 IR 的顺序相同）遍历，首次计算总是先于它的重复计算
+static void rewrite(GVN* g, ASTNode* node) {
+    for (; node; node = node->next) {
+        ASTNode* first = find_redundant(g, node);
+        int index = first ? find_leader(g, first) : -1;
+        if (index >= 0) {
+            if (!g->leaders[index].temp) save_leader(g, &g->leaders[index]);
+            Use use = { node, index };
+            GVN_PUSH(g->uses, g->nuses, g->cap_uses, use);
+            continue;
+        }
+        if (rewritable(node) && is_leader(g, node) && !g->in_arguments) {
+            Leader leader = { node, NULL };
+            GVN_PUSH(g->leaders, g->nleaders, g->cap_leaders, leader);
+        }
+        switch (node->type) {
+            case AST_BINARY_OP:
+                rewrite(g, node->data.binary.left);
+                rewrite(g, node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                rewrite(g, node->data.unary.operand);
+                break;
+            case AST_CALL: {
+                // 有多个实参时实参从右到左求值，而栈槽共享按从左到右算活跃区间：
+                // 实参里的赋值可能覆盖左边实参还要读的变量，不在这里存临时变量
+                int multiple = node->data.call.args && node->data.call.args->next;
+                g->in_arguments += multiple;
+                rewrite(g, node->data.call.args);
+                g->in_arguments -= multiple;
+                break;
+            }
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                rewrite(g, node->data.element.index);
+                rewrite(g, node->data.element.value);
+                break;
+            case AST_DECLARATION:
+                rewrite(g, node->data.declaration.initializer);
+                break;
+            case AST_IF:
+                rewrite(g, node->data.if_stmt.condition);
+                rewrite(g, node->data.if_stmt.then_branch);
+                rewrite(g, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                rewrite(g, node->data.while_stmt.condition);
+                rewrite(g, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                rewrite(g, node->data.for_stmt.init);
+                rewrite(g, node->data.for_stmt.condition);
+                rewrite(g, node->data.for_stmt.body);
+                // 更新语句与循环体里的 a[i + 1] 同值，换成临时变量后就不再是计数循环，展开和向量化都认不出来
+                if (!induction_step(node->data.for_stmt.update)) rewrite(g, node->data.for_stmt.update);
+                break;
+            case AST_SWITCH:
+                rewrite(g, node->data.switch_stmt.condition);
+                rewrite(g, node->data.switch_stmt.body);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                rewrite(g, node->left);
+                break;
+        }
+    }
+}
+
+static int gvn_function(ASTNode* function) {
+    IRFunction* fn = ir_build_function(function);
+    ssa_construct(fn);
+
+    GVN g;
+    memset(&g, 0, sizeof(g));
+    g.fn = fn;
+    g.vn = malloc(sizeof(int) * (fn->ninstrs + 1));
+    for (int i = 0; i < fn->ninstrs; i++) {
+        g.vn[i] = -1;
+    }
+    if (fn->nrpo > 0) number_block(&g, fn->entry);
+
+    if (g.nredundant > 0) {
+        ASTNode* body = function->data.function.body;
+        rewrite(&g, body->left);
+        for (int i = 0; i < g.nuses; i++) {
+            ASTNode* use = create_node(AST_IDENTIFIER);
+            use->line = g.uses[i].node->line;
+            use->column = g.uses[i].node->column;
+            use->data.identifier = strdup(g.leaders[g.uses[i].leader].temp);
+            replace_node(g.uses[i].node, use);
+        }
+        if (g.decls) {
+            ASTNode* last = g.decls;
+            while (last->next) last = last->next;
+            last->next = body->left;
+            body->left = g.decls;
+        }
+    }
+
+    for (int i = 0; i < g.nleaders; i++) {
+        free(g.leaders[i].temp);
+    }
+    free(g.leaders);
+    free(g.uses);
+    free(g.redundant);
+    free(g.table);
+    free(g.constants);
+    free(g.vn);
+    ir_free_function(fn);
+    return g.nuses;
+}
+
+int gvn_optimize_program(ASTNode* program) {
+    if (!program || program->type != AST_PROGRAM) return 0;
+    int total = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION || !node->data.function.body) continue;
+        total += gvn_function(node);
+    }
+    return total;
+}
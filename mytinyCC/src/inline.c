@@ -0,0 +1,309 @@
+#include "optimize.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 函数内联：只有一条 return 表达式的小函数（取值、包装一类），在调用点直接展开成
+// 参数代换后的表达式，省掉整套调用、序言和尾声。
+// 按调用图自底向上处理，被调用者先完成自身的内联；处在调用环上的函数（直接或间接递归）不内联。
+
+// 代价模型：函数体的节点数加上因参数多次使用而复制出的实参节点数，不超过预算才内联。
+// 有剖析数据时按被调用者的调用次数：从未调用过的不内联，调用频繁的放宽到 PROFILE_HOT_INLINE_BUDGET
+#define INLINE_BUDGET 24
+
+typedef struct {
+    ASTNode* function;
+    ASTNode* expr;          // 唯一 return 的表达式；不是这种形式时为 NULL
+    int* callees;
+    int ncallees;
+    int cap_callees;
+    int recursive;
+    int done;
+} CallGraphNode;
+
+static ASTNode* root;          // 正在处理的 AST_PROGRAM
+static CallGraphNode* graph;
+static int nfuncs;
+static int changes;
+
+// 调用点记为 caller 的出边
+static void add_callee(ASTNode* call, void* data) {
+    CallGraphNode* caller = data;
+    int callee = program_find_function(root, call->data.call.name);
+    if (callee < 0) return;
+    if (caller->ncallees == caller->cap_callees) {
+        caller->cap_callees = caller->cap_callees ? caller->cap_callees * 2 : 4;
+        caller->callees = realloc(caller->callees, sizeof(int) * caller->cap_callees);
+    }
+    caller->callees[caller->ncallees++] = callee;
+}
+
+// target 是否能从 from 经调用边到达
+static int reaches(int from, int target, unsigned char* seen) {
+    for (int i = 0; i < graph[from].ncallees; i++) {
+        int callee = graph[from].callees[i];
+        if (callee == target) return 1;
+        if (seen[callee]) continue;
+        seen[callee] = 1;
+        if (reaches(callee, target, seen)) return 1;
+    }
+    return 0;
+}
+
+static int expr_size(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_BINARY_OP:
+            return 1 + expr_size(node->data.binary.left) + expr_size(node->data.binary.right);
+        case AST_UNARY_OP:
+            return 1 + expr_size(node->data.unary.operand);
+        case AST_CALL: {
+            int size = 1;
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) size += expr_size(arg);
+            return size;
+        }
+        default:
+            return 1;
+    }
+}
+
+static int param_index(ASTNode* function, const char* name) {
+    int index = 0;
+    for (ASTNode* param = function->data.function.params; param; param = param->next, index++) {
+        if (param->type == AST_DECLARATION && strcmp(param->data.declaration.name, name) == 0) return index;
+    }
+    return -1;
+}
+
+// 表达式只读参数、不含赋值时才能代换展开；顺便统计每个参数的使用次数
+static int substitutable(ASTNode* function, ASTNode* node, int* uses) {
+    if (!node) return 1;
+    switch (node->type) {
+        case AST_LITERAL:
+            return 1;
+        case AST_IDENTIFIER: {
+            int index = param_index(function, node->data.identifier);
+            if (index < 0) return 0;
+            uses[index]++;
+            return 1;
+        }
+        case AST_BINARY_OP:
+            if (strcmp(node->data.binary.operator, "=") == 0) return 0;
+            return substitutable(function, node->data.binary.left, uses) &&
+                   substitutable(function, node->data.binary.right, uses);
+        case AST_UNARY_OP:
+            return substitutable(function, node->data.unary.operand, uses);
+        case AST_CALL:
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) {
+                if (!substitutable(function, arg, uses)) return 0;
+            }
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// 表达式树中是否有 type 类型的节点
+static int contains_node(ASTNode* node, ASTNodeType type) {
+    if (!node) return 0;
+    if (node->type == type) return 1;
+    switch (node->type) {
+        case AST_BINARY_OP:
+            return contains_node(node->data.binary.left, type) || contains_node(node->data.binary.right, type);
+        case AST_UNARY_OP:
+            return contains_node(node->data.unary.operand, type);
+        case AST_ASSIGNMENT:
+            return contains_node(node->left, type);
+        case AST_CALL:
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) {
+                if (contains_node(arg, type)) return 1;
+            }
+            return 0;
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT:
+            return contains_node(node->data.element.index, type) || contains_node(node->data.element.value, type);
+        default:
+            return 0;
+    }
+}
+
+static int count_params(ASTNode* function) {
+    int count = 0;
+    for (ASTNode* param = function->data.function.params; param; param = param->next) count++;
+    return count;
+}
+
+// 函数体形如 { return expr; } 时返回 expr
+static ASTNode* single_return(ASTNode* function) {
+    ASTNode* body = function->data.function.body;
+    if (!body || body->type != AST_BLOCK) return NULL;
+    ASTNode* stmt = body->left;
+    if (!stmt || stmt->next || stmt->type != AST_RETURN || !stmt->left) return NULL;
+    return stmt->left;
+}
+
+// 同时代换全部参数：替换进来的实参不再继续代换
+static void substitute(ASTNode* function, ASTNode* node, ASTNode** args) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_IDENTIFIER: {
+                int index = param_index(function, node->data.identifier);
+                if (index >= 0) replace_node(node, copy_expr(args[index]));
+                break;
+            }
+            case AST_BINARY_OP:
+                substitute(function, node->data.binary.left, args);
+                substitute(function, node->data.binary.right, args);
+                break;
+            case AST_UNARY_OP:
+                substitute(function, node->data.unary.operand, args);
+                break;
+            case AST_CALL:
+                substitute(function, node->data.call.args, args);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// 尝试在调用点 call 展开 callee
+static void try_inline(ASTNode* call, int callee) {
+    CallGraphNode* g = &graph[callee];
+    if (!g->expr || g->recursive) return;
+
+    ASTNode* function = g->function;
+    int nparams = count_params(function);
+    ASTNode* args[64];
+    int nargs = 0;
+    for (ASTNode* arg = call->data.call.args; arg; arg = arg->next) {
+        if (nargs == 64) return;
+        args[nargs++] = arg;
+    }
+    if (nargs != nparams) return;
+
+    int budget = INLINE_BUDGET;
+    long long calls = profile_count(function, 0);
+    if (calls == 0) return;
+    if (calls >= PROFILE_HOT_CALLS) budget = PROFILE_HOT_INLINE_BUDGET;
+
+    int uses[64] = { 0 };
+    if (!substitutable(function, g->expr, uses)) return;
+
+    // 有副作用的实参不内联（会改变求值次数或与函数体内调用的先后）；
+    // 无副作用的复杂实参每多用一次就多复制一份
+    // 读数组元素的实参展开后可能挪到函数体里的调用之后，读到被调用者改写过的全局数组
+    int cost = expr_size(g->expr);
+    int has_call = contains_node(g->expr, AST_CALL);
+    for (int i = 0; i < nargs; i++) {
+        ASTNode* arg = args[i];
+        if (arg->type == AST_LITERAL || arg->type == AST_IDENTIFIER) continue;
+        if (node_has_side_effects(arg)) return;
+        if (has_call && contains_node(arg, AST_INDEX)) return;
+        if (uses[i] > 1) cost += (uses[i] - 1) * expr_size(arg);
+    }
+    if (cost > budget) return;
+
+    ASTNode* expanded = copy_expr(g->expr);
+    substitute(function, expanded, args);
+    replace_node(call, expanded);
+    changes++;
+}
+
+// 在语句/表达式树中展开调用（先处理实参里的调用）
+static void inline_calls(ASTNode* node, int self) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_CALL: {
+                inline_calls(node->data.call.args, self);
+                int callee = program_find_function(root, node->data.call.name);
+                if (callee >= 0 && callee != self) try_inline(node, callee);
+                break;
+            }
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                inline_calls(node->data.element.index, self);
+                inline_calls(node->data.element.value, self);
+                break;
+            case AST_BINARY_OP:
+                inline_calls(node->data.binary.left, self);
+                inline_calls(node->data.binary.right, self);
+                break;
+            case AST_UNARY_OP:
+                inline_calls(node->data.unary.operand, self);
+                break;
+            case AST_DECLARATION:
+                inline_calls(node->data.declaration.initializer, self);
+                break;
+            case AST_IF:
+                inline_calls(node->data.if_stmt.condition, self);
+                inline_calls(node->data.if_stmt.then_branch, self);
+                inline_calls(node->data.if_stmt.else_branch, self);
+                break;
+            case AST_WHILE:
+                inline_calls(node->data.while_stmt.condition, self);
+                inline_calls(node->data.while_stmt.body, self);
+                break;
+            case AST_FOR:
+                inline_calls(node->data.for_stmt.init, self);
+                inline_calls(node->data.for_stmt.condition, self);
+                inline_calls(node->data.for_stmt.update, self);
+                inline_calls(node->data.for_stmt.body, self);
+                break;
+            case AST_SWITCH:
+                inline_calls(node->data.switch_stmt.condition, self);
+                inline_calls(node->data.switch_stmt.body, self);
+                break;
+            default:
+                inline_calls(node->left, self);
+                break;
+        }
+    }
+}
+
+// 调用图后序：先处理被调用者
+static void process(int index) {
+    if (graph[index].done) return;
+    graph[index].done = 1;
+    for (int i = 0; i < graph[index].ncallees; i++) {
+        process(graph[index].callees[i]);
+    }
+    inline_calls(graph[index].function->data.function.body, index);
+}
+
+int inline_functions(ASTNode* program) {
+    if (!program) return 0;
+    root = program;
+    changes = 0;
+    nfuncs = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) nfuncs++;
+    }
+    if (nfuncs == 0) return 0;
+
+    graph = calloc(nfuncs, sizeof(CallGraphNode));
+    int index = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) graph[index++].function = node;
+    }
+    for (int i = 0; i < nfuncs; i++) {
+        node_visit_calls(graph[i].function->data.function.body, add_callee, &graph[i]);
+        graph[i].expr = single_return(graph[i].function);
+    }
+    unsigned char* seen = malloc(nfuncs);
+    for (int i = 0; i < nfuncs; i++) {
+        memset(seen, 0, nfuncs);
+        graph[i].recursive = reaches(i, i, seen);
+    }
+    free(seen);
+
+    for (int i = 0; i < nfuncs; i++) {
+        process(i);
+    }
+
+    for (int i = 0; i < nfuncs; i++) {
+        free(graph[i].callees);
+    }
+    free(graph);
+    graph = NULL;
+    return changes;
+}
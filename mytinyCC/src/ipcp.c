@@ -0,0 +1,607 @@
+#include "optimize.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 过程间常量传播与函数特化，在整个 AST_PROGRAM 的调用图（AST_CALL）上进行。
+//   传播：每个形参取一个格值（未知 / 常量 c / 不定），实参是字面量时取常量，是调用者自己未被改写的形参时
+//   取那个形参的格值（递归调用原样传下去的参数），其余为不定；迭代到不动点。所有调用点都传同一个常量的形参
+//   从函数签名里去掉，改成函数体开头以该常量初始化的局部变量，调用点删去对应实参。
+//   特化：形参只在部分调用点是常量、并且它决定分支或作除数、移位量时，为这组常量克隆一份函数
+//   （f.constprop.N），常量形参同样改成局部变量，调用点改调克隆。
+// 之后的常量折叠、SCCP 与死代码消除在改写后的函数体里完成传播和删除死分支。
+// main 的形参来自运行时；单独编译（-c/-S）时函数可能被别的目标文件调用，不改签名，只做特化（克隆不导出）。
+
+#define IPCP_CLONE_BUDGET 200       // 函数体节点数不超过此值才克隆
+#define IPCP_MAX_CLONES 4           // 每个函数的克隆数上限
+
+enum { LATTICE_TOP, LATTICE_CONST, LATTICE_BOTTOM };
+
+typedef struct {
+    ASTNode* function;
+    int nparams;
+    int* lattice;
+    int* value;
+    int fixed;              // 签名不能改：main、有同名函数、或有实参个数不符的调用点
+    int clones;
+} IpcpFunction;
+
+typedef struct {
+    ASTNode* call;
+    int caller;
+    int callee;
+} CallSite;
+
+typedef struct {
+    int callee;
+    int* mask;              // 按形参下标：是否特化为常量
+    int* value;
+    const char* name;
+} Clone;
+
+static ASTNode* root;          // 正在处理的 AST_PROGRAM
+static IpcpFunction* functions;
+static int nfuncs;
+static CallSite* sites;
+static int nsites;
+static int cap_sites;
+static Clone* clones;
+static int nclones;
+static int cap_clones;
+
+static ASTNode* nth_node(ASTNode* node, int index) {
+    while (node && index-- > 0) node = node->next;
+    return node;
+}
+
+static int count_nodes(ASTNode* node) {
+    int count = 0;
+    for (; node; node = node->next) count++;
+    return count;
+}
+
+// 记下调用有定义的函数的调用点，data 指向调用者的下标
+static void add_site(ASTNode* call, void* data) {
+    int callee = program_find_function(root, call->data.call.name);
+    if (callee < 0 || !functions[callee].function->data.function.body) return;
+    if (nsites == cap_sites) {
+        cap_sites = cap_sites ? cap_sites * 2 : 16;
+        sites = realloc(sites, sizeof(CallSite) * cap_sites);
+    }
+    sites[nsites].call = call;
+    sites[nsites].caller = *(int*)data;
+    sites[nsites].callee = callee;
+    nsites++;
+}
+
+// node（及其 next 链）中是否给 name 赋值
+static int assigns(ASTNode* node, const char* name) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                if (strcmp(node->data.identifier, name) == 0 || assigns(node->left, name)) return 1;
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                if (assigns(node->data.element.index, name) || assigns(node->data.element.value, name)) return 1;
+                break;
+            case AST_BINARY_OP:
+                if (assigns(node->data.binary.left, name) || assigns(node->data.binary.right, name)) return 1;
+                break;
+            case AST_UNARY_OP:
+                if (assigns(node->data.unary.operand, name)) return 1;
+                break;
+            case AST_CALL:
+                if (assigns(node->data.call.args, name)) return 1;
+                break;
+            case AST_DECLARATION:
+                if (assigns(node->data.declaration.initializer, name)) return 1;
+                break;
+            case AST_IF:
+                if (assigns(node->data.if_stmt.condition, name) || assigns(node->data.if_stmt.then_branch, name) ||
+                    assigns(node->data.if_stmt.else_branch, name)) return 1;
+                break;
+            case AST_WHILE:
+                if (assigns(node->data.while_stmt.condition, name) || assigns(node->data.while_stmt.body, name)) return 1;
+                break;
+            case AST_FOR:
+                if (assigns(node->data.for_stmt.init, name) || assigns(node->data.for_stmt.condition, name) ||
+                    assigns(node->data.for_stmt.update, name) || assigns(node->data.for_stmt.body, name)) return 1;
+                break;
+            case AST_SWITCH:
+                if (assigns(node->data.switch_stmt.condition, name) || assigns(node->data.switch_stmt.body, name)) return 1;
+                break;
+            default:
+                if (assigns(node->left, name)) return 1;
+                break;
+        }
+    }
+    return 0;
+}
+
+static int uses(ASTNode* node, const char* name) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_IDENTIFIER:
+                if (strcmp(node->data.identifier, name) == 0) return 1;
+                break;
+            case AST_ASSIGNMENT:
+                if (uses(node->left, name)) return 1;
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                if (uses(node->data.element.index, name) || uses(node->data.element.value, name)) return 1;
+                break;
+            case AST_BINARY_OP:
+                if (uses(node->data.binary.left, name) || uses(node->data.binary.right, name)) return 1;
+                break;
+            case AST_UNARY_OP:
+                if (uses(node->data.unary.operand, name)) return 1;
+                break;
+            case AST_CALL:
+                if (uses(node->data.call.args, name)) return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+// name 是否决定分支、循环、switch，或作为除数、移位量：这些地方的常量让折叠与死分支删除真正起作用
+static int controls(ASTNode* node, const char* name) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                if (controls(node->left, name)) return 1;
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                if (controls(node->data.element.index, name) || controls(node->data.element.value, name)) return 1;
+                break;
+            case AST_BINARY_OP: {
+                const char* op = node->data.binary.operator;
+                if ((strcmp(op, "/") == 0 || strcmp(op, "%") == 0 || strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) &&
+                    uses(node->data.binary.right, name)) return 1;
+                if (controls(node->data.binary.left, name) || controls(node->data.binary.right, name)) return 1;
+                break;
+            }
+            case AST_UNARY_OP:
+                if (controls(node->data.unary.operand, name)) return 1;
+                break;
+            case AST_CALL:
+                if (controls(node->data.call.args, name)) return 1;
+                break;
+            case AST_DECLARATION:
+                if (controls(node->data.declaration.initializer, name)) return 1;
+                break;
+            case AST_IF:
+                if (uses(node->data.if_stmt.condition, name) || controls(node->data.if_stmt.condition, name) ||
+                    controls(node->data.if_stmt.then_branch, name) ||
+                    controls(node->data.if_stmt.else_branch, name)) return 1;
+                break;
+            case AST_WHILE:
+                if (uses(node->data.while_stmt.condition, name) || controls(node->data.while_stmt.condition, name) ||
+                    controls(node->data.while_stmt.body, name)) return 1;
+                break;
+            case AST_FOR:
+                if (uses(node->data.for_stmt.condition, name) || controls(node->data.for_stmt.init, name) ||
+                    controls(node->data.for_stmt.condition, name) || controls(node->data.for_stmt.update, name) ||
+                    controls(node->data.for_stmt.body, name)) return 1;
+                break;
+            case AST_SWITCH:
+                if (uses(node->data.switch_stmt.condition, name) || controls(node->data.switch_stmt.body, name)) return 1;
+                break;
+            default:
+                if (controls(node->left, name)) return 1;
+                break;
+        }
+    }
+    return 0;
+}
+
+static int code_size(ASTNode* node) {
+    int size = 0;
+    for (; node; node = node->next) {
+        size++;
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                size += code_size(node->left);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                size += code_size(node->data.element.index) + code_size(node->data.element.value);
+                break;
+            case AST_BINARY_OP:
+                size += code_size(node->data.binary.left) + code_size(node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                size += code_size(node->data.unary.operand);
+                break;
+            case AST_CALL:
+                size += code_size(node->data.call.args);
+                break;
+            case AST_DECLARATION:
+                size += code_size(node->data.declaration.initializer);
+                break;
+            case AST_IF:
+                size += code_size(node->data.if_stmt.condition) + code_size(node->data.if_stmt.then_branch) +
+                        code_size(node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                size += code_size(node->data.while_stmt.condition) + code_size(node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                size += code_size(node->data.for_stmt.init) + code_size(node->data.for_stmt.condition) +
+                        code_size(node->data.for_stmt.update) + code_size(node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                size += code_size(node->data.switch_stmt.condition) + code_size(node->data.switch_stmt.body);
+                break;
+            default:
+                size += code_size(node->left);
+                break;
+        }
+    }
+    return size;
+}
+
+// 形参 index 在函数体里没有同名局部变量遮蔽、也没有被改写：函数体内的这个名字始终是调用时传入的值
+static int param_unchanged(ASTNode* function, int index) {
+    const char* name = nth_node(function->data.function.params, index)->data.declaration.name;
+    return !node_declares(function->data.function.body, name) && !assigns(function->data.function.body, name);
+}
+
+// 调用者形参的下标：实参是 caller 未改写的形参时原样传递它的值
+static int pass_through(ASTNode* arg, int caller) {
+    if (arg->type != AST_IDENTIFIER) return -1;
+    ASTNode* function = functions[caller].function;
+    int index = 0;
+    for (ASTNode* param = function->data.function.params; param; param = param->next, index++) {
+        if (strcmp(param->data.declaration.name, arg->data.identifier) == 0) {
+            return param_unchanged(function, index) ? index : -1;
+        }
+    }
+    return -1;
+}
+
+static int meet(IpcpFunction* f, int index, int lattice, int value) {
+    if (lattice == LATTICE_TOP || f->lattice[index] == LATTICE_BOTTOM) return 0;
+    if (f->lattice[index] == LATTICE_CONST && (lattice == LATTICE_CONST && f->value[index] == value)) return 0;
+    if (f->lattice[index] == LATTICE_TOP && lattice == LATTICE_CONST) {
+        f->lattice[index] = LATTICE_CONST;
+        f->value[index] = value;
+    } else {
+        f->lattice[index] = LATTICE_BOTTOM;
+    }
+    return 1;
+}
+
+static void solve_lattice(void) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int s = 0; s < nsites; s++) {
+            IpcpFunction* callee = &functions[sites[s].callee];
+            IpcpFunction* caller = &functions[sites[s].caller];
+            int index = 0;
+            for (ASTNode* arg = sites[s].call->data.call.args; arg; arg = arg->next, index++) {
+                int value = 0;
+                int lattice = LATTICE_BOTTOM;
+                int from = pass_through(arg, sites[s].caller);
+                if (node_is_constant(arg, &value)) {
+                    lattice = LATTICE_CONST;
+                } else if (from >= 0) {
+                    lattice = caller->lattice[from];
+                    value = caller->value[from];
+                }
+                changed |= meet(callee, index, lattice, value);
+            }
+        }
+    }
+}
+
+// 删去调用点上 mask 为真的实参（都是字面量或形参名，没有副作用）
+static void remove_args(ASTNode* call, const int* mask) {
+    ASTNode** link = &call->data.call.args;
+    int index = 0;
+    while (*link) {
+        ASTNode* arg = *link;
+        if (mask[index++]) {
+            *link = arg->next;
+            arg->next = NULL;
+            destroy_node(arg);
+        } else {
+            link = &arg->next;
+        }
+    }
+}
+
+// 把 mask 为真的形参移到函数体开头，成为以常量初始化的局部变量
+static void fix_params(ASTNode* function, const int* mask, const int* value) {
+    ASTNode** link = &function->data.function.params;
+    ASTNode* body = function->data.function.body;
+    int index = 0;
+    while (*link) {
+        ASTNode* param = *link;
+        if (mask[index]) {
+            *link = param->next;
+            ASTNode* literal = create_node(AST_LITERAL);
+            literal->line = param->line;
+            literal->column = param->column;
+            make_literal_node(literal, value[index]);
+            param->data.declaration.initializer = literal;
+            param->next = body->left;
+            body->left = param;
+        } else {
+            link = &param->next;
+        }
+        index++;
+    }
+}
+
+// 所有调用点都传同一常量的形参改为局部常量，返回改写的形参数
+static int propagate(void) {
+    int count = 0;
+    for (int i = 0; i < nfuncs; i++) {
+        IpcpFunction* f = &functions[i];
+        if (f->fixed) continue;
+        int* mask = calloc(f->nparams + 1, sizeof(int));
+        int any = 0;
+        for (int p = 0; p < f->nparams; p++) {
+            mask[p] = f->lattice[p] == LATTICE_CONST;
+            any += mask[p];
+        }
+        if (any) {
+            for (int s = 0; s < nsites; s++) {
+                if (sites[s].callee == i) remove_args(sites[s].call, mask);
+            }
+            fix_params(f->function, mask, f->value);
+            f->nparams -= any;
+            count += any;
+        }
+        free(mask);
+    }
+    return count;
+}
+
+static int same_clone(Clone* clone, int callee, const int* mask, const int* value) {
+    if (clone->callee != callee) return 0;
+    for (int p = 0; p < functions[callee].nparams; p++) {
+        if (clone->mask[p] != mask[p] || (mask[p] && clone->value[p] != value[p])) return 0;
+    }
+    return 1;
+}
+
+// 克隆体内对原函数的递归调用：特化的位置上传的仍是同一常量（字面量或未改写的同名形参）时改调克隆
+static void redirect_recursion(ASTNode* node, ASTNode* original, Clone* clone) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_CALL: {
+                redirect_recursion(node->data.call.args, original, clone);
+                if (strcmp(node->data.call.name, original->data.function.name) != 0) break;
+                int nparams = count_nodes(original->data.function.params);
+                if (count_nodes(node->data.call.args) != nparams) break;
+                int same = 1;
+                int index = 0;
+                for (ASTNode* arg = node->data.call.args; arg && same; arg = arg->next, index++) {
+                    if (!clone->mask[index]) continue;
+                    int value;
+                    ASTNode* param = nth_node(original->data.function.params, index);
+                    if (node_is_constant(arg, &value)) {
+                        same = value == clone->value[index];
+                    } else {
+                        same = arg->type == AST_IDENTIFIER &&
+                               strcmp(arg->data.identifier, param->data.declaration.name) == 0 &&
+                               param_unchanged(original, index);
+                    }
+                }
+                if (!same) break;
+                free(node->data.call.name);
+                node->data.call.name = strdup(clone->name);
+                remove_args(node, clone->mask);
+                break;
+            }
+            case AST_ASSIGNMENT:
+                redirect_recursion(node->left, original, clone);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                redirect_recursion(node->data.element.index, original, clone);
+                redirect_recursion(node->data.element.value, original, clone);
+                break;
+            case AST_BINARY_OP:
+                redirect_recursion(node->data.binary.left, original, clone);
+                redirect_recursion(node->data.binary.right, original, clone);
+                break;
+            case AST_UNARY_OP:
+                redirect_recursion(node->data.unary.operand, original, clone);
+                break;
+            case AST_DECLARATION:
+                redirect_recursion(node->data.declaration.initializer, original, clone);
+                break;
+            case AST_IF:
+                redirect_recursion(node->data.if_stmt.condition, original, clone);
+                redirect_recursion(node->data.if_stmt.then_branch, original, clone);
+                redirect_recursion(node->data.if_stmt.else_branch, original, clone);
+                break;
+            case AST_WHILE:
+                redirect_recursion(node->data.while_stmt.condition, original, clone);
+                redirect_recursion(node->data.while_stmt.body, original, clone);
+                break;
+            case AST_FOR:
+                redirect_recursion(node->data.for_stmt.init, original, clone);
+                redirect_recursion(node->data.for_stmt.condition, original, clone);
+                redirect_recursion(node->data.for_stmt.update, original, clone);
+                redirect_recursion(node->data.for_stmt.body, original, clone);
+                break;
+            case AST_SWITCH:
+                redirect_recursion(node->data.switch_stmt.condition, original, clone);
+                redirect_recursion(node->data.switch_stmt.body, original, clone);
+                break;
+            default:
+                redirect_recursion(node->left, original, clone);
+                break;
+        }
+    }
+}
+
+static Clone* make_clone(int callee, const int* mask, const int* value) {
+    IpcpFunction* f = &functions[callee];
+    ASTNode* original = f->function;
+    char name[256];
+    snprintf(name, sizeof(name), "%s.constprop.%d", original->data.function.name, f->clones++);
+
+    if (nclones == cap_clones) {
+        cap_clones = cap_clones ? cap_clones * 2 : 8;
+        clones = realloc(clones, sizeof(Clone) * cap_clones);
+    }
+    Clone* clone = &clones[nclones++];
+    clone->callee = callee;
+    clone->mask = malloc(sizeof(int) * (f->nparams + 1));
+    clone->value = malloc(sizeof(int) * (f->nparams + 1));
+    memcpy(clone->mask, mask, sizeof(int) * f->nparams);
+    memcpy(clone->value, value, sizeof(int) * f->nparams);
+
+    ASTNode* next = original->next;
+    original->next = NULL;
+    ASTNode* copy = copy_node(original);
+    original->next = next;
+    free(copy->data.function.name);
+    copy->data.function.name = strdup(name);
+    clone->name = copy->data.function.name;
+
+    redirect_recursion(copy->data.function.body, original, clone);
+    fix_params(copy, mask, value);
+    copy->next = original->next;
+    original->next = copy;
+    return clone;
+}
+
+// 调用点的常量实参里值得特化的那些（决定控制流或作除数、移位量），返回个数
+static int specializable(CallSite* site, int* mask, int* value) {
+    ASTNode* function = functions[site->callee].function;
+    int count = 0;
+    int index = 0;
+    ASTNode* param = function->data.function.params;
+    for (ASTNode* arg = site->call->data.call.args; arg; arg = arg->next, param = param->next, index++) {
+        mask[index] = node_is_constant(arg, &value[index]) &&
+                      !node_declares(function->data.function.body, param->data.declaration.name) &&
+                      controls(function->data.function.body, param->data.declaration.name);
+        count += mask[index];
+    }
+    return count;
+}
+
+static int specialize(void) {
+    int count = 0;
+    for (int s = 0; s < nsites; s++) {
+        IpcpFunction* f = &functions[sites[s].callee];
+        if (f->fixed || f->nparams == 0) continue;
+        if (count_nodes(sites[s].call->data.call.args) != f->nparams) continue;
+        if (code_size(f->function->data.function.body) > IPCP_CLONE_BUDGET) continue;
+
+        int* mask = calloc(f->nparams, sizeof(int));
+        int* value = calloc(f->nparams, sizeof(int));
+        if (specializable(&sites[s], mask, value)) {
+            Clone* clone = NULL;
+            for (int c = 0; c < nclones && !clone; c++) {
+                if (same_clone(&clones[c], sites[s].callee, mask, value)) clone = &clones[c];
+            }
+            if (!clone && f->clones < IPCP_MAX_CLONES) {
+                clone = make_clone(sites[s].callee, mask, value);
+                count++;
+            }
+            if (clone) {
+                ASTNode* call = sites[s].call;
+                free(call->data.call.name);
+                call->data.call.name = strdup(clone->name);
+                remove_args(call, clone->mask);
+            }
+        }
+        free(mask);
+        free(value);
+    }
+    return count;
+}
+
+int ipcp_optimize_program(ASTNode* program, int whole_program, int clone, int* specialized) {
+    *specialized = 0;
+    if (!program) return 0;
+
+    root = program;
+    nfuncs = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type == AST_FUNCTION) nfuncs++;
+    }
+    if (nfuncs == 0) return 0;
+    functions = calloc(nfuncs, sizeof(IpcpFunction));
+    int i = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION) continue;
+        IpcpFunction* f = &functions[i++];
+        f->function = node;
+        f->nparams = count_nodes(node->data.function.params);
+        f->lattice = calloc(f->nparams + 1, sizeof(int));
+        f->value = calloc(f->nparams + 1, sizeof(int));
+    }
+
+    for (i = 0; i < nfuncs; i++) {
+        IpcpFunction* f = &functions[i];
+        ASTNode* function = f->function;
+        if (!function->data.function.body || strcmp(function->data.function.name, "main") == 0) f->fixed = 1;
+        for (int j = 0; j < nfuncs; j++) {
+            if (j != i && strcmp(functions[j].function->data.function.name, function->data.function.name) == 0) {
+                f->fixed = 1;
+            }
+        }
+        for (ASTNode* param = function->data.function.params; param; param = param->next) {
+            if (param->type != AST_DECLARATION) f->fixed = 1;
+        }
+    }
+    for (i = 0; i < nfuncs; i++) {
+        ASTNode* body = functions[i].function->data.function.body;
+        if (body) node_visit_calls(body, add_site, &i);
+    }
+    for (int s = 0; s < nsites; s++) {
+        if (count_nodes(sites[s].call->data.call.args) != functions[sites[s].callee].nparams) {
+            functions[sites[s].callee].fixed = 1;
+        }
+    }
+
+    // 签名不能改的函数、以及可能被外部调用的函数，形参一律不定；被遮蔽的形参不传播
+    for (i = 0; i < nfuncs; i++) {
+        IpcpFunction* f = &functions[i];
+        for (int p = 0; p < f->nparams; p++) {
+            if (f->fixed || !whole_program) {
+                f->lattice[p] = LATTICE_BOTTOM;
+            } else if (node_declares(f->function->data.function.body,
+                                     nth_node(f->function->data.function.params, p)->data.declaration.name)) {
+                f->lattice[p] = LATTICE_BOTTOM;
+            }
+        }
+    }
+
+    solve_lattice();
+    int count = propagate();
+    if (clone) *specialized = specialize();
+
+    for (i = 0; i < nfuncs; i++) {
+        free(functions[i].lattice);
+        free(functions[i].value);
+    }
+    free(functions);
+    functions = NULL;
+    nfuncs = 0;
+    free(sites);
+    sites = NULL;
+    nsites = cap_sites = 0;
+    for (int c = 0; c < nclones; c++) {
+        free(clones[c].mask);
+        free(clones[c].value);
+    }
+    free(clones);
+    clones = NULL;
+    nclones = cap_clones = 0;
+    return count;
+}
@@ -0,0 +1,690 @@
+#include "ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 降级时的构建状态
+typedef struct {
+    IRFunction* fn;
+    IRBlock* current;
+    int temp_count;
+    IRBlock* break_target;  // 最内层 switch 的出口
+} IRBuilder;
+
+// 动态数组追加
+#define IR_PUSH(arr, count, cap, item) do {                          \
+        if ((count) >= (cap)) {                                      \
+            (cap) = (cap) ? (cap) * 2 : 4;                           \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap));          \
+        }                                                            \
+        (arr)[(count)++] = (item);                                   \
+    } while (0)
+
+static IRBlock* new_block(IRFunction* fn, ASTNode* origin) {
+    IRBlock* block = calloc(1, sizeof(IRBlock));
+    block->id = fn->nblocks;
+    block->rpo = -1;
+    block->origin = origin;
+    IR_PUSH(fn->blocks, fn->nblocks, fn->cap_blocks, block);
+    return block;
+}
+
+IRInstr* ir_new_instr(IRFunction* fn, IROpcode op) {
+    IRInstr* instr = calloc(1, sizeof(IRInstr));
+    instr->op = op;
+    instr->var = -1;
+    instr->id = fn->ninstrs;
+    IR_PUSH(fn->instrs, fn->ninstrs, fn->cap_instrs, instr);
+    return instr;
+}
+
+static void set_args(IRInstr* instr, int nargs) {
+    free(instr->args);
+    instr->nargs = nargs;
+    instr->args = nargs ? calloc(nargs, sizeof(IRInstr*)) : NULL;
+}
+
+void ir_append(IRBlock* block, IRInstr* instr) {
+    instr->block = block;
+    instr->next = NULL;
+    instr->prev = block->last;
+    if (block->last) {
+        block->last->next = instr;
+    } else {
+        block->first = instr;
+    }
+    block->last = instr;
+}
+
+void ir_insert_before(IRInstr* pos, IRInstr* instr) {
+    IRBlock* block = pos->block;
+    instr->block = block;
+    instr->next = pos;
+    instr->prev = pos->prev;
+    if (pos->prev) {
+        pos->prev->next = instr;
+    } else {
+        block->first = instr;
+    }
+    pos->prev = instr;
+}
+
+// 只从块中摘除，指令本身在 ir_free_function() 中统一释放
+void ir_remove(IRInstr* instr) {
+    IRBlock* block = instr->block;
+    if (!block) return;
+    if (instr->prev) instr->prev->next = instr->next;
+    else block->first = instr->next;
+    if (instr->next) instr->next->prev = instr->prev;
+    else block->last = instr->prev;
+    instr->prev = instr->next = NULL;
+    instr->block = NULL;
+    instr->op = IR_NOP;
+}
+
+int ir_is_terminator(IRInstr* instr) {
+    return instr && (instr->op == IR_JUMP || instr->op == IR_BRANCH || instr->op == IR_RETURN);
+}
+
+int ir_fold_binary(const char* op, int a, int b, int* result) {
+    unsigned int ua = (unsigned int)a;
+    unsigned int ub = (unsigned int)b;
+
+    if (strcmp(op, "+") == 0) *result = (int)(ua + ub);
+    else if (strcmp(op, "-") == 0) *result = (int)(ua - ub);
+    else if (strcmp(op, "*") == 0) *result = (int)(ua * ub);
+    else if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+        if (b == 0 || (a == -2147483647 - 1 && b == -1)) return 0;
+        *result = op[0] == '/' ? a / b : a % b;
+    }
+    else if (strcmp(op, "&") == 0) *result = a & b;
+    else if (strcmp(op, "|") == 0) *result = a | b;
+    else if (strcmp(op, "^") == 0) *result = a ^ b;
+    else if (strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) {
+        if (b < 0 || b > 31) return 0;
+        *result = op[0] == '<' ? (int)(ua << b) : a >> b;
+    }
+    else if (strcmp(op, "<") == 0) *result = a < b;
+    else if (strcmp(op, "<=") == 0) *result = a <= b;
+    else if (strcmp(op, ">") == 0) *result = a > b;
+    else if (strcmp(op, ">=") == 0) *result = a >= b;
+    else if (strcmp(op, "==") == 0) *result = a == b;
+    else if (strcmp(op, "!=") == 0) *result = a != b;
+    else if (strcmp(op, "&&") == 0) *result = a && b;
+    else if (strcmp(op, "||") == 0) *result = a || b;
+    else return 0;
+    return 1;
+}
+
+int ir_fold_unary(const char* op, int a, int* result) {
+    if (strcmp(op, "-") == 0) *result = (int)(0u - (unsigned int)a);
+    else if (strcmp(op, "~") == 0) *result = ~a;
+    else if (strcmp(op, "!") == 0) *result = !a;
+    else return 0;
+    return 1;
+}
+
+int ir_var_index(IRFunction* fn, const char* name) {
+    for (int i = 0; i < fn->nvars; i++) {
+        if (strcmp(fn->vars[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static int add_var(IRFunction* fn, const char* name) {
+    int index = ir_var_index(fn, name);
+    if (index >= 0) return index;
+    IR_PUSH(fn->vars, fn->nvars, fn->cap_vars, strdup(name));
+    return fn->nvars - 1;
+}
+
+// 收集函数内声明的局部变量（变量按函数作用域处理）
+static void collect_locals(IRFunction* fn, ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_DECLARATION:
+                // 数组不是标量变量：元素读写都是不透明的内存访问
+                if (!node->data.declaration.array_size) add_var(fn, node->data.declaration.name);
+                break;
+            case AST_BLOCK:
+                collect_locals(fn, node->left);
+                break;
+            case AST_IF:
+                collect_locals(fn, node->data.if_stmt.then_branch);
+                collect_locals(fn, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                collect_locals(fn, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                collect_locals(fn, node->data.for_stmt.init);
+                collect_locals(fn, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                collect_locals(fn, node->data.switch_stmt.body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static IRInstr* emit_instr(IRBuilder* b, IROpcode op, ASTNode* origin) {
+    IRInstr* instr = ir_new_instr(b->fn, op);
+    instr->origin = origin;
+    ir_append(b->current, instr);
+    return instr;
+}
+
+static IRInstr* emit_const(IRBuilder* b, int value) {
+    IRInstr* instr = emit_instr(b, IR_CONST, NULL);
+    instr->imm = value;
+    return instr;
+}
+
+// origin 为产生写入的赋值或声明节点（短路求值的临时变量为 NULL）
+static void emit_store(IRBuilder* b, int var, IRInstr* value, ASTNode* origin) {
+    IRInstr* store = emit_instr(b, IR_STORE, origin);
+    store->var = var;
+    set_args(store, 1);
+    store->args[0] = value;
+}
+
+// 结束当前块并跳转到 target（当前块已终结时不重复生成）
+static void jump_to(IRBuilder* b, IRBlock* target) {
+    if (!ir_is_terminator(b->current->last)) {
+        IRInstr* jump = emit_instr(b, IR_JUMP, NULL);
+        jump->targets[0] = target;
+    }
+}
+
+static void emit_branch(IRBuilder* b, IRInstr* cond, IRBlock* if_true, IRBlock* if_false,
+                        ASTNode* origin) {
+    IRInstr* branch = emit_instr(b, IR_BRANCH, origin);
+    set_args(branch, 1);
+    branch->args[0] = cond;
+    branch->targets[0] = if_true;
+    branch->targets[1] = if_false;
+}
+
+static IRInstr* lower_expr(IRBuilder* b, ASTNode* node);
+static void lower_stmt(IRBuilder* b, ASTNode* node);
+
+// a && b / a || b：用隐藏变量合并两条路径的结果
+static IRInstr* lower_logical(IRBuilder* b, ASTNode* node) {
+    int is_and = node->data.binary.operator[0] == '&';
+    char name[32];
+    snprintf(name, sizeof(name), ".sc%d", b->temp_count++);
+    int tmp = add_var(b->fn, name);
+
+    IRBlock* rhs = new_block(b->fn, NULL);
+    IRBlock* shortcut = new_block(b->fn, NULL);
+    IRBlock* join = new_block(b->fn, NULL);
+
+    IRInstr* left = lower_expr(b, node->data.binary.left);
+    if (is_and) emit_branch(b, left, rhs, shortcut, NULL);
+    else emit_branch(b, left, shortcut, rhs, NULL);
+
+    b->current = rhs;
+    IRInstr* right = lower_expr(b, node->data.binary.right);
+    IRInstr* zero = emit_const(b, 0);
+    IRInstr* test = emit_instr(b, IR_BINOP, NULL);
+    strcpy(test->opname, "!=");
+    set_args(test, 2);
+    test->args[0] = right;
+    test->args[1] = zero;
+    emit_store(b, tmp, test, NULL);
+    jump_to(b, join);
+
+    b->current = shortcut;
+    emit_store(b, tmp, emit_const(b, is_and ? 0 : 1), NULL);
+    jump_to(b, join);
+
+    b->current = join;
+    IRInstr* load = emit_instr(b, IR_LOAD, node);
+    load->var = tmp;
+    return load;
+}
+
+static IRInstr* lower_expr(IRBuilder* b, ASTNode* node) {
+    if (!node) return emit_const(b, 0);
+
+    switch (node->type) {
+        case AST_LITERAL:
+            if (node->data.literal.value_type == TOK_NUMBER) {
+                IRInstr* c = emit_const(b, (int)strtol(node->data.literal.value, NULL, 0));
+                c->origin = node;
+                return c;
+            }
+            return emit_instr(b, IR_UNDEF, NULL);
+
+        case AST_IDENTIFIER: {
+            int var = ir_var_index(b->fn, node->data.identifier);
+            if (var >= 0) {
+                IRInstr* load = emit_instr(b, IR_LOAD, node);
+                load->var = var;
+                return load;
+            }
+            IRInstr* load = emit_instr(b, IR_LOAD_GLOBAL, node);
+            load->name = strdup(node->data.identifier);
+            return load;
+        }
+
+        case AST_ASSIGNMENT: {
+            IRInstr* value = lower_expr(b, node->left);
+            int var = ir_var_index(b->fn, node->data.identifier);
+            if (var >= 0) {
+                emit_store(b, var, value, node);
+            } else {
+                IRInstr* store = emit_instr(b, IR_STORE_GLOBAL, NULL);
+                store->name = strdup(node->data.identifier);
+                set_args(store, 1);
+                store->args[0] = value;
+            }
+            return value;
+        }
+
+        case AST_BINARY_OP: {
+            if (strcmp(node->data.binary.operator, "&&") == 0 ||
+                strcmp(node->data.binary.operator, "||") == 0) {
+                return lower_logical(b, node);
+            }
+            IRInstr* left = lower_expr(b, node->data.binary.left);
+            IRInstr* right = lower_expr(b, node->data.binary.right);
+            IRInstr* instr = emit_instr(b, IR_BINOP, node);
+            strncpy(instr->opname, node->data.binary.operator, sizeof(instr->opname) - 1);
+            set_args(instr, 2);
+            instr->args[0] = left;
+            instr->args[1] = right;
+            return instr;
+        }
+
+        case AST_UNARY_OP: {
+            IRInstr* operand = lower_expr(b, node->data.unary.operand);
+            IRInstr* instr = emit_instr(b, IR_UNOP, node);
+            strncpy(instr->opname, node->data.unary.operator, sizeof(instr->opname) - 1);
+            set_args(instr, 1);
+            instr->args[0] = operand;
+            return instr;
+        }
+
+        case AST_INDEX: {
+            IRInstr* index = lower_expr(b, node->data.element.index);
+            IRInstr* load = emit_instr(b, IR_LOAD_ELEMENT, node);
+            load->name = strdup(node->data.element.name);
+            set_args(load, 1);
+            load->args[0] = index;
+            return load;
+        }
+
+        case AST_INDEX_ASSIGNMENT: {
+            // 先求下标再求值，与代码生成的顺序一致
+            IRInstr* index = lower_expr(b, node->data.element.index);
+            IRInstr* value = lower_expr(b, node->data.element.value);
+            IRInstr* store = emit_instr(b, IR_STORE_ELEMENT, NULL);
+            store->name = strdup(node->data.element.name);
+            set_args(store, 2);
+            store->args[0] = index;
+            store->args[1] = value;
+            return value;
+        }
+
+        case AST_CALL: {
+            int nargs = 0;
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) nargs++;
+            IRInstr** values = nargs ? malloc(sizeof(IRInstr*) * nargs) : NULL;
+            int i = 0;
+            for (ASTNode* arg = node->data.call.args; arg; arg = arg->next) {
+                values[i++] = lower_expr(b, arg);
+            }
+            IRInstr* call = emit_instr(b, IR_CALL, node);
+            call->name = strdup(node->data.call.name);
+            call->nargs = nargs;
+            call->args = values;
+            return call;
+        }
+
+        default:
+            return emit_const(b, 0);
+    }
+}
+
+static void lower_stmt(IRBuilder* b, ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case AST_BLOCK:
+            for (ASTNode* stmt = node->left; stmt; stmt = stmt->next) {
+                lower_stmt(b, stmt);
+            }
+            break;
+
+        case AST_DECLARATION:
+            if (node->data.declaration.initializer) {
+                IRInstr* value = lower_expr(b, node->data.declaration.initializer);
+                emit_store(b, ir_var_index(b->fn, node->data.declaration.name), value, node);
+            }
+            break;
+
+        case AST_IF: {
+            IRBlock* then_block = new_block(b->fn, node);
+            IRBlock* else_block = node->data.if_stmt.else_branch ? new_block(b->fn, node) : NULL;
+            IRBlock* join = new_block(b->fn, NULL);
+
+            IRInstr* cond = lower_expr(b, node->data.if_stmt.condition);
+            emit_branch(b, cond, then_block, else_block ? else_block : join, node);
+
+            b->current = then_block;
+            lower_stmt(b, node->data.if_stmt.then_branch);
+            jump_to(b, join);
+
+            if (else_block) {
+                b->current = else_block;
+                lower_stmt(b, node->data.if_stmt.else_branch);
+                jump_to(b, join);
+            }
+            b->current = join;
+            break;
+        }
+
+        case AST_WHILE: {
+            IRBlock* header = new_block(b->fn, node);
+            IRBlock* body = new_block(b->fn, NULL);
+            IRBlock* exit = new_block(b->fn, NULL);
+
+            jump_to(b, header);
+            b->current = header;
+            IRInstr* cond = lower_expr(b, node->data.while_stmt.condition);
+            emit_branch(b, cond, body, exit, node);
+
+            b->current = body;
+            lower_stmt(b, node->data.while_stmt.body);
+            jump_to(b, header);
+            b->current = exit;
+            break;
+        }
+
+        case AST_FOR: {
+            lower_stmt(b, node->data.for_stmt.init);
+
+            IRBlock* header = new_block(b->fn, node);
+            IRBlock* body = new_block(b->fn, NULL);
+            IRBlock* exit = new_block(b->fn, NULL);
+
+            jump_to(b, header);
+            b->current = header;
+            if (node->data.for_stmt.condition) {
+                IRInstr* cond = lower_expr(b, node->data.for_stmt.condition);
+                emit_branch(b, cond, body, exit, node);
+            } else {
+                jump_to(b, body);
+            }
+
+            b->current = body;
+            lower_stmt(b, node->data.for_stmt.body);
+            lower_expr(b, node->data.for_stmt.update);
+            jump_to(b, header);
+            b->current = exit;
+            break;
+        }
+
+        case AST_SWITCH: {
+            // 分派降级为逐个比较的分支链（跳转表与判定树是代码生成的选择）；
+            // 每个 case 标签开始一个新块，前一段没有 break 时顺序落入
+            ASTNode* body = node->data.switch_stmt.body;
+            int nlabels = 0;
+            for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+                if (stmt->type == AST_CASE) nlabels++;
+            }
+            IRBlock** labels = malloc(sizeof(IRBlock*) * (nlabels ? nlabels : 1));
+            IRBlock* exit = new_block(b->fn, NULL);
+            IRBlock* fallback = exit;
+
+            IRInstr* value = lower_expr(b, node->data.switch_stmt.condition);
+            int i = 0;
+            for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+                if (stmt->type != AST_CASE) continue;
+                labels[i] = new_block(b->fn, NULL);
+                if (stmt->data.case_label.is_default) {
+                    fallback = labels[i++];
+                    continue;
+                }
+                IRInstr* constant = emit_const(b, stmt->data.case_label.value);
+                IRInstr* test = emit_instr(b, IR_BINOP, NULL);
+                strcpy(test->opname, "==");
+                set_args(test, 2);
+                test->args[0] = value;
+                test->args[1] = constant;
+                IRBlock* next = new_block(b->fn, NULL);
+                emit_branch(b, test, labels[i++], next, NULL);
+                b->current = next;
+            }
+            jump_to(b, fallback);
+
+            // 第一个标签之前的语句不可达
+            IRBlock* saved_break = b->break_target;
+            b->break_target = exit;
+            b->current = new_block(b->fn, NULL);
+            i = 0;
+            for (ASTNode* stmt = body->left; stmt; stmt = stmt->next) {
+                if (stmt->type == AST_CASE) {
+                    jump_to(b, labels[i]);
+                    b->current = labels[i++];
+                } else {
+                    lower_stmt(b, stmt);
+                }
+            }
+            jump_to(b, exit);
+            b->break_target = saved_break;
+            b->current = exit;
+            free(labels);
+            break;
+        }
+
+        case AST_BREAK:
+            if (b->break_target) jump_to(b, b->break_target);
+            b->current = new_block(b->fn, NULL);
+            break;
+
+        case AST_CASE:
+            break;
+
+        case AST_RETURN: {
+            if (node->left) {
+                IRInstr* value = lower_expr(b, node->left);
+                IRInstr* ret = emit_instr(b, IR_RETURN, node);
+                set_args(ret, 1);
+                ret->args[0] = value;
+            } else {
+                emit_instr(b, IR_RETURN, node);
+            }
+            // return 之后的语句放进一个不可达块
+            b->current = new_block(b->fn, NULL);
+            break;
+        }
+
+        default:
+            lower_expr(b, node);
+            break;
+    }
+}
+
+// 将 AST_FUNCTION 降级为 CFG（尚未进入 SSA）
+IRFunction* ir_build_function(ASTNode* function) {
+    if (!function || function->type != AST_FUNCTION) return NULL;
+
+    IRFunction* fn = calloc(1, sizeof(IRFunction));
+    fn->name = strdup(function->data.function.name);
+    fn->ast = function;
+
+    for (ASTNode* param = function->data.function.params; param; param = param->next) {
+        if (param->type == AST_DECLARATION) {
+            add_var(fn, param->data.declaration.name);
+        }
+    }
+    fn->nparams = fn->nvars;
+    collect_locals(fn, function->data.function.body);
+
+    IRBuilder b = { fn, NULL, 0, NULL };
+    fn->entry = new_block(fn, function);
+    b.current = fn->entry;
+    lower_stmt(&b, function->data.function.body);
+    if (!ir_is_terminator(b.current->last)) {
+        emit_instr(&b, IR_RETURN, NULL);
+    }
+    // 补齐所有悬空块的终结指令
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        if (!ir_is_terminator(block->last)) {
+            b.current = block;
+            emit_instr(&b, IR_RETURN, NULL);
+        }
+    }
+
+    ir_compute_cfg(fn);
+    return fn;
+}
+
+static void rpo_visit(IRFunction* fn, IRBlock* block, char* visited, IRBlock** post, int* count) {
+    visited[block->id] = 1;
+    for (int i = block->nsuccs - 1; i >= 0; i--) {
+        IRBlock* succ = block->succs[i];
+        if (!visited[succ->id]) rpo_visit(fn, succ, visited, post, count);
+    }
+    post[(*count)++] = block;
+}
+
+// 根据终结指令重建前驱/后继，并计算逆后序
+void ir_compute_cfg(IRFunction* fn) {
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        block->npreds = 0;
+        block->nsuccs = 0;
+        block->rpo = -1;
+    }
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        IRInstr* term = block->last;
+        if (!term) continue;
+        int ntargets = term->op == IR_JUMP ? 1 : term->op == IR_BRANCH ? 2 : 0;
+        for (int t = 0; t < ntargets; t++) {
+            IRBlock* succ = term->targets[t];
+            block->succs[block->nsuccs++] = succ;
+            IR_PUSH(succ->preds, succ->npreds, succ->cap_preds, block);
+        }
+    }
+
+    char* visited = calloc(fn->nblocks, 1);
+    IRBlock** post = malloc(sizeof(IRBlock*) * fn->nblocks);
+    int count = 0;
+    rpo_visit(fn, fn->entry, visited, post, &count);
+
+    free(fn->rpo_order);
+    fn->rpo_order = malloc(sizeof(IRBlock*) * (count ? count : 1));
+    fn->nrpo = count;
+    for (int i = 0; i < count; i++) {
+        fn->rpo_order[i] = post[count - 1 - i];
+        fn->rpo_order[i]->rpo = i;
+    }
+    free(post);
+    free(visited);
+}
+
+// 建立 def-use 链（只统计仍在块中的指令）
+void ir_compute_uses(IRFunction* fn) {
+    for (int i = 0; i < fn->ninstrs; i++) {
+        fn->instrs[i]->nusers = 0;
+    }
+    for (int i = 0; i < fn->nblocks; i++) {
+        for (IRInstr* instr = fn->blocks[i]->first; instr; instr = instr->next) {
+            for (int a = 0; a < instr->nargs; a++) {
+                IRInstr* def = instr->args[a];
+                if (def) IR_PUSH(def->users, def->nusers, def->cap_users, instr);
+            }
+        }
+    }
+}
+
+void ir_free_function(IRFunction* fn) {
+    if (!fn) return;
+    for (int i = 0; i < fn->ninstrs; i++) {
+        IRInstr* instr = fn->instrs[i];
+        free(instr->args);
+        free(instr->users);
+        free(instr->name);
+        free(instr);
+    }
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        free(block->preds);
+        free(block->dom_children);
+        free(block->df);
+        free(block);
+    }
+    for (int i = 0; i < fn->nvars; i++) {
+        free(fn->vars[i]);
+    }
+    free(fn->instrs);
+    free(fn->blocks);
+    free(fn->rpo_order);
+    free(fn->vars);
+    free(fn->name);
+    free(fn);
+}
+
+static const char* opcode_name(IROpcode op) {
+    switch (op) {
+        case IR_CONST: return "const";
+        case IR_UNDEF: return "undef";
+        case IR_PARAM: return "param";
+        case IR_LOAD: return "load";
+        case IR_STORE: return "store";
+        case IR_LOAD_GLOBAL: return "gload";
+        case IR_STORE_GLOBAL: return "gstore";
+        case IR_LOAD_ELEMENT: return "eload";
+        case IR_STORE_ELEMENT: return "estore";
+        case IR_BINOP: return "binop";
+        case IR_UNOP: return "unop";
+        case IR_CALL: return "call";
+        case IR_COPY: return "copy";
+        case IR_PHI: return "phi";
+        case IR_JUMP: return "jmp";
+        case IR_BRANCH: return "br";
+        case IR_RETURN: return "ret";
+        default: return "nop";
+    }
+}
+
+void ir_dump_function(IRFunction* fn, FILE* out) {
+    fprintf(out, "function %s%s\n", fn->name, fn->in_ssa ? " (ssa)" : "");
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        fprintf(out, "bb%d:", block->id);
+        if (block->rpo < 0) fprintf(out, "  ; unreachable");
+        fprintf(out, "  ; preds:");
+        for (int p = 0; p < block->npreds; p++) fprintf(out, " bb%d", block->preds[p]->id);
+        fprintf(out, "\n");
+
+        for (IRInstr* instr = block->first; instr; instr = instr->next) {
+            fprintf(out, "    ");
+            if (instr->op != IR_STORE && instr->op != IR_STORE_GLOBAL && instr->op != IR_STORE_ELEMENT &&
+                !ir_is_terminator(instr)) {
+                fprintf(out, "%%%d = ", instr->id);
+            }
+            fprintf(out, "%s", opcode_name(instr->op));
+            if (instr->op == IR_BINOP || instr->op == IR_UNOP) fprintf(out, " %s", instr->opname);
+            if (instr->op == IR_CONST || instr->op == IR_PARAM) fprintf(out, " %d", instr->imm);
+            if (instr->var >= 0) fprintf(out, " %s", fn->vars[instr->var]);
+            if (instr->name) fprintf(out, " %s", instr->name);
+            for (int a = 0; a < instr->nargs; a++) {
+                if (instr->args[a]) fprintf(out, "%s%%%d", a ? ", " : " ", instr->args[a]->id);
+                else fprintf(out, "%s?", a ? ", " : " ");
+            }
+            if (instr->op == IR_JUMP) fprintf(out, " bb%d", instr->targets[0]->id);
+            if (instr->op == IR_BRANCH) {
+                fprintf(out, " ? bb%d : bb%d", instr->targets[0]->id, instr->targets[1]->id);
+            }
+            fprintf(out, "\n");
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+#include "jit.h"
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 装载布局（每组按页对齐，各自设置权限，任何时刻都不会同时可写可执行）：
+//   [.text | 外部函数跳板] R+X    [.rodata] R    [.data | .bss] R+W
+// 先以 RW 映射写入代码和数据、处理重定位，最后再用 mprotect 收紧权限。
+
+#define STUB_SIZE 16
+
+struct JitModule {
+    unsigned char* base;
+    size_t size;
+    unsigned char* section_addr[OBJ_SEC_COUNT];
+    char** names;
+    void** addrs;
+    int count;
+};
+
+static size_t page_round(size_t n, size_t page) {
+    return (n + page - 1) / page * page;
+}
+
+static int jit_fail(char* error, size_t error_size, const char* message, const char* detail) {
+    snprintf(error, error_size, "%s: %s", message, detail);
+    return 0;
+}
+
+static int is_external(const ObjSymbol* sym) {
+    return sym->section < 0 && !sym->local_label;
+}
+
+// 外部函数的跳板：jmp *0(%rip) 后紧跟 8 字节目标地址，
+// 这样即使 libc 距离 JIT 代码超过 2GB，call rel32 也能到达
+static void write_stub(unsigned char* p, void* target) {
+    static const unsigned char jmp[6] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+    uint64_t addr = (uint64_t)(uintptr_t)target;
+    memcpy(p, jmp, sizeof(jmp));
+    memcpy(p + 6, &addr, sizeof(addr));
+    memset(p + 14, 0xCC, STUB_SIZE - 14);
+}
+
+static int apply_relocs(JitModule* m, const ObjectFile* obj, void** external, unsigned char** stubs,
+                        char* error, size_t error_size) {
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        const ObjSection* sec = &obj->sections[s];
+        for (int r = 0; r < sec->nrelocs; r++) {
+            const ObjReloc* reloc = &sec->relocs[r];
+            const ObjSymbol* sym = &obj->symbols[reloc->symbol];
+            unsigned char* place = m->section_addr[s] + reloc->offset;
+            uintptr_t target;
+            if (sym->section >= 0) {
+                target = (uintptr_t)(m->section_addr[sym->section] + sym->value);
+            } else if (reloc->type == RELOC_PLT32) {
+                target = (uintptr_t)stubs[reloc->symbol];
+            } else {
+                target = (uintptr_t)external[reloc->symbol];
+            }
+
+            int64_t value = (int64_t)target + reloc->addend;
+            switch (reloc->type) {
+                case RELOC_ABS64:
+                    memcpy(place, &value, 8);
+                    break;
+                case RELOC_PC32:
+                case RELOC_PLT32:
+                    value -= (int64_t)(uintptr_t)place;
+                    /* fallthrough */
+                case RELOC_ABS32S: {
+                    if (value < INT32_MIN || value > INT32_MAX) {
+                        return jit_fail(error, error_size, "relocation out of range", sym->name);
+                    }
+                    int32_t v32 = (int32_t)value;
+                    memcpy(place, &v32, 4);
+                    break;
+                }
+                case RELOC_ABS32: {
+                    if (value < 0 || value > (int64_t)UINT32_MAX) {
+                        return jit_fail(error, error_size, "relocation out of range", sym->name);
+                    }
+                    uint32_t v32 = (uint32_t)value;
+                    memcpy(place, &v32, 4);
+                    break;
+                }
+                default:
+                    return jit_fail(error, error_size, "unsupported relocation", sym->name);
+            }
+        }
+    }
+    return 1;
+}
+
+JitModule* jit_load(const ObjectFile* obj, char* error, size_t error_size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void** external = calloc(obj->nsymbols + 1, sizeof(void*));
+    unsigned char** stubs = calloc(obj->nsymbols + 1, sizeof(unsigned char*));
+    int nstubs = 0;
+
+    // 符号解析器：JIT 内定义的符号直接取地址，其余在进程里查找
+    for (int i = 0; i < obj->nsymbols; i++) {
+        const ObjSymbol* sym = &obj->symbols[i];
+        if (!is_external(sym)) continue;
+        external[i] = dlsym(RTLD_DEFAULT, sym->name);
+        if (!external[i]) {
+            jit_fail(error, error_size, "undefined symbol", sym->name);
+            free(external);
+            free(stubs);
+            return NULL;
+        }
+        nstubs++;
+    }
+
+    size_t text_size = page_round(obj->sections[OBJ_SEC_TEXT].size + 16 + (size_t)nstubs * STUB_SIZE, page);
+    size_t rodata_size = page_round(obj->sections[OBJ_SEC_RODATA].size, page);
+    size_t data_size = page_round(obj->sections[OBJ_SEC_DATA].size + 16 + obj->sections[OBJ_SEC_BSS].size, page);
+    size_t total = text_size + rodata_size + data_size;
+
+    // 尽量映射到低 4GB，让 $sym 这类 32 位绝对地址也能直接使用
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* base = MAP_FAILED;
+#ifdef MAP_32BIT
+    base = mmap(NULL, total, PROT_READ | PROT_WRITE, flags | MAP_32BIT, -1, 0);
+#endif
+    if (base == MAP_FAILED) base = mmap(NULL, total, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (base == MAP_FAILED) {
+        jit_fail(error, error_size, "mmap failed", "out of memory");
+        free(external);
+        free(stubs);
+        return NULL;
+    }
+
+    JitModule* m = calloc(1, sizeof(JitModule));
+    m->base = base;
+    m->size = total;
+    m->section_addr[OBJ_SEC_TEXT] = m->base;
+    m->section_addr[OBJ_SEC_RODATA] = m->base + text_size;
+    m->section_addr[OBJ_SEC_DATA] = m->base + text_size + rodata_size;
+    m->section_addr[OBJ_SEC_BSS] = m->section_addr[OBJ_SEC_DATA] +
+                                   ((obj->sections[OBJ_SEC_DATA].size + 15) & ~15L);
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (obj->sections[s].data) memcpy(m->section_addr[s], obj->sections[s].data, obj->sections[s].size);
+    }
+
+    unsigned char* stub = m->base + ((obj->sections[OBJ_SEC_TEXT].size + 15) & ~15L);
+    for (int i = 0; i < obj->nsymbols; i++) {
+        if (!external[i]) continue;
+        write_stub(stub, external[i]);
+        stubs[i] = stub;
+        stub += STUB_SIZE;
+    }
+
+    int ok = apply_relocs(m, obj, external, stubs, error, error_size);
+    free(external);
+    free(stubs);
+    if (ok && (mprotect(m->base, text_size, PROT_READ | PROT_EXEC) != 0 ||
+               (rodata_size && mprotect(m->section_addr[OBJ_SEC_RODATA], rodata_size, PROT_READ) != 0))) {
+        ok = jit_fail(error, error_size, "mprotect failed", "cannot make code executable");
+    }
+    if (!ok) {
+        jit_free(m);
+        return NULL;
+    }
+
+    // 记录已定义的全局符号，供 jit_lookup 使用
+    m->names = calloc(obj->nsymbols + 1, sizeof(char*));
+    m->addrs = calloc(obj->nsymbols + 1, sizeof(void*));
+    for (int i = 0; i < obj->nsymbols; i++) {
+        const ObjSymbol* sym = &obj->symbols[i];
+        if (sym->section < 0 || sym->local_label) continue;
+        m->names[m->count] = strdup(sym->name);
+        m->addrs[m->count++] = m->section_addr[sym->section] + sym->value;
+    }
+    return m;
+}
+
+void* jit_lookup(JitModule* module, const char* name) {
+    for (int i = 0; i < module->count; i++) {
+        if (strcmp(module->names[i], name) == 0) return module->addrs[i];
+    }
+    return NULL;
+}
+
+void jit_free(JitModule* module) {
+    if (!module) return;
+    munmap(module->base, module->size);
+    for (int i = 0; i < module->count; i++) {
+        free(module->names[i]);
+    }
+    free(module->names);
+    free(module->addrs);
+    free(module);
+}
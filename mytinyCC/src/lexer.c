@@ -408,6 +408,24 @@ Token get_next_token(Lexer* lexer) {
         return token;
     }
     
+    // 复合赋值 += -= *= /= %=
+    if (next == '=' && (c == '+' || c == '-' || c == '*' || c == '/' || c == '%')) {
+        advance_char(lexer); advance_char(lexer);
+        switch (c) {
+            case '+': token.type = TOK_PLUS_ASSIGN; break;
+            case '-': token.type = TOK_MINUS_ASSIGN; break;
+            case '*': token.type = TOK_MULT_ASSIGN; break;
+            case '/': token.type = TOK_DIV_ASSIGN; break;
+            default:  token.type = TOK_MOD_ASSIGN; break;
+        }
+        token.value = malloc(3);
+        token.value[0] = c;
+        token.value[1] = '=';
+        token.value[2] = '\0';
+        token.length = 2;
+        return token;
+    }
+
     // Single-character tokens
     advance_char(lexer);
     token.length = 1;
@@ -0,0 +1,873 @@
+#include "optimize.h"
+#include "ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 循环优化：在 CFG 上按回边（尾块被头块支配）找出循环，头块的 origin 就是对应的
+// while/for 语句，再统计语句内写过哪些变量；然后在 AST 上做两件事：
+//   1. 不变代码外提：只读循环内不变变量的纯算术表达式，在循环前算一次存进临时变量
+//   2. 归纳变量强度削减：i 在循环里只有一处 i = i ± c 时，i * k（k 为常量或不变量）
+//      换成临时变量 t，循环前 t = i * k，每次 i 更新后紧跟 t = t ± c * k
+// 前置块就是把循环语句原地包进一个新块，临时变量的声明放在循环之前。
+
+typedef struct {
+    ASTNode* stmt;          // while/for 语句
+    unsigned char* stored;  // 循环内被写的局部变量（按 IRFunction.vars 编号）
+    int* nstores;           // 每个变量在循环内的写入次数
+    int has_call;           // 含调用或写全局变量：全局变量都视为可变
+} Loop;
+
+typedef struct {
+    ASTNode* expr;
+    const char* name;
+} Temp;
+
+typedef struct {
+    IRFunction* fn;
+    Loop* loops;
+    int nloops;
+    int cap_loops;
+
+    Loop* loop;             // 正在处理的循环
+    Temp* temps;            // 本循环外提的表达式
+    int ntemps;
+    int cap_temps;
+    ASTNode* decls;         // 前置块中的新声明
+    ASTNode* decls_tail;
+
+    // 新建的临时变量只在循环前赋值一次（或随归纳变量更新），对之后处理的内层循环都不变
+    char** invariant_names;
+    int ninvariant;
+    int cap_invariant;
+
+    int unroll;
+    int hoisted;
+    int reduced;
+} LoopPass;
+
+static int temp_counter;
+
+#define LOOP_PUSH(arr, count, cap, item) do {                        \
+        if ((count) >= (cap)) {                                      \
+            (cap) = (cap) ? (cap) * 2 : 4;                           \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap));          \
+        }                                                            \
+        (arr)[(count)++] = (item);                                   \
+    } while (0)
+
+// ---- 循环识别 ----
+
+static Loop* find_loop(LoopPass* p, ASTNode* stmt) {
+    for (int i = 0; i < p->nloops; i++) {
+        if (p->loops[i].stmt == stmt) return &p->loops[i];
+    }
+    return NULL;
+}
+
+// 循环语句内写过的变量与调用。按 AST 而不是自然循环的块统计：以 return 结束的分支
+// 到不了回边，不在自然循环里，但外提的表达式同样会被挪到这些语句之前
+static void collect_stores(LoopPass* p, Loop* loop, ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT: {
+                int var = ir_var_index(p->fn, node->data.identifier);
+                if (var >= 0) {
+                    loop->stored[var] = 1;
+                    loop->nstores[var]++;
+                } else {
+                    loop->has_call = 1;
+                }
+                collect_stores(p, loop, node->left);
+                break;
+            }
+            case AST_DECLARATION: {
+                int var = ir_var_index(p->fn, node->data.declaration.name);
+                if (var >= 0 && node->data.declaration.initializer) {
+                    loop->stored[var] = 1;
+                    loop->nstores[var]++;
+                }
+                collect_stores(p, loop, node->data.declaration.initializer);
+                break;
+            }
+            case AST_CALL:
+                loop->has_call = 1;
+                collect_stores(p, loop, node->data.call.args);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                collect_stores(p, loop, node->data.element.index);
+                collect_stores(p, loop, node->data.element.value);
+                break;
+            case AST_BINARY_OP:
+                collect_stores(p, loop, node->data.binary.left);
+                collect_stores(p, loop, node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                collect_stores(p, loop, node->data.unary.operand);
+                break;
+            case AST_IF:
+                collect_stores(p, loop, node->data.if_stmt.condition);
+                collect_stores(p, loop, node->data.if_stmt.then_branch);
+                collect_stores(p, loop, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                collect_stores(p, loop, node->data.while_stmt.condition);
+                collect_stores(p, loop, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                collect_stores(p, loop, node->data.for_stmt.init);
+                collect_stores(p, loop, node->data.for_stmt.condition);
+                collect_stores(p, loop, node->data.for_stmt.update);
+                collect_stores(p, loop, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                collect_stores(p, loop, node->data.switch_stmt.condition);
+                collect_stores(p, loop, node->data.switch_stmt.body);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                collect_stores(p, loop, node->left);
+                break;
+        }
+    }
+}
+
+// 头块带有 while/for 来源、且存在回边的才是要处理的循环；for 的初始化只执行一次，不算循环内
+static void collect_loop(LoopPass* p, IRBlock* header) {
+    if (find_loop(p, header->origin)) return;
+    ASTNode* stmt = header->origin;
+    Loop fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.stmt = stmt;
+    fresh.stored = calloc(p->fn->nvars + 1, 1);
+    fresh.nstores = calloc(p->fn->nvars + 1, sizeof(int));
+    if (stmt->type == AST_FOR) {
+        collect_stores(p, &fresh, stmt->data.for_stmt.condition);
+        collect_stores(p, &fresh, stmt->data.for_stmt.update);
+        collect_stores(p, &fresh, stmt->data.for_stmt.body);
+    } else {
+        collect_stores(p, &fresh, stmt->data.while_stmt.condition);
+        collect_stores(p, &fresh, stmt->data.while_stmt.body);
+    }
+    LOOP_PUSH(p->loops, p->nloops, p->cap_loops, fresh);
+}
+
+static void find_loops(LoopPass* p) {
+    IRFunction* fn = p->fn;
+    ssa_compute_dominators(fn);
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* tail = fn->rpo_order[i];
+        for (int s = 0; s < tail->nsuccs; s++) {
+            IRBlock* header = tail->succs[s];
+            if (!ssa_dominates(header, tail) || !header->origin) continue;
+            if (header->origin->type != AST_WHILE && header->origin->type != AST_FOR) continue;
+            collect_loop(p, header);
+        }
+    }
+}
+
+// ---- AST 工具 ----
+
+static ASTNode* make_identifier(const char* name, ASTNode* at) {
+    ASTNode* node = create_node(AST_IDENTIFIER);
+    node->line = at->line;
+    node->column = at->column;
+    node->data.identifier = strdup(name);
+    return node;
+}
+
+static ASTNode* make_binary(const char* op, ASTNode* left, ASTNode* right) {
+    ASTNode* node = create_node(AST_BINARY_OP);
+    node->line = left->line;
+    node->column = left->column;
+    node->data.binary.operator = strdup(op);
+    node->data.binary.left = left;
+    node->data.binary.right = right;
+    return node;
+}
+
+static ASTNode* make_number(int value, ASTNode* at) {
+    ASTNode* node = create_node(AST_LITERAL);
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d", value);
+    node->line = at->line;
+    node->column = at->column;
+    node->data.literal.value = strdup(buffer);
+    node->data.literal.value_type = TOK_NUMBER;
+    return node;
+}
+
+static ASTNode* make_assignment(const char* name, ASTNode* value) {
+    ASTNode* node = create_node(AST_ASSIGNMENT);
+    node->line = value->line;
+    node->column = value->column;
+    node->data.identifier = strdup(name);
+    node->left = value;
+    return node;
+}
+
+// 把语句原地改写成只含它自己的块，返回挪进块里的原语句；指向 node 的指针仍然有效
+static ASTNode* wrap_in_block(ASTNode* node) {
+    ASTNode* inner = create_node(node->type);
+    *inner = *node;
+    inner->next = NULL;
+    ASTNode* next = node->next;
+    memset(node, 0, sizeof(*node));
+    node->type = AST_BLOCK;
+    node->line = inner->line;
+    node->column = inner->column;
+    node->left = inner;
+    node->next = next;
+    return inner;
+}
+
+// 循环体改成块：新建块节点挂到原位置，原语句（可能是内层循环）保持不动
+static ASTNode* body_block(ASTNode** body) {
+    if ((*body)->type == AST_BLOCK) return *body;
+    ASTNode* block = create_node(AST_BLOCK);
+    block->line = (*body)->line;
+    block->column = (*body)->column;
+    block->left = *body;
+    *body = block;
+    return block;
+}
+
+// ---- 不变代码外提 ----
+
+static int is_invariant_var(LoopPass* p, const char* name) {
+    for (int i = 0; i < p->ninvariant; i++) {
+        if (strcmp(p->invariant_names[i], name) == 0) return 1;
+    }
+    int var = ir_var_index(p->fn, name);
+    if (var < 0) return !p->loop->has_call;
+    return !p->loop->stored[var];
+}
+
+// 表达式在循环内是否不变且可以提前求值：不含赋值和调用，也不会因外提而新增除零陷阱
+static int is_invariant(LoopPass* p, ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_LITERAL:
+            return node->data.literal.value_type == TOK_NUMBER;
+        case AST_IDENTIFIER:
+            return is_invariant_var(p, node->data.identifier);
+        case AST_UNARY_OP:
+            return is_invariant(p, node->data.unary.operand);
+        case AST_BINARY_OP: {
+            const char* op = node->data.binary.operator;
+            if (strcmp(op, "=") == 0) return 0;
+            if (strcmp(op, "/") == 0 || strcmp(op, "%") == 0) {
+                int d;
+                if (!node_is_constant(node->data.binary.right, &d) || d == 0 || d == -1) return 0;
+            }
+            return is_invariant(p, node->data.binary.left) && is_invariant(p, node->data.binary.right);
+        }
+        default:
+            return 0;
+    }
+}
+
+// 只外提算术运算；比较和逻辑运算在条件里直接生成跳转，物化成 0/1 反而更慢
+static int is_arithmetic(ASTNode* node) {
+    static const char* ops[] = { "+", "-", "*", "/", "%", "&", "|", "^", "<<", ">>" };
+    if (node->type != AST_BINARY_OP) return 0;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(node->data.binary.operator, ops[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// 在前置块里声明临时变量 name = init（name 归声明节点所有）
+static void add_decl(LoopPass* p, char* name, ASTNode* init) {
+    ASTNode* decl = create_node(AST_DECLARATION);
+    decl->line = init->line;
+    decl->column = init->column;
+    decl->data.declaration.name = name;
+    decl->data.declaration.type = COPY_STRING("int");
+    decl->data.declaration.initializer = init;
+    if (p->decls_tail) p->decls_tail->next = decl;
+    else p->decls = decl;
+    p->decls_tail = decl;
+    LOOP_PUSH(p->invariant_names, p->ninvariant, p->cap_invariant, decl->data.declaration.name);
+}
+
+static char* new_temp_name(const char* prefix) {
+    char name[32];
+    snprintf(name, sizeof(name), "__%s%d", prefix, temp_counter++);
+    return strdup(name);
+}
+
+// 不变表达式对应的临时变量，相同的表达式共用一个
+static const char* hoist_temp(LoopPass* p, ASTNode* expr) {
+    for (int i = 0; i < p->ntemps; i++) {
+        if (same_expr(p->temps[i].expr, expr)) return p->temps[i].name;
+    }
+    char* name = new_temp_name("licm");
+    add_decl(p, name, copy_expr(expr));
+    Temp temp;
+    temp.expr = copy_expr(expr);
+    temp.name = name;
+    LOOP_PUSH(p->temps, p->ntemps, p->cap_temps, temp);
+    return temp.name;
+}
+
+// 把语句/表达式树中最大的不变算术子表达式换成临时变量
+static void hoist(LoopPass* p, ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_BINARY_OP:
+                if (is_arithmetic(node) && is_invariant(p, node)) {
+                    replace_node(node, make_identifier(hoist_temp(p, node), node));
+                    p->hoisted++;
+                    break;
+                }
+                hoist(p, node->data.binary.left);
+                hoist(p, node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                hoist(p, node->data.unary.operand);
+                break;
+            case AST_CALL:
+                hoist(p, node->data.call.args);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                hoist(p, node->data.element.index);
+                hoist(p, node->data.element.value);
+                break;
+            case AST_DECLARATION:
+                hoist(p, node->data.declaration.initializer);
+                break;
+            case AST_IF:
+                hoist(p, node->data.if_stmt.condition);
+                hoist(p, node->data.if_stmt.then_branch);
+                hoist(p, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                hoist(p, node->data.while_stmt.condition);
+                hoist(p, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                hoist(p, node->data.for_stmt.init);
+                hoist(p, node->data.for_stmt.condition);
+                hoist(p, node->data.for_stmt.update);
+                hoist(p, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                hoist(p, node->data.switch_stmt.condition);
+                hoist(p, node->data.switch_stmt.body);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                hoist(p, node->left);
+                break;
+        }
+    }
+}
+
+// ---- 归纳变量强度削减 ----
+
+typedef struct {
+    const char* name;       // 归纳变量
+    int step;
+    ASTNode* update;        // 唯一的 i = i ± c
+    ASTNode* factors[16];   // 已削减的乘数及对应的临时变量
+    const char* temps[16];
+    int nfactors;
+} Induction;
+
+// node 是否为 name = name ± c 形式的赋值
+static int induction_step(ASTNode* node, const char* name, int* step) {
+    if (!node || node->type != AST_ASSIGNMENT || strcmp(node->data.identifier, name) != 0) return 0;
+    ASTNode* value = node->left;
+    if (!value || value->type != AST_BINARY_OP) return 0;
+    ASTNode* left = value->data.binary.left;
+    ASTNode* right = value->data.binary.right;
+    int c;
+    if (strcmp(value->data.binary.operator, "+") == 0) {
+        if (left->type == AST_IDENTIFIER && strcmp(left->data.identifier, name) == 0 && node_is_constant(right, &c)) {
+            *step = c;
+            return 1;
+        }
+        if (right->type == AST_IDENTIFIER && strcmp(right->data.identifier, name) == 0 && node_is_constant(left, &c)) {
+            *step = c;
+            return 1;
+        }
+    } else if (strcmp(value->data.binary.operator, "-") == 0) {
+        if (left->type == AST_IDENTIFIER && strcmp(left->data.identifier, name) == 0 && node_is_constant(right, &c)) {
+            *step = (int)(0u - (unsigned)c);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 乘法 node 若为 iv * k 或 k * iv（k 是常量或不变变量）则返回 k；iv << c 按 iv * 2^c 处理
+static ASTNode* induction_factor(LoopPass* p, ASTNode* node, const char* name, int* shift) {
+    *shift = -1;
+    if (node->type != AST_BINARY_OP) return NULL;
+    ASTNode* left = node->data.binary.left;
+    ASTNode* right = node->data.binary.right;
+    int is_iv_left = left->type == AST_IDENTIFIER && strcmp(left->data.identifier, name) == 0;
+    int is_iv_right = right->type == AST_IDENTIFIER && strcmp(right->data.identifier, name) == 0;
+    if (strcmp(node->data.binary.operator, "<<") == 0) {
+        int c;
+        if (is_iv_left && node_is_constant(right, &c) && c >= 0 && c < 31) {
+            *shift = c;
+            return right;
+        }
+        return NULL;
+    }
+    if (strcmp(node->data.binary.operator, "*") != 0) return NULL;
+    ASTNode* factor = is_iv_left ? right : (is_iv_right ? left : NULL);
+    if (!factor) return NULL;
+    if (node_is_constant(factor, NULL)) return factor;
+    if (factor->type == AST_IDENTIFIER && strcmp(factor->data.identifier, name) != 0 &&
+        is_invariant_var(p, factor->data.identifier)) {
+        return factor;
+    }
+    return NULL;
+}
+
+// 在 i 的更新语句之后插入 t = t + step
+static void insert_after_update(Induction* iv, ASTNode* stmt) {
+    stmt->next = iv->update->next;
+    iv->update->next = stmt;
+}
+
+// 乘数 factor 对应的临时变量：循环前 t = i * k，i 更新后 t = t + c * k
+static const char* induction_temp(LoopPass* p, Induction* iv, ASTNode* product, ASTNode* factor, int shift) {
+    // 乘积节点随后会被替换掉，记下乘数的拷贝；左移记为乘 2^c，与 i * 2^c 共用临时变量
+    ASTNode* key = shift >= 0 ? make_number((int)(1u << shift), product) : copy_expr(factor);
+    for (int i = 0; i < iv->nfactors; i++) {
+        if (same_expr(iv->factors[i], key)) {
+            destroy_node(key);
+            return iv->temps[i];
+        }
+    }
+    if (iv->nfactors == 16) {
+        destroy_node(key);
+        return NULL;
+    }
+
+    char* name = new_temp_name("iv");
+    ASTNode* init = copy_expr(product);
+    add_decl(p, name, init);
+
+    ASTNode* delta;
+    int k;
+    if (node_is_constant(key, &k)) {
+        delta = make_number((int)((unsigned)iv->step * (unsigned)k), product);
+    } else if (iv->step == 1) {
+        delta = copy_expr(factor);
+    } else {
+        ASTNode* scaled = make_binary("*", copy_expr(factor), make_number(iv->step, product));
+        delta = make_identifier(hoist_temp(p, scaled), product);
+        destroy_node(scaled);
+    }
+    ASTNode* sum = make_binary("+", make_identifier(name, product), delta);
+    insert_after_update(iv, make_assignment(name, sum));
+
+    iv->factors[iv->nfactors] = key;
+    iv->temps[iv->nfactors++] = name;
+    return name;
+}
+
+static void reduce(LoopPass* p, Induction* iv, ASTNode* node) {
+    for (; node; node = node->next) {
+        if (node == iv->update) continue;
+        switch (node->type) {
+            case AST_BINARY_OP: {
+                int shift;
+                ASTNode* factor = induction_factor(p, node, iv->name, &shift);
+                const char* temp = factor ? induction_temp(p, iv, node, factor, shift) : NULL;
+                if (temp) {
+                    replace_node(node, make_identifier(temp, node));
+                    p->reduced++;
+                    break;
+                }
+                reduce(p, iv, node->data.binary.left);
+                reduce(p, iv, node->data.binary.right);
+                break;
+            }
+            case AST_UNARY_OP:
+                reduce(p, iv, node->data.unary.operand);
+                break;
+            case AST_CALL:
+                reduce(p, iv, node->data.call.args);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                reduce(p, iv, node->data.element.index);
+                reduce(p, iv, node->data.element.value);
+                break;
+            case AST_ASSIGNMENT:
+                reduce(p, iv, node->left);
+                break;
+            case AST_DECLARATION:
+                reduce(p, iv, node->data.declaration.initializer);
+                break;
+            case AST_IF:
+                reduce(p, iv, node->data.if_stmt.condition);
+                reduce(p, iv, node->data.if_stmt.then_branch);
+                reduce(p, iv, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                reduce(p, iv, node->data.while_stmt.condition);
+                reduce(p, iv, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                reduce(p, iv, node->data.for_stmt.init);
+                reduce(p, iv, node->data.for_stmt.condition);
+                reduce(p, iv, node->data.for_stmt.update);
+                reduce(p, iv, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                reduce(p, iv, node->data.switch_stmt.condition);
+                reduce(p, iv, node->data.switch_stmt.body);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                reduce(p, iv, node->left);
+                break;
+        }
+    }
+}
+
+// 找到归纳变量的更新语句：for 的更新表达式，或循环体顶层的一条赋值。
+// for 的更新表达式挪到循环体末尾，好在它后面接上临时变量的更新（语言没有 continue，等价）
+static ASTNode* find_update(ASTNode* stmt, const char* name, int* step) {
+    ASTNode** body = stmt->type == AST_FOR ? &stmt->data.for_stmt.body : &stmt->data.while_stmt.body;
+    if (!*body) return NULL;
+    if (stmt->type == AST_FOR && induction_step(stmt->data.for_stmt.update, name, step)) {
+        ASTNode* update = stmt->data.for_stmt.update;
+        ASTNode** tail = &body_block(body)->left;
+        while (*tail) tail = &(*tail)->next;
+        *tail = update;
+        stmt->data.for_stmt.update = NULL;
+        return update;
+    }
+    if ((*body)->type != AST_BLOCK) {
+        if (!induction_step(*body, name, step)) return NULL;
+        return body_block(body)->left;
+    }
+    for (ASTNode* s = (*body)->left; s; s = s->next) {
+        if (induction_step(s, name, step)) return s;
+    }
+    return NULL;
+}
+
+static void reduce_inductions(LoopPass* p, ASTNode* stmt) {
+    for (int v = 0; v < p->fn->nvars; v++) {
+        if (p->loop->nstores[v] != 1) continue;
+        Induction iv;
+        memset(&iv, 0, sizeof(iv));
+        iv.name = p->fn->vars[v];
+        iv.update = find_update(stmt, iv.name, &iv.step);
+        if (!iv.update) continue;
+        if (stmt->type == AST_FOR) {
+            reduce(p, &iv, stmt->data.for_stmt.condition);
+            reduce(p, &iv, stmt->data.for_stmt.update);
+            reduce(p, &iv, stmt->data.for_stmt.body);
+        } else {
+            reduce(p, &iv, stmt->data.while_stmt.condition);
+            reduce(p, &iv, stmt->data.while_stmt.body);
+        }
+        for (int i = 0; i < iv.nfactors; i++) {
+            destroy_node(iv.factors[i]);
+        }
+    }
+}
+
+// ---- 计数循环 ----
+
+// 语句/表达式树中对 name 的赋值次数（同名声明也算）
+static int count_assignments(ASTNode* node, const char* name) {
+    int count = 0;
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                if (strcmp(node->data.identifier, name) == 0) count++;
+                count += count_assignments(node->left, name);
+                break;
+            case AST_DECLARATION:
+                if (strcmp(node->data.declaration.name, name) == 0) count++;
+                count += count_assignments(node->data.declaration.initializer, name);
+                break;
+            case AST_BINARY_OP:
+                count += count_assignments(node->data.binary.left, name);
+                count += count_assignments(node->data.binary.right, name);
+                break;
+            case AST_UNARY_OP:
+                count += count_assignments(node->data.unary.operand, name);
+                break;
+            case AST_CALL:
+                count += count_assignments(node->data.call.args, name);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                count += count_assignments(node->data.element.index, name);
+                count += count_assignments(node->data.element.value, name);
+                break;
+            case AST_IF:
+                count += count_assignments(node->data.if_stmt.condition, name);
+                count += count_assignments(node->data.if_stmt.then_branch, name);
+                count += count_assignments(node->data.if_stmt.else_branch, name);
+                break;
+            case AST_WHILE:
+                count += count_assignments(node->data.while_stmt.condition, name);
+                count += count_assignments(node->data.while_stmt.body, name);
+                break;
+            case AST_FOR:
+                count += count_assignments(node->data.for_stmt.init, name);
+                count += count_assignments(node->data.for_stmt.condition, name);
+                count += count_assignments(node->data.for_stmt.update, name);
+                count += count_assignments(node->data.for_stmt.body, name);
+                break;
+            case AST_SWITCH:
+                count += count_assignments(node->data.switch_stmt.condition, name);
+                count += count_assignments(node->data.switch_stmt.body, name);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                count += count_assignments(node->left, name);
+                break;
+        }
+    }
+    return count;
+}
+
+static int tree_size(ASTNode* node) {
+    int size = 0;
+    for (; node; node = node->next) {
+        size++;
+        switch (node->type) {
+            case AST_ASSIGNMENT:
+                size += tree_size(node->left);
+                break;
+            case AST_DECLARATION:
+                size += tree_size(node->data.declaration.initializer);
+                break;
+            case AST_BINARY_OP:
+                size += tree_size(node->data.binary.left) + tree_size(node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                size += tree_size(node->data.unary.operand);
+                break;
+            case AST_CALL:
+                size += tree_size(node->data.call.args);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                size += tree_size(node->data.element.index) + tree_size(node->data.element.value);
+                break;
+            case AST_IF:
+                size += tree_size(node->data.if_stmt.condition) + tree_size(node->data.if_stmt.then_branch) +
+                        tree_size(node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                size += tree_size(node->data.while_stmt.condition) + tree_size(node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                size += tree_size(node->data.for_stmt.init) + tree_size(node->data.for_stmt.condition) +
+                        tree_size(node->data.for_stmt.update) + tree_size(node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                size += tree_size(node->data.switch_stmt.condition) + tree_size(node->data.switch_stmt.body);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                size += tree_size(node->left);
+                break;
+        }
+    }
+    return size;
+}
+
+static int compare(const char* op, int a, int b) {
+    if (strcmp(op, "<") == 0) return a < b;
+    if (strcmp(op, "<=") == 0) return a <= b;
+    if (strcmp(op, ">") == 0) return a > b;
+    return a >= b;
+}
+
+// 初始化为 var = 常量（赋值或声明）时取出初值
+static int constant_init(ASTNode* init, const char* var, int* value) {
+    if (!init) return 0;
+    if (init->type == AST_ASSIGNMENT && strcmp(init->data.identifier, var) == 0) {
+        return node_is_constant(init->left, value);
+    }
+    if (init->type == AST_DECLARATION && strcmp(init->data.declaration.name, var) == 0) {
+        return node_is_constant(init->data.declaration.initializer, value);
+    }
+    return 0;
+}
+
+int counted_loop(ASTNode* loop, CountedLoop* info) {
+    static const char* swapped[][2] = { { "<", ">" }, { "<=", ">=" }, { ">", "<" }, { ">=", "<=" } };
+    if (!loop || loop->type != AST_FOR || !loop->data.for_stmt.body) return 0;
+    ASTNode* cond = loop->data.for_stmt.condition;
+    if (!cond || cond->type != AST_BINARY_OP) return 0;
+
+    memset(info, 0, sizeof(*info));
+    int relational = -1;
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(cond->data.binary.operator, swapped[i][0]) == 0) relational = i;
+    }
+    if (relational < 0) return 0;
+    ASTNode* left = cond->data.binary.left;
+    ASTNode* right = cond->data.binary.right;
+    if (left->type == AST_IDENTIFIER && (right->type == AST_IDENTIFIER || node_is_constant(right, NULL))) {
+        info->var = left->data.identifier;
+        info->bound = right;
+        info->op = swapped[relational][0];
+    } else if (right->type == AST_IDENTIFIER && node_is_constant(left, NULL)) {
+        info->var = right->data.identifier;
+        info->bound = left;
+        info->op = swapped[relational][1];
+    } else {
+        return 0;
+    }
+
+    // 更新语句：for 的更新表达式，或（循环优化挪过之后）循环体顶层的一条赋值
+    ASTNode* body = loop->data.for_stmt.body;
+    ASTNode* update = loop->data.for_stmt.update;
+    int found = update && induction_step(update, info->var, &info->step);
+    for (ASTNode* s = body->type == AST_BLOCK ? body->left : body; s && !found; s = s->next) {
+        found = induction_step(s, info->var, &info->step);
+        if (body->type != AST_BLOCK) break;
+    }
+    if (!found || info->step == 0) return 0;
+    int upward = info->op[0] == '<';
+    if (upward != (info->step > 0)) return 0;
+    if (count_assignments(body, info->var) + count_assignments(update, info->var) != 1) return 0;
+    if (info->bound->type == AST_IDENTIFIER &&
+        (strcmp(info->bound->data.identifier, info->var) == 0 ||
+         count_assignments(body, info->bound->data.identifier) +
+         count_assignments(update, info->bound->data.identifier) != 0)) {
+        return 0;
+    }
+
+    info->size = tree_size(body) + tree_size(update);
+    info->trips = -1;
+    int value, limit;
+    if (constant_init(loop->data.for_stmt.init, info->var, &value) && node_is_constant(info->bound, &limit)) {
+        // 按 32 位回绕语义模拟
+        int trips = 0;
+        while (compare(info->op, value, limit) && trips <= UNROLL_FULL_TRIPS) {
+            trips++;
+            value = (int)((unsigned)value + (unsigned)info->step);
+        }
+        if (trips <= UNROLL_FULL_TRIPS) info->trips = trips;
+    }
+    info->full_unroll = info->trips >= 0 && info->trips * info->size <= UNROLL_FULL_BUDGET;
+    return 1;
+}
+
+// ---- 驱动 ----
+
+static void optimize_loop(LoopPass* p, ASTNode* stmt) {
+    p->ntemps = 0;
+    p->decls = p->decls_tail = NULL;
+
+    if (stmt->type == AST_FOR) {
+        hoist(p, stmt->data.for_stmt.condition);
+        hoist(p, stmt->data.for_stmt.update);
+        hoist(p, stmt->data.for_stmt.body);
+    } else {
+        hoist(p, stmt->data.while_stmt.condition);
+        hoist(p, stmt->data.while_stmt.body);
+    }
+    reduce_inductions(p, stmt);
+
+    for (int i = 0; i < p->ntemps; i++) {
+        destroy_node(p->temps[i].expr);
+    }
+    if (!p->decls) return;
+
+    // { for 的初始化; 临时变量声明...; 循环 }：初始化先于临时变量求值
+    ASTNode* inner = wrap_in_block(stmt);
+    p->decls_tail->next = inner;
+    ASTNode* first = p->decls;
+    if (inner->type == AST_FOR && inner->data.for_stmt.init) {
+        ASTNode* init = inner->data.for_stmt.init;
+        inner->data.for_stmt.init = NULL;
+        init->next = first;
+        first = init;
+    }
+    stmt->left = first;
+}
+
+// 先外层后内层：外层外提出的表达式不必再在内层里检查。
+// 会被完全展开的循环不动：挪走初始化语句就算不出迭代次数了
+static void walk(LoopPass* p, ASTNode* node) {
+    for (; node; node = node->next) {
+        Loop* loop = (node->type == AST_WHILE || node->type == AST_FOR) ? find_loop(p, node) : NULL;
+        CountedLoop counted;
+        if (loop && p->unroll && counted_loop(node, &counted) && counted.full_unroll) loop = NULL;
+        if (loop) {
+            p->loop = loop;
+            optimize_loop(p, node);
+        }
+        switch (node->type) {
+            case AST_IF:
+                walk(p, node->data.if_stmt.then_branch);
+                walk(p, node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                walk(p, node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                walk(p, node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                walk(p, node->data.switch_stmt.body);
+                break;
+            case AST_BLOCK:
+                walk(p, node->left);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int loop_optimize_program(ASTNode* program, int unroll, int* reduced) {
+    int hoisted = 0;
+    if (reduced) *reduced = 0;
+    if (!program || program->type != AST_PROGRAM) return 0;
+
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION || !node->data.function.body) continue;
+
+        LoopPass p;
+        memset(&p, 0, sizeof(p));
+        p.fn = ir_build_function(node);
+        p.unroll = unroll;
+        find_loops(&p);
+        if (p.nloops > 0) walk(&p, node->data.function.body);
+
+        hoisted += p.hoisted;
+        if (reduced) *reduced += p.reduced;
+        for (int i = 0; i < p.nloops; i++) {
+            free(p.loops[i].stored);
+            free(p.loops[i].nstores);
+        }
+        free(p.loops);
+        free(p.temps);
+        free(p.invariant_names);
+        ir_free_function(p.fn);
+    }
+    return hoisted;
+}
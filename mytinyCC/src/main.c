@@ -5,12 +5,76 @@
 #include "parser.h"
 #include "codegen.h"
 #include "utils.h"
+#include "ir.h"
+#include "optimize.h"
+#include "x86.h"
+#include "jit.h"
+#include <time.h>
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// --run：汇编到内存、装载并调用 main，返回程序的退出码
+static int run_in_memory(AsmList* program, int argc, char* argv[], int verbose) {
+    ObjectFile obj;
+    char error[256];
+    double start = now_ms();
+    if (!x86_assemble(program, &obj, error, sizeof(error))) {
+        fprintf(stderr, "Assembler error: %s\n", error);
+        return 1;
+    }
+    JitModule* module = jit_load(&obj, error, sizeof(error));
+    obj_free(&obj);
+    if (!module) {
+        fprintf(stderr, "JIT error: %s\n", error);
+        return 1;
+    }
+    int (*entry)(int, char**) = (int (*)(int, char**))jit_lookup(module, "main");
+    if (!entry) {
+        fprintf(stderr, "JIT error: no main function\n");
+        jit_free(module);
+        return 1;
+    }
+    if (verbose) {
+        printf("JIT: assembled and loaded in %.3f ms\n", now_ms() - start);
+        fflush(stdout);
+    }
+    int status = entry(argc, argv);
+    fflush(stdout);
+    jit_free(module);
+    return status;
+}
+
+#define DEFAULT_PROFILE "tinycc.profile"
+#define DEFAULT_FUNCTION_PROFILE "tinycc.fnprof"
 
 void print_usage(const char* program_name) {
     printf("Usage: %s [options] <input_file>\n", program_name);
     printf("Options:\n");
     printf("  -o <output>  Specify output file (default: a.out)\n");
     printf("  -S           Generate assembly only\n");
+    printf("  -c           Generate ELF object with the built-in assembler\n");
+    printf("  --run        Compile in memory and run main (remaining arguments go to the program)\n");
+    printf("  -O0          Disable optimizations\n");
+    printf("  -O1          Enable optimizations (default)\n");
+    printf("  -fomit-frame-pointer  Omit the frame pointer in leaf functions\n");
+    printf("  -fno-inline  Do not inline small functions\n");
+    printf("  -funroll-loops=N  Unroll counted for loops N times (default 4; 1 = only fully unroll constant trip counts)\n");
+    printf("  -fno-ipa-cp  Do not propagate constant arguments into functions or clone specialized versions\n");
+    printf("  -fno-eval-pure-calls  Do not evaluate calls to pure functions with constant arguments at compile time\n");
+    printf("  -fno-unroll-loops  Do not unroll loops\n");
+    printf("  -fno-if-conversion  Keep branches for simple if/else assignments instead of cmov\n");
+    printf("  -fno-tree-vectorize  Do not vectorize counted for loops over arrays with SSE2\n");
+    printf("  -fno-promote-locals  Keep all local variables in stack slots instead of callee-saved registers\n");
+    printf("  -fno-reorder-blocks  Lay out code in source order (no loop rotation or cold-block splitting)\n");
+    printf("  -fprofile-generate[=file]  Instrument the program; each run appends its counts to file (default %s)\n",
+           DEFAULT_PROFILE);
+    printf("  -fprofile-use[=file]  Use recorded counts for block layout, inlining and unrolling\n");
+    printf("  -finstrument-functions[=file]  Record calls and rdtsc cycles per function; main writes a flat profile"
+           " to file (default %s)\n", DEFAULT_FUNCTION_PROFILE);
     printf("  -v           Verbose output\n");
     printf("  -h           Show this help\n");
 }
@@ -19,7 +83,25 @@ int main(int argc, char* argv[]) {
     char* input_file = NULL;
     char* output_file = "a.out";
     int generate_asm_only = 0;
+    int generate_object = 0;
     int verbose = 0;
+    int optimize = 1;
+    int run = 0;
+    int omit_frame_pointer = 0;
+    int inline_enabled = 1;
+    int eval_pure_calls = 1;
+    int ipa_cp = 1;
+    int clone_functions = 1;
+    int unroll_factor = 4;
+    int if_convert = 1;
+    int vectorize = 1;
+    int promote_locals = 1;
+    int reorder_blocks = 1;
+    const char* profile_generate = NULL;
+    const char* profile_use = NULL;
+    const char* instrument_functions = NULL;
+    int program_argc = 0;
+    char** program_argv = NULL;
     
     // 解析命令行参数
     for (int i = 1; i < argc; i++) {
@@ -27,6 +109,54 @@ int main(int argc, char* argv[]) {
             output_file = argv[++i];
         } else if (strcmp(argv[i], "-S") == 0) {
             generate_asm_only = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            generate_object = 1;
+        } else if (strcmp(argv[i], "-fomit-frame-pointer") == 0) {
+            omit_frame_pointer = 1;
+        } else if (strcmp(argv[i], "-fno-inline") == 0) {
+            inline_enabled = 0;
+        } else if (strcmp(argv[i], "-fno-ipa-cp") == 0) {
+            ipa_cp = 0;
+        } else if (strcmp(argv[i], "-fno-eval-pure-calls") == 0) {
+            eval_pure_calls = 0;
+        } else if (strncmp(argv[i], "-funroll-loops=", 15) == 0) {
+            unroll_factor = atoi(argv[i] + 15);
+            if (unroll_factor < 1 || unroll_factor > 64) {
+                fprintf(stderr, "Invalid unroll factor: %s\n", argv[i] + 15);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-fno-unroll-loops") == 0) {
+            unroll_factor = 0;
+        } else if (strcmp(argv[i], "-fno-if-conversion") == 0) {
+            if_convert = 0;
+        } else if (strcmp(argv[i], "-fno-tree-vectorize") == 0) {
+            vectorize = 0;
+        } else if (strcmp(argv[i], "-fno-promote-locals") == 0) {
+            promote_locals = 0;
+        } else if (strcmp(argv[i], "-fno-reorder-blocks") == 0) {
+            reorder_blocks = 0;
+        } else if (strcmp(argv[i], "-fprofile-generate") == 0 || strncmp(argv[i], "-fprofile-generate=", 19) == 0) {
+            profile_generate = argv[i][18] == '=' ? argv[i] + 19 : DEFAULT_PROFILE;
+            // 路径原样写进生成的程序的 .string 里
+            if (!*profile_generate || strpbrk(profile_generate, "\"\\\n")) {
+                fprintf(stderr, "Invalid profile path: %s\n", profile_generate);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-finstrument-functions") == 0 ||
+                   strncmp(argv[i], "-finstrument-functions=", 23) == 0) {
+            instrument_functions = argv[i][22] == '=' ? argv[i] + 23 : DEFAULT_FUNCTION_PROFILE;
+            if (!*instrument_functions || strpbrk(instrument_functions, "\"\\\n")) {
+                fprintf(stderr, "Invalid profile path: %s\n", instrument_functions);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-fprofile-use") == 0 || strncmp(argv[i], "-fprofile-use=", 14) == 0) {
+            profile_use = argv[i][13] == '=' ? argv[i] + 14 : DEFAULT_PROFILE;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            run = 1;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            optimize = 0;
+        } else if (strcmp(argv[i], "-O1") == 0 || strcmp(argv[i], "-O") == 0) {
+            optimize = 1;
         } else if (strcmp(argv[i], "-v") == 0) {
             verbose = 1;
         } else if (strcmp(argv[i], "-h") == 0) {
@@ -34,6 +164,12 @@ int main(int argc, char* argv[]) {
             return 0;
         } else if (argv[i][0] != '-') {
             input_file = argv[i];
+            if (run) {
+                // 源文件之后的参数原样交给被运行的程序
+                program_argc = argc - i;
+                program_argv = argv + i;
+                break;
+            }
         } else {
             fprintf(stderr, "Unknown option: %s\n", argv[i]);
             print_usage(argv[0]);
@@ -49,7 +185,9 @@ int main(int argc, char* argv[]) {
     
     if (verbose) {
         printf("Compiling: %s\n", input_file);
-        printf("Output: %s\n", output_file);
+        if (!run) {
+            printf("Output: %s\n", output_file);
+        }
     }
     
     // 读取源代码
@@ -92,10 +230,60 @@ int main(int argc, char* argv[]) {
         printf("AST:\n");
       //  print_ast(ast, 0);
     }
+
+    // 剖析计数点在任何优化之前编号，插桩与使用剖析的两次编译编号一致
+    unsigned profile_sum;
+    int profile_points = profile_number(ast, &profile_sum);
+    // 插桩时不内联：函数的计数要是真实的调用次数（-fprofile-use 据此决定内联），
+    // 函数级剖析里也要能看到每个函数；同理不在编译期求值调用，也不克隆特化版本
+    if (profile_generate || instrument_functions) {
+        inline_enabled = 0;
+        eval_pure_calls = 0;
+        clone_functions = 0;
+    }
+    if (profile_use && optimize) {
+        char error[256];
+        int runs = profile_load(profile_use, profile_points, profile_sum, error, sizeof(error));
+        if (runs < 0) {
+            fprintf(stderr, "Warning: %s; compiling without profile\n", error);
+        } else if (verbose) {
+            printf("Profile: %d runs of %d points loaded from %s\n", runs, profile_points, profile_use);
+        }
+    }
+
+    // 优化：内联 -> 过程间常量传播与特化 -> 常量折叠 -> SSA 上的稀疏条件常量传播 -> 再次折叠暴露出的恒等式
+    //       -> 编译期求值常量实参的纯函数调用（结果再折叠一次）-> 全局值编号
+    //       -> 循环优化 -> 死代码消除
+    if (optimize) {
+        int inlined = inline_enabled ? inline_functions(ast) : 0;
+        int specialized = 0;
+        int constant_params = ipa_cp ? ipcp_optimize_program(ast, run, clone_functions, &specialized) : 0;
+        int folded = fold_constants(ast);
+        int propagated = sccp_optimize_program(ast, verbose);
+        folded += fold_constants(ast);
+        int evaluated = eval_pure_calls ? evaluate_pure_calls(ast) : 0;
+        if (evaluated) folded += fold_constants(ast);
+        int numbered = gvn_optimize_program(ast);
+        int reduced = 0;
+        int hoisted = loop_optimize_program(ast, unroll_factor > 0, &reduced);
+        DeadCodeStats dead;
+        eliminate_dead_code(ast, run, &dead);
+        if (verbose) {
+            printf("Inlining: %d call sites\n", inlined);
+            printf("IPCP: %d constant parameters propagated, %d specialized clones\n", constant_params, specialized);
+            printf("Constant folding: %d rewrites\n", folded);
+            printf("SCCP: %d rewrites\n", propagated);
+            printf("Compile-time evaluation: %d calls replaced by constants\n", evaluated);
+            printf("GVN: %d redundant expressions replaced\n", numbered);
+            printf("Loops: %d invariant expressions hoisted, %d induction multiplies reduced\n", hoisted, reduced);
+            printf("Dead code: %d stores, %d expressions, %d unreachable statements, %d functions removed\n",
+                   dead.stores, dead.expressions, dead.statements, dead.functions);
+        }
+    }
     
     // 代码生成
-    FILE* output = fopen(output_file, "w");
-    if (!output) {
+    FILE* output = run ? NULL : fopen(output_file, generate_object ? "wb" : "w");
+    if (!run && !output) {
         fprintf(stderr, "Failed to open output file: %s\n", output_file);
         parser_free(parser);
         lexer_free(lexer);
@@ -104,15 +292,107 @@ int main(int argc, char* argv[]) {
     }
     
     CodeGenerator* codegen = codegen_init(output);
+    codegen->optimize = optimize;
+    codegen->omit_frame_pointer = omit_frame_pointer;
+    codegen->unroll_factor = optimize ? unroll_factor : 0;
+    codegen->if_convert = optimize && if_convert;
+    codegen->vectorize = optimize && vectorize;
+    codegen->promote_locals = optimize && promote_locals;
+    codegen->reorder_blocks = optimize && reorder_blocks;
+    if (profile_generate) {
+        // then 分支的计数器要有一个分支可放，插桩时不做 if 转换；循环体计数要逐次迭代累加，也不向量化
+        codegen->profile_generate = 1;
+        codegen->profile_path = profile_generate;
+        codegen->profile_points = profile_points;
+        codegen->profile_sum = profile_sum;
+        codegen->if_convert = 0;
+        codegen->vectorize = 0;
+    }
+    if (instrument_functions) {
+        codegen->instrument_functions = 1;
+        codegen->instrument_path = instrument_functions;
+    }
+    if (generate_object || run) {
+        codegen->program = asm_list_create();
+    }
     generate_assembly(codegen, ast);
+    if (codegen->errors > 0) {
+        fprintf(stderr, "Code generation failed with %d errors\n", codegen->errors);
+        if (output) {
+            fclose(output);
+            remove(output_file);
+        }
+        codegen_free(codegen);
+        profile_free();
+        parser_free(parser);
+        lexer_free(lexer);
+        free(source);
+        return 1;
+    }
     
     if (verbose) {
         printf("Code generation completed\n");
+        if (optimize) {
+            printf("Frame layout: %d variables in %d stack slots\n", codegen->frame_vars, codegen->frame_slots);
+            printf("Register promotion: %d variables in %d callee-saved register assignments across %d functions\n",
+                   codegen->promoted_vars, codegen->promoted_slots, codegen->promoted_functions);
+            printf("Tail calls: %d self-recursive calls turned into jumps\n", codegen->tail_calls);
+            printf("Unrolling: %d loops fully, %d partially\n", codegen->unrolled_full, codegen->unrolled_partial);
+            printf("Switch: %d jump tables, %d decision trees\n", codegen->switch_tables, codegen->switch_trees);
+            printf("If-conversion: %d branches replaced by cmov\n", codegen->if_conversions);
+            printf("Vectorized loops: %d\n", codegen->vectorized);
+            printf("Block layout: %d loops rotated, %d cold blocks moved to function end\n",
+                   codegen->rotated_loops, codegen->cold_blocks);
+            if (profile_generate) {
+                printf("Profile: %d points instrumented, counts appended to %s\n", profile_points, profile_generate);
+            } else if (profile_use) {
+                printf("Profile: %d layout and unrolling decisions from measured counts\n",
+                       codegen->profile_decisions);
+            }
+            peephole_print_stats(stdout);
+        }
+    }
+
+    // JIT：不落盘，直接运行
+    if (run) {
+        int status = run_in_memory(codegen->program, program_argc, program_argv, verbose);
+        codegen_free(codegen);
+        profile_free();
+        parser_free(parser);
+        lexer_free(lexer);
+        free(source);
+        return status;
+    }
+
+    // 内置汇编器：直接编码并写出 ELF 目标文件
+    if (generate_object) {
+        ObjectFile obj;
+        char error[256];
+        int ok = x86_assemble(codegen->program, &obj, error, sizeof(error));
+        if (!ok) {
+            fprintf(stderr, "Assembler error: %s\n", error);
+        } else {
+            if (verbose) {
+                printf("Assembler: %d branches relaxed to rel32\n", obj.relaxed_branches);
+            }
+            ok = elf_write_object(&obj, output);
+            obj_free(&obj);
+        }
+        if (!ok) {
+            fclose(output);
+            remove(output_file);
+            codegen_free(codegen);
+            parser_free(parser);
+            lexer_free(lexer);
+            free(source);
+            return 1;
+        }
     }
     
     // 清理
     fclose(output);
     codegen_free(codegen);
+    profile_free();
     parser_free(parser);
     lexer_free(lexer);
     free(source);
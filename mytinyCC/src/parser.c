@@ -11,6 +11,13 @@ Parser* create_parser(Lexer* lexer) {
     
     parser->lexer = lexer;
     parser->error_count = 0;
+    parser->in_switch = 0;
+    parser->scope_names = NULL;
+    parser->scope_renamed = NULL;
+    parser->scope_count = 0;
+    parser->scope_capacity = 0;
+    parser->scope_start = 0;
+    parser->renamed = 0;
     
     // Initialize with first two tokens
     parser->current_token = get_next_token(lexer);
@@ -19,8 +26,13 @@ Parser* create_parser(Lexer* lexer) {
     return parser;
 }
 
+static void scope_pop(Parser* parser, int start);
+
 void destroy_parser(Parser* parser) {
     if (parser) {
+        scope_pop(parser, 0);
+        free(parser->scope_names);
+        free(parser->scope_renamed);
         destroy_token(&parser->current_token);
         destroy_token(&parser->peek_token);
         free(parser);
@@ -49,6 +61,10 @@ void parser_free(Parser* parser) {
     
     // Reset error count
     parser->error_count = 0;
+
+    scope_pop(parser, 0);
+    free(parser->scope_names);
+    free(parser->scope_renamed);
     
     // Free the parser structure itself
     free(parser);
@@ -67,6 +83,13 @@ Parser* parser_init(const char* source) {
     }
     
     parser->error_count = 0;
+    parser->in_switch = 0;
+    parser->scope_names = NULL;
+    parser->scope_renamed = NULL;
+    parser->scope_count = 0;
+    parser->scope_capacity = 0;
+    parser->scope_start = 0;
+    parser->renamed = 0;
     
     // Initialize tokens
     parser->current_token = get_next_token(parser->lexer);
@@ -119,9 +142,40 @@ void destroy_node(ASTNode* node) {
             break;
         case AST_BINARY_OP:
             free(node->data.binary.operator);
+            destroy_node(node->data.binary.left);
+            destroy_node(node->data.binary.right);
             break;
         case AST_UNARY_OP:
             free(node->data.unary.operator);
+            destroy_node(node->data.unary.operand);
+            break;
+        case AST_ASSIGNMENT:
+            free(node->data.identifier);
+            break;
+        case AST_IF:
+            destroy_node(node->data.if_stmt.condition);
+            destroy_node(node->data.if_stmt.then_branch);
+            destroy_node(node->data.if_stmt.else_branch);
+            break;
+        case AST_WHILE:
+            destroy_node(node->data.while_stmt.condition);
+            destroy_node(node->data.while_stmt.body);
+            break;
+        case AST_FOR:
+            destroy_node(node->data.for_stmt.init);
+            destroy_node(node->data.for_stmt.condition);
+            destroy_node(node->data.for_stmt.update);
+            destroy_node(node->data.for_stmt.body);
+            break;
+        case AST_SWITCH:
+            destroy_node(node->data.switch_stmt.condition);
+            destroy_node(node->data.switch_stmt.body);
+            break;
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT:
+            free(node->data.element.name);
+            destroy_node(node->data.element.index);
+            destroy_node(node->data.element.value);
             break;
         default:
             break;
@@ -130,6 +184,270 @@ void destroy_node(ASTNode* node) {
     free(node);
 }
 
+// 用 src 的内容替换 dst（保留 dst->next），src 必须已从 dst 中摘下
+void replace_node(ASTNode* dst, ASTNode* src) {
+    ASTNode* next = dst->next;
+    ASTNode* old = create_node(dst->type);
+    *old = *dst;
+    old->next = NULL;
+    destroy_node(old);
+
+    *dst = *src;
+    dst->next = next;
+    free(src);
+}
+
+// 深拷贝一棵子树（连同 next 链上的兄弟节点）
+ASTNode* copy_node(ASTNode* node) {
+    if (!node) return NULL;
+    ASTNode* copy = create_node(node->type);
+    *copy = *node;
+    copy->left = copy_node(node->left);
+    copy->right = copy_node(node->right);
+    copy->next = copy_node(node->next);
+
+    switch (node->type) {
+        case AST_FUNCTION:
+            copy->data.function.name = COPY_STRING(node->data.function.name);
+            copy->data.function.params = copy_node(node->data.function.params);
+            copy->data.function.body = copy_node(node->data.function.body);
+            break;
+        case AST_IDENTIFIER:
+        case AST_ASSIGNMENT:
+            copy->data.identifier = COPY_STRING(node->data.identifier);
+            break;
+        case AST_LITERAL:
+            copy->data.literal.value = COPY_STRING(node->data.literal.value);
+            break;
+        case AST_CALL:
+            copy->data.call.name = COPY_STRING(node->data.call.name);
+            copy->data.call.args = copy_node(node->data.call.args);
+            break;
+        case AST_DECLARATION:
+            copy->data.declaration.name = COPY_STRING(node->data.declaration.name);
+            copy->data.declaration.type = COPY_STRING(node->data.declaration.type);
+            copy->data.declaration.initializer = copy_node(node->data.declaration.initializer);
+            break;
+        case AST_BINARY_OP:
+            copy->data.binary.operator = COPY_STRING(node->data.binary.operator);
+            copy->data.binary.left = copy_node(node->data.binary.left);
+            copy->data.binary.right = copy_node(node->data.binary.right);
+            break;
+        case AST_UNARY_OP:
+            copy->data.unary.operator = COPY_STRING(node->data.unary.operator);
+            copy->data.unary.operand = copy_node(node->data.unary.operand);
+            break;
+        case AST_IF:
+            copy->data.if_stmt.condition = copy_node(node->data.if_stmt.condition);
+            copy->data.if_stmt.then_branch = copy_node(node->data.if_stmt.then_branch);
+            copy->data.if_stmt.else_branch = copy_node(node->data.if_stmt.else_branch);
+            break;
+        case AST_WHILE:
+            copy->data.while_stmt.condition = copy_node(node->data.while_stmt.condition);
+            copy->data.while_stmt.body = copy_node(node->data.while_stmt.body);
+            break;
+        case AST_FOR:
+            copy->data.for_stmt.init = copy_node(node->data.for_stmt.init);
+            copy->data.for_stmt.condition = copy_node(node->data.for_stmt.condition);
+            copy->data.for_stmt.update = copy_node(node->data.for_stmt.update);
+            copy->data.for_stmt.body = copy_node(node->data.for_stmt.body);
+            break;
+        case AST_SWITCH:
+            copy->data.switch_stmt.condition = copy_node(node->data.switch_stmt.condition);
+            copy->data.switch_stmt.body = copy_node(node->data.switch_stmt.body);
+            break;
+        case AST_INDEX:
+        case AST_INDEX_ASSIGNMENT:
+            copy->data.element.name = COPY_STRING(node->data.element.name);
+            copy->data.element.index = copy_node(node->data.element.index);
+            copy->data.element.value = copy_node(node->data.element.value);
+            break;
+        default:
+            break;
+    }
+    return copy;
+}
+
+// 将表达式节点原地改写为整数字面量
+void make_literal_node(ASTNode* node, int value) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d", value);
+    ASTNode* literal = create_node(AST_LITERAL);
+    literal->line = node->line;
+    literal->column = node->column;
+    literal->data.literal.value = strdup(buffer);
+    literal->data.literal.value_type = TOK_NUMBER;
+    replace_node(node, literal);
+}
+
+// 将语句节点原地改写为空块
+void make_empty_block(ASTNode* node) {
+    ASTNode* block = create_node(AST_BLOCK);
+    block->line = node->line;
+    block->column = node->column;
+    replace_node(node, block);
+}
+
+// 表达式求值是否有副作用（赋值、函数调用）
+int node_has_side_effects(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case AST_ASSIGNMENT:
+        case AST_INDEX_ASSIGNMENT:
+        case AST_CALL:
+            return 1;
+        case AST_INDEX:
+            return node_has_side_effects(node->data.element.index);
+        case AST_BINARY_OP:
+            return node_has_side_effects(node->data.binary.left) ||
+                   node_has_side_effects(node->data.binary.right);
+        case AST_UNARY_OP:
+            return node_has_side_effects(node->data.unary.operand);
+        case AST_LITERAL:
+        case AST_IDENTIFIER:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+// 是否为整数字面量
+int node_is_constant(ASTNode* node, int* value) {
+    if (!node || node->type != AST_LITERAL || node->data.literal.value_type != TOK_NUMBER) {
+        return 0;
+    }
+    if (value) *value = (int)strtol(node->data.literal.value, NULL, 0);
+    return 1;
+}
+
+// 两棵无副作用的表达式树是否结构相同
+int same_expr(ASTNode* a, ASTNode* b) {
+    if (!a || !b || a->type != b->type) return 0;
+    switch (a->type) {
+        case AST_IDENTIFIER:
+            return strcmp(a->data.identifier, b->data.identifier) == 0;
+        case AST_LITERAL: {
+            int va, vb;
+            return node_is_constant(a, &va) && node_is_constant(b, &vb) && va == vb;
+        }
+        case AST_BINARY_OP:
+            return strcmp(a->data.binary.operator, b->data.binary.operator) == 0 &&
+                   same_expr(a->data.binary.left, b->data.binary.left) &&
+                   same_expr(a->data.binary.right, b->data.binary.right);
+        case AST_UNARY_OP:
+            return strcmp(a->data.unary.operator, b->data.unary.operator) == 0 &&
+                   same_expr(a->data.unary.operand, b->data.unary.operand);
+        default:
+            return 0;
+    }
+}
+
+// 只拷贝一个节点的子树，不带 next 链
+ASTNode* copy_expr(ASTNode* node) {
+    ASTNode* next = node->next;
+    node->next = NULL;
+    ASTNode* copy = copy_node(node);
+    node->next = next;
+    return copy;
+}
+
+// node（及其 next 链）中是否声明了 name
+int node_declares(ASTNode* node, const char* name) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_DECLARATION:
+                if (strcmp(node->data.declaration.name, name) == 0) return 1;
+                break;
+            case AST_BLOCK:
+                if (node_declares(node->left, name)) return 1;
+                break;
+            case AST_IF:
+                if (node_declares(node->data.if_stmt.then_branch, name) ||
+                    node_declares(node->data.if_stmt.else_branch, name)) return 1;
+                break;
+            case AST_WHILE:
+                if (node_declares(node->data.while_stmt.body, name)) return 1;
+                break;
+            case AST_FOR:
+                if (node_declares(node->data.for_stmt.init, name) || node_declares(node->data.for_stmt.body, name)) return 1;
+                break;
+            case AST_SWITCH:
+                if (node_declares(node->data.switch_stmt.body, name)) return 1;
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+// 对 node（及其 next 链）中的每个调用按求值树先序调用 visit（调用本身先于其实参里的调用）
+void node_visit_calls(ASTNode* node, void (*visit)(ASTNode* call, void* data), void* data) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_CALL:
+                visit(node, data);
+                node_visit_calls(node->data.call.args, visit, data);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                node_visit_calls(node->data.element.index, visit, data);
+                node_visit_calls(node->data.element.value, visit, data);
+                break;
+            case AST_BINARY_OP:
+                node_visit_calls(node->data.binary.left, visit, data);
+                node_visit_calls(node->data.binary.right, visit, data);
+                break;
+            case AST_UNARY_OP:
+                node_visit_calls(node->data.unary.operand, visit, data);
+                break;
+            case AST_DECLARATION:
+                node_visit_calls(node->data.declaration.initializer, visit, data);
+                break;
+            case AST_IF:
+                node_visit_calls(node->data.if_stmt.condition, visit, data);
+                node_visit_calls(node->data.if_stmt.then_branch, visit, data);
+                node_visit_calls(node->data.if_stmt.else_branch, visit, data);
+                break;
+            case AST_WHILE:
+                node_visit_calls(node->data.while_stmt.condition, visit, data);
+                node_visit_calls(node->data.while_stmt.body, visit, data);
+                break;
+            case AST_FOR:
+                node_visit_calls(node->data.for_stmt.init, visit, data);
+                node_visit_calls(node->data.for_stmt.condition, visit, data);
+                node_visit_calls(node->data.for_stmt.update, visit, data);
+                node_visit_calls(node->data.for_stmt.body, visit, data);
+                break;
+            case AST_SWITCH:
+                node_visit_calls(node->data.switch_stmt.condition, visit, data);
+                node_visit_calls(node->data.switch_stmt.body, visit, data);
+                break;
+            case AST_LITERAL:
+            case AST_IDENTIFIER:
+                break;
+            default:
+                node_visit_calls(node->left, visit, data);
+                break;
+        }
+    }
+}
+
+// 按名字找函数，返回它在 program 的函数链（只数 AST_FUNCTION）中的序号；有定义的优先于只有原型的声明
+int program_find_function(ASTNode* program, const char* name) {
+    int found = -1;
+    int index = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION) continue;
+        if (strcmp(node->data.function.name, name) == 0) {
+            if (node->data.function.body) return index;
+            if (found < 0) found = index;
+        }
+        index++;
+    }
+    return found;
+}
+
 void advance_token(Parser* parser) {
     destroy_token(&parser->current_token);
     parser->current_token = parser->peek_token;
@@ -161,6 +479,59 @@ void parser_error(Parser* parser, const char* message) {
     parser->error_count++;
 }
 
+// 局部变量的作用域：内层声明与外层可见的变量同名时改名为 x.N（'.' 不会出现在源码标识符里），
+// 之后各遍按名字区分变量时不会把两者混在一起
+static int scope_enter(Parser* parser) {
+    int start = parser->scope_start;
+    parser->scope_start = parser->scope_count;
+    return start;
+}
+
+static void scope_pop(Parser* parser, int count) {
+    while (parser->scope_count > count) {
+        parser->scope_count--;
+        free(parser->scope_names[parser->scope_count]);
+        free(parser->scope_renamed[parser->scope_count]);
+    }
+}
+
+static void scope_leave(Parser* parser, int start) {
+    scope_pop(parser, parser->scope_start);
+    parser->scope_start = start;
+}
+
+// 源码中的名字对应的 AST 名字，不是局部变量（全局数组、函数）时返回 NULL
+static const char* scope_lookup(Parser* parser, const char* name) {
+    for (int i = parser->scope_count - 1; i >= 0; i--) {
+        if (strcmp(parser->scope_names[i], name) == 0) return parser->scope_renamed[i];
+    }
+    return NULL;
+}
+
+static void scope_declare(Parser* parser, ASTNode* decl) {
+    const char* name = decl->data.declaration.name;
+    for (int i = parser->scope_start; i < parser->scope_count; i++) {
+        if (strcmp(parser->scope_names[i], name) == 0) {
+            parser_error(parser, "redeclaration of a variable in the same scope");
+            break;
+        }
+    }
+    if (parser->scope_count == parser->scope_capacity) {
+        parser->scope_capacity = parser->scope_capacity ? parser->scope_capacity * 2 : 16;
+        parser->scope_names = realloc(parser->scope_names, parser->scope_capacity * sizeof(char*));
+        parser->scope_renamed = realloc(parser->scope_renamed, parser->scope_capacity * sizeof(char*));
+    }
+    parser->scope_names[parser->scope_count] = COPY_STRING(name);
+    if (scope_lookup(parser, name)) {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "%s.%d", name, ++parser->renamed);
+        free(decl->data.declaration.name);
+        decl->data.declaration.name = strdup(buffer);
+    }
+    parser->scope_renamed[parser->scope_count] = COPY_STRING(decl->data.declaration.name);
+    parser->scope_count++;
+}
+
 // Fixed parse_return function
 ASTNode* parse_return(Parser* parser) {
     ASTNode* ret = create_node(AST_RETURN);
@@ -183,6 +554,8 @@ ASTNode* parse_return(Parser* parser) {
 
 ASTNode* parse_if(Parser* parser) {
     ASTNode* node = create_node(AST_IF);
+    node->line = parser->current_token.line;
+    node->column = parser->current_token.column;
     advance_token(parser); // consume 'if'
 
     expect_token(parser, TOK_LPAREN);
@@ -237,18 +610,21 @@ ASTNode* parse_program(Parser* parser) {
             parser->peek_token.type == TOK_IDENTIFIER) {
 
             // 进一步 peek 判断是否函数（必须接着是 LPAREN）
+            // 保存 lexer 状态，读完第三个 token 后整体回退
+            Lexer saved = *parser->lexer;
             Token third = get_next_token(parser->lexer);
-            if (third.type == TOK_LPAREN) {
-                // 回退 peek_token（手动重设）
-                parser->lexer->current -= third.length;
-                parser->peek_token = third;
+            TokenType third_type = third.type;
+            destroy_token(&third);
+            *parser->lexer = saved;
 
+            if (third_type == TOK_LPAREN) {
                 stmt = parse_function(parser);
             } else {
-                // 非函数，回退 lexer 状态
-                parser->lexer->current -= third.length;
-                parser->peek_token = third;
-                stmt = parse_statement(parser);
+                // 非函数：全局数组（放在 .bss）；全局标量没有存储，不支持
+                stmt = parse_declaration(parser);
+                if (stmt && stmt->data.declaration.array_size == 0) {
+                    parser_error(parser, "global scalar variables are not supported (only global arrays)");
+                }
             }
 
         } else {
@@ -271,9 +647,10 @@ ASTNode* parse_program(Parser* parser) {
 }
 
 
-// Minimal parse_declaration() as a stub
+static int constant_expression(ASTNode* node, int* value);
+
+// parse_declaration(): int x; / int x = expr; / int a[N];
 ASTNode* parse_declaration(Parser* parser) {
-    // Example: int x;
     if (parser->current_token.type == TOK_INT) {
         advance_token(parser);
         if (parser->current_token.type == TOK_IDENTIFIER) {
@@ -283,6 +660,25 @@ ASTNode* parse_declaration(Parser* parser) {
             node->data.declaration.type = COPY_STRING("int");
             node->data.declaration.name = COPY_STRING(parser->current_token.value);
             advance_token(parser);
+            if (match_token(parser, TOK_LBRACKET)) {
+                // 元素个数是正的整数常量表达式；数组不支持初始化
+                ASTNode* size = parse_expression(parser);
+                int count;
+                if (!constant_expression(size, &count) || count <= 0) {
+                    parser_error(parser, "array size is not a positive integer constant");
+                    count = 1;
+                }
+                destroy_node(size);
+                node->data.declaration.array_size = count;
+                expect_token(parser, TOK_RBRACKET);
+                if (parser->current_token.type == TOK_ASSIGN) {
+                    parser_error(parser, "array initializers are not supported");
+                }
+            } else if (match_token(parser, TOK_ASSIGN)) {
+                node->data.declaration.initializer = parse_expression(parser);
+            }
+            // 初值里的同名变量还是外层的那个，解析完初值才进入作用域
+            scope_declare(parser, node);
             expect_token(parser, TOK_SEMICOLON);
             return node;
         }
@@ -329,6 +725,11 @@ ASTNode* parse_assignment(Parser* parser) {
 
 ASTNode* parse_expression_statement(Parser* parser) {
     ASTNode* expr = parse_expression(parser);
+    if (!expr) {
+        // 跳过出错的 token，避免死循环
+        advance_token(parser);
+        return NULL;
+    }
     expect_token(parser, TOK_SEMICOLON);
     return expr;
 }
@@ -341,10 +742,28 @@ ASTNode* parse_statement(Parser* parser) {
             return parse_while(parser);
         case TOK_FOR:
             return parse_for(parser);
+        case TOK_SWITCH:
+            return parse_switch(parser);
+        case TOK_BREAK: {
+            ASTNode* node = create_node(AST_BREAK);
+            node->line = parser->current_token.line;
+            node->column = parser->current_token.column;
+            if (!parser->in_switch) parser_error(parser, "break is only supported inside switch");
+            advance_token(parser); // consume 'break'
+            expect_token(parser, TOK_SEMICOLON);
+            return node;
+        }
+        case TOK_CASE:
+        case TOK_DEFAULT:
+            parser_error(parser, "case label not directly inside a switch body");
+            advance_token(parser);
+            return NULL;
         case TOK_RETURN:
             return parse_return(parser);
         case TOK_LBRACE:
             return parse_block(parser);
+        case TOK_INT:
+            return parse_declaration(parser);
         default:
             return parse_expression_statement(parser);
     }
@@ -354,9 +773,20 @@ ASTNode* parse_statement(Parser* parser) {
 
 ASTNode* parse_expression(Parser* parser) {
     ASTNode* expr = parse_binary_expression(parser, 0);
+    if (!expr) return NULL;
+
+    // a[i] = e：读元素的节点原地改成写元素
+    if (parser->current_token.type == TOK_ASSIGN && expr->type == AST_INDEX) {
+        advance_token(parser); // consume '='
+        expr->type = AST_INDEX_ASSIGNMENT;
+        expr->data.element.value = parse_expression(parser);
+        return expr;
+    }
 
     if (parser->current_token.type == TOK_ASSIGN && expr->type == AST_IDENTIFIER) {
         ASTNode* assign = create_node(AST_ASSIGNMENT);
+        assign->line = expr->line;
+        assign->column = expr->column;
         assign->data.identifier = COPY_STRING(expr->data.identifier);
         destroy_node(expr);
         advance_token(parser); // consume '='
@@ -364,42 +794,96 @@ ASTNode* parse_expression(Parser* parser) {
         return assign;
     }
 
+    // x op= e  =>  x = x op e
+    const char* compound = NULL;
+    switch (parser->current_token.type) {
+        case TOK_PLUS_ASSIGN:  compound = "+"; break;
+        case TOK_MINUS_ASSIGN: compound = "-"; break;
+        case TOK_MULT_ASSIGN:  compound = "*"; break;
+        case TOK_DIV_ASSIGN:   compound = "/"; break;
+        case TOK_MOD_ASSIGN:   compound = "%"; break;
+        default: break;
+    }
+    // a[i] op= e  =>  a[i] = a[i] op e：下标要求值两次，不能有副作用
+    if (compound && expr->type == AST_INDEX) {
+        if (node_has_side_effects(expr->data.element.index)) {
+            parser_error(parser, "array index with side effects in compound assignment");
+        }
+        advance_token(parser); // consume 'op='
+        ASTNode* bin = create_node(AST_BINARY_OP);
+        bin->line = expr->line;
+        bin->column = expr->column;
+        bin->data.binary.operator = COPY_STRING(compound);
+        bin->data.binary.left = copy_node(expr);
+        bin->data.binary.right = parse_expression(parser);
+        expr->type = AST_INDEX_ASSIGNMENT;
+        expr->data.element.value = bin;
+        return expr;
+    }
+
+    if (compound && expr->type == AST_IDENTIFIER) {
+        advance_token(parser); // consume 'op='
+        ASTNode* bin = create_node(AST_BINARY_OP);
+        bin->line = expr->line;
+        bin->column = expr->column;
+        bin->data.binary.operator = COPY_STRING(compound);
+        bin->data.binary.left = expr;
+        bin->data.binary.right = parse_expression(parser);
+
+        ASTNode* assign = create_node(AST_ASSIGNMENT);
+        assign->line = expr->line;
+        assign->column = expr->column;
+        assign->data.identifier = COPY_STRING(expr->data.identifier);
+        assign->left = bin;
+        return assign;
+    }
+
     return expr;
 }
 
-ASTNode* parse_binary_expression(Parser* parser, int precedence) {
-    ASTNode* left = parse_primary(parser);
-    while (1) {
-        TokenType type = parser->current_token.type;
-        int current_precedence = 0;
-
-        switch (type) {
-            case TOK_PLUS:
-            case TOK_MINUS:
-                current_precedence = 1;
-                break;
-            case TOK_MULTIPLY:
-            case TOK_DIVIDE:
-                current_precedence = 2;
-                break;
-            case TOK_GREATER_THAN:
-            case TOK_LESS_THAN:
-            case TOK_EQUAL:
-            case TOK_NOT_EQUAL:
-                current_precedence = 0;
-                break;
-            default:
-                return left;
-        }
+// 二元运算符优先级（数值越大结合越紧），非二元运算符返回 -1
+static int binary_precedence(TokenType type) {
+    switch (type) {
+        case TOK_LOGICAL_OR:    return 0;
+        case TOK_LOGICAL_AND:   return 1;
+        case TOK_BITWISE_OR:    return 2;
+        case TOK_BITWISE_XOR:   return 3;
+        case TOK_BITWISE_AND:   return 4;
+        case TOK_EQUAL:
+        case TOK_NOT_EQUAL:     return 5;
+        case TOK_LESS_THAN:
+        case TOK_LESS_EQUAL:
+        case TOK_GREATER_THAN:
+        case TOK_GREATER_EQUAL: return 6;
+        case TOK_LEFT_SHIFT:
+        case TOK_RIGHT_SHIFT:   return 7;
+        case TOK_PLUS:
+        case TOK_MINUS:         return 8;
+        case TOK_MULTIPLY:
+        case TOK_DIVIDE:
+        case TOK_MODULO:        return 9;
+        default:                return -1;
+    }
+}
 
-        if (current_precedence < precedence)
+ASTNode* parse_binary_expression(Parser* parser, int precedence) {
+    ASTNode* left = parse_unary_expression(parser);
+    while (left) {
+        int current_precedence = binary_precedence(parser->current_token.type);
+        if (current_precedence < 0 || current_precedence < precedence)
             break;
 
+        // 运算符文本（"+", "<=" ...）就是 codegen 比较的内容
+        char* op = COPY_STRING(parser->current_token.value);
+        int line = parser->current_token.line;
+        int column = parser->current_token.column;
         advance_token(parser);
         ASTNode* right = parse_binary_expression(parser, current_precedence + 1);
 
         ASTNode* bin = create_node(AST_BINARY_OP);
-        bin->data.binary.operator = COPY_STRING(token_type_to_string(type));
+        bin->line = line;
+        bin->column = column;
+        bin->data.binary.operator = op;
         bin->data.binary.left = left;
         bin->data.binary.right = right;
         left = bin;
@@ -407,6 +891,48 @@ ASTNode* parse_binary_expression(Parser* parser, int precedence) {
     return left;
 }
 
+ASTNode* parse_unary_expression(Parser* parser) {
+    TokenType type = parser->current_token.type;
+    if (type == TOK_MINUS || type == TOK_LOGICAL_NOT || type == TOK_BITWISE_NOT) {
+        ASTNode* node = create_node(AST_UNARY_OP);
+        node->line = parser->current_token.line;
+        node->column = parser->current_token.column;
+        node->data.unary.operator = COPY_STRING(parser->current_token.value);
+        advance_token(parser);
+        node->data.unary.operand = parse_unary_expression(parser);
+        return node;
+    }
+    if (type == TOK_PLUS) {
+        advance_token(parser);
+        return parse_unary_expression(parser);
+    }
+    return parse_primary(parser);
+}
+
+ASTNode* parse_call(Parser* parser, ASTNode* function) {
+    ASTNode* call = create_node(AST_CALL);
+    call->line = function->line;
+    call->column = function->column;
+    call->data.call.name = COPY_STRING(function->data.identifier);
+    destroy_node(function);
+
+    expect_token(parser, TOK_LPAREN);
+    ASTNode* last = NULL;
+    while (parser->current_token.type != TOK_RPAREN && parser->current_token.type != TOK_EOF) {
+        ASTNode* arg = parse_expression(parser);
+        if (!arg) break;
+        if (!call->data.call.args) {
+            call->data.call.args = arg;
+        } else {
+            last->next = arg;
+        }
+        last = arg;
+        if (!match_token(parser, TOK_COMMA)) break;
+    }
+    expect_token(parser, TOK_RPAREN);
+    return call;
+}
+
 
 /*
 ASTNode* parse_expression(Parser* parser) {
@@ -454,14 +980,38 @@ ASTNode* parse_binary_expression(Parser* parser, int precedence) {
 ASTNode* parse_primary(Parser* parser) {
     if (parser->current_token.type == TOK_NUMBER) {
         ASTNode* node = create_node(AST_LITERAL);
+        node->line = parser->current_token.line;
+        node->column = parser->current_token.column;
         node->data.literal.value = COPY_STRING(parser->current_token.value);
         node->data.literal.value_type = TOK_NUMBER;
         advance_token(parser);
         return node;
     } else if (parser->current_token.type == TOK_IDENTIFIER) {
         ASTNode* node = create_node(AST_IDENTIFIER);
+        node->line = parser->current_token.line;
+        node->column = parser->current_token.column;
         node->data.identifier = COPY_STRING(parser->current_token.value);
         advance_token(parser);
+        if (parser->current_token.type == TOK_LPAREN) {
+            return parse_call(parser, node);
+        }
+        const char* renamed = scope_lookup(parser, node->data.identifier);
+        if (renamed && strcmp(renamed, node->data.identifier) != 0) {
+            free(node->data.identifier);
+            node->data.identifier = COPY_STRING(renamed);
+        }
+        if (match_token(parser, TOK_LBRACKET)) {
+            // a[i]：名字挪进元素节点
+            ASTNode* element = create_node(AST_INDEX);
+            element->line = node->line;
+            element->column = node->column;
+            element->data.element.name = node->data.identifier;
+            element->data.element.index = parse_expression(parser);
+            node->data.identifier = NULL;
+            destroy_node(node);
+            expect_token(parser, TOK_RBRACKET);
+            return element;
+        }
         return node;
     } else if (parser->current_token.type == TOK_LPAREN) {
         advance_token(parser);
@@ -477,18 +1027,163 @@ ASTNode* parse_primary(Parser* parser) {
 
 
 ASTNode* parse_while(Parser* parser) {
-    parser_error(parser, "parse_while not implemented");
-    return NULL;
+    ASTNode* node = create_node(AST_WHILE);
+    node->line = parser->current_token.line;
+    node->column = parser->current_token.column;
+    advance_token(parser); // consume 'while'
+
+    expect_token(parser, TOK_LPAREN);
+    node->data.while_stmt.condition = parse_expression(parser);
+    expect_token(parser, TOK_RPAREN);
+
+    int in_switch = parser->in_switch;
+    parser->in_switch = 0;
+    node->data.while_stmt.body = parse_statement(parser);
+    parser->in_switch = in_switch;
+    return node;
 }
 
 ASTNode* parse_for(Parser* parser) {
-    parser_error(parser, "parse_for not implemented");
-    return NULL;
+    ASTNode* node = create_node(AST_FOR);
+    node->line = parser->current_token.line;
+    node->column = parser->current_token.column;
+    advance_token(parser); // consume 'for'
+
+    expect_token(parser, TOK_LPAREN);
+    int scope = scope_enter(parser);
+    if (parser->current_token.type == TOK_INT) {
+        node->data.for_stmt.init = parse_declaration(parser); // 消耗 ';'
+    } else {
+        if (parser->current_token.type != TOK_SEMICOLON) {
+            node->data.for_stmt.init = parse_expression(parser);
+        }
+        expect_token(parser, TOK_SEMICOLON);
+    }
+
+    if (parser->current_token.type != TOK_SEMICOLON) {
+        node->data.for_stmt.condition = parse_expression(parser);
+    }
+    expect_token(parser, TOK_SEMICOLON);
+
+    if (parser->current_token.type != TOK_RPAREN) {
+        node->data.for_stmt.update = parse_expression(parser);
+    }
+    expect_token(parser, TOK_RPAREN);
+
+    int in_switch = parser->in_switch;
+    parser->in_switch = 0;
+    node->data.for_stmt.body = parse_statement(parser);
+    parser->in_switch = in_switch;
+    scope_leave(parser, scope);
+    return node;
+}
+
+// case 标签的整数常量表达式
+static int constant_expression(ASTNode* node, int* value) {
+    if (!node) return 0;
+    if (node_is_constant(node, value)) return 1;
+    int a, b;
+    if (node->type == AST_UNARY_OP) {
+        if (!constant_expression(node->data.unary.operand, &a)) return 0;
+        const char* op = node->data.unary.operator;
+        if (strcmp(op, "-") == 0) *value = (int)(0u - (unsigned int)a);
+        else if (strcmp(op, "~") == 0) *value = ~a;
+        else if (strcmp(op, "!") == 0) *value = !a;
+        else return 0;
+        return 1;
+    }
+    if (node->type != AST_BINARY_OP || !constant_expression(node->data.binary.left, &a) ||
+        !constant_expression(node->data.binary.right, &b)) {
+        return 0;
+    }
+    const char* op = node->data.binary.operator;
+    if (strcmp(op, "+") == 0) *value = (int)((unsigned int)a + (unsigned int)b);
+    else if (strcmp(op, "-") == 0) *value = (int)((unsigned int)a - (unsigned int)b);
+    else if (strcmp(op, "*") == 0) *value = (int)((unsigned int)a * (unsigned int)b);
+    else if (strcmp(op, "&") == 0) *value = a & b;
+    else if (strcmp(op, "|") == 0) *value = a | b;
+    else if (strcmp(op, "^") == 0) *value = a ^ b;
+    else if (strcmp(op, "<<") == 0 && b >= 0 && b < 32) *value = (int)((unsigned int)a << b);
+    else if (strcmp(op, ">>") == 0 && b >= 0 && b < 32) *value = a >> b;
+    else return 0;
+    return 1;
+}
+
+// case N: / default:，标签后面的语句照常接在块的语句链上
+static ASTNode* parse_case_label(Parser* parser, ASTNode* body) {
+    ASTNode* label = create_node(AST_CASE);
+    label->line = parser->current_token.line;
+    label->column = parser->current_token.column;
+    if (match_token(parser, TOK_DEFAULT)) {
+        label->data.case_label.is_default = 1;
+    } else {
+        advance_token(parser); // consume 'case'
+        ASTNode* expr = parse_expression(parser);
+        if (!constant_expression(expr, &label->data.case_label.value)) {
+            parser_error(parser, "case label is not an integer constant");
+        }
+        destroy_node(expr);
+    }
+    expect_token(parser, TOK_COLON);
+
+    for (ASTNode* other = body->left; other; other = other->next) {
+        if (other->type != AST_CASE) continue;
+        if (other->data.case_label.is_default && label->data.case_label.is_default) {
+            parser_error(parser, "multiple default labels in one switch");
+        } else if (!other->data.case_label.is_default && !label->data.case_label.is_default &&
+                   other->data.case_label.value == label->data.case_label.value) {
+            parser_error(parser, "duplicate case value");
+        }
+    }
+    return label;
+}
+
+// switch (expr) { case ...: ... }：case 标签只能出现在 switch 的块的顶层
+ASTNode* parse_switch(Parser* parser) {
+    ASTNode* node = create_node(AST_SWITCH);
+    node->line = parser->current_token.line;
+    node->column = parser->current_token.column;
+    advance_token(parser); // consume 'switch'
+
+    expect_token(parser, TOK_LPAREN);
+    node->data.switch_stmt.condition = parse_expression(parser);
+    expect_token(parser, TOK_RPAREN);
+
+    ASTNode* body = create_node(AST_BLOCK);
+    body->line = parser->current_token.line;
+    body->column = parser->current_token.column;
+    node->data.switch_stmt.body = body;
+    expect_token(parser, TOK_LBRACE);
+
+    int in_switch = parser->in_switch;
+    parser->in_switch = 1;
+    int scope = scope_enter(parser);
+    ASTNode* current = NULL;
+    while (parser->current_token.type != TOK_RBRACE && parser->current_token.type != TOK_EOF) {
+        ASTNode* stmt;
+        if (parser->current_token.type == TOK_CASE || parser->current_token.type == TOK_DEFAULT) {
+            stmt = parse_case_label(parser, body);
+        } else {
+            stmt = parse_statement(parser);
+        }
+        if (!stmt) break;
+        if (!body->left) {
+            body->left = stmt;
+        } else {
+            current->next = stmt;
+        }
+        current = stmt;
+    }
+    scope_leave(parser, scope);
+    parser->in_switch = in_switch;
+    expect_token(parser, TOK_RBRACE);
+    return node;
 }
 
 ASTNode* parse_block(Parser* parser) {
     expect_token(parser, TOK_LBRACE);
     ASTNode* block = create_node(AST_BLOCK);
+    int scope = scope_enter(parser);
     ASTNode* current = NULL;
     while (parser->current_token.type != TOK_RBRACE && parser->current_token.type != TOK_EOF) {
         ASTNode* stmt = parse_statement(parser);
@@ -501,6 +1196,7 @@ ASTNode* parse_block(Parser* parser) {
             current = stmt;
         }
     }
+    scope_leave(parser, scope);
     expect_token(parser, TOK_RBRACE);
     return block;
 }
@@ -521,10 +1217,17 @@ ASTNode* parse_function(Parser* parser) {
     // 3. (
     if (!expect_token(parser, TOK_LPAREN)) return NULL;
 
-    // 4. 参数列表
+    // 4. 参数列表（参数是函数里最外层的局部变量）
+    scope_pop(parser, 0);
+    parser->scope_start = 0;
     ASTNode* param_list = NULL;
     ASTNode* last_param = NULL;
 
+    // int f(void)
+    if (parser->current_token.type == TOK_VOID && parser->peek_token.type == TOK_RPAREN) {
+        advance_token(parser);
+    }
+
     while (parser->current_token.type != TOK_RPAREN && parser->current_token.type != TOK_EOF) {
         // 类型 + 标识符
         if (parser->current_token.type != TOK_INT &&
@@ -547,6 +1250,7 @@ ASTNode* parse_function(Parser* parser) {
         param->data.declaration.type = param_type;
         param->data.declaration.initializer = NULL;
         advance_token(parser);
+        scope_declare(parser, param);
 
         // 连接参数链表
         if (!param_list) {
@@ -569,6 +1273,7 @@ ASTNode* parse_function(Parser* parser) {
 
     // 6. 函数体
     ASTNode* body = parse_block(parser); // parse_block() 应返回 AST_BLOCK
+    scope_pop(parser, 0);
 
     // 7. 创建函数节点
     ASTNode* func_node = create_node(AST_FUNCTION);
@@ -0,0 +1,436 @@
+#include "asm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 窥孔优化：在结构化指令流上滑动窗口，按规则匹配并改写，直到不再变化。
+// 每条规则记录命中次数，-v 时输出。
+
+#define MAX_WINDOW 5
+#define MAX_PASSES 8
+#define LIVENESS_BUDGET 64
+
+enum { EFFECT_NONE = 0, EFFECT_READ, EFFECT_KILL };
+
+typedef int (*PeepholeApply)(AsmList* list, AsmInsn** w, int n);
+
+typedef struct {
+    const char* name;
+    int window;
+    PeepholeApply apply;
+    int hits;
+} PeepholeRule;
+
+static void delete_insn(AsmInsn* insn) {
+    insn->deleted = 1;
+}
+
+static int starts_with(const char* s, const char* prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static int is_callee_saved(int reg) {
+    return reg == REG_RBX || reg == REG_RBP || reg == REG_RSP ||
+           (reg >= REG_R12 && reg <= REG_R15);
+}
+
+static int is_arg_reg(int reg) {
+    return reg == REG_RDI || reg == REG_RSI || reg == REG_RDX || reg == REG_RCX ||
+           reg == REG_R8 || reg == REG_R9;
+}
+
+// 一条指令对寄存器 reg 的作用：读取、整体覆盖（杀死旧值）或无关
+static int reg_effect(const AsmInsn* insn, int reg) {
+    const char* m = insn->mnemonic;
+    int n = insn->nops;
+
+    // 所有内存操作数中的地址寄存器都是读
+    for (int i = 0; i < n; i++) {
+        if (insn->ops[i].kind == OPND_MEM && asm_operand_uses_reg(&insn->ops[i], reg)) {
+            return EFFECT_READ;
+        }
+        if (insn->ops[i].kind == OPND_RAW) return EFFECT_READ;
+    }
+
+    if (strcmp(m, "call") == 0) {
+        if (n && insn->ops[0].indirect && asm_operand_uses_reg(&insn->ops[0], reg)) return EFFECT_READ;
+        if (is_arg_reg(reg)) return EFFECT_READ;
+        return is_callee_saved(reg) ? EFFECT_NONE : EFFECT_KILL;
+    }
+    if (strcmp(m, "cltd") == 0 || strcmp(m, "cqto") == 0) {
+        if (reg == REG_RAX) return EFFECT_READ;
+        return reg == REG_RDX ? EFFECT_KILL : EFFECT_NONE;
+    }
+    if (strcmp(m, "rdtsc") == 0) {
+        return (reg == REG_RAX || reg == REG_RDX) ? EFFECT_KILL : EFFECT_NONE;
+    }
+    if (strcmp(m, "cltq") == 0) {
+        return reg == REG_RAX ? EFFECT_READ : EFFECT_NONE;
+    }
+    if (starts_with(m, "idiv") || starts_with(m, "div")) {
+        if (reg == REG_RAX || reg == REG_RDX) return EFFECT_READ;
+        return asm_operand_uses_reg(&insn->ops[0], reg) ? EFFECT_READ : EFFECT_NONE;
+    }
+    if (strcmp(m, "leave") == 0) {
+        return (reg == REG_RBP || reg == REG_RSP) ? EFFECT_READ : EFFECT_NONE;
+    }
+    if (strcmp(m, "nop") == 0) return EFFECT_NONE;
+    if (m[0] == 'j') {
+        return (n && asm_operand_uses_reg(&insn->ops[0], reg)) ? EFFECT_READ : EFFECT_NONE;
+    }
+    if (starts_with(m, "push")) {
+        return (reg == REG_RSP || asm_operand_uses_reg(&insn->ops[0], reg)) ? EFFECT_READ : EFFECT_NONE;
+    }
+    if (starts_with(m, "pop")) {
+        if (reg == REG_RSP) return EFFECT_READ;
+        return asm_is_reg(&insn->ops[0], reg) ? EFFECT_KILL : EFFECT_NONE;
+    }
+    if (n == 0) return EFFECT_READ;  // 未知的无操作数指令，保守处理
+
+    // 源操作数
+    for (int i = 0; i < n - 1; i++) {
+        if (asm_operand_uses_reg(&insn->ops[i], reg)) {
+            // xorl %eax, %eax 这类清零写法不依赖旧值
+            if ((starts_with(m, "xor") || starts_with(m, "sub")) && n == 2 &&
+                asm_same_operand(&insn->ops[0], &insn->ops[1]) && insn->ops[1].size >= 4) {
+                return EFFECT_KILL;
+            }
+            return EFFECT_READ;
+        }
+    }
+
+    // 目的操作数
+    const AsmOperand* dst = &insn->ops[n - 1];
+    if (!asm_is_reg(dst, reg)) {
+        // 隐式读写 eax/edx 的单操作数乘法
+        if (n == 1 && (starts_with(m, "imul") || starts_with(m, "mul")) &&
+            (reg == REG_RAX || reg == REG_RDX)) {
+            return EFFECT_READ;
+        }
+        return EFFECT_NONE;
+    }
+    // 32/64 位的 mov/lea 整体覆盖目的寄存器；其余（含 setcc、cmov）都依赖旧值
+    if ((starts_with(m, "mov") || starts_with(m, "lea")) && dst->size >= 4) return EFFECT_KILL;
+    return EFFECT_READ;
+}
+
+static int find_label(AsmList* list, const char* name) {
+    for (int i = 0; i < list->count; i++) {
+        AsmInsn* insn = &list->items[i];
+        if (!insn->deleted && insn->kind == ASM_LABEL && strcmp(insn->text, name) == 0) return i;
+    }
+    return -1;
+}
+
+// 从 start 开始沿控制流判断 reg 的当前值是否已死（不会再被读取）
+static int reg_dead_from(AsmList* list, int start, int reg, int budget) {
+    for (int i = start; i < list->count; i++) {
+        if (--budget <= 0) return 0;
+        AsmInsn* insn = &list->items[i];
+        if (insn->deleted || insn->kind == ASM_LABEL) continue;
+        // 循环头的对齐填充不影响数据流，其余伪指令（切换段等）保守处理
+        if (insn->kind == ASM_DIRECTIVE && !starts_with(insn->text, ".p2align")) return 0;
+
+        if (asm_is(insn, "ret")) {
+            return reg != REG_RAX && reg != REG_RDX && !is_callee_saved(reg);
+        }
+        if (asm_is_jump(insn)) {
+            if (insn->nops != 1 || insn->ops[0].kind != OPND_SYM) return 0;
+            int target = find_label(list, insn->ops[0].sym);
+            if (target < 0) return 0;
+            if (!asm_is_cond_jump(insn)) {
+                i = target;
+                continue;
+            }
+            if (!reg_dead_from(list, target + 1, reg, budget)) return 0;
+            continue;
+        }
+
+        int effect = reg_effect(insn, reg);
+        if (effect == EFFECT_READ) return 0;
+        if (effect == EFFECT_KILL) return 1;
+    }
+    return 0;
+}
+
+static int index_of(AsmList* list, AsmInsn* insn) {
+    return (int)(insn - list->items);
+}
+
+static int all_insns(AsmInsn** w, int n) {
+    for (int i = 0; i < n; i++) {
+        if (w[i]->kind != ASM_INSN) return 0;
+    }
+    return 1;
+}
+
+static void set_reg(AsmOperand* op, int reg, int size) {
+    free(op->sym);
+    memset(op, 0, sizeof(*op));
+    op->kind = OPND_REG;
+    op->reg = reg;
+    op->index = REG_NONE;
+    op->size = size;
+}
+
+static void copy_operand(AsmOperand* dst, const AsmOperand* src) {
+    free(dst->sym);
+    *dst = *src;
+    dst->sym = src->sym ? strdup(src->sym) : NULL;
+}
+
+// pushq %rax; popq %rax  =>  (删除)
+static int rule_push_pop_same(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 2 || !all_insns(w, 2)) return 0;
+    if (!asm_is(w[0], "pushq") || !asm_is(w[1], "popq")) return 0;
+    if (!asm_same_operand(&w[0]->ops[0], &w[1]->ops[0])) return 0;
+    delete_insn(w[0]);
+    delete_insn(w[1]);
+    return 1;
+}
+
+// pushq X; popq %r  =>  movq X, %r
+static int rule_push_pop_move(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 2 || !all_insns(w, 2)) return 0;
+    if (!asm_is(w[0], "pushq") || !asm_is(w[1], "popq")) return 0;
+    if (w[1]->ops[0].kind != OPND_REG || w[0]->ops[0].kind == OPND_MEM) return 0;
+    if (asm_operand_uses_reg(&w[0]->ops[0], REG_RSP)) return 0;
+    strcpy(w[1]->mnemonic, "movq");
+    w[1]->ops[1] = w[1]->ops[0];
+    w[1]->ops[0] = w[0]->ops[0];
+    w[0]->ops[0].sym = NULL;
+    w[1]->nops = 2;
+    delete_insn(w[0]);
+    return 1;
+}
+
+// pushq %rax; movl X, %eax; movl %eax, %r; popq %rax  =>  movl X, %r
+static int rule_push_load_pop(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 4 || !all_insns(w, 4)) return 0;
+    if (!asm_is(w[0], "pushq") || !asm_is_reg(&w[0]->ops[0], REG_RAX)) return 0;
+    if (!asm_is(w[1], "movl") || !asm_is_reg(&w[1]->ops[1], REG_RAX)) return 0;
+    if (!asm_is(w[2], "movl") || !asm_is_reg(&w[2]->ops[0], REG_RAX)) return 0;
+    if (w[2]->ops[1].kind != OPND_REG) return 0;
+    if (!asm_is(w[3], "popq") || !asm_is_reg(&w[3]->ops[0], REG_RAX)) return 0;
+
+    int dst = w[2]->ops[1].reg;
+    if (dst == REG_RAX || dst == REG_RSP) return 0;
+    if (asm_operand_uses_reg(&w[1]->ops[0], REG_RSP)) return 0;
+
+    copy_operand(&w[2]->ops[0], &w[1]->ops[0]);
+    delete_insn(w[0]);
+    delete_insn(w[1]);
+    delete_insn(w[3]);
+    return 1;
+}
+
+// movl %r, M; movl M, %s  =>  movl %r, M; movl %r, %s
+static int rule_store_reload(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 2 || !all_insns(w, 2)) return 0;
+    if (strcmp(w[0]->mnemonic, w[1]->mnemonic) != 0) return 0;
+    if (!asm_is(w[0], "movl") && !asm_is(w[0], "movq")) return 0;
+    AsmOperand* src = &w[0]->ops[0];
+    AsmOperand* mem = &w[0]->ops[1];
+    if (src->kind != OPND_REG || mem->kind != OPND_MEM) return 0;
+    if (!asm_same_operand(mem, &w[1]->ops[0]) || w[1]->ops[1].kind != OPND_REG) return 0;
+
+    if (asm_same_operand(src, &w[1]->ops[1])) {
+        delete_insn(w[1]);
+    } else {
+        set_reg(&w[1]->ops[0], src->reg, src->size);
+    }
+    return 1;
+}
+
+// 在 %eax 里算完再写回的双操作数运算，寄存器变量可以直接原地运算
+static int is_in_place_op(const AsmInsn* insn) {
+    static const char* ops2[] = { "addl", "subl", "andl", "orl", "xorl", "imull", "sall", "sarl", "shrl" };
+    static const char* ops1[] = { "negl", "notl" };
+    if (insn->nops == 2) {
+        for (size_t i = 0; i < sizeof(ops2) / sizeof(ops2[0]); i++) {
+            if (asm_is(insn, ops2[i])) return 1;
+        }
+    } else if (insn->nops == 1) {
+        for (size_t i = 0; i < sizeof(ops1) / sizeof(ops1[0]); i++) {
+            if (asm_is(insn, ops1[i])) return 1;
+        }
+    }
+    return 0;
+}
+
+// movl %r, %eax; op X, %eax; movl %eax, %r  =>  op X, %r（之后 %eax 不再被读取）
+static int rule_op_in_place(AsmList* list, AsmInsn** w, int n) {
+    if (n < 3 || !all_insns(w, 3)) return 0;
+    if (!asm_is(w[0], "movl") || w[0]->ops[0].kind != OPND_REG || !asm_is_reg(&w[0]->ops[1], REG_RAX)) return 0;
+    int reg = w[0]->ops[0].reg;
+    if (reg == REG_RAX || reg == REG_RSP || reg == REG_RBP) return 0;
+    if (!is_in_place_op(w[1]) || !asm_is_reg(&w[1]->ops[w[1]->nops - 1], REG_RAX)) return 0;
+    if (w[1]->nops == 2 && asm_operand_uses_reg(&w[1]->ops[0], REG_RAX)) return 0;
+    if (!asm_is(w[2], "movl") || !asm_is_reg(&w[2]->ops[0], REG_RAX) || !asm_is_reg(&w[2]->ops[1], reg)) return 0;
+    if (!reg_dead_from(list, index_of(list, w[2]) + 1, REG_RAX, LIVENESS_BUDGET)) return 0;
+
+    set_reg(&w[1]->ops[w[1]->nops - 1], reg, 4);
+    delete_insn(w[0]);
+    delete_insn(w[2]);
+    return 1;
+}
+
+// movl X, %eax; movl %eax, %r  =>  movl X, %r（之后 %eax 不再被读取）
+static int rule_move_direct(AsmList* list, AsmInsn** w, int n) {
+    if (n < 2 || !all_insns(w, 2)) return 0;
+    if (!asm_is(w[0], "movl") || !asm_is_reg(&w[0]->ops[1], REG_RAX)) return 0;
+    if (w[0]->ops[0].kind == OPND_RAW || asm_operand_uses_reg(&w[0]->ops[0], REG_RAX)) return 0;
+    if (!asm_is(w[1], "movl") || !asm_is_reg(&w[1]->ops[0], REG_RAX) || w[1]->ops[1].kind != OPND_REG) return 0;
+    int reg = w[1]->ops[1].reg;
+    if (reg == REG_RAX || reg == REG_RSP || reg == REG_RBP) return 0;
+    if (!reg_dead_from(list, index_of(list, w[1]) + 1, REG_RAX, LIVENESS_BUDGET)) return 0;
+
+    copy_operand(&w[1]->ops[0], &w[0]->ops[0]);
+    delete_insn(w[0]);
+    return 1;
+}
+
+// movl %r, %eax; cmpl X, %eax  =>  cmpl X, %r（之后 %eax 不再被读取）
+static int rule_compare_in_place(AsmList* list, AsmInsn** w, int n) {
+    if (n < 2 || !all_insns(w, 2)) return 0;
+    if (!asm_is(w[0], "movl") || w[0]->ops[0].kind != OPND_REG || !asm_is_reg(&w[0]->ops[1], REG_RAX)) return 0;
+    int reg = w[0]->ops[0].reg;
+    if (reg == REG_RAX || reg == REG_RSP || reg == REG_RBP) return 0;
+    if (!asm_is(w[1], "cmpl") || !asm_is_reg(&w[1]->ops[1], REG_RAX)) return 0;
+    if (asm_operand_uses_reg(&w[1]->ops[0], REG_RAX)) return 0;
+    if (!reg_dead_from(list, index_of(list, w[1]) + 1, REG_RAX, LIVENESS_BUDGET)) return 0;
+
+    set_reg(&w[1]->ops[1], reg, 4);
+    delete_insn(w[0]);
+    return 1;
+}
+
+// cmp A, B; setCC %al; movzbl %al, %eax; cmpl $0, %eax; je/jne L  =>  cmp A, B; jCC' L
+static int rule_setcc_branch(AsmList* list, AsmInsn** w, int n) {
+    if (n < 5 || !all_insns(w, 5)) return 0;
+    if (!starts_with(w[0]->mnemonic, "cmp") && !starts_with(w[0]->mnemonic, "test")) return 0;
+    if (!starts_with(w[1]->mnemonic, "set") || !asm_is_reg(&w[1]->ops[0], REG_RAX)) return 0;
+    if (!asm_is(w[2], "movzbl") || !asm_is_reg(&w[2]->ops[0], REG_RAX) ||
+        !asm_is_reg(&w[2]->ops[1], REG_RAX)) return 0;
+
+    int is_zero_test = 0;
+    if (asm_is(w[3], "cmpl") && w[3]->ops[0].kind == OPND_IMM && !w[3]->ops[0].sym &&
+        w[3]->ops[0].imm == 0 && asm_is_reg(&w[3]->ops[1], REG_RAX)) is_zero_test = 1;
+    if (asm_is(w[3], "testl") && asm_is_reg(&w[3]->ops[0], REG_RAX) &&
+        asm_is_reg(&w[3]->ops[1], REG_RAX)) is_zero_test = 1;
+    if (!is_zero_test) return 0;
+
+    int jump_if_false;
+    if (asm_is(w[4], "je")) jump_if_false = 1;
+    else if (asm_is(w[4], "jne")) jump_if_false = 0;
+    else return 0;
+    if (w[4]->ops[0].kind != OPND_SYM) return 0;
+
+    const char* cc = w[1]->mnemonic + 3;
+    const char* new_cc = jump_if_false ? asm_invert_cc(cc) : cc;
+    if (!new_cc) return 0;
+
+    // 条件值只被这次跳转使用时才能丢掉 eax 中的布尔结果
+    int target = find_label(list, w[4]->ops[0].sym);
+    if (target < 0) return 0;
+    if (!reg_dead_from(list, index_of(list, w[4]) + 1, REG_RAX, LIVENESS_BUDGET) ||
+        !reg_dead_from(list, target + 1, REG_RAX, LIVENESS_BUDGET)) return 0;
+
+    snprintf(w[4]->mnemonic, sizeof(w[4]->mnemonic), "j%s", new_cc);
+    delete_insn(w[1]);
+    delete_insn(w[2]);
+    delete_insn(w[3]);
+    return 1;
+}
+
+// jmp L; L1: ... L:  =>  L1: ... L:（跳过中间连续的标签）
+static int rule_jump_to_next(AsmList* list, AsmInsn** w, int n) {
+    if (n < 2 || !asm_is(w[0], "jmp") || w[1]->kind != ASM_LABEL) return 0;
+    if (w[0]->ops[0].kind != OPND_SYM) return 0;
+    for (int i = index_of(list, w[0]) + 1; i < list->count; i++) {
+        AsmInsn* insn = &list->items[i];
+        if (insn->deleted) continue;
+        if (insn->kind != ASM_LABEL) return 0;
+        if (strcmp(insn->text, w[0]->ops[0].sym) == 0) {
+            delete_insn(w[0]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// jmp/ret 之后直到下一个标签之前的指令不可达
+static int rule_unreachable(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 2 || w[1]->kind != ASM_INSN) return 0;
+    if (!asm_is(w[0], "jmp") && !asm_is(w[0], "ret")) return 0;
+    delete_insn(w[1]);
+    return 1;
+}
+
+// movq %r, %r  =>  (删除)
+static int rule_self_move(AsmList* list, AsmInsn** w, int n) {
+    (void)list;
+    if (n < 1 || !asm_is(w[0], "movq")) return 0;
+    if (w[0]->ops[0].kind != OPND_REG || !asm_same_operand(&w[0]->ops[0], &w[0]->ops[1])) return 0;
+    delete_insn(w[0]);
+    return 1;
+}
+
+static PeepholeRule rules[] = {
+    { "push-pop-same",  2, rule_push_pop_same,  0 },
+    { "push-load-pop",  4, rule_push_load_pop,  0 },
+    { "push-pop-move",  2, rule_push_pop_move,  0 },
+    { "store-reload",   2, rule_store_reload,   0 },
+    { "op-in-place",    3, rule_op_in_place,    0 },
+    { "cmp-in-place",   2, rule_compare_in_place, 0 },
+    { "move-direct",    2, rule_move_direct,    0 },
+    { "setcc-branch",   5, rule_setcc_branch,   0 },
+    { "jump-to-next",   2, rule_jump_to_next,   0 },
+    { "unreachable",    2, rule_unreachable,    0 },
+    { "self-move",      1, rule_self_move,      0 },
+};
+
+#define RULE_COUNT ((int)(sizeof(rules) / sizeof(rules[0])))
+
+// 从 start 起收集 n 个未删除的条目
+static int gather_window(AsmList* list, int start, AsmInsn** w, int n) {
+    int count = 0;
+    for (int i = start; i < list->count && count < n; i++) {
+        if (!list->items[i].deleted) w[count++] = &list->items[i];
+    }
+    return count;
+}
+
+int peephole_optimize(AsmList* list) {
+    int total = 0;
+    for (int pass = 0; pass < MAX_PASSES; pass++) {
+        int changed = 0;
+        for (int i = 0; i < list->count; i++) {
+            if (list->items[i].deleted) continue;
+            for (int r = 0; r < RULE_COUNT && !list->items[i].deleted; r++) {
+                AsmInsn* window[MAX_WINDOW];
+                int n = gather_window(list, i, window, rules[r].window);
+                if (n < rules[r].window) continue;
+                if (rules[r].apply(list, window, n)) {
+                    rules[r].hits++;
+                    changed++;
+                }
+            }
+        }
+        total += changed;
+        if (!changed) break;
+    }
+    return total;
+}
+
+void peephole_print_stats(FILE* out) {
+    fprintf(out, "Peephole rule hits:\n");
+    for (int r = 0; r < RULE_COUNT; r++) {
+        fprintf(out, "  %-16s %d\n", rules[r].name, rules[r].hits);
+    }
+}
@@ -0,0 +1,122 @@
+#include "optimize.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 基于剖析的优化：计数点与剖析文件。
+// 解析之后、任何优化之前按源码顺序给函数、if、while、for 编号，-fprofile-generate 与
+// -fprofile-use 两次编译同一份源码得到同样的编号；优化复制出的节点带着原节点的编号，计数合在一起。
+// 剖析文件是文本：每次运行追加一条记录，"tinycc-profile 计数点数 校验和" 一行，
+// 之后每行一个计数器；读入时把与源码相符的记录逐项相加。
+
+static long long* counts;
+static int ncounts;
+
+static int next_id;
+static unsigned checksum;
+
+// 校验和：依次混入计数点的种类与行号，源码结构变了就对不上
+static void mix(unsigned value) {
+    checksum = (checksum ^ value) * 16777619u;
+}
+
+static void number(ASTNode* node) {
+    for (; node; node = node->next) {
+        switch (node->type) {
+            case AST_FUNCTION:
+            case AST_IF:
+            case AST_WHILE:
+            case AST_FOR:
+                node->profile_id = ++next_id;
+                mix((unsigned)node->type);
+                mix((unsigned)node->line);
+                break;
+            default:
+                break;
+        }
+        switch (node->type) {
+            case AST_FUNCTION:
+                number(node->data.function.body);
+                break;
+            case AST_IF:
+                number(node->data.if_stmt.then_branch);
+                number(node->data.if_stmt.else_branch);
+                break;
+            case AST_WHILE:
+                number(node->data.while_stmt.body);
+                break;
+            case AST_FOR:
+                number(node->data.for_stmt.body);
+                break;
+            case AST_SWITCH:
+                number(node->data.switch_stmt.body);
+                break;
+            case AST_BLOCK:
+            case AST_PROGRAM:
+                number(node->left);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int profile_number(ASTNode* program, unsigned* sum) {
+    next_id = 0;
+    checksum = 2166136261u;
+    number(program);
+    if (sum) *sum = checksum;
+    return next_id;
+}
+
+int profile_load(const char* path, int npoints, unsigned sum, char* error, size_t size) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        snprintf(error, size, "cannot open profile %s", path);
+        return -1;
+    }
+    free(counts);
+    ncounts = 2 * npoints;
+    counts = calloc(ncounts + 1, sizeof(long long));
+    int runs = 0;
+    int points;
+    unsigned record_sum;
+    while (fscanf(file, " tinycc-profile %d %u", &points, &record_sum) == 2) {
+        if (points != npoints || record_sum != sum) {
+            snprintf(error, size, "profile %s does not match the source", path);
+            runs = -1;
+            break;
+        }
+        for (int i = 0; i < ncounts; i++) {
+            long long value;
+            if (fscanf(file, "%lld", &value) != 1 || value < 0) {
+                snprintf(error, size, "truncated profile %s", path);
+                runs = -1;
+                break;
+            }
+            counts[i] += value;
+        }
+        if (runs < 0) break;
+        runs++;
+    }
+    if (runs == 0) snprintf(error, size, "no profile records in %s", path);
+    fclose(file);
+    if (runs <= 0) {
+        profile_free();
+        return -1;
+    }
+    return runs;
+}
+
+long long profile_count(const ASTNode* node, int which) {
+    if (!counts || !node || node->profile_id <= 0) return -1;
+    int index = 2 * (node->profile_id - 1) + which;
+    if (index >= ncounts) return -1;
+    return counts[index];
+}
+
+void profile_free(void) {
+    free(counts);
+    counts = NULL;
+    ncounts = 0;
+}
@@ -0,0 +1,459 @@
+#include "ir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 稀疏条件常量传播（Wegman-Zadeck）：在 SSA 上同时求常量格值与可达边，
+// 结果写回 AST —— 常量表达式改写为字面量，常量条件的分支只保留活跃的一侧。
+
+enum { LATTICE_TOP = 0, LATTICE_CONST, LATTICE_BOTTOM };
+
+typedef struct {
+    IRBlock* from;
+    IRBlock* to;
+} CFGEdge;
+
+typedef struct {
+    IRFunction* fn;
+    char* state;            // 按指令编号
+    int* value;
+    char* block_exec;       // 按块编号
+    char** edge_exec;       // edge_exec[b][p]：preds[p] -> b 是否可执行
+
+    CFGEdge* cfg_work;
+    int cfg_count;
+    int cfg_cap;
+    IRInstr** ssa_work;
+    int ssa_count;
+    int ssa_cap;
+} SCCP;
+
+#define SCCP_PUSH(arr, count, cap, item) do {                        \
+        if ((count) >= (cap)) {                                      \
+            (cap) = (cap) ? (cap) * 2 : 16;                          \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap));          \
+        }                                                            \
+        (arr)[(count)++] = (item);                                   \
+    } while (0)
+
+static void add_edge(SCCP* s, IRBlock* from, IRBlock* to) {
+    CFGEdge edge = { from, to };
+    SCCP_PUSH(s->cfg_work, s->cfg_count, s->cfg_cap, edge);
+}
+
+static void set_lattice(SCCP* s, IRInstr* instr, int state, int value) {
+    int id = instr->id;
+    if (s->state[id] == LATTICE_BOTTOM) return;
+    if (s->state[id] == state && (state != LATTICE_CONST || s->value[id] == value)) return;
+    // 常量只能下降到 BOTTOM
+    if (s->state[id] == LATTICE_CONST && state == LATTICE_CONST) state = LATTICE_BOTTOM;
+
+    s->state[id] = state;
+    s->value[id] = value;
+    for (int i = 0; i < instr->nusers; i++) {
+        SCCP_PUSH(s->ssa_work, s->ssa_count, s->ssa_cap, instr->users[i]);
+    }
+}
+
+static void visit_phi(SCCP* s, IRInstr* phi) {
+    IRBlock* block = phi->block;
+    int state = LATTICE_TOP;
+    int value = 0;
+    for (int p = 0; p < phi->nargs; p++) {
+        if (!s->edge_exec[block->id][p] || !phi->args[p]) continue;
+        int id = phi->args[p]->id;
+        if (s->state[id] == LATTICE_TOP) continue;
+        if (s->state[id] == LATTICE_BOTTOM) {
+            state = LATTICE_BOTTOM;
+            break;
+        }
+        if (state == LATTICE_TOP) {
+            state = LATTICE_CONST;
+            value = s->value[id];
+        } else if (value != s->value[id]) {
+            state = LATTICE_BOTTOM;
+            break;
+        }
+    }
+    set_lattice(s, phi, state, value);
+}
+
+static void visit_instr(SCCP* s, IRInstr* instr) {
+    switch (instr->op) {
+        case IR_PHI:
+            visit_phi(s, instr);
+            break;
+
+        case IR_CONST:
+            set_lattice(s, instr, LATTICE_CONST, instr->imm);
+            break;
+
+        case IR_COPY: {
+            IRInstr* src = instr->args[0];
+            set_lattice(s, instr, s->state[src->id], s->value[src->id]);
+            break;
+        }
+
+        case IR_BINOP: {
+            IRInstr* a = instr->args[0];
+            IRInstr* b = instr->args[1];
+            if (s->state[a->id] == LATTICE_BOTTOM || s->state[b->id] == LATTICE_BOTTOM) {
+                set_lattice(s, instr, LATTICE_BOTTOM, 0);
+            } else if (s->state[a->id] == LATTICE_CONST && s->state[b->id] == LATTICE_CONST) {
+                int result;
+                if (ir_fold_binary(instr->opname, s->value[a->id], s->value[b->id], &result)) {
+                    set_lattice(s, instr, LATTICE_CONST, result);
+                } else {
+                    set_lattice(s, instr, LATTICE_BOTTOM, 0);
+                }
+            }
+            break;
+        }
+
+        case IR_UNOP: {
+            IRInstr* a = instr->args[0];
+            if (s->state[a->id] == LATTICE_BOTTOM) {
+                set_lattice(s, instr, LATTICE_BOTTOM, 0);
+            } else if (s->state[a->id] == LATTICE_CONST) {
+                int result;
+                if (ir_fold_unary(instr->opname, s->value[a->id], &result)) {
+                    set_lattice(s, instr, LATTICE_CONST, result);
+                } else {
+                    set_lattice(s, instr, LATTICE_BOTTOM, 0);
+                }
+            }
+            break;
+        }
+
+        case IR_JUMP:
+            add_edge(s, instr->block, instr->targets[0]);
+            break;
+
+        case IR_BRANCH: {
+            IRInstr* cond = instr->args[0];
+            if (s->state[cond->id] == LATTICE_CONST) {
+                add_edge(s, instr->block, instr->targets[s->value[cond->id] ? 0 : 1]);
+            } else if (s->state[cond->id] == LATTICE_BOTTOM) {
+                add_edge(s, instr->block, instr->targets[0]);
+                add_edge(s, instr->block, instr->targets[1]);
+            }
+            break;
+        }
+
+        case IR_RETURN:
+        case IR_STORE_GLOBAL:
+        case IR_STORE_ELEMENT:
+        case IR_NOP:
+            break;
+
+        default:
+            // 参数、未初始化值、全局变量、数组元素与调用结果都视为未知
+            set_lattice(s, instr, LATTICE_BOTTOM, 0);
+            break;
+    }
+}
+
+static void visit_edge(SCCP* s, CFGEdge edge) {
+    IRBlock* to = edge.to;
+    int newly = 0;
+    for (int p = 0; p < to->npreds; p++) {
+        if (to->preds[p] == edge.from && !s->edge_exec[to->id][p]) {
+            s->edge_exec[to->id][p] = 1;
+            newly = 1;
+        }
+    }
+    if (!newly && edge.from) return;
+
+    if (!s->block_exec[to->id]) {
+        s->block_exec[to->id] = 1;
+        for (IRInstr* instr = to->first; instr; instr = instr->next) {
+            visit_instr(s, instr);
+        }
+    } else {
+        for (IRInstr* instr = to->first; instr && instr->op == IR_PHI; instr = instr->next) {
+            visit_phi(s, instr);
+        }
+    }
+}
+
+static void sccp_solve(SCCP* s) {
+    IRFunction* fn = s->fn;
+    s->state = calloc(fn->ninstrs, 1);
+    s->value = calloc(fn->ninstrs, sizeof(int));
+    s->block_exec = calloc(fn->nblocks, 1);
+    s->edge_exec = malloc(sizeof(char*) * fn->nblocks);
+    for (int i = 0; i < fn->nblocks; i++) {
+        s->edge_exec[i] = calloc(fn->blocks[i]->npreds + 1, 1);
+    }
+
+    ir_compute_uses(fn);
+    add_edge(s, NULL, fn->entry);
+
+    while (s->cfg_count || s->ssa_count) {
+        while (s->cfg_count) {
+            visit_edge(s, s->cfg_work[--s->cfg_count]);
+        }
+        while (s->ssa_count) {
+            IRInstr* instr = s->ssa_work[--s->ssa_count];
+            if (instr->block && s->block_exec[instr->block->id]) {
+                visit_instr(s, instr);
+            }
+        }
+    }
+}
+
+static void sccp_release(SCCP* s) {
+    for (int i = 0; i < s->fn->nblocks; i++) {
+        free(s->edge_exec[i]);
+    }
+    free(s->edge_exec);
+    free(s->block_exec);
+    free(s->state);
+    free(s->value);
+    free(s->cfg_work);
+    free(s->ssa_work);
+}
+
+// ---------------- 写回 AST ----------------
+
+// AST 节点 -> 常量值 / 分支结论的指针哈希表
+typedef struct {
+    ASTNode** keys;
+    int* values;
+    int cap;
+} NodeMap;
+
+static unsigned int hash_ptr(const void* p, int cap) {
+    unsigned long x = (unsigned long)p;
+    x ^= x >> 17;
+    x *= 0x9E3779B1u;
+    return (unsigned int)(x ^ (x >> 13)) & (unsigned int)(cap - 1);
+}
+
+static void map_init(NodeMap* map, int expected) {
+    map->cap = 16;
+    while (map->cap < expected * 2) map->cap *= 2;
+    map->keys = calloc(map->cap, sizeof(ASTNode*));
+    map->values = calloc(map->cap, sizeof(int));
+}
+
+static void map_put(NodeMap* map, ASTNode* key, int value) {
+    unsigned int i = hash_ptr(key, map->cap);
+    while (map->keys[i] && map->keys[i] != key) i = (i + 1) & (map->cap - 1);
+    map->keys[i] = key;
+    map->values[i] = value;
+}
+
+static int map_get(NodeMap* map, ASTNode* key, int* value) {
+    unsigned int i = hash_ptr(key, map->cap);
+    while (map->keys[i]) {
+        if (map->keys[i] == key) {
+            *value = map->values[i];
+            return 1;
+        }
+        i = (i + 1) & (map->cap - 1);
+    }
+    return 0;
+}
+
+static void map_free(NodeMap* map) {
+    free(map->keys);
+    free(map->values);
+}
+
+typedef struct {
+    NodeMap constants;      // 表达式 -> 常量值
+    NodeMap branches;       // if/while/for -> 条件恒为真(1)/假(0)
+    int changes;
+} Rewriter;
+
+static void rewrite_expr(Rewriter* rw, ASTNode* node) {
+    for (; node; node = node->next) {
+        int value;
+        if (node->type != AST_LITERAL && map_get(&rw->constants, node, &value) &&
+            !node_has_side_effects(node)) {
+            make_literal_node(node, value);
+            rw->changes++;
+            continue;
+        }
+        switch (node->type) {
+            case AST_BINARY_OP:
+                rewrite_expr(rw, node->data.binary.left);
+                rewrite_expr(rw, node->data.binary.right);
+                break;
+            case AST_UNARY_OP:
+                rewrite_expr(rw, node->data.unary.operand);
+                break;
+            case AST_ASSIGNMENT:
+                rewrite_expr(rw, node->left);
+                break;
+            case AST_CALL:
+                rewrite_expr(rw, node->data.call.args);
+                break;
+            case AST_INDEX:
+            case AST_INDEX_ASSIGNMENT:
+                rewrite_expr(rw, node->data.element.index);
+                rewrite_expr(rw, node->data.element.value);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void rewrite_stmt(Rewriter* rw, ASTNode* node);
+
+static void rewrite_one(Rewriter* rw, ASTNode* node) {
+    int taken;
+    switch (node->type) {
+        case AST_BLOCK:
+            rewrite_stmt(rw, node->left);
+            break;
+
+        case AST_DECLARATION:
+            if (node->data.declaration.initializer) {
+                ASTNode* init = node->data.declaration.initializer;
+                ASTNode* next = init->next;
+                init->next = NULL;
+                rewrite_expr(rw, init);
+                init->next = next;
+            }
+            break;
+
+        case AST_IF:
+            if (map_get(&rw->branches, node, &taken)) {
+                ASTNode* live = taken ? node->data.if_stmt.then_branch
+                                      : node->data.if_stmt.else_branch;
+                if (taken) node->data.if_stmt.then_branch = NULL;
+                else node->data.if_stmt.else_branch = NULL;
+                rw->changes++;
+                if (live) {
+                    // 先在原地址上改写（映射表以节点地址为键），再搬进 if 节点
+                    rewrite_one(rw, live);
+                    replace_node(node, live);
+                } else {
+                    make_empty_block(node);
+                }
+                break;
+            }
+            rewrite_expr(rw, node->data.if_stmt.condition);
+            if (node->data.if_stmt.then_branch) rewrite_one(rw, node->data.if_stmt.then_branch);
+            if (node->data.if_stmt.else_branch) rewrite_one(rw, node->data.if_stmt.else_branch);
+            break;
+
+        case AST_WHILE:
+            if (map_get(&rw->branches, node, &taken) && !taken) {
+                make_empty_block(node);
+                rw->changes++;
+                break;
+            }
+            rewrite_expr(rw, node->data.while_stmt.condition);
+            if (node->data.while_stmt.body) rewrite_one(rw, node->data.while_stmt.body);
+            break;
+
+        case AST_FOR:
+            if (node->data.for_stmt.init) rewrite_one(rw, node->data.for_stmt.init);
+            if (map_get(&rw->branches, node, &taken) && !taken) {
+                // 循环体一次都不执行，只保留初始化部分
+                ASTNode* init = node->data.for_stmt.init;
+                node->data.for_stmt.init = NULL;
+                if (init) replace_node(node, init);
+                else make_empty_block(node);
+                rw->changes++;
+                break;
+            }
+            rewrite_expr(rw, node->data.for_stmt.condition);
+            rewrite_expr(rw, node->data.for_stmt.update);
+            if (node->data.for_stmt.body) rewrite_one(rw, node->data.for_stmt.body);
+            break;
+
+        case AST_SWITCH: {
+            ASTNode* condition = node->data.switch_stmt.condition;
+            ASTNode* next = condition->next;
+            condition->next = NULL;
+            rewrite_expr(rw, condition);
+            condition->next = next;
+            rewrite_one(rw, node->data.switch_stmt.body);
+            break;
+        }
+
+        case AST_CASE:
+        case AST_BREAK:
+            break;
+
+        case AST_RETURN:
+            rewrite_expr(rw, node->left);
+            break;
+
+        default: {
+            ASTNode* next = node->next;
+            node->next = NULL;
+            rewrite_expr(rw, node);
+            node->next = next;
+            break;
+        }
+    }
+}
+
+static void rewrite_stmt(Rewriter* rw, ASTNode* node) {
+    for (; node; node = node->next) {
+        rewrite_one(rw, node);
+    }
+}
+
+static int is_rewritable_expr(ASTNode* node) {
+    return node && (node->type == AST_IDENTIFIER || node->type == AST_BINARY_OP ||
+                    node->type == AST_UNARY_OP);
+}
+
+static int sccp_apply(SCCP* s) {
+    IRFunction* fn = s->fn;
+    Rewriter rw;
+    map_init(&rw.constants, fn->ninstrs);
+    map_init(&rw.branches, fn->nblocks);
+    rw.changes = 0;
+
+    for (int i = 0; i < fn->nblocks; i++) {
+        IRBlock* block = fn->blocks[i];
+        if (!s->block_exec[block->id]) continue;
+        for (IRInstr* instr = block->first; instr; instr = instr->next) {
+            if (instr->op == IR_BRANCH && instr->origin) {
+                IRInstr* cond = instr->args[0];
+                if (s->state[cond->id] == LATTICE_CONST) {
+                    map_put(&rw.branches, instr->origin, s->value[cond->id] != 0);
+                }
+            } else if (is_rewritable_expr(instr->origin) && s->state[instr->id] == LATTICE_CONST) {
+                map_put(&rw.constants, instr->origin, s->value[instr->id]);
+            }
+        }
+    }
+
+    rewrite_one(&rw, fn->ast->data.function.body);
+
+    map_free(&rw.constants);
+    map_free(&rw.branches);
+    return rw.changes;
+}
+
+// 对程序中每个函数：降级 -> SSA -> SCCP -> 写回 AST
+int sccp_optimize_program(ASTNode* program, int verbose) {
+    if (!program || program->type != AST_PROGRAM) return 0;
+
+    int total = 0;
+    for (ASTNode* node = program->left; node; node = node->next) {
+        if (node->type != AST_FUNCTION || !node->data.function.body) continue;
+
+        IRFunction* fn = ir_build_function(node);
+        ssa_construct(fn);
+        if (verbose) ir_dump_function(fn, stdout);
+
+        SCCP s;
+        memset(&s, 0, sizeof(s));
+        s.fn = fn;
+        sccp_solve(&s);
+        total += sccp_apply(&s);
+        sccp_release(&s);
+        ir_free_function(fn);
+    }
+    return total;
+}
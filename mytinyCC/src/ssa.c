@@ -0,0 +1,225 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SSA_PUSH(arr, count, cap, item) do {                         \
+        if ((count) >= (cap)) {                                      \
+            (cap) = (cap) ? (cap) * 2 : 4;                           \
+            (arr) = realloc((arr), sizeof(*(arr)) * (cap));          \
+        }                                                            \
+        (arr)[(count)++] = (item);                                   \
+    } while (0)
+
+static IRBlock* intersect(IRBlock* a, IRBlock* b) {
+    while (a != b) {
+        while (a->rpo > b->rpo) a = a->idom;
+        while (b->rpo > a->rpo) b = b->idom;
+    }
+    return a;
+}
+
+// Cooper-Harvey-Kennedy 迭代算法计算直接支配者
+void ssa_compute_dominators(IRFunction* fn) {
+    for (int i = 0; i < fn->nblocks; i++) {
+        fn->blocks[i]->idom = NULL;
+        fn->blocks[i]->ndom_children = 0;
+    }
+    if (fn->nrpo == 0) return;
+    fn->entry->idom = fn->entry;
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < fn->nrpo; i++) {
+            IRBlock* block = fn->rpo_order[i];
+            IRBlock* new_idom = NULL;
+            for (int p = 0; p < block->npreds; p++) {
+                IRBlock* pred = block->preds[p];
+                if (pred->rpo < 0 || !pred->idom) continue;
+                new_idom = new_idom ? intersect(pred, new_idom) : pred;
+            }
+            if (new_idom && block->idom != new_idom) {
+                block->idom = new_idom;
+                changed = 1;
+            }
+        }
+    }
+
+    for (int i = 1; i < fn->nrpo; i++) {
+        IRBlock* block = fn->rpo_order[i];
+        IRBlock* parent = block->idom;
+        SSA_PUSH(parent->dom_children, parent->ndom_children, parent->cap_dom_children, block);
+    }
+}
+
+int ssa_dominates(IRBlock* a, IRBlock* b) {
+    if (a->rpo < 0 || b->rpo < 0) return 0;
+    while (b != a) {
+        if (b->idom == b) return 0;
+        b = b->idom;
+    }
+    return 1;
+}
+
+static void add_frontier(IRBlock* block, IRBlock* frontier) {
+    for (int i = 0; i < block->ndf; i++) {
+        if (block->df[i] == frontier) return;
+    }
+    SSA_PUSH(block->df, block->ndf, block->cap_df, frontier);
+}
+
+// 支配边界：汇合点沿各前驱向上走到其直接支配者为止
+void ssa_compute_frontiers(IRFunction* fn) {
+    for (int i = 0; i < fn->nblocks; i++) {
+        fn->blocks[i]->ndf = 0;
+    }
+    for (int i = 0; i < fn->nrpo; i++) {
+        IRBlock* block = fn->rpo_order[i];
+        if (block->npreds < 2) continue;
+        for (int p = 0; p < block->npreds; p++) {
+            IRBlock* runner = block->preds[p];
+            if (runner->rpo < 0) continue;
+            while (runner != block->idom) {
+                add_frontier(runner, block);
+                runner = runner->idom;
+            }
+        }
+    }
+}
+
+typedef struct {
+    IRInstr** items;
+    int count;
+    int cap;
+} ValueStack;
+
+static void insert_phis(IRFunction* fn) {
+    char* has_phi = malloc(fn->nblocks);
+    char* queued = malloc(fn->nblocks);
+    IRBlock** worklist = malloc(sizeof(IRBlock*) * (fn->nblocks + 1));
+
+    for (int var = 0; var < fn->nvars; var++) {
+        memset(has_phi, 0, fn->nblocks);
+        memset(queued, 0, fn->nblocks);
+        int count = 0;
+
+        // 入口块视为每个变量的定义点（参数或 undef）
+        worklist[count++] = fn->entry;
+        queued[fn->entry->id] = 1;
+        for (int i = 0; i < fn->nrpo; i++) {
+            IRBlock* block = fn->rpo_order[i];
+            if (queued[block->id]) continue;
+            for (IRInstr* instr = block->first; instr; instr = instr->next) {
+                if (instr->op == IR_STORE && instr->var == var) {
+                    worklist[count++] = block;
+                    queued[block->id] = 1;
+                    break;
+                }
+            }
+        }
+
+        while (count > 0) {
+            IRBlock* block = worklist[--count];
+            for (int d = 0; d < block->ndf; d++) {
+                IRBlock* frontier = block->df[d];
+                if (has_phi[frontier->id]) continue;
+                has_phi[frontier->id] = 1;
+
+                IRInstr* phi = ir_new_instr(fn, IR_PHI);
+                phi->var = var;
+                phi->nargs = frontier->npreds;
+                phi->args = calloc(frontier->npreds, sizeof(IRInstr*));
+                if (frontier->first) ir_insert_before(frontier->first, phi);
+                else ir_append(frontier, phi);
+
+                if (!queued[frontier->id]) {
+                    queued[frontier->id] = 1;
+                    worklist[count++] = frontier;
+                }
+            }
+        }
+    }
+
+    free(worklist);
+    free(queued);
+    free(has_phi);
+}
+
+static IRInstr* top_of(ValueStack* stack) {
+    return stack->count ? stack->items[stack->count - 1] : NULL;
+}
+
+// 沿支配树重命名：load 变为对当前定义的 copy，store 被删除
+static void rename_block(IRFunction* fn, IRBlock* block, ValueStack* stacks) {
+    int* pushed = calloc(fn->nvars, sizeof(int));
+
+    IRInstr* instr = block->first;
+    while (instr) {
+        IRInstr* next = instr->next;
+        if (instr->op == IR_PHI) {
+            ValueStack* s = &stacks[instr->var];
+            SSA_PUSH(s->items, s->count, s->cap, instr);
+            pushed[instr->var]++;
+        } else if (instr->op == IR_LOAD) {
+            IRInstr* def = top_of(&stacks[instr->var]);
+            instr->op = IR_COPY;
+            instr->nargs = 1;
+            instr->args = realloc(instr->args, sizeof(IRInstr*));
+            instr->args[0] = def;
+        } else if (instr->op == IR_STORE) {
+            ValueStack* s = &stacks[instr->var];
+            SSA_PUSH(s->items, s->count, s->cap, instr->args[0]);
+            pushed[instr->var]++;
+            ir_remove(instr);
+        }
+        instr = next;
+    }
+
+    for (int i = 0; i < block->nsuccs; i++) {
+        IRBlock* succ = block->succs[i];
+        if (i == 1 && succ == block->succs[0]) break;
+        for (int p = 0; p < succ->npreds; p++) {
+            if (succ->preds[p] != block) continue;
+            for (IRInstr* phi = succ->first; phi && phi->op == IR_PHI; phi = phi->next) {
+                phi->args[p] = top_of(&stacks[phi->var]);
+            }
+        }
+    }
+
+    for (int i = 0; i < block->ndom_children; i++) {
+        rename_block(fn, block->dom_children[i], stacks);
+    }
+
+    for (int var = 0; var < fn->nvars; var++) {
+        stacks[var].count -= pushed[var];
+    }
+    free(pushed);
+}
+
+// 构造 SSA：支配树 -> 支配边界 -> 插入 phi -> 重命名
+void ssa_construct(IRFunction* fn) {
+    if (fn->in_ssa) return;
+    ssa_compute_dominators(fn);
+    ssa_compute_frontiers(fn);
+    insert_phis(fn);
+
+    ValueStack* stacks = calloc(fn->nvars ? fn->nvars : 1, sizeof(ValueStack));
+
+    // 每个变量在入口处的初始值
+    IRInstr* first = fn->entry->first;
+    for (int var = 0; var < fn->nvars; var++) {
+        IRInstr* init = ir_new_instr(fn, var < fn->nparams ? IR_PARAM : IR_UNDEF);
+        init->imm = var;
+        if (first) ir_insert_before(first, init);
+        else ir_append(fn->entry, init);
+        SSA_PUSH(stacks[var].items, stacks[var].count, stacks[var].cap, init);
+    }
+
+    rename_block(fn, fn->entry, stacks);
+
+    for (int var = 0; var < fn->nvars; var++) {
+        free(stacks[var].items);
+    }
+    free(stacks);
+    fn->in_ssa = 1;
+}
@@ -0,0 +1,1128 @@
+#include "x86.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// x86-64 编码器。第一遍把每条指令（跳转除外）编码成字节并记下待填的符号引用；
+// 然后反复计算布局，把放不下 rel8 的跳转放宽为 rel32，直到稳定；
+// 最后把字节写入各段，段内可解析的 PC 相对引用直接回填，其余生成重定位。
+
+#define MAX_INSN_BYTES 32
+#define MAX_FIXUPS 4
+
+typedef struct {
+    int at;             // 在本条目字节内的偏移
+    int size;           // 4 或 8
+    int type;           // ObjRelocType
+    int symbol;
+    long addend;
+    int base;           // 差值 sym-base 中减去的符号，-1 表示没有
+} Fixup;
+
+typedef enum {
+    ITEM_NONE,
+    ITEM_BYTES,         // 已编码的指令或数据
+    ITEM_ZERO,          // .zero N
+    ITEM_LABEL,
+    ITEM_BRANCH,        // jmp/jcc 到标签，长度待定
+    ITEM_ALIGN
+} ItemKind;
+
+typedef struct {
+    ItemKind kind;
+    int section;
+    long offset;
+    long size;
+    unsigned char* data;
+    Fixup* fixups;
+    int nfixups;
+    int symbol;         // LABEL 定义的符号 / BRANCH 的目标
+    int cc;             // BRANCH 的条件码，jmp 为 -1
+    int is_long;        // BRANCH 使用 rel32
+    int relaxable;      // BRANCH 目标在同一段内，可以选短跳转
+    int align;
+} Item;
+
+typedef struct {
+    unsigned char buf[MAX_INSN_BYTES];
+    int len;
+    Fixup fix[MAX_FIXUPS];
+    int nfix;
+} Enc;
+
+typedef struct {
+    ObjectFile* obj;
+    Item* items;
+    int nitems;
+    int section;
+    char* error;
+    size_t error_size;
+    int failed;
+} Assembler;
+
+static const char* section_names[OBJ_SEC_COUNT] = { ".text", ".data", ".rodata", ".bss" };
+
+static void fail(Assembler* as, const char* message, const char* detail) {
+    if (as->failed) return;
+    as->failed = 1;
+    snprintf(as->error, as->error_size, "%s: %s", message, detail);
+}
+
+static int fits8(long v) {
+    return v >= -128 && v <= 127;
+}
+
+static int fits32(long v) {
+    return v >= -2147483648L && v <= 2147483647L;
+}
+
+// ---------------------------------------------------------------- 符号
+
+int obj_find_symbol(const ObjectFile* obj, const char* name) {
+    for (int i = 0; i < obj->nsymbols; i++) {
+        if (strcmp(obj->symbols[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+static int get_symbol(ObjectFile* obj, const char* name) {
+    int index = obj_find_symbol(obj, name);
+    if (index >= 0) return index;
+    if (obj->nsymbols >= obj->cap_symbols) {
+        obj->cap_symbols = obj->cap_symbols ? obj->cap_symbols * 2 : 16;
+        obj->symbols = realloc(obj->symbols, sizeof(ObjSymbol) * obj->cap_symbols);
+    }
+    ObjSymbol* sym = &obj->symbols[obj->nsymbols];
+    memset(sym, 0, sizeof(*sym));
+    sym->name = strdup(name);
+    sym->section = -1;
+    sym->local_label = strncmp(name, ".L", 2) == 0;
+    return obj->nsymbols++;
+}
+
+void obj_free(ObjectFile* obj) {
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        free(obj->sections[s].data);
+        free(obj->sections[s].relocs);
+    }
+    for (int i = 0; i < obj->nsymbols; i++) {
+        free(obj->symbols[i].name);
+    }
+    free(obj->symbols);
+    memset(obj, 0, sizeof(*obj));
+}
+
+// ---------------------------------------------------------------- 字节输出
+
+static void put8(Enc* e, long v) {
+    if (e->len < MAX_INSN_BYTES) e->buf[e->len++] = (unsigned char)v;
+}
+
+static void put_le(Enc* e, long v, int size) {
+    for (int i = 0; i < size; i++) put8(e, v >> (8 * i));
+}
+
+// 记录一个符号引用，先写入占位的 0
+static void add_fixup(Assembler* as, Enc* e, const char* sym, int type, long addend, int size) {
+    if (e->nfix >= MAX_FIXUPS) {
+        fail(as, "too many symbol references", sym);
+        return;
+    }
+    Fixup* f = &e->fix[e->nfix++];
+    f->at = e->len;
+    f->size = size;
+    f->type = type;
+    f->symbol = get_symbol(as->obj, sym);
+    f->addend = addend;
+    f->base = -1;
+    put_le(e, 0, size);
+}
+
+// 输出立即数操作数，符号立即数生成 type 类型的重定位
+static int put_imm(Assembler* as, Enc* e, const AsmOperand* op, int size, int type) {
+    if (op->sym) {
+        if (size != 4) return 0;
+        add_fixup(as, e, op->sym, type, 0, 4);
+        return 1;
+    }
+    if (size == 1 && (op->imm < -128 || op->imm > 255)) return 0;
+    if (size == 2 && (op->imm < -32768 || op->imm > 65535)) return 0;
+    if (size == 4 && (op->imm < -2147483648L || op->imm > 4294967295L)) return 0;
+    put_le(e, op->imm, size);
+    return 1;
+}
+
+static int scale_bits(int scale) {
+    switch (scale) {
+        case 1: return 0;
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        default: return -1;
+    }
+}
+
+// spl/bpl/sil/dil 必须带 REX 前缀才能访问
+static int needs_byte_rex(const AsmOperand* op) {
+    return op->kind == OPND_REG && op->size == 1 && op->reg >= REG_RSP && op->reg <= REG_RDI;
+}
+
+// 输出 [前缀] [REX] 操作码 ModRM [SIB] [位移]。
+// reg 为 ModRM.reg 字段（寄存器号或 /digit 扩展码），imm_size 是紧随其后的立即数长度，
+// RIP 相对寻址的加数需要把它算进去。
+static int emit_modrm(Assembler* as, Enc* e, int prefix, int rex_w, int force_rex,
+                      const unsigned char* opcode, int oplen, int reg,
+                      const AsmOperand* rm, int imm_size) {
+    int rex = rex_w ? 8 : 0;
+    if (reg >= 8) rex |= 4;
+    if (rm->kind == OPND_REG) {
+        if (rm->reg >= 8) rex |= 1;
+    } else if (rm->kind == OPND_MEM) {
+        if (rm->index != REG_NONE && rm->index >= 8) rex |= 2;
+        if (rm->reg != REG_NONE && rm->reg != REG_RIP && rm->reg >= 8) rex |= 1;
+    } else {
+        return 0;
+    }
+
+    if (prefix) put8(e, prefix);
+    if (rex || force_rex) put8(e, 0x40 | rex);
+    for (int i = 0; i < oplen; i++) put8(e, opcode[i]);
+    reg &= 7;
+
+    if (rm->kind == OPND_REG) {
+        put8(e, 0xC0 | reg << 3 | (rm->reg & 7));
+        return 1;
+    }
+
+    if (rm->reg == REG_RIP) {
+        if (rm->index != REG_NONE) return 0;
+        put8(e, 0x05 | reg << 3);
+        if (rm->sym) add_fixup(as, e, rm->sym, RELOC_PC32, rm->imm - 4 - imm_size, 4);
+        else put_le(e, rm->imm, 4);
+        return 1;
+    }
+
+    int ss = scale_bits(rm->scale);
+    if (ss < 0 || rm->index == REG_RSP) return 0;
+    if (!rm->sym && !fits32(rm->imm)) return 0;
+    int index = rm->index == REG_NONE ? 4 : (rm->index & 7);
+
+    // 没有基址寄存器：SIB 中 base=101 表示 disp32
+    if (rm->reg == REG_NONE) {
+        put8(e, 0x04 | reg << 3);
+        put8(e, ss << 6 | index << 3 | 5);
+        if (rm->sym) add_fixup(as, e, rm->sym, RELOC_ABS32S, rm->imm, 4);
+        else put_le(e, rm->imm, 4);
+        return 1;
+    }
+
+    int mod;
+    if (rm->sym) mod = 2;
+    else if (rm->imm == 0 && (rm->reg & 7) != 5) mod = 0;    // rbp/r13 没有无位移形式
+    else if (fits8(rm->imm)) mod = 1;
+    else mod = 2;
+
+    int need_sib = rm->index != REG_NONE || (rm->reg & 7) == 4;   // rsp/r12 作基址需要 SIB
+    put8(e, mod << 6 | reg << 3 | (need_sib ? 4 : (rm->reg & 7)));
+    if (need_sib) put8(e, ss << 6 | index << 3 | (rm->reg & 7));
+    if (mod == 1) {
+        put8(e, rm->imm);
+    } else if (mod == 2) {
+        if (rm->sym) add_fixup(as, e, rm->sym, RELOC_ABS32S, rm->imm, 4);
+        else put_le(e, rm->imm, 4);
+    }
+    return 1;
+}
+
+// 单字节操作码 + 寄存器号（push/pop/mov imm 的短形式）
+static void emit_opcode_reg(Enc* e, int prefix, int rex_w, int force_rex, int opcode, int reg) {
+    int rex = (rex_w ? 8 : 0) | (reg >= 8 ? 1 : 0);
+    if (prefix) put8(e, prefix);
+    if (rex || force_rex) put8(e, 0x40 | rex);
+    put8(e, opcode + (reg & 7));
+}
+
+// ---------------------------------------------------------------- 指令
+
+static int condition_code(const char* cc) {
+    static const struct { const char* name; int code; } table[] = {
+        { "o", 0 }, { "no", 1 }, { "b", 2 }, { "c", 2 }, { "nae", 2 },
+        { "ae", 3 }, { "nb", 3 }, { "nc", 3 }, { "e", 4 }, { "z", 4 },
+        { "ne", 5 }, { "nz", 5 }, { "be", 6 }, { "na", 6 }, { "a", 7 },
+        { "nbe", 7 }, { "s", 8 }, { "ns", 9 }, { "p", 10 }, { "pe", 10 },
+        { "np", 11 }, { "po", 11 }, { "l", 12 }, { "nge", 12 }, { "ge", 13 },
+        { "nl", 13 }, { "le", 14 }, { "ng", 14 }, { "g", 15 }, { "nle", 15 },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(cc, table[i].name) == 0) return table[i].code;
+    }
+    return -1;
+}
+
+// 指令族 base 可带 b/w/l/q 后缀；没有后缀时按寄存器操作数推断宽度。不匹配返回 0
+static int family_size(const AsmInsn* insn, const char* base) {
+    size_t n = strlen(base);
+    const char* m = insn->mnemonic;
+    if (strncmp(m, base, n) != 0) return 0;
+    if (m[n] == '\0') {
+        for (int i = insn->nops - 1; i >= 0; i--) {
+            if (insn->ops[i].kind == OPND_REG && !insn->ops[i].indirect) return insn->ops[i].size;
+        }
+        return 0;
+    }
+    if (m[n + 1] != '\0') return 0;
+    switch (m[n]) {
+        case 'b': return 1;
+        case 'w': return 2;
+        case 'l': return 4;
+        case 'q': return 8;
+        default: return 0;
+    }
+}
+
+// 寄存器操作数的宽度必须与指令宽度一致
+static int check_size(const AsmOperand* op, int size) {
+    return op->kind != OPND_REG || op->size == size;
+}
+
+static int is_rm(const AsmOperand* op) {
+    return op->kind == OPND_REG || op->kind == OPND_MEM;
+}
+
+// add/or/adc/sbb/and/sub/xor/cmp（ext 即 /digit，也是操作码基数 ext*8）
+static int encode_alu(Assembler* as, Enc* e, const AsmInsn* insn, int ext, int size) {
+    if (insn->nops != 2) return 0;
+    const AsmOperand* src = &insn->ops[0];
+    const AsmOperand* dst = &insn->ops[1];
+    int prefix = size == 2 ? 0x66 : 0;
+    int w = size == 8;
+    int force = size == 1 && (needs_byte_rex(src) || needs_byte_rex(dst));
+    int imm_size = size == 1 ? 1 : (size == 2 ? 2 : 4);
+    int imm_type = w ? RELOC_ABS32S : RELOC_ABS32;
+    unsigned char op;
+
+    if (!check_size(src, size) || !check_size(dst, size)) return 0;
+
+    if (src->kind == OPND_IMM) {
+        if (!is_rm(dst)) return 0;
+        if (size != 1 && !src->sym && fits8(src->imm)) {
+            op = 0x83;
+            return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, 1) && put_imm(as, e, src, 1, 0);
+        }
+        if (w && !src->sym && !fits32(src->imm)) return 0;
+        if (asm_is_reg(dst, REG_RAX)) {
+            // 累加器短形式
+            if (prefix) put8(e, prefix);
+            if (w) put8(e, 0x48);
+            put8(e, ext * 8 + (size == 1 ? 4 : 5));
+            return put_imm(as, e, src, imm_size, imm_type);
+        }
+        op = size == 1 ? 0x80 : 0x81;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, imm_size) &&
+               put_imm(as, e, src, imm_size, imm_type);
+    }
+    if (src->kind == OPND_REG && is_rm(dst)) {
+        op = (unsigned char)(ext * 8 + (size == 1 ? 0 : 1));
+        return emit_modrm(as, e, prefix, w, force, &op, 1, src->reg, dst, 0);
+    }
+    if (src->kind == OPND_MEM && dst->kind == OPND_REG) {
+        op = (unsigned char)(ext * 8 + (size == 1 ? 2 : 3));
+        return emit_modrm(as, e, prefix, w, force, &op, 1, dst->reg, src, 0);
+    }
+    return 0;
+}
+
+static int encode_mov(Assembler* as, Enc* e, const AsmInsn* insn, int size) {
+    if (insn->nops != 2) return 0;
+    const AsmOperand* src = &insn->ops[0];
+    const AsmOperand* dst = &insn->ops[1];
+    int prefix = size == 2 ? 0x66 : 0;
+    int w = size == 8;
+    int force = size == 1 && (needs_byte_rex(src) || needs_byte_rex(dst));
+    unsigned char op;
+
+    if (!check_size(src, size) || !check_size(dst, size)) return 0;
+
+    if (src->kind == OPND_IMM) {
+        if (dst->kind == OPND_REG && size != 8) {
+            emit_opcode_reg(e, prefix, 0, force, size == 1 ? 0xB0 : 0xB8, dst->reg);
+            return put_imm(as, e, src, size, RELOC_ABS32);
+        }
+        if (dst->kind == OPND_REG && !src->sym && !fits32(src->imm)) {
+            // movabs $imm64, %r64
+            emit_opcode_reg(e, 0, 1, 0, 0xB8, dst->reg);
+            put_le(e, src->imm, 8);
+            return 1;
+        }
+        if (!is_rm(dst)) return 0;
+        int imm_size = size == 1 ? 1 : (size == 2 ? 2 : 4);
+        if (w && !src->sym && !fits32(src->imm)) return 0;
+        op = size == 1 ? 0xC6 : 0xC7;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, 0, dst, imm_size) &&
+               put_imm(as, e, src, imm_size, w ? RELOC_ABS32S : RELOC_ABS32);
+    }
+    if (src->kind == OPND_REG && is_rm(dst)) {
+        op = size == 1 ? 0x88 : 0x89;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, src->reg, dst, 0);
+    }
+    if (src->kind == OPND_MEM && dst->kind == OPND_REG) {
+        op = size == 1 ? 0x8A : 0x8B;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, dst->reg, src, 0);
+    }
+    return 0;
+}
+
+static int encode_test(Assembler* as, Enc* e, const AsmInsn* insn, int size) {
+    if (insn->nops != 2) return 0;
+    const AsmOperand* src = &insn->ops[0];
+    const AsmOperand* dst = &insn->ops[1];
+    int prefix = size == 2 ? 0x66 : 0;
+    int w = size == 8;
+    int force = size == 1 && (needs_byte_rex(src) || needs_byte_rex(dst));
+    int imm_size = size == 1 ? 1 : (size == 2 ? 2 : 4);
+    unsigned char op;
+
+    if (!check_size(src, size) || !check_size(dst, size)) return 0;
+
+    if (src->kind == OPND_IMM) {
+        if (asm_is_reg(dst, REG_RAX)) {
+            if (prefix) put8(e, prefix);
+            if (w) put8(e, 0x48);
+            put8(e, size == 1 ? 0xA8 : 0xA9);
+            return put_imm(as, e, src, imm_size, w ? RELOC_ABS32S : RELOC_ABS32);
+        }
+        op = size == 1 ? 0xF6 : 0xF7;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, 0, dst, imm_size) &&
+               put_imm(as, e, src, imm_size, w ? RELOC_ABS32S : RELOC_ABS32);
+    }
+    op = size == 1 ? 0x84 : 0x85;
+    if (src->kind == OPND_REG && is_rm(dst)) {
+        return emit_modrm(as, e, prefix, w, force, &op, 1, src->reg, dst, 0);
+    }
+    if (src->kind == OPND_MEM && dst->kind == OPND_REG) {
+        return emit_modrm(as, e, prefix, w, force, &op, 1, dst->reg, src, 0);
+    }
+    return 0;
+}
+
+// F7 /digit 单操作数组：not/neg/mul/imul/div/idiv；FF /0 /1：inc/dec
+static int encode_unary(Assembler* as, Enc* e, const AsmInsn* insn, int size, int byte_op,
+                        int word_op, int ext) {
+    if (insn->nops != 1 || !is_rm(&insn->ops[0]) || !check_size(&insn->ops[0], size)) return 0;
+    unsigned char op = (unsigned char)(size == 1 ? byte_op : word_op);
+    return emit_modrm(as, e, size == 2 ? 0x66 : 0, size == 8,
+                      size == 1 && needs_byte_rex(&insn->ops[0]), &op, 1, ext, &insn->ops[0], 0);
+}
+
+// 移位：D1（1 位）、D3（%cl）、C1 ib
+static int encode_shift(Assembler* as, Enc* e, const AsmInsn* insn, int size, int ext) {
+    const AsmOperand* dst = &insn->ops[insn->nops - 1];
+    int prefix = size == 2 ? 0x66 : 0;
+    int w = size == 8;
+    int force = size == 1 && needs_byte_rex(dst);
+    unsigned char op;
+
+    if (insn->nops < 1 || insn->nops > 2 || !is_rm(dst) || !check_size(dst, size)) return 0;
+    if (insn->nops == 1) {
+        op = size == 1 ? 0xD0 : 0xD1;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, 0);
+    }
+    const AsmOperand* count = &insn->ops[0];
+    if (count->kind == OPND_REG) {
+        if (count->reg != REG_RCX || count->size != 1) return 0;
+        op = size == 1 ? 0xD2 : 0xD3;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, 0);
+    }
+    if (count->kind != OPND_IMM || count->sym) return 0;
+    if (count->imm == 1) {
+        op = size == 1 ? 0xD0 : 0xD1;
+        return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, 0);
+    }
+    op = size == 1 ? 0xC0 : 0xC1;
+    return emit_modrm(as, e, prefix, w, force, &op, 1, ext, dst, 1) && put_imm(as, e, count, 1, 0);
+}
+
+static int encode_imul(Assembler* as, Enc* e, const AsmInsn* insn, int size) {
+    int prefix = size == 2 ? 0x66 : 0;
+    int w = size == 8;
+    if (insn->nops == 1) return encode_unary(as, e, insn, size, 0xF6, 0xF7, 5);
+    if (size == 1) return 0;
+
+    const AsmOperand* src;
+    const AsmOperand* dst = &insn->ops[insn->nops - 1];
+    const AsmOperand* imm = NULL;
+    if (insn->nops == 2 && insn->ops[0].kind == OPND_IMM) {
+        imm = &insn->ops[0];
+        src = dst;
+    } else if (insn->nops == 3 && insn->ops[0].kind == OPND_IMM) {
+        imm = &insn->ops[0];
+        src = &insn->ops[1];
+    } else if (insn->nops == 2) {
+        src = &insn->ops[0];
+    } else {
+        return 0;
+    }
+    if (dst->kind != OPND_REG || !is_rm(src) || !check_size(dst, size) || !check_size(src, size)) return 0;
+
+    if (!imm) {
+        static const unsigned char op[] = { 0x0F, 0xAF };
+        return emit_modrm(as, e, prefix, w, 0, op, 2, dst->reg, src, 0);
+    }
+    unsigned char op;
+    if (!imm->sym && fits8(imm->imm)) {
+        op = 0x6B;
+        return emit_modrm(as, e, prefix, w, 0, &op, 1, dst->reg, src, 1) && put_imm(as, e, imm, 1, 0);
+    }
+    int imm_size = size == 2 ? 2 : 4;
+    op = 0x69;
+    return emit_modrm(as, e, prefix, w, 0, &op, 1, dst->reg, src, imm_size) &&
+           put_imm(as, e, imm, imm_size, w ? RELOC_ABS32S : RELOC_ABS32);
+}
+
+static int encode_push_pop(Assembler* as, Enc* e, const AsmInsn* insn, int push) {
+    if (insn->nops != 1) return 0;
+    const AsmOperand* op = &insn->ops[0];
+    unsigned char code;
+    if (op->kind == OPND_REG) {
+        if (op->size != 8) return 0;
+        emit_opcode_reg(e, 0, 0, 0, push ? 0x50 : 0x58, op->reg);
+        return 1;
+    }
+    if (op->kind == OPND_MEM) {
+        code = push ? 0xFF : 0x8F;
+        return emit_modrm(as, e, 0, 0, 0, &code, 1, push ? 6 : 0, op, 0);
+    }
+    if (push && op->kind == OPND_IMM) {
+        if (!op->sym && fits8(op->imm)) {
+            put8(e, 0x6A);
+            return put_imm(as, e, op, 1, 0);
+        }
+        if (!op->sym && !fits32(op->imm)) return 0;
+        put8(e, 0x68);
+        return put_imm(as, e, op, 4, RELOC_ABS32S);
+    }
+    return 0;
+}
+
+static int encode_extend(Assembler* as, Enc* e, const AsmInsn* insn) {
+    static const struct { const char* name; int opcode; int from; int to; } table[] = {
+        { "movzbw", 0xB6, 1, 2 }, { "movzbl", 0xB6, 1, 4 }, { "movzbq", 0xB6, 1, 8 },
+        { "movzwl", 0xB7, 2, 4 }, { "movzwq", 0xB7, 2, 8 },
+        { "movsbw", 0xBE, 1, 2 }, { "movsbl", 0xBE, 1, 4 }, { "movsbq", 0xBE, 1, 8 },
+        { "movswl", 0xBF, 2, 4 }, { "movswq", 0xBF, 2, 8 },
+        { "movslq", 0x63, 4, 8 },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(insn->mnemonic, table[i].name) != 0) continue;
+        if (insn->nops != 2) return 0;
+        const AsmOperand* src = &insn->ops[0];
+        const AsmOperand* dst = &insn->ops[1];
+        if (!is_rm(src) || dst->kind != OPND_REG) return 0;
+        if (!check_size(src, table[i].from) || !check_size(dst, table[i].to)) return 0;
+        int prefix = table[i].to == 2 ? 0x66 : 0;
+        int force = table[i].from == 1 && needs_byte_rex(src);
+        if (table[i].opcode == 0x63) {
+            unsigned char op = 0x63;
+            return emit_modrm(as, e, prefix, 1, force, &op, 1, dst->reg, src, 0);
+        }
+        unsigned char op[2] = { 0x0F, (unsigned char)table[i].opcode };
+        return emit_modrm(as, e, prefix, table[i].to == 8, force, op, 2, dst->reg, src, 0);
+    }
+    return -1;
+}
+
+static int encode_simple(Enc* e, const char* m) {
+    static const struct { const char* name; int len; unsigned char bytes[3]; } table[] = {
+        { "ret", 1, { 0xC3 } }, { "leave", 1, { 0xC9 } }, { "nop", 1, { 0x90 } },
+        { "cltd", 1, { 0x99 } }, { "cqto", 2, { 0x48, 0x99 } }, { "cltq", 2, { 0x48, 0x98 } },
+        { "cwtl", 1, { 0x98 } }, { "hlt", 1, { 0xF4 } }, { "ud2", 2, { 0x0F, 0x0B } },
+        { "rdtsc", 2, { 0x0F, 0x31 } }, { "lfence", 3, { 0x0F, 0xAE, 0xE8 } },
+        { "mfence", 3, { 0x0F, 0xAE, 0xF0 } }, { "pause", 2, { 0xF3, 0x90 } },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(m, table[i].name) == 0) {
+            for (int b = 0; b < table[i].len; b++) put8(e, table[i].bytes[b]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 跳转与调用。直接跳转到标签的 jmp/jcc 变成 ITEM_BRANCH，长度留给放宽阶段决定
+static int encode_control(Assembler* as, Enc* e, const AsmInsn* insn, Item* item) {
+    const char* m = insn->mnemonic;
+    int is_call = strcmp(m, "call") == 0 || strcmp(m, "callq") == 0;
+    int is_jmp = strcmp(m, "jmp") == 0 || strcmp(m, "jmpq") == 0;
+    int cc = -1;
+    if (!is_call && !is_jmp) {
+        cc = condition_code(m + 1);
+        if (cc < 0) return 0;
+    }
+    if (insn->nops != 1) return 0;
+    const AsmOperand* target = &insn->ops[0];
+
+    if (target->indirect) {
+        if (cc >= 0 || !is_rm(target) || !check_size(target, 8)) return 0;
+        unsigned char op = 0xFF;
+        return emit_modrm(as, e, 0, 0, 0, &op, 1, is_call ? 2 : 4, target, 0);
+    }
+    if (target->kind != OPND_SYM) return 0;
+
+    if (is_call) {
+        put8(e, 0xE8);
+        add_fixup(as, e, target->sym, RELOC_PLT32, -4, 4);
+        return 1;
+    }
+    item->kind = ITEM_BRANCH;
+    item->cc = cc;
+    item->symbol = get_symbol(as->obj, target->sym);
+    return 1;
+}
+
+static int is_xmm(const AsmOperand* op) {
+    return op->kind == OPND_REG && op->size == 16;
+}
+
+// xmm 寄存器在指令流里从 REG_XMM0 编号，编码时换回硬件编号 0~15
+static AsmOperand xmm_operand(const AsmOperand* op) {
+    AsmOperand copy = *op;
+    if (is_xmm(op)) copy.reg -= REG_XMM0;
+    return copy;
+}
+
+// SSE2 整数指令（都带强制前缀 66/F3）。load 是“xmm/m128 -> xmm”的操作码，
+// store 非 0 时目的为内存（movdqu/movdqa 写回）或通用寄存器（movd）用它
+static int encode_sse(Assembler* as, Enc* e, const AsmInsn* insn) {
+    static const struct { const char* name; int prefix; int load; int store; } table[] = {
+        { "movdqa", 0x66, 0x6F, 0x7F }, { "movdqu", 0xF3, 0x6F, 0x7F }, { "movd", 0x66, 0x6E, 0x7E },
+        { "paddd", 0x66, 0xFE, 0 }, { "psubd", 0x66, 0xFA, 0 }, { "pand", 0x66, 0xDB, 0 },
+        { "por", 0x66, 0xEB, 0 }, { "pxor", 0x66, 0xEF, 0 }, { "pmuludq", 0x66, 0xF4, 0 },
+        { "punpckldq", 0x66, 0x62, 0 }, { "pshufd", 0x66, 0x70, 0 },
+    };
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        if (strcmp(insn->mnemonic, table[i].name) != 0) continue;
+        int shuffle = table[i].load == 0x70;
+        if (insn->nops != (shuffle ? 3 : 2)) return 0;
+        const AsmOperand* imm = shuffle ? &insn->ops[0] : NULL;
+        AsmOperand src = xmm_operand(&insn->ops[shuffle]);
+        AsmOperand dst = xmm_operand(&insn->ops[shuffle + 1]);
+        if (imm && (imm->kind != OPND_IMM || imm->sym)) return 0;
+        int movd = table[i].load == 0x6E;
+        unsigned char op[2] = { 0x0F, (unsigned char)table[i].load };
+        if (is_xmm(&insn->ops[shuffle + 1])) {
+            // movd 的源是 32 位通用寄存器或内存，其余是 xmm 或内存
+            if (!is_rm(&src) || (src.kind == OPND_REG && is_xmm(&insn->ops[shuffle]) == movd) ||
+                (movd && !check_size(&src, 4))) return 0;
+            return emit_modrm(as, e, table[i].prefix, 0, 0, op, 2, dst.reg, &src, imm ? 1 : 0) &&
+                   (!imm || put_imm(as, e, imm, 1, 0));
+        }
+        if (!table[i].store || !is_xmm(&insn->ops[shuffle]) || !is_rm(&dst) ||
+            (dst.kind == OPND_REG && (!movd || !check_size(&dst, 4)))) return 0;
+        op[1] = (unsigned char)table[i].store;
+        return emit_modrm(as, e, table[i].prefix, 0, 0, op, 2, src.reg, &dst, 0);
+    }
+    return -1;
+}
+
+static int encode_insn(Assembler* as, const AsmInsn* insn, Enc* e, Item* item) {
+    static const char* alu[] = { "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp" };
+    static const struct { const char* name; int ext; } unary[] = {
+        { "not", 2 }, { "neg", 3 }, { "mul", 4 }, { "div", 6 }, { "idiv", 7 },
+    };
+    static const struct { const char* name; int ext; } shifts[] = {
+        { "rol", 0 }, { "ror", 1 }, { "rcl", 2 }, { "rcr", 3 },
+        { "shl", 4 }, { "sal", 4 }, { "shr", 5 }, { "sar", 7 },
+    };
+    const char* m = insn->mnemonic;
+    int size;
+
+    if (insn->nops == 0 && encode_simple(e, m)) return 1;
+    if (m[0] == 'j' || strncmp(m, "call", 4) == 0) return encode_control(as, e, insn, item);
+
+    int extended = encode_extend(as, e, insn);
+    if (extended >= 0) return extended;
+    int sse = encode_sse(as, e, insn);
+    if (sse >= 0) return sse;
+
+    if (strncmp(m, "set", 3) == 0) {
+        int cc = condition_code(m + 3);
+        if (cc < 0 || insn->nops != 1 || !is_rm(&insn->ops[0]) || !check_size(&insn->ops[0], 1)) return 0;
+        unsigned char op[2] = { 0x0F, (unsigned char)(0x90 + cc) };
+        return emit_modrm(as, e, 0, 0, needs_byte_rex(&insn->ops[0]), op, 2, 0, &insn->ops[0], 0);
+    }
+    if (strncmp(m, "cmov", 4) == 0) {
+        // cmovl 既可能是“小于”也可能是带 l 后缀，先按完整条件码解析
+        char cc_name[8];
+        snprintf(cc_name, sizeof(cc_name), "%s", m + 4);
+        int cc = condition_code(cc_name);
+        size_t n = strlen(cc_name);
+        if (cc < 0 && n > 1 && strchr("wlq", cc_name[n - 1])) {
+            cc_name[n - 1] = '\0';
+            cc = condition_code(cc_name);
+        }
+        if (cc < 0 || insn->nops != 2 || insn->ops[1].kind != OPND_REG || !is_rm(&insn->ops[0])) return 0;
+        size = insn->ops[1].size;
+        if (size == 1 || !check_size(&insn->ops[0], size)) return 0;
+        unsigned char op[2] = { 0x0F, (unsigned char)(0x40 + cc) };
+        return emit_modrm(as, e, size == 2 ? 0x66 : 0, size == 8, 0, op, 2,
+                          insn->ops[1].reg, &insn->ops[0], 0);
+    }
+
+    for (size_t i = 0; i < sizeof(alu) / sizeof(alu[0]); i++) {
+        if ((size = family_size(insn, alu[i]))) return encode_alu(as, e, insn, (int)i, size);
+    }
+    if (strcmp(m, "movabsq") == 0 || strcmp(m, "movabs") == 0) {
+        if (insn->nops != 2 || insn->ops[0].kind != OPND_IMM || insn->ops[0].sym ||
+            insn->ops[1].kind != OPND_REG || insn->ops[1].size != 8) return 0;
+        emit_opcode_reg(e, 0, 1, 0, 0xB8, insn->ops[1].reg);
+        put_le(e, insn->ops[0].imm, 8);
+        return 1;
+    }
+    if ((size = family_size(insn, "mov"))) return encode_mov(as, e, insn, size);
+    if ((size = family_size(insn, "test"))) return encode_test(as, e, insn, size);
+    if ((size = family_size(insn, "lea"))) {
+        if (insn->nops != 2 || insn->ops[0].kind != OPND_MEM || insn->ops[1].kind != OPND_REG ||
+            size < 2 || !check_size(&insn->ops[1], size)) return 0;
+        unsigned char op = 0x8D;
+        return emit_modrm(as, e, size == 2 ? 0x66 : 0, size == 8, 0, &op, 1,
+                          insn->ops[1].reg, &insn->ops[0], 0);
+    }
+    if ((size = family_size(insn, "imul"))) return encode_imul(as, e, insn, size);
+    for (size_t i = 0; i < sizeof(unary) / sizeof(unary[0]); i++) {
+        if ((size = family_size(insn, unary[i].name))) {
+            return encode_unary(as, e, insn, size, 0xF6, 0xF7, unary[i].ext);
+        }
+    }
+    if ((size = family_size(insn, "inc"))) return encode_unary(as, e, insn, size, 0xFE, 0xFF, 0);
+    if ((size = family_size(insn, "dec"))) return encode_unary(as, e, insn, size, 0xFE, 0xFF, 1);
+    for (size_t i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++) {
+        if ((size = family_size(insn, shifts[i].name))) return encode_shift(as, e, insn, size, shifts[i].ext);
+    }
+    // 64 位模式下 push/pop 只有 8 字节形式
+    if (strcmp(m, "pushq") == 0 || strcmp(m, "push") == 0) return encode_push_pop(as, e, insn, 1);
+    if (strcmp(m, "popq") == 0 || strcmp(m, "pop") == 0) return encode_push_pop(as, e, insn, 0);
+    return 0;
+}
+
+// ---------------------------------------------------------------- 伪指令
+
+static int set_section(Assembler* as, const char* name) {
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (strcmp(name, section_names[s]) == 0) {
+            as->section = s;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void set_bytes(Item* item, const unsigned char* bytes, long len) {
+    item->kind = ITEM_BYTES;
+    item->size = len;
+    item->data = malloc(len ? len : 1);
+    memcpy(item->data, bytes, len);
+}
+
+// .byte/.short/.long/.quad 的参数：数字、符号[+-偏移]，或 .long 符号-符号（跳转表）
+static int emit_data_value(Assembler* as, Enc* e, const char* text, int size) {
+    char* end;
+    long value = strtol(text, &end, 0);
+    if (end != text && *end == '\0') {
+        put_le(e, value, size);
+        return 1;
+    }
+    if (size != 4 && size != 8) return 0;
+    char name[128];
+    size_t n = 0;
+    while (text[n] && (isalnum((unsigned char)text[n]) || strchr("_.$", text[n])) && n < sizeof(name) - 1) {
+        name[n] = text[n];
+        n++;
+    }
+    name[n] = '\0';
+    long addend = 0;
+    if (text[n] == '-' && size == 4 && n && !isdigit((unsigned char)text[n + 1])) {
+        // 两个符号之差：按 PC 相对引用处理，写入时把减去的符号换算成相对引用位置的偏移
+        const char* base = text + n + 1;
+        size_t k = 0;
+        while (base[k] && (isalnum((unsigned char)base[k]) || strchr("_.$", base[k]))) k++;
+        if (!k || base[k] != '\0') return 0;
+        add_fixup(as, e, name, RELOC_PC32, 0, size);
+        e->fix[e->nfix - 1].base = get_symbol(as->obj, base);
+        return 1;
+    }
+    if (text[n]) {
+        addend = strtol(text + n, &end, 0);
+        if (*end != '\0' || (text[n] != '+' && text[n] != '-')) return 0;
+    }
+    if (!n) return 0;
+    add_fixup(as, e, name, size == 8 ? RELOC_ABS64 : RELOC_ABS32, addend, size);
+    return 1;
+}
+
+static int parse_string(const char* text, unsigned char* out, long* len) {
+    const char* p = text;
+    if (*p++ != '"') return 0;
+    *len = 0;
+    while (*p && *p != '"') {
+        int c = (unsigned char)*p++;
+        if (c == '\\') {
+            c = (unsigned char)*p++;
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '\\': case '"': break;
+                default:
+                    if (c >= '0' && c <= '7') {
+                        int v = c - '0';
+                        for (int k = 0; k < 2 && *p >= '0' && *p <= '7'; k++) v = v * 8 + (*p++ - '0');
+                        c = v & 0xFF;
+                    } else {
+                        return 0;
+                    }
+            }
+        }
+        out[(*len)++] = (unsigned char)c;
+    }
+    return *p == '"' && p[1] == '\0';
+}
+
+static int handle_directive(Assembler* as, const AsmInsn* insn, Item* item) {
+    char name[32];
+    const char* args = insn->text;
+    size_t n = 0;
+    while (*args && !isspace((unsigned char)*args) && n < sizeof(name) - 1) name[n++] = *args++;
+    name[n] = '\0';
+    while (isspace((unsigned char)*args)) args++;
+
+    if (strcmp(name, ".text") == 0 || strcmp(name, ".data") == 0 || strcmp(name, ".bss") == 0) {
+        return set_section(as, name);
+    }
+    if (strcmp(name, ".section") == 0) {
+        char section[32];
+        n = 0;
+        while (args[n] && args[n] != ',' && !isspace((unsigned char)args[n]) && n < sizeof(section) - 1) {
+            section[n] = args[n];
+            n++;
+        }
+        section[n] = '\0';
+        return set_section(as, section);
+    }
+    if (strcmp(name, ".globl") == 0 || strcmp(name, ".global") == 0) {
+        int sym = get_symbol(as->obj, args);
+        as->obj->symbols[sym].global = 1;
+        return 1;
+    }
+    if (strcmp(name, ".p2align") == 0 || strcmp(name, ".align") == 0 || strcmp(name, ".balign") == 0) {
+        long value = strtol(args, NULL, 0);
+        long align = strcmp(name, ".p2align") == 0 ? (value >= 0 && value < 13 ? 1L << value : 0) : value;
+        if (align <= 0 || (align & (align - 1)) || align > 4096) return 0;
+        item->kind = ITEM_ALIGN;
+        item->align = (int)align;
+        if (align > as->obj->sections[as->section].align) as->obj->sections[as->section].align = (int)align;
+        return 1;
+    }
+    if (strcmp(name, ".zero") == 0 || strcmp(name, ".skip") == 0 || strcmp(name, ".space") == 0) {
+        long count = strtol(args, NULL, 0);
+        if (count < 0) return 0;
+        item->kind = ITEM_ZERO;
+        item->size = count;
+        return 1;
+    }
+    int size = 0;
+    if (strcmp(name, ".byte") == 0) size = 1;
+    else if (strcmp(name, ".short") == 0 || strcmp(name, ".word") == 0 || strcmp(name, ".value") == 0) size = 2;
+    else if (strcmp(name, ".long") == 0 || strcmp(name, ".int") == 0) size = 4;
+    else if (strcmp(name, ".quad") == 0) size = 8;
+    if (size) {
+        unsigned char bytes[1024];
+        long len = 0;
+        char* copy = strdup(args);
+        int ok = 1;
+        for (char* value = strtok(copy, ", \t"); value && ok; value = strtok(NULL, ", \t")) {
+            Enc e = { .len = 0 };
+            ok = emit_data_value(as, &e, value, size) && len + e.len <= (long)sizeof(bytes) &&
+                 item->nfixups + e.nfix <= 64;
+            if (!ok) break;
+            for (int i = 0; i < e.nfix; i++) {
+                item->fixups = realloc(item->fixups, sizeof(Fixup) * (item->nfixups + 1));
+                item->fixups[item->nfixups] = e.fix[i];
+                item->fixups[item->nfixups++].at += (int)len;
+            }
+            memcpy(bytes + len, e.buf, e.len);
+            len += e.len;
+        }
+        free(copy);
+        if (ok) set_bytes(item, bytes, len);
+        return ok;
+    }
+    if (strcmp(name, ".string") == 0 || strcmp(name, ".asciz") == 0 || strcmp(name, ".ascii") == 0) {
+        unsigned char* bytes = malloc(strlen(args) + 1);
+        long len;
+        int ok = parse_string(args, bytes, &len);
+        if (ok) {
+            if (strcmp(name, ".ascii") != 0) bytes[len++] = '\0';
+            set_bytes(item, bytes, len);
+        }
+        free(bytes);
+        return ok;
+    }
+    // 只影响调试信息或符号属性的伪指令
+    if (strcmp(name, ".type") == 0 || strcmp(name, ".size") == 0 || strcmp(name, ".file") == 0 ||
+        strcmp(name, ".ident") == 0 || strcmp(name, ".local") == 0) {
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------- 布局与输出
+
+static long branch_size(const Item* item) {
+    if (!item->is_long) return 2;
+    return item->cc < 0 ? 5 : 6;
+}
+
+static void layout(Assembler* as) {
+    long offset[OBJ_SEC_COUNT] = { 0 };
+    for (int i = 0; i < as->nitems; i++) {
+        Item* item = &as->items[i];
+        item->offset = offset[item->section];
+        switch (item->kind) {
+            case ITEM_LABEL:
+                as->obj->symbols[item->symbol].value = item->offset;
+                break;
+            case ITEM_BRANCH:
+                item->size = branch_size(item);
+                break;
+            case ITEM_ALIGN:
+                item->size = (item->align - item->offset % item->align) % item->align;
+                break;
+            default:
+                break;
+        }
+        offset[item->section] += item->size;
+    }
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        as->obj->sections[s].size = offset[s];
+    }
+}
+
+// 反复布局，直到所有短跳转的位移都落在 rel8 范围内。跳转只会变长，因此必然收敛
+static void relax_branches(Assembler* as) {
+    for (;;) {
+        layout(as);
+        int changed = 0;
+        for (int i = 0; i < as->nitems; i++) {
+            Item* item = &as->items[i];
+            if (item->kind != ITEM_BRANCH || item->is_long) continue;
+            long disp = as->obj->symbols[item->symbol].value - (item->offset + 2);
+            if (!fits8(disp)) {
+                item->is_long = 1;
+                as->obj->relaxed_branches++;
+                changed = 1;
+            }
+        }
+        if (!changed) break;
+    }
+}
+
+static void add_reloc(ObjSection* sec, long offset, int type, int symbol, long addend) {
+    if (sec->nrelocs >= sec->cap_relocs) {
+        sec->cap_relocs = sec->cap_relocs ? sec->cap_relocs * 2 : 16;
+        sec->relocs = realloc(sec->relocs, sizeof(ObjReloc) * sec->cap_relocs);
+    }
+    ObjReloc* r = &sec->relocs[sec->nrelocs++];
+    r->offset = offset;
+    r->type = type;
+    r->symbol = symbol;
+    r->addend = addend;
+}
+
+static void write_le(unsigned char* p, long v, int size) {
+    for (int i = 0; i < size; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+// 同一段内、非全局符号的 PC 相对引用在汇编时就能算出；其余留给链接器
+static void apply_fixup(Assembler* as, int section, long base, const Fixup* f) {
+    ObjSection* sec = &as->obj->sections[section];
+    const ObjSymbol* sym = &as->obj->symbols[f->symbol];
+    long place = base + f->at;
+    long addend = f->addend;
+    if (f->base >= 0) {
+        // sym - b = sym + (place - b) - place：b 与引用位置在同一段，换成 PC 相对的加数
+        const ObjSymbol* b = &as->obj->symbols[f->base];
+        if (b->section != section) {
+            fail(as, "symbol difference across sections", b->name);
+            return;
+        }
+        addend += place - b->value;
+    }
+    int pcrel = f->type == RELOC_PC32 || f->type == RELOC_PLT32;
+    if (pcrel && sym->section == section && (sym->local_label || !sym->global)) {
+        write_le(sec->data + place, sym->value + addend - place, 4);
+        return;
+    }
+    add_reloc(sec, place, f->type, f->symbol, addend);
+}
+
+// 与 GNU as 相同的填充：先用最长 11 字节的 nop，余下的再选一条合适长度的
+static void fill_nops(unsigned char* p, long n) {
+    static const unsigned char nops[11][11] = {
+        { 0x90 },
+        { 0x66, 0x90 },
+        { 0x0F, 0x1F, 0x00 },
+        { 0x0F, 0x1F, 0x40, 0x00 },
+        { 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+        { 0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00 },
+        { 0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00 },
+        { 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        { 0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        { 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        { 0x66, 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    };
+    while (n > 0) {
+        int len = n > 11 ? 11 : (int)n;
+        memcpy(p, nops[len - 1], len);
+        p += len;
+        n -= len;
+    }
+}
+
+static void write_sections(Assembler* as) {
+    ObjectFile* obj = as->obj;
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        if (s != OBJ_SEC_BSS) obj->sections[s].data = calloc(1, obj->sections[s].size + 1);
+    }
+    for (int i = 0; i < as->nitems; i++) {
+        Item* item = &as->items[i];
+        unsigned char* p = obj->sections[item->section].data;
+        if (!p) continue;
+        p += item->offset;
+        switch (item->kind) {
+            case ITEM_BYTES:
+                memcpy(p, item->data, item->size);
+                for (int f = 0; f < item->nfixups; f++) {
+                    apply_fixup(as, item->section, item->offset, &item->fixups[f]);
+                }
+                break;
+            case ITEM_ALIGN:
+                if (item->section == OBJ_SEC_TEXT) fill_nops(p, item->size);
+                break;
+            case ITEM_BRANCH: {
+                long target = obj->symbols[item->symbol].value;
+                if (!item->is_long) {
+                    p[0] = (unsigned char)(item->cc < 0 ? 0xEB : 0x70 + item->cc);
+                    p[1] = (unsigned char)(target - (item->offset + 2));
+                    break;
+                }
+                int oplen = item->cc < 0 ? 1 : 2;
+                if (item->cc < 0) p[0] = 0xE9;
+                else {
+                    p[0] = 0x0F;
+                    p[1] = (unsigned char)(0x80 + item->cc);
+                }
+                Fixup f = { oplen, 4, RELOC_PLT32, item->symbol, -4, -1 };
+                if (item->relaxable) write_le(p + oplen, target - (item->offset + item->size), 4);
+                else apply_fixup(as, item->section, item->offset, &f);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+static void free_items(Assembler* as) {
+    for (int i = 0; i < as->nitems; i++) {
+        free(as->items[i].data);
+        free(as->items[i].fixups);
+    }
+    free(as->items);
+}
+
+int x86_assemble(AsmList* list, ObjectFile* obj, char* error, size_t error_size) {
+    Assembler as;
+    memset(&as, 0, sizeof(as));
+    memset(obj, 0, sizeof(*obj));
+    as.obj = obj;
+    as.section = OBJ_SEC_TEXT;
+    as.error = error;
+    as.error_size = error_size;
+    as.items = calloc(list->count + 1, sizeof(Item));
+    for (int s = 0; s < OBJ_SEC_COUNT; s++) {
+        obj->sections[s].name = section_names[s];
+        obj->sections[s].align = 1;
+    }
+
+    // 第一遍：编码指令、登记标签
+    for (int i = 0; i < list->count && !as.failed; i++) {
+        AsmInsn* insn = &list->items[i];
+        if (insn->deleted) continue;
+        Item* item = &as.items[as.nitems++];
+        item->section = as.section;
+        char text[256];
+        asm_format_insn(insn, text, sizeof(text));
+
+        if (insn->kind == ASM_LABEL) {
+            int sym = get_symbol(obj, insn->text);
+            if (obj->symbols[sym].section >= 0) {
+                fail(&as, "duplicate label", insn->text);
+                break;
+            }
+            obj->symbols[sym].section = as.section;
+            item->kind = ITEM_LABEL;
+            item->symbol = sym;
+        } else if (insn->kind == ASM_DIRECTIVE) {
+            if (!handle_directive(&as, insn, item)) fail(&as, "unsupported directive", text);
+            item->section = as.section;
+        } else {
+            Enc e;
+            memset(&e, 0, sizeof(e));
+            if (as.section == OBJ_SEC_BSS || !encode_insn(&as, insn, &e, item)) {
+                fail(&as, "cannot encode instruction", text);
+                break;
+            }
+            if (item->kind != ITEM_BRANCH) {
+                set_bytes(item, e.buf, e.len);
+                if (e.nfix) {
+                    item->fixups = malloc(sizeof(Fixup) * e.nfix);
+                    memcpy(item->fixups, e.fix, sizeof(Fixup) * e.nfix);
+                    item->nfixups = e.nfix;
+                }
+            }
+        }
+        if (item->section == OBJ_SEC_BSS && item->kind == ITEM_BYTES) {
+            fail(&as, "initialized data in .bss", text);
+        }
+    }
+
+    // 引用了但没定义的 .L 标签是代码生成的错误
+    for (int i = 0; i < obj->nsymbols && !as.failed; i++) {
+        if (obj->symbols[i].local_label && obj->symbols[i].section < 0) {
+            fail(&as, "undefined label", obj->symbols[i].name);
+        }
+    }
+    if (as.failed) {
+        free_items(&as);
+        obj_free(obj);
+        return 0;
+    }
+
+    // 目标在同一段且不会被外部替换的跳转可以参与放宽，其余固定为 rel32 + 重定位
+    for (int i = 0; i < as.nitems; i++) {
+        Item* item = &as.items[i];
+        if (item->kind != ITEM_BRANCH) continue;
+        const ObjSymbol* sym = &obj->symbols[item->symbol];
+        item->relaxable = sym->section == item->section && (sym->local_label || !sym->global);
+        item->is_long = !item->relaxable;
+    }
+
+    relax_branches(&as);
+    write_sections(&as);
+    free_items(&as);
+    if (as.failed) {
+        obj_free(obj);
+        return 0;
+    }
+    return 1;
+}
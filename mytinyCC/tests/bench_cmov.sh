@@ -0,0 +1,30 @@
+#!/bin/sh
+# if 转换的效果：分支方向随机的 min/max/选择循环，默认（cmov）与 -fno-if-conversion 各运行 N 次（进程内 JIT）。
+# 有 perf 时同时给出分支预测失败次数。
+# 用法：bench_cmov.sh <tinycc> [iterations]
+TINYCC=$1
+N=${2:-5}
+INPUT=$(dirname "$0")/examples/cmov.c
+
+now() { date +%s%N; }
+
+run() {
+    start=$(now)
+    i=0
+    while [ $i -lt "$N" ]; do
+        "$TINYCC" "$@" --run "$INPUT" bench >/dev/null || exit 1
+        i=$((i + 1))
+    done
+    echo $(( ($(now) - start) / N / 1000 ))
+}
+
+misses() {
+    if command -v perf >/dev/null 2>&1; then
+        perf stat -x, -e branch-misses "$TINYCC" "$@" --run "$INPUT" bench 2>&1 >/dev/null | cut -d, -f1
+    else
+        echo "n/a (perf not found)"
+    fi
+}
+
+echo "cmov:                $(run) us/run, branch misses: $(misses)"
+echo "-fno-if-conversion:  $(run -fno-if-conversion) us/run, branch misses: $(misses -fno-if-conversion)"
@@ -0,0 +1,23 @@
+#!/bin/sh
+# 内联的效果：同一个调用密集的程序，默认（内联）与 -fno-inline 各运行 N 次（进程内 JIT）
+# 用法：bench_inline.sh <tinycc> <input.c> [iterations]
+TINYCC=$1
+INPUT=$2
+N=${3:-10}
+
+now() { date +%s%N; }
+
+run() {
+    start=$(now)
+    i=0
+    while [ $i -lt "$N" ]; do
+        "$TINYCC" --run "$@" "$INPUT" >/dev/null || exit 1
+        i=$((i + 1))
+    done
+    echo $(( ($(now) - start) / N / 1000 ))
+}
+
+inlined=$(run)
+plain=$(run -fno-inline)
+echo "inline:     $inlined us/run"
+echo "-fno-inline: $plain us/run"
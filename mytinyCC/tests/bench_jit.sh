@@ -0,0 +1,44 @@
+#!/bin/sh
+# 编译并运行的延迟对比：tinycc --run（进程内 JIT）与落盘路径
+#   text:   tinycc -S -> cc（as + ld）-> 运行
+#   object: tinycc -c -> cc（仅 ld）-> 运行
+# 用法：bench_jit.sh <tinycc> <input.c> [iterations]
+TINYCC=$1
+INPUT=$2
+N=${3:-50}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now() { date +%s%N; }
+
+report() {
+    echo "$1: $(( ($3 - $2) / N / 1000 )) us/iter"
+}
+
+start=$(now)
+i=0
+while [ $i -lt "$N" ]; do
+    "$TINYCC" --run "$INPUT" >/dev/null
+    i=$((i + 1))
+done
+report "jit   (--run)" "$start" "$(now)"
+
+start=$(now)
+i=0
+while [ $i -lt "$N" ]; do
+    "$TINYCC" -S "$INPUT" -o "$WORK/prog.s" >/dev/null
+    cc "$WORK/prog.s" -o "$WORK/prog" 2>/dev/null
+    "$WORK/prog" >/dev/null
+    i=$((i + 1))
+done
+report "text  (-S, as, ld)" "$start" "$(now)"
+
+start=$(now)
+i=0
+while [ $i -lt "$N" ]; do
+    "$TINYCC" -c "$INPUT" -o "$WORK/prog.o" >/dev/null
+    cc "$WORK/prog.o" -o "$WORK/prog" 2>/dev/null
+    "$WORK/prog" >/dev/null
+    i=$((i + 1))
+done
+report "object (-c, ld)" "$start" "$(now)"
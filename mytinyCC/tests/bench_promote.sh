@@ -0,0 +1,22 @@
+#!/bin/sh
+# 寄存器提升的效果：循环计数器与累加器放在寄存器里（默认）与全部留在栈槽（-fno-promote-locals），
+# 各运行 N 次（进程内 JIT）。
+# 用法：bench_promote.sh <tinycc> [iterations]
+TINYCC=$1
+N=${2:-5}
+INPUT=$(dirname "$0")/examples/promote.c
+
+now() { date +%s%N; }
+
+run() {
+    start=$(now)
+    i=0
+    while [ $i -lt "$N" ]; do
+        "$TINYCC" "$@" --run "$INPUT" bench >/dev/null || exit 1
+        i=$((i + 1))
+    done
+    echo $(( ($(now) - start) / N / 1000 ))
+}
+
+echo "registers:            $(run) us/run"
+echo "-fno-promote-locals:  $(run -fno-promote-locals) us/run"
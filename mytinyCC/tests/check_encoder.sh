@@ -0,0 +1,41 @@
+#!/bin/sh
+# 内置汇编器与 GNU as 的交叉检查：同一份输入分别生成 .o，比较 objdump 的反汇编和重定位。
+# 用法：check_encoder.sh <tinycc> <test_encoder> <input.c|input.s> <workdir> [tinycc 选项...]
+# 没有 as/objdump 时返回 77（ctest 记为跳过）。
+set -e
+TINYCC=$1
+ENCODER=$2
+INPUT=$3
+WORK=$4
+shift 4
+
+command -v as >/dev/null 2>&1 || exit 77
+command -v objdump >/dev/null 2>&1 || exit 77
+
+name=$(basename "$INPUT")
+name=${name%.*}
+mkdir -p "$WORK"
+
+case "$INPUT" in
+    *.c)
+        "$TINYCC" "$@" "$INPUT" -S -o "$WORK/$name.s" >/dev/null
+        "$TINYCC" "$@" "$INPUT" -c -o "$WORK/$name.o" >/dev/null
+        ;;
+    *)
+        cp "$INPUT" "$WORK/$name.s"
+        "$ENCODER" "$INPUT" "$WORK/$name.o"
+        ;;
+esac
+as --64 -o "$WORK/$name.gas.o" "$WORK/$name.s"
+
+# 对齐填充用的 nop 序列允许与 as 不同，只要长度一致
+# 有 .rodata（switch 跳转表）时再比较它的内容与重定位
+dump() {
+    objdump -d -r --insn-width=16 "$1" | sed -n '/^Disassembly/,$p' | grep -v 'nop'
+    if objdump -h "$1" | grep -q ' \.rodata '; then
+        objdump -s -r -j .rodata "$1" | sed -n '/^RELOCATION\|^Contents/,$p'
+    fi
+}
+dump "$WORK/$name.gas.o" > "$WORK/$name.gas.dump"
+dump "$WORK/$name.o" > "$WORK/$name.tinycc.dump"
+diff -u "$WORK/$name.gas.dump" "$WORK/$name.tinycc.dump"
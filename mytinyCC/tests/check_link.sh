@@ -0,0 +1,28 @@
+#!/bin/sh
+# 单独编译：每个输入分别用 tinycc -c 生成目标文件，再用 cc 链接运行，程序返回 0 为通过。
+# 用法：check_link.sh <tinycc> <workdir> <input.c>... [-- tinycc 选项...]
+# 没有 cc 时返回 77（ctest 记为跳过）。
+set -e
+TINYCC=$1
+WORK=$2
+shift 2
+
+command -v cc >/dev/null 2>&1 || exit 77
+
+inputs=
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    inputs="$inputs $1"
+    shift
+done
+[ "$1" = "--" ] && shift
+
+mkdir -p "$WORK"
+objects=
+for input in $inputs; do
+    name=$(basename "$input")
+    name=${name%.*}
+    "$TINYCC" "$@" "$input" -c -o "$WORK/$name.o" >/dev/null
+    objects="$objects $WORK/$name.o"
+done
+cc -o "$WORK/linked" $objects
+"$WORK/linked"
@@ -0,0 +1,43 @@
+// 条件上下文：关系运算直接生成 cmp + jcc，&&、|| 和 ! 生成短路跳转。
+// 右操作数里的除零只有在短路失效时才会执行。
+int safe_div(int a, int d) {
+    if (d != 0 && a / d > 2) return 1;
+    return 0;
+}
+
+int either(int a, int d) {
+    if (d == 0 || a / d < 2) return 1;
+    return 0;
+}
+
+int count_below(int n, int limit) {
+    int count = 0;
+    int i = 0;
+    while (i < n) {
+        if (!(i >= limit)) count = count + 1;
+        i = i + 1;
+    }
+    return count;
+}
+
+int in_range(int x) {
+    return x >= 10 && x <= 20 || x == 42;
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    if (safe_div(9 * one, zero) != 0) failures = failures + 1;
+    if (safe_div(9 * one, 2 * one) != 1) failures = failures + 1;
+    if (either(9 * one, zero) != 1) failures = failures + 1;
+    if (either(9 * one, 3 * one) != 0) failures = failures + 1;
+    if (count_below(10 * one, 4 * one) != 4) failures = failures + 1;
+    if (in_range(15 * one) + in_range(42 * one) + in_range(5 * one) + in_range(21 * one) != 2) failures = failures + 1;
+    for (int k = 0; 3 > k; k = k + 1) {
+        if (!k) failures = failures + 0;
+    }
+    if (!(1 < 2)) failures = failures + 1;
+    while (0) failures = failures + 1;
+    return failures;
+}
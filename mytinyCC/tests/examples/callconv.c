@@ -0,0 +1,26 @@
+int sum8(int a, int b, int c, int d, int e, int f, int g, int h) {
+    return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * g + 8 * h;
+}
+
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+int twice(int x) {
+    return x + x;
+}
+
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (sum8(one, 2 * one, 3 * one, 4 * one, 5 * one, 6 * one, 7 * one, 8 * one) != 204) failures = failures + 1;
+    // 调用嵌在表达式中间，参数本身也是调用
+    if (1 + twice(twice(3 * one)) != 13) failures = failures + 1;
+    if (fib(15 * one) != 610) failures = failures + 1;
+    // 与 libc 互通
+    putchar(79);
+    putchar(75);
+    putchar(10);
+    return failures;
+}
@@ -0,0 +1,79 @@
+// if 转换：简单的 if/else 赋值改用 cmov；数据来自线性同余发生器，分支方向无法预测。
+// 也作为 bench_cmov.sh 的微基准：带参数运行时每个循环迭代两千万次。
+
+// 模 2^20 的线性同余发生器（乘积不会溢出），取高位使用
+int next_random(int seed) {
+    return (seed * 109 + 89) & 1048575;
+}
+
+int min_max(int n) {
+    int seed = 7;
+    int lo = 1024;
+    int hi = -1;
+    int sum = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        seed = next_random(seed);
+        int v = (seed >> 10) & 1023;
+        int m = 0;
+        if (v < 512) m = v;
+        else m = 1023 - v;
+        if (v < lo) lo = v;
+        if (!(v <= hi)) hi = v;
+        sum = sum + m;
+    }
+    return sum + lo * 7 + hi;
+}
+
+// 各种条件与值的形状：常量、表达式、非比较的条件、带 ! 的条件
+int shapes(int n) {
+    int seed = 12345;
+    int acc = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        seed = next_random(seed);
+        int a = (seed >> 12) & 255;
+        int b = (seed >> 4) & 255;
+        int r = 0;
+        if (a > b) {
+            r = a - b;
+        } else {
+            r = b - a + 1;
+        }
+        int s;
+        if (a & 1) s = 3;
+        else s = -5;
+        int t = a;
+        if (!(a >= 100)) t = b * 2 + i;
+        acc = (acc * 3 + r + s + t) & 1048575;
+    }
+    return acc;
+}
+
+// 不能转换的情形：值里有除法（提前求值会除以 0）、条件里有 &&、两边写不同的变量
+int not_converted(int a, int b) {
+    int q = 0;
+    if (b != 0) q = a / b;
+    else q = -1;
+    int r = 0;
+    if (a > 0 && b > 0) r = a + b;
+    int x = 1;
+    int y = 2;
+    if (a < b) x = a;
+    else y = b;
+    return q * 1000 + r * 10 + x + y;
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int n = 1000;
+    if (argc > 1) n = 20000000;
+    int failures = 0;
+    int mm = min_max(n);
+    int sh = shapes(n);
+    if (argc > 1) return mm + sh == 0;
+    if (mm != 247834) failures = failures + 1;
+    if (sh != 218310) failures = failures + 1;
+    if (not_converted(17 * one, 5 * one) != 3226 || not_converted(17 * one, zero) != -999) failures = failures + 1;
+    if (not_converted(-4 * one, 3 * one) != -1002) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,54 @@
+// 复合赋值：x op= e 即 x = x op e，e 整体作为右操作数
+int main(int argc) {
+    int failures = 0;
+    int x = argc + 9;
+    x += 5;
+    if (x != 15) failures = failures + 1;
+    x -= argc + 2;
+    if (x != 12) failures = failures + 1;
+    x *= 3 + argc;
+    if (x != 48) failures = failures + 1;
+    x /= argc + 6;
+    if (x != 6) failures = failures + 1;
+    x %= 4;
+    if (x != 2) failures = failures + 1;
+
+    // 复合赋值是表达式，值为赋值后的值；右结合
+    int y = argc;
+    int z = (x += 10) * 2;
+    if (x != 12 || z != 24) failures = failures + 1;
+    y += x -= 2;
+    if (x != 10 || y != 11) failures = failures + 1;
+
+    // 循环更新语句
+    int sum = 0;
+    for (int i = 0; i < 10; i += 2) {
+        sum += i;
+    }
+    if (sum != 20) failures = failures + 1;
+    int n = 100 * argc;
+    while (n > 1) n /= 3;
+    if (n != 1) failures = failures + 1;
+
+    // 数组元素：a[i] op= e 即 a[i] = a[i] op e，下标只是读变量
+    int arr[8];
+    for (int i = 0; i < 8; i += 1) arr[i] = i + argc;
+    for (int i = 0; i < 8; i += 1) {
+        arr[i] *= 3;
+        arr[i] -= i;
+    }
+    int k = argc + 2;
+    arr[k] += 100;
+    arr[k - 1] %= 4;
+    arr[k + 1] /= 2;
+    int total = 0;
+    for (int i = 0; i < 8; i += 1) total = total * 10 + arr[i];
+    if (total != 36396467 || (arr[0] += 7) != 10) failures = failures + 1;
+
+    // 与运算符相邻的写法仍按原来的记号切分
+    int a = argc;
+    int b = a-1;
+    int c = a ==1;
+    if (b != 0 || c != 1) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,97 @@
+// 编译期求值：常量实参的纯函数调用在编译期算出结果，-fno-eval-pure-calls 的结果一致。
+// 超出步数或深度、调用外部函数、实参不是常量时照常在运行时调用。
+
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// switch 的落入与 break
+int weight(int c) {
+    int w = 0;
+    switch (c) {
+        case 1:
+            w = w + 1;
+        case 2:
+            w = w + 10;
+            break;
+        case 3:
+            w = 100;
+            break;
+        default:
+            w = -1;
+    }
+    return w;
+}
+
+// 互相递归的纯函数
+int is_even(int n) {
+    if (n == 0) return 1;
+    return is_odd(n - 1);
+}
+
+int is_odd(int n) {
+    if (n == 0) return 0;
+    return is_even(n - 1);
+}
+
+// 只在不执行的路径上除以零
+int safe_div(int a, int b) {
+    if (b == 0) return 0;
+    return a / b;
+}
+
+// 有符号溢出按补码回绕，与运行时一致
+int wrap(int n) {
+    int x = 2147483647;
+    for (int i = 0; i < n; i = i + 1) x = x + 1;
+    return x * 3;
+}
+
+// 循环次数远超步数上限：留到运行时
+int spin(int n) {
+    int h = 0;
+    for (int i = 0; i < n; i = i + 1) h = (h * 31 + i) ^ (h >> 7);
+    return h;
+}
+
+// 递归深度超过上限：留到运行时
+int depth(int n) {
+    if (n == 0) return 0;
+    return 1 + depth(n - 1);
+}
+
+// 调用外部函数的不是纯函数
+int impure(int n) {
+    return abs(n) + 1;
+}
+
+int twice(int n) {
+    return n * 2;
+}
+
+int main(int argc) {
+    int failures = 0;
+    if (fib(20) != 6765) failures = failures + 1;
+    if (gcd(1071, 462) != 21) failures = failures + 1;
+    if (weight(1) != 11 || weight(2) != 10 || weight(3) != 100 || weight(7) != -1) failures = failures + 1;
+    if (is_even(10) != 1 || is_odd(7) != 1) failures = failures + 1;
+    if (safe_div(7, 0) != 0 || safe_div(-7, 2) != -3) failures = failures + 1;
+    if (wrap(2) != -2147483645) failures = failures + 1;
+    if (spin(3000000) != 1108431991) failures = failures + 1;
+    if (depth(1000) != 1000) failures = failures + 1;
+    if (impure(-4) != 5) failures = failures + 1;
+    // 内层调用先换成字面量，外层调用的实参随之成为常量
+    if (twice(gcd(fib(12), 12)) != 24) failures = failures + 1;
+    if (twice(argc) != argc * 2) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,31 @@
+// 稀疏条件常量传播：常量条件的分支、恒假的循环与循环中不变的常量
+int f(int a) {
+    int DEBUG = 0;
+    int N = 4;
+    int x = N * 2 + 1;
+    int y = 0;
+    if (DEBUG) {
+        y = a * 100;
+    } else {
+        y = a + x;
+    }
+    int i = 0;
+    int k = 3;
+    while (i < a) {
+        if (k != 3) { k = k + 1; }
+        y = y + k;
+        i = i + 1;
+    }
+    if (N > 2 && !DEBUG) { y = y + N; }
+    while (DEBUG) { y = 0; }
+    for (int j = 0; j < 0; j = j + 1) y = 7;
+    return y + x;
+}
+
+// 实参由 argc 算出，f 里只剩函数内部的常量可以传播
+int main(int argc) {
+    int failures = 0;
+    if (f(argc + 4) != 42) failures = failures + 1;
+    if (f(argc - 1) != 22 || f(argc + 9) != 62) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,87 @@
+// 死代码消除：死存储、无用表达式语句、return 之后的语句与 main 不可达的函数
+
+// 从 main 不可达，整个删除
+int never_called(int x) {
+    return x * x + 1;
+}
+
+int only_from_dead(int x) {
+    return never_called(x) - 1;
+}
+
+// 调用按有副作用处理，表达式语句里的调用要保留
+int bump(int x) {
+    return x + 1;
+}
+
+// 写了从未读取的变量、被覆盖的初值
+int dead_stores(int a, int b) {
+    int unused = a * b + 7;
+    int r = a + b;
+    r = a - b;
+    unused = r * 3;
+    return r;
+}
+
+// 只有调用要保留的表达式语句
+int expression_statements(int a) {
+    a + 1;
+    a * 2 + bump(a);
+    int k = bump(a) + a * 5;
+    k = bump(k);
+    return a;
+}
+
+// return 之后以及两个分支都返回的 if 之后的语句
+int after_return(int a) {
+    if (a > 0) {
+        return 1;
+        a = a + 100;
+    } else {
+        return 2;
+    }
+    a = a * 3;
+    return a;
+}
+
+// return 之后声明的变量在后面的 case 里使用：声明要留下
+int declared_after_return(int k, int x) {
+    switch (k) {
+        case 1:
+            return 7;
+            int y = 100;
+        case 2:
+            y = x * 3;
+            return y;
+        default:
+            break;
+    }
+    return 0;
+}
+
+// 循环里的存储在下一次迭代被读取，不是死存储
+int loop_carried(int n) {
+    int prev = 0;
+    int cur = 1;
+    int i = 0;
+    while (i < n) {
+        int next = prev + cur;
+        prev = cur;
+        cur = next;
+        i = i + 1;
+    }
+    return prev;
+}
+
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (declared_after_return(one, 5 * one) != 7) failures = failures + 1;
+    if (declared_after_return(2 * one, 5 * one) != 15) failures = failures + 1;
+    if (dead_stores(9 * one, 4 * one) != 5) failures = failures + 1;
+    if (expression_statements(6 * one) != 6) failures = failures + 1;
+    if (after_return(3 * one) != 1) failures = failures + 1;
+    if (after_return(-3 * one) != 2) failures = failures + 1;
+    if (loop_carried(10 * one) != 55) failures = failures + 1;
+    return failures;
+}
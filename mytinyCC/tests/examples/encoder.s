@@ -0,0 +1,186 @@
+# 内置汇编器的编码覆盖：各类寻址方式、立即数宽度、REX 前缀和跳转放宽
+.section .text
+.globl enc_alu
+enc_alu:
+    pushq %rbp
+    movq %rsp, %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r15
+    addl %ebx, %eax
+    addq %r8, %r9
+    subl $1, %eax
+    subl $1000, %eax
+    subl $1000, %ecx
+    subq $16, %rsp
+    addq $4096, %rsp
+    andl $-1, %edx
+    orl -4(%rbp), %eax
+    xorl %eax, -8(%rbp)
+    cmpl $0, -12(%rbp)
+    cmpl $100000, 8(%rsp)
+    cmpq %rax, (%r12)
+    cmpb $7, %al
+    cmpb $7, %sil
+    adcl %ecx, %edx
+    sbbl %ecx, %edx
+    movl $5, %eax
+    movl $-1, %r10d
+    movq $-1, %rax
+    movq $0x123456789, %rcx
+    movabsq $0x1122334455667788, %r11
+    movl %eax, %ebx
+    movq %rsp, %rbp
+    movl -4(%rbp), %eax
+    movl %eax, -400(%rbp)
+    movq 16(%rsp), %r13
+    movq %r14, (%r13)
+    movl (%rax,%rcx,4), %edx
+    movl 8(%rbx,%r9,8), %edx
+    movl %edx, (,%rcx,4)
+    movb %al, (%rdi)
+    movb $1, (%rsi)
+    movl $7, -4(%rbp)
+    movq $7, 8(%rsp)
+    movzbl %al, %eax
+    movzbl %dil, %ecx
+    movsbl (%rdi), %eax
+    movzwl %ax, %eax
+    movslq %eax, %rax
+    movslq -4(%rbp), %r8
+    leaq -16(%rbp), %rax
+    leaq (%rax,%rax,2), %rdx
+    leal 1(%rdi), %eax
+    testl %eax, %eax
+    testq %r8, %r8
+    testl $1, %eax
+    testl $256, %ecx
+    imull %ebx, %eax
+    imull -4(%rbp), %ecx
+    imull $3, %eax
+    imull $1000, %edx, %eax
+    imulq %r9, %r10
+    idivl %ebx
+    idivl -4(%rbp)
+    divq %rcx
+    negl %eax
+    notq %r11
+    incl %eax
+    decq (%rax)
+    cltd
+    cqto
+    cltq
+    sall %cl, %eax
+    sarl %cl, %eax
+    shrq %cl, %r12
+    sall $1, %eax
+    sarl $31, %edx
+    shrq $3, %rax
+    shll %eax
+    sete %al
+    setne %cl
+    setl %sil
+    setge (%rdi)
+    cmovl %ebx, %eax
+    cmovgeq %r8, %rax
+    cmovne -4(%rbp), %edx
+    popq %r15
+    popq %r12
+    popq %rbx
+    leave
+    ret
+.globl enc_sse
+enc_sse:
+    movdqu (%rsi,%rcx,4), %xmm0
+    movdqu 16(%r8,%rcx,4), %xmm9
+    movdqu %xmm1, -32(%rbp,%rcx,4)
+    movdqu %xmm12, (%r11,%rcx,4)
+    movdqa %xmm0, %xmm1
+    movdqa %xmm15, %xmm2
+    movdqa -48(%rbp), %xmm3
+    movd %eax, %xmm15
+    movd -4(%rbp), %xmm3
+    movd %r12d, %xmm8
+    movd %xmm2, %eax
+    movd %xmm10, -8(%rbp)
+    pshufd $0, %xmm15, %xmm15
+    pshufd $245, %xmm0, %xmm8
+    paddd %xmm1, %xmm0
+    paddd (%rdi,%rcx,4), %xmm14
+    psubd %xmm13, %xmm2
+    pand %xmm1, %xmm0
+    por %xmm9, %xmm10
+    pxor 8(%rsp), %xmm1
+    pmuludq %xmm1, %xmm0
+    punpckldq %xmm8, %xmm0
+    leaq table(%rip), %rsi
+    movdqu counter(%rip), %xmm4
+    ret
+.globl enc_branch
+enc_branch:
+    pushq $1
+    pushq $1000
+    pushq 8(%rbp)
+    popq (%rax)
+    call enc_alu
+    call external_function
+    call *%rax
+    call *8(%rbx)
+    jmp *%rdx
+    jmp *(%rax,%rcx,8)
+    rdtsc
+.Lloop:
+    subl $1, %eax
+    jne .Lloop
+    je .Lfar
+    jmp .Lnear
+.Lnear:
+    .p2align 4
+    jg .Lfar
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+    movl $1, %eax
+.Lfar:
+    movl counter(%rip), %eax
+    addl $1, counter(%rip)
+    movl $message, %edi
+    leaq message(%rip), %rsi
+    movq table(,%rax,8), %rdx
+    ret
+.section .data
+.globl counter
+counter:
+    .long 0
+table:
+    .quad .Lnear, .Lfar
+    .quad enc_alu
+.section .rodata
+message:
+    .string "hi\n"
+.section .bss
+buffer:
+    .zero 64
@@ -1,6 +1,6 @@
 
-int main() {
-    int n = 5;
+int main(int argc) {
+    int n = 5 * argc;
     int result = 1;
     int i = 1;
     
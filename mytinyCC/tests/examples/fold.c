@@ -0,0 +1,16 @@
+// 常量折叠与代数化简：x * 1、y - y、x & 0、x == x 等，实参由 argc 算出
+int h(int x, int y) {
+    int a = x * 1 + 0;
+    int b = (y - y) + a * 0 + 2 * 3 - 1;
+    int c = x * 0;
+    if (1 < 2) { a = a + b; } else { a = 0; }
+    while (0) { a = 1; }
+    return -(-a) + (x & 0) + (x | 0) + c + (0 && h(1,2)) + (x == x);
+}
+
+int main(int argc) {
+    int failures = 0;
+    if (h(argc + 2, argc + 3) != 12) failures = failures + 1;
+    if (h(argc - 8, argc - 1) != -8 || h(argc + 99, argc + 8) != 206) failures = failures + 1;
+    return failures;
+}
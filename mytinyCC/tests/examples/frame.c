@@ -0,0 +1,41 @@
+// 叶函数：几个临时变量活跃区间不相交，应共用栈槽
+int mix(int a, int b) {
+    int s = a + b;
+    int t = s * 2;
+    int u = t - a;
+    int v = u + 7;
+    return v;
+}
+
+// 两个先后执行的循环，各自的计数器和累加器可以复用同一组槽
+int loops(int n) {
+    int total = 0;
+    int i = 0;
+    while (i < n) {
+        total = total + i;
+        i = i + 1;
+    }
+    int j = 0;
+    int acc = 1;
+    while (j < 5) {
+        acc = acc * 2;
+        j = j + 1;
+    }
+    return total + acc;
+}
+
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (mix(3 * one, 4 * one) != 18) failures = failures + 1;
+    if (loops(10 * one) != 77) failures = failures + 1;
+    {
+        int x = 5;
+        failures = failures + x - 5;
+    }
+    {
+        int y = 6;
+        failures = failures + y - 6;
+    }
+    return failures;
+}
@@ -0,0 +1,6 @@
+// 全局标量没有存储，编译应当报错（全局数组可以）
+int g;
+
+int main(int argc) {
+    return g + argc;
+}
@@ -0,0 +1,57 @@
+// 全局值编号：被支配的重复计算改为读取临时变量；可交换运算的操作数顺序不影响编号
+
+int area(int w, int h) {
+    int a = w * h + 3;
+    int b = h * w + 3;
+    return a + b + (w * h + 3) * 2;
+}
+
+// 首次计算在 if 之前，重复计算在两个分支和循环里
+int branches(int x, int y) {
+    int s = (x - y) * (x + y);
+    if (x > y) {
+        s = s + (x - y) * (x + y);
+    } else {
+        s = s - (x + y);
+    }
+    for (int i = 0; i < 4; i = i + 1) {
+        s = s + (x ^ y) + (y ^ x);
+    }
+    return s;
+}
+
+// 变量重新赋值后的同名表达式是新的值，不能替换
+int reassigned(int a, int b) {
+    int p = a * b;
+    a = a + 1;
+    int q = a * b;
+    return p * 100 + q + -a + -a;
+}
+
+// 同一调用的不同实参之间不替换；调用之后的重复计算可以替换
+int pick(int a, int b) {
+    return a * 10 + b;
+}
+
+int calls(int x, int y) {
+    int r = pick(x * y + 1, x * y + 1);
+    return r + (x * y + 1) + pick(x % 7, ~x) + (~x);
+}
+
+// 分支内的首次计算不支配分支之后的重复计算
+int not_dominated(int x) {
+    int r = 0;
+    if (x > 0) r = x * x;
+    return r + x * x;
+}
+
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (area(4 * one, 5 * one) != 92) failures = failures + 1;
+    if (branches(7 * one, 3 * one) != 112 || branches(2 * one, 9 * one) != 0) failures = failures + 1;
+    if (reassigned(6 * one, 7 * one) != 4235) failures = failures + 1;
+    if (calls(3 * one, 4 * one) != 178) failures = failures + 1;
+    if (not_dominated(5 * one) != 50 || not_dominated(-4 * one) != 16) failures = failures + 1;
+    return failures;
+}
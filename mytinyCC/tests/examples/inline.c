@@ -0,0 +1,36 @@
+// 调用密集的小函数：取值、包装、组合。内联后循环体里不再有调用。
+int square(int x) {
+    return x * x;
+}
+
+int add(int a, int b) {
+    return a + b;
+}
+
+int low_bits(int v) {
+    return v & 1023;
+}
+
+int mix(int a, int b) {
+    return low_bits(add(square(a), b));
+}
+
+// 递归函数不内联
+int fact(int n) {
+    if (n < 2) return 1;
+    return n * fact(n - 1);
+}
+
+int main(int argc) {
+    int one = argc;
+    int acc = 0;
+    int i = 0;
+    while (i < 20000000) {
+        acc = mix(acc + i, add(i, 3 * one));
+        i = i + 1;
+    }
+    if (acc != 274) return 1;
+    if (fact(5 * one) != 120) return 2;
+    if (add(square(3 * one), low_bits(2048 + 5 * one)) != 14) return 3;
+    return 0;
+}
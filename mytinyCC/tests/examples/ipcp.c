@@ -0,0 +1,69 @@
+// 过程间常量传播与函数特化：-fno-ipa-cp 的结果一致。
+// 变化的实参都由 argc 算出，编译期求值不会把这些调用整个算掉。
+
+// 所有调用点都传 k = 3：k 变成局部常量，乘法按常量处理
+int scale(int x, int k) {
+    return x * k + k;
+}
+
+// mod 只在递归里原样传递，入口处总是 1000
+int power(int base, int e, int mod) {
+    if (e == 0) return 1;
+    int half = power(base, e / 2, mod);
+    int r = half * half % mod;
+    if (e % 2 == 1) r = r * base % mod;
+    return r;
+}
+
+// mode 在不同调用点取不同常量：每个常量一份克隆，switch 只剩一个分支；非常量实参仍调用原函数
+int apply(int x, int mode) {
+    switch (mode) {
+        case 0: return x + 1;
+        case 1: return x * 2;
+        case 2: return x - 7;
+        default: return -x;
+    }
+}
+
+// 除数为常量的克隆里除法可以换成乘法
+int bucket(int x, int d) {
+    if (d == 0) return 0;
+    return x / d + x % d;
+}
+
+// 克隆体里的递归调用原样传递 step，改调克隆自身
+int walk(int n, int step) {
+    if (n <= 0) return 0;
+    if (step == 1) return n;
+    return 1 + walk(n - step, step);
+}
+
+// 形参在函数体里被改写：改成局部变量后仍从调用点的常量开始
+int bump(int a, int k) {
+    k = k + a;
+    return k * 2;
+}
+
+// 内层块里有同名变量遮蔽形参：不传播
+int shadow(int x, int k) {
+    int r = x + k;
+    {
+        int k = 5;
+        r = r * k;
+    }
+    return r;
+}
+
+int main(int argc) {
+    int v = argc + 9;
+    int failures = 0;
+    if (scale(v, 3) != 33 || scale(v + 1, 3) != 36) failures = failures + 1;
+    if (power(v - 7, v, 1000) != 49) failures = failures + 1;
+    if (apply(v, 0) != 11 || apply(v, 1) != 20 || apply(v, 2) != 3) failures = failures + 1;
+    if (apply(v, argc) != 20 || apply(v, 9) != -10) failures = failures + 1;
+    if (bucket(v * 10, 7) != 16 || bucket(v + 25, 10) != 8 || bucket(v, 7) != 4) failures = failures + 1;
+    if (walk(v * 3, 2) != 15 || walk(v, 4) != 3 || walk(v, 1) != 10) failures = failures + 1;
+    if (bump(v, 4) != 28 || bump(v + 1, 4) != 30) failures = failures + 1;
+    if (shadow(v, 2) != 60 || shadow(v, 2) != 60) failures = failures + 1;
+    return failures;
+}
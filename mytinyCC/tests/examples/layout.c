@@ -0,0 +1,96 @@
+// 代码布局：循环轮转（条件放在底部）、提前返回与错误检查移到函数末尾；-fno-reorder-blocks 的结果一致
+
+// 错误检查：与 0 的比较预测为假，处理代码移到函数末尾
+int checked_div(int a, int b) {
+    if (b == 0) {
+        return -1;
+    }
+    if (a < 0) {
+        a = -a;
+    }
+    return a / b;
+}
+
+// 提前返回预测为不执行；else 分支一定返回时预测 else 不执行
+int classify(int x) {
+    if (x > 1000) return 3;
+    int r = 0;
+    if (x > 10) {
+        r = x * 2;
+    } else {
+        return x + 100;
+    }
+    if (!x) r = r + 7;
+    if (x != 0) {
+        r = r + 1;
+    } else {
+        r = r - 1;
+    }
+    return r;
+}
+
+// 冷分支里还有循环、switch 和嵌套的冷分支
+int cold_work(int n) {
+    int total = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        if (i % 7 == 0) {
+            int k = 0;
+            while (k < i) {
+                if (k == 0) total = total + 3;
+                k = k + 2;
+            }
+            switch (i % 4) {
+                case 0: total = total + 1; break;
+                case 1: total = total + 2; break;
+                case 2: total = total + 3; break;
+                default: total = total - 1;
+            }
+        }
+        total = total + i;
+    }
+    return total;
+}
+
+// 各种循环形状：条件恒真、不执行、没有条件的 for
+int loops(int n) {
+    int s = 0;
+    int i = 0;
+    while (1) {
+        i = i + 1;
+        if (i > n) return s + i;
+        s = s + i;
+    }
+    return -1;
+}
+
+int empty_loops(int n) {
+    int s = 5;
+    while (n < -100) s = s + 1;
+    for (int i = 10; i < 3; i = i + 1) s = s + 100;
+    int j = 0;
+    for (;;) {
+        j = j + 3;
+        if (j >= n) return s + j;
+    }
+    return 0;
+}
+
+// 递归的基础情形是提前返回
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+// 实参都由 argc 算出：编译期求值与过程间常量传播不会把被测函数算掉或特化
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    if (checked_div(10, zero) != -1 || checked_div(-9, 2 * one) != 4 || checked_div(9, 3 * one) != 3) failures = failures + 1;
+    if (classify(5000 * one) != 3 || classify(5 * one) != 105 || classify(zero) != 100 || classify(50 * one) != 101) failures = failures + 1;
+    if (cold_work(40 * one) != 800) failures = failures + 1;
+    if (loops(10 * one) != 66 || loops(zero) != 1) failures = failures + 1;
+    if (empty_loops(10 * one) != 17 || empty_loops(-2 * one) != 8) failures = failures + 1;
+    if (fib(20 * one) != 6765) failures = failures + 1;
+    return failures;
+}
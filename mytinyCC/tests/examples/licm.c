@@ -0,0 +1,74 @@
+// 循环不变代码外提与归纳变量强度削减
+int id(int x) {
+    return x;
+}
+
+// a * b + c 与 n - 1 每次迭代都一样，提到循环之前；i * 8 变成每次加 8
+int invariant_sum(int a, int b, int c, int n) {
+    int s = 0;
+    for (int i = 0; i < n - 1; i = i + 1) {
+        s = s + a * b + c + i * 8;
+    }
+    return s;
+}
+
+// 嵌套循环：i * n 对内层不变，j * 3 在内层削减；w 每次外层迭代都重写，不能提到外层之外
+int nested(int n, int m) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        int w = i * n + m;
+        for (int j = 0; j < m; j = j + 1) {
+            s = s ^ (w + j * 3 + (m << 2));
+        }
+        i = i + 1;
+    }
+    return s;
+}
+
+// 递减的归纳变量、左移当乘法，以及乘以不变变量
+int countdown(int n, int k) {
+    int s = 0;
+    int i = n;
+    while (i > 0) {
+        s = s + (i << 2) - i * k;
+        i = i - 2;
+    }
+    return s;
+}
+
+// 除数可能为零的除法不能外提（循环可能一次都不执行）；循环里有调用时照样外提局部表达式
+int guarded(int a, int d, int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s + a / d + id(i) * (a + 1);
+    }
+    return s;
+}
+
+// 归纳变量在循环里写了两次：不是基本归纳变量
+int irregular(int n) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        s = s + i * 5;
+        i = i + 1;
+        if (s > 100) i = i + 1;
+    }
+    return s;
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    if (invariant_sum(3 * one, 4 * one, 5 * one, 10 * one) != 441) failures = failures + 1;
+    if (invariant_sum(-2 * one, 7 * one, one, zero) != 0) failures = failures + 1;
+    if (nested(6 * one, 5 * one) != 14) failures = failures + 1;
+    if (countdown(9 * one, 3 * one) != 25) failures = failures + 1;
+    if (countdown(10 * one, -1 * one) != 150) failures = failures + 1;
+    if (guarded(7 * one, zero, zero) != 0) failures = failures + 1;
+    if (guarded(20 * one, 3 * one, 4 * one) != 150) failures = failures + 1;
+    if (irregular(20 * one) != 495) failures = failures + 1;
+    return failures;
+}
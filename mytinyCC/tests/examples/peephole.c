@@ -0,0 +1,17 @@
+// 窥孔优化：比较与分支、循环的跳转，实参由 argc 算出
+int f(int a, int b) {
+    int c = a * 2 + b;
+    if (a < b && b != 3) {
+        c = c - 1;
+    }
+    while (c > 10) {
+        c = c - b;
+    }
+    return c == 4;
+}
+int main(int argc) {
+    int failures = 0;
+    if (f(argc, argc + 1) != 0 || f(argc + 1, argc - 1) != 1) failures = failures + 1;
+    if (f(argc - 1, argc + 4) != 1 || f(argc + 8, argc + 1) != 0) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,62 @@
+// 基于剖析的优化：-fprofile-generate 插桩后运行两次，-fprofile-use 读回累加的计数再编译运行，结果一致
+
+// 静态预测认为 x == 0 很少成立（按错误检查处理），实测几乎总是成立：
+// 剖析数据把 else 移到函数末尾，方向稳定也不再改成 cmov
+int mostly_zero(int n) {
+    int hits = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        int x = i % 50 == 49;
+        if (x == 0) {
+            hits = hits + 1;
+        } else {
+            hits = hits - 3;
+        }
+    }
+    return hits;
+}
+
+// 内层循环平均不到两次迭代：不做部分展开
+int short_trips(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        int m = i % 3;
+        for (int j = 0; j < m; j = j + 1) s = s + j + i;
+    }
+    return s;
+}
+
+// 从未调用过的函数不内联；从未执行的循环不对齐
+int rarely(int x) {
+    return x * 3 + 7;
+}
+
+int guarded(int n) {
+    int r = n;
+    if (n < -1000) r = rarely(n);
+    while (n < -100) n = n + 1;
+    return r + n;
+}
+
+// 调用频繁的函数放宽内联预算
+int scramble(int a, int b) {
+    return (a * 31 + b) * 17 + (a ^ b) * 5 + (a & 255) - (b | 3) + a % 7 + (b >> 2) * (a - b);
+}
+
+int hot_calls(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = (s + scramble(i, s & 1023)) & 65535;
+    }
+    return s;
+}
+
+// 实参都由 argc 算出：编译期求值与过程间常量传播不会把被测函数算掉或特化
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (mostly_zero(5000 * one) != 4600) failures = failures + 1;
+    if (short_trips(300 * one) != 45150) failures = failures + 1;
+    if (guarded(5 * one) != 10 || guarded(-5 * one) != -10) failures = failures + 1;
+    if (hot_calls(2000 * one) != 23749) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,103 @@
+// 寄存器提升：访问最多的局部变量与参数放进被调用者保存的寄存器，-fno-promote-locals 的结果一致。
+// 也作为 bench_promote.sh 的微基准：带参数运行时循环次数放大一千倍。
+
+// 循环计数器与累加器整个循环都在寄存器里
+int sum_squares(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s + i * i;
+    }
+    return s;
+}
+
+// 变量比寄存器多：只有权重最大的几个槽提升，内层循环的变量优先
+int many(int n) {
+    int a = 1;
+    int b = 2;
+    int c = 3;
+    int d = 4;
+    int e = 5;
+    int f = 6;
+    int g = 7;
+    for (int i = 0; i < n; i = i + 1) {
+        for (int j = 0; j < 3; j = j + 1) {
+            a = a + b;
+            b = b ^ c;
+            c = c + d;
+            d = d - e;
+        }
+        e = e + f;
+        f = f * 3 + g;
+    }
+    g = g + a;
+    return (a ^ b ^ c ^ d ^ e ^ f ^ g) & 65535;
+}
+
+// 被调用者保存的寄存器跨调用保持不变；调用者里的寄存器变量不会被被调用者破坏
+int mix(int x, int y) {
+    int t = x * 7;
+    for (int k = 0; k < 4; k = k + 1) t = (t ^ y) + k;
+    return t;
+}
+
+int across_calls(int n) {
+    int acc = 0;
+    int step = 3;
+    for (int i = 0; i < n; i = i + 1) {
+        acc = acc + mix(i, step);
+        step = step + 1;
+    }
+    return acc;
+}
+
+// 第 7、8 个参数在调用者的栈上，提升时在序言里装进寄存器
+int eight(int a, int b, int c, int d, int e, int f, int g, int h) {
+    int s = 0;
+    for (int i = 0; i < 5; i = i + 1) {
+        s = s + g * i + h;
+    }
+    return s + a + b + c + d + e + f;
+}
+
+// 自递归尾调用把实参写回参数所在的寄存器
+int count_down(int n, int acc) {
+    if (n == 0) return acc;
+    return count_down(n - 1, acc + n * 2);
+}
+
+// 活跃区间不相交的变量共用一个槽，也就共用一个寄存器
+int phases(int n) {
+    int total = 0;
+    {
+        int x = 0;
+        for (int i = 0; i < n; i = i + 1) x = x + 2;
+        total = total + x;
+    }
+    {
+        int y = 100;
+        for (int i = 0; i < n; i = i + 1) y = y - 1;
+        total = total + y;
+    }
+    return total;
+}
+
+int main(int argc) {
+    // 输入由 argc 算出；基准测试（带参数运行）时多跑几轮，输入不变
+    int one = argc;
+    int scale = 1;
+    if (argc > 1) {
+        scale = 1000;
+        one = 1;
+    }
+    int zero = one - 1;
+    int failures = 0;
+    for (int r = 0; r < scale; r = r + 1) {
+        if (sum_squares(100 * one) != 328350) failures = failures + 1;
+        if (many(50 * one) != 60411) failures = failures + 1;
+        if (across_calls(30 * one) != 3165) failures = failures + 1;
+    }
+    if (eight(one, 2 * one, 3 * one, 4 * one, 5 * one, 6 * one, 7 * one, 8 * one) != 131) failures = failures + 1;
+    if (count_down(100 * one, zero) != 10100) failures = failures + 1;
+    if (phases(10 * one) != 110) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,80 @@
+// 块作用域：内层同名变量遮住外层的，离开块后外层的值不变
+int ga[8];
+
+// 参数被 for 的初始化与循环体里的声明遮住
+int shadow_param(int n) {
+    int s = 0;
+    for (int n = 0; n < 4; n = n + 1) {
+        int s = n * 10;
+        ga[n] = s;
+    }
+    for (int i = 0; i < 4; i = i + 1) s = s + ga[i];
+    return s + n;
+}
+
+// 初值里的名字还是外层的变量
+int initializer(int x) {
+    int y = x + 1;
+    {
+        int x = y * 2;
+        int y = x + 3;
+        x = x + y;
+        if (x > 0) {
+            int x = 100;
+            y = y + x;
+        }
+        return x * 1000 + y;
+    }
+}
+
+// switch 体与其中的块各是一层作用域
+int in_switch(int k) {
+    int t = k;
+    switch (k) {
+        case 1: {
+            int t = 50;
+            return t + k;
+        }
+        case 2:
+            t = t * 7;
+            break;
+        default: {
+            int k = 9;
+            t = t + k;
+        }
+    }
+    return t;
+}
+
+// 循环里重复进入的块：每次都从初值重新开始
+int loops(int n) {
+    int x = 3;
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        int x = i;
+        while (x > 0) {
+            int x2 = x;
+            x = x - 2;
+            s = s + x2;
+        }
+        s = s + x;
+    }
+    return s * 100 + x;
+}
+
+int main(int argc) {
+    int failures = 0;
+    int x = argc;
+    int s = 0;
+    if (x) {
+        int x = 5;
+        s = s + x;
+    }
+    s = s + x;
+    if (s != 6) failures = failures + 1;
+    if (shadow_param(argc + 6) != 67) failures = failures + 1;
+    if (initializer(argc + 1) != 15109) failures = failures + 1;
+    if (in_switch(argc) != 51 || in_switch(argc + 1) != 14 || in_switch(argc + 4) != 14) failures = failures + 1;
+    if (loops(argc + 6) != 3103) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,16 @@
+// 单独编译：与 separate_other.c 各自 -c 后链接。本文件里调用 scale 都传常量 3，
+// 但另一个目标文件还以别的实参调用它，签名不能改；helper 从 main 不可达，也不能删
+int scale(int x, int k) {
+    if (k > 2) return x * k + 1;
+    return x - k;
+}
+
+int helper(int x) {
+    return x * 7;
+}
+
+int main(int argc) {
+    int failures = 0;
+    if (scale(argc, 3) != 4 || scale(argc + 1, 3) != 7) failures = failures + 1;
+    return failures + check_other(argc);
+}
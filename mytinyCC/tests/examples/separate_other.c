@@ -0,0 +1,8 @@
+// 单独编译的另一半：调用 separate.c 里的 scale 与 helper
+int check_other(int x) {
+    int failures = 0;
+    if (scale(x, 5) != 6) failures = failures + 1;
+    if (scale(x + 1, 1) != 1) failures = failures + 1;
+    if (helper(x + 2) != 21) failures = failures + 1;
+    return failures;
+}
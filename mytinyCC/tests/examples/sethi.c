@@ -0,0 +1,28 @@
+// 深表达式树：右子树更重时先算右边，临时值放在寄存器里，避免压栈
+int id(int x) {
+    return x;
+}
+
+int deep(int a, int b, int c, int d) {
+    return a - (b * (c - (d * (a - (b + c * d)))));
+}
+
+int mixed(int a, int b, int c, int d) {
+    return (a + b) * (c - d) - (a - b) / (c + d + 1) + ((a ^ c) << (b & 3)) - ((d | a) >> 1) % (b + 7);
+}
+
+int with_calls(int a, int b) {
+    return a * (b + id(a - b)) - id(b) * (a + id(a)) + (id(3) << id(2));
+}
+
+int main(int argc) {
+    int one = argc;
+    int failures = 0;
+    if (deep(3 * one, 5 * one, 7 * one, 2 * one) != -192) failures = failures + 1;
+    if (deep(-4 * one, 9 * one, one, 6 * one) != -1039) failures = failures + 1;
+    if (mixed(13 * one, 6 * one, 20 * one, 4 * one) != 398) failures = failures + 1;
+    if (mixed(-9 * one, 2 * one, 5 * one, 11 * one) != -13) failures = failures + 1;
+    if (with_calls(7 * one, 3 * one) != 19) failures = failures + 1;
+    if (with_calls(-5 * one, 8 * one) != 117) failures = failures + 1;
+    return failures;
+}
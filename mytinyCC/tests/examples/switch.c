@@ -0,0 +1,153 @@
+// switch：稠密的 case 用跳转表，稀疏的用二分比较树；贯穿、default、负数 case 与循环里的状态机
+
+// 稠密：0..7 中有 6 个 case，缺的值和越界的值走 default
+int dense(int x) {
+    int r = 0;
+    switch (x) {
+        case 0:
+            r = 10;
+            break;
+        case 1:
+            r = 11;
+            break;
+        case 2:
+            r = 12;
+            break;
+        case 4:
+            r = 14;
+            break;
+        case 6:
+            return 16;
+        case 7:
+            r = 17;
+            break;
+        default:
+            r = -1;
+            break;
+    }
+    return r;
+}
+
+// 稠密但从负数开始，没有 default
+int negative_range(int x) {
+    int r = 100;
+    switch (x) {
+        case -3: r = 1; break;
+        case -2: r = 2; break;
+        case -1: r = 3; break;
+        case 0: r = 4; break;
+        case 1: r = 5; break;
+    }
+    return r;
+}
+
+// 稀疏：值域很大，用比较树
+int sparse(int x) {
+    switch (x) {
+        case -100000: return 1;
+        case -7: return 2;
+        case 3: return 3;
+        case 50: return 4;
+        case 999: return 5;
+        case 4096: return 6;
+        case 70000: return 7;
+        case 2147483647: return 8;
+        default: return 0;
+    }
+    return -1;
+}
+
+// 没有 break 的 case 落到下一个；default 不在最后
+int fallthrough(int x) {
+    int r = 0;
+    switch (x) {
+        case 1:
+            r = r + 1;
+        case 2:
+            r = r + 10;
+        default:
+            r = r + 100;
+        case 3:
+            r = r + 1000;
+            break;
+        case 4:
+            r = 7;
+    }
+    return r;
+}
+
+// 状态机：识别 a(b|c)*d，返回最终状态
+int recognize(int n, int seed) {
+    int state = 0;
+    int i = 0;
+    int ch = seed;
+    while (i < n) {
+        ch = (ch * 7 + 3) % 5;
+        switch (state) {
+            case 0:
+                if (ch == 0) state = 1;
+                else state = 4;
+                break;
+            case 1:
+                switch (ch) {
+                    case 1:
+                    case 2:
+                        break;
+                    case 3:
+                        state = 2;
+                        break;
+                    default:
+                        state = 4;
+                }
+                break;
+            case 2:
+                state = 3;
+                break;
+            case 3:
+                state = 0;
+                break;
+            case 4:
+                if (ch == 4) state = 0;
+                break;
+        }
+        i = i + 1;
+    }
+    return state * 1000 + ch;
+}
+
+// 只有 default，以及空的 switch
+int degenerate(int x) {
+    int r = 5;
+    switch (x) {
+        default:
+            r = r + x;
+    }
+    switch (x + 1) {
+    }
+    return r;
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    int sum = 0;
+    int i;
+    for (i = -2; i < 10; i = i + 1) {
+        sum = sum * 3 + dense(i);
+    }
+    if (sum != 62222) failures = failures + 1;
+    for (i = -5; i < 3; i = i + 1) {
+        sum = sum + negative_range(i) * (i + 7);
+    }
+    if (sum != 63722) failures = failures + 1;
+    if (sparse(-100000 * one) != 1 || sparse(-7 * one) != 2 || sparse(3 * one) != 3 || sparse(50 * one) != 4) failures = failures + 1;
+    if (sparse(999 * one) != 5 || sparse(4096 * one) != 6 || sparse(70000 * one) != 7 || sparse(2147483647 * one) != 8) failures = failures + 1;
+    if (sparse(zero) != 0 || sparse(4 * one) != 0 || sparse(-2147483647 * one) != 0) failures = failures + 1;
+    if (fallthrough(one) != 1111 || fallthrough(2 * one) != 1110 || fallthrough(3 * one) != 1000) failures = failures + 1;
+    if (fallthrough(4 * one) != 7 || fallthrough(9 * one) != 1100) failures = failures + 1;
+    if (recognize(37 * one, 2 * one) != 4002 || recognize(100 * one, 4 * one) != 4) failures = failures + 1;
+    if (recognize(50 * one, one) != 2003) failures = failures + 1;
+    if (degenerate(4 * one) != 9) failures = failures + 1;
+    return failures;
+}
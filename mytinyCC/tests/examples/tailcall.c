@@ -0,0 +1,46 @@
+// 自递归尾调用变成跳转：递归深度一百万也不会耗尽栈
+int sum_to(int n, int acc) {
+    if (n == 0) return acc;
+    return sum_to(n - 1, acc + n);
+}
+
+int gcd(int a, int b) {
+    if (b == 0) return a;
+    return gcd(b, a % b);
+}
+
+// 累加器变换：return n * fact(n - 1) / return n + count(n - 1)
+int fact(int n) {
+    if (n < 2) return 1;
+    return n * fact(n - 1);
+}
+
+int count(int n) {
+    if (n == 0) return 0;
+    return 1 + count(n - 1);
+}
+
+// 超过 6 个参数：后面的参数在栈上，同样原地写回
+int rotate(int a, int b, int c, int d, int e, int f, int g, int n) {
+    if (n == 0) return a * 1000000 + b * 100000 + c * 10000 + d * 1000 + e * 100 + f * 10 + g;
+    return rotate(b, c, d, e, f, g, a, n - 1);
+}
+
+// 非尾递归保持原样
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    if (sum_to(1000000 * one, zero) != 1784293664) failures = failures + 1;
+    if (gcd(1071 * one, 462 * one) != 21) failures = failures + 1;
+    if (fact(10 * one) != 3628800) failures = failures + 1;
+    if (count(1000000 * one) != 1000000) failures = failures + 1;
+    if (rotate(one, 2 * one, 3 * one, 4 * one, 5 * one, 6 * one, 7 * one, 10 * one) != 4567123) failures = failures + 1;
+    if (fib(20 * one) != 6765) failures = failures + 1;
+    return failures;
+}
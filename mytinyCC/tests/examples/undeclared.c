@@ -0,0 +1,4 @@
+// 未声明的变量：代码生成报错，不输出结果
+int main(int argc) {
+    return argc + missing;
+}
@@ -0,0 +1,75 @@
+// 循环展开：常量次数的小循环完全展开，变量边界的计数循环按倍数展开并带余数循环
+int small_constant(int base) {
+    int s = base;
+    for (int i = 0; i < 5; i = i + 1) {
+        s = s * 3 + i;
+    }
+    return s;
+}
+
+// 剩余迭代数从 0 到展开倍数以上都要覆盖
+int sum_to(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s + i;
+    }
+    return s;
+}
+
+// 步长不为 1、<= 边界、边界写在左边
+int strided(int lo, int hi) {
+    int s = 0;
+    for (int i = lo; i <= hi; i = i + 3) {
+        s = s ^ (i + 1);
+    }
+    for (int j = hi; lo < j; j = j - 2) {
+        s = s + j;
+    }
+    return s;
+}
+
+// 边界贴近 INT_MAX：主循环的入口检查不能溢出
+int near_max(int start) {
+    int count = 0;
+    for (int i = start; i < 2147483647; i = i + 1) {
+        count = count + 1;
+    }
+    return count;
+}
+
+// 循环体中途 return
+int find_first(int n, int k) {
+    for (int i = 1; i < n; i = i + 1) {
+        if (i * i > k) return i;
+    }
+    return -1;
+}
+
+// 循环体内改写了归纳变量：不是计数循环，照原样生成
+int irregular(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        if (s > 20) i = i + 2;
+        s = s + i;
+    }
+    return s;
+}
+
+int main(int argc) {
+    int one = argc;
+    int zero = argc - 1;
+    int failures = 0;
+    if (small_constant(zero) != 58) failures = failures + 1;
+    for (int n = 0; n < 12; n = n + 1) {
+        if (sum_to(n) != n * (n - 1) / 2) failures = failures + 1;
+    }
+    if (strided(-4 * one, 20 * one) != 97) failures = failures + 1;
+    if (strided(7 * one, 7 * one) != 8) failures = failures + 1;
+    if (strided(9 * one, 3 * one) != 0) failures = failures + 1;
+    if (near_max(2147483640 * one) != 7) failures = failures + 1;
+    if (near_max(2147483647 * one) != 0) failures = failures + 1;
+    if (find_first(100 * one, 50 * one) != 8) failures = failures + 1;
+    if (find_first(5 * one, 50 * one) != -1) failures = failures + 1;
+    if (irregular(30 * one) != 177) failures = failures + 1;
+    return failures;
+}
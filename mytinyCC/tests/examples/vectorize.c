@@ -0,0 +1,101 @@
+// 数组与循环向量化：-fno-tree-vectorize 的结果一致。
+// 元素个数由 argc 算出，剩余迭代数 0~3 都要覆盖；数组内容用标量循环填成不规则的值。
+int ga[64];
+int gb[64];
+int gc[64];
+
+// 全局数组的校验和：按位置加权，元素错位也能发现
+int checksum(int n) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        s = s * 31 + gc[i];
+    }
+    return s;
+}
+
+void fill(int n, int seed) {
+    for (int i = 0; i < n; i = i + 1) {
+        ga[i] = (i * i + seed) % 23 - 11;
+        gb[i] = (i * seed) % 17 + 65536 * (i % 3);
+        gc[i] = 0;
+    }
+}
+
+// 六种运算与复合赋值，循环不变的变量和常量广播到每个元素
+int elementwise(int n, int k) {
+    int s = 0;
+    for (int i = 0; i < n; i = i + 1) gc[i] = ga[i] + gb[i];
+    s = s ^ checksum(n);
+    for (int i = 0; i < n; i = i + 1) gc[i] = ga[i] - gb[i] * k;
+    s = s ^ checksum(n);
+    for (int i = 0; i < n; i = i + 1) {
+        gc[i] = (ga[i] & gb[i]) | (ga[i] ^ 1234567);
+        gb[i] = gb[i] * gb[i] * 7 + k;
+    }
+    for (int i = 0; i < n; i += 1) {
+        gc[i] += ga[i];
+        ga[i] -= gb[i] * 3;
+    }
+    return s ^ checksum(n) ^ gb[n / 2] ^ ga[n / 3];
+}
+
+// 局部数组，<= 边界，多条语句；a[i + 1] 在被写之前读到的是旧值
+int local_arrays(int n) {
+    int a[40];
+    int b[40];
+    int s = 0;
+    for (int i = 0; i < 40; i = i + 1) {
+        a[i] = i * 7 - 100;
+        b[i] = 0;
+    }
+    for (int i = 1; i <= n; i = i + 1) {
+        b[i] = a[i] * a[i] - a[i + 1];
+        a[i] = b[i] ^ 85;
+    }
+    for (int i = 0; i < 40; i = i + 1) {
+        s = s * 3 + a[i] + b[i];
+    }
+    return s;
+}
+
+// 同一数组的常量距离：a[i + 1] 读旧值可以向量化，a[i - 1] 读刚写的值（递推）不行，
+// 相距 4 个元素正好不重叠
+int dependences(int n) {
+    int a[48];
+    int s = 0;
+    for (int i = 0; i < 48; i = i + 1) a[i] = i;
+    for (int i = 0; i < n; i = i + 1) a[i] = a[i + 1] + 1;
+    for (int i = 0; i < 48; i = i + 1) s = s * 5 + a[i];
+    for (int i = 1; i < n; i = i + 1) a[i] = a[i - 1] + a[i];
+    for (int i = 0; i < 48; i = i + 1) s = s * 5 + a[i];
+    int m = n - 4;
+    for (int i = 0; i < m; i = i + 1) a[i + 4] = a[i] * 3;
+    for (int i = 0; i < 48; i = i + 1) s = s * 5 + a[i];
+    return s;
+}
+
+// 偏移量是变量：运行时检查距离，1~3 时走标量循环
+int shifted(int n, int d) {
+    fill(64, 5);
+    for (int i = 8; i < n; i = i + 1) gc[i + d] = gc[i] + ga[i - d];
+    for (int i = 8; i < n; i = i + 1) gb[i - d] = gb[i] * 2;
+    for (int i = 0; i < 64; i = i + 1) gc[i] = gc[i] + gb[i];
+    return checksum(64);
+}
+
+int main(int argc) {
+    int failures = 0;
+    int sizes = 0;
+    for (int n = argc - 1; n <= argc + 37; n = n + 1) {
+        fill(n, argc + 2);
+        sizes = sizes * 7 + elementwise(n, argc + 2);
+    }
+    if (sizes != 995917731) failures = failures + 1;
+    if (local_arrays(argc + 20) != -1878394364 || local_arrays(argc + 37) != 1390914757) failures = failures + 1;
+    if (local_arrays(argc - 1) != -1078165652) failures = failures + 1;
+    if (dependences(argc + 44) != -1145380108 || dependences(argc + 2) != 1428212144) failures = failures + 1;
+    if (shifted(argc + 40, 0) != -1484876058) failures = failures + 1;
+    if (shifted(argc + 40, 1) != -1619013560 || shifted(argc + 40, 3) != -1840337521) failures = failures + 1;
+    if (shifted(argc + 40, 4) != 910831237 || shifted(argc + 40, -2) != 249022889) failures = failures + 1;
+    return failures;
+}
@@ -0,0 +1,151 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "codegen.h"
+#include "ir.h"
+#include "optimize.h"
+#include "x86.h"
+#include "jit.h"
+
+// 除以常量的强度削减：对每个除数生成 x / d 和 x % d 两个函数，经完整的优化流水线
+// 编译并 JIT 装载，再与 C 的 / 和 %（运行时除数，走 idiv）逐一比对。
+//   test_divmagic               多个除数，边界附近和伪随机的输入
+//   test_divmagic --exhaustive  覆盖各条代码路径的除数，全部 2^32 个输入
+
+typedef int (*IntFn)(int);
+
+// 覆盖每条路径：魔数与除数异号需修正（7、-7）、无移位（3、-3）、2 的幂（8、-2）
+static const int exhaustive_divisors[] = { 7, -7, 3, -3, 8, -2 };
+
+static const int special_divisors[] = {
+    641, 1000, 6700417, 1 << 30, -(1 << 30), 3 << 28, 0x55555555, -0x55555555,
+    INT_MAX, INT_MAX - 1, -INT_MAX, 1000000007, 125, 625, 99991,
+};
+
+static int failures = 0;
+
+static void check(IntFn q, IntFn r, int d, int x) {
+    volatile int divisor = d;
+    if (x == INT_MIN && d == -1) return;  // 溢出，C 中未定义
+    int want_q = x / divisor;
+    int want_r = x % divisor;
+    int got_q = q(x);
+    int got_r = r(x);
+    if (got_q != want_q || got_r != want_r) {
+        if (failures < 20) {
+            fprintf(stderr, "x=%d d=%d: got %d, %d; expected %d, %d\n", x, d, got_q, got_r, want_q, want_r);
+        }
+        failures++;
+    }
+}
+
+static void check_range(IntFn q, IntFn r, int d, int64_t lo, int64_t hi) {
+    for (int64_t x = lo; x <= hi; x++) check(q, r, d, (int)x);
+}
+
+static void check_sampled(IntFn q, IntFn r, int d) {
+    check_range(q, r, d, -70000, 70000);
+    check_range(q, r, d, INT_MIN, (int64_t)INT_MIN + 70000);
+    check_range(q, r, d, (int64_t)INT_MAX - 70000, INT_MAX);
+    // 商变化的边界：d 的倍数两侧
+    int64_t ad = llabs(d);
+    int64_t step = ad * (INT_MAX / 1001 / ad + 1);
+    for (int64_t k = -1000; k <= 1000; k++) {
+        int64_t m = k * step;
+        if (m - 1 >= INT_MIN && m + 1 <= INT_MAX) check_range(q, r, d, m - 1, m + 1);
+    }
+    uint32_t seed = 12345u + (uint32_t)d;
+    for (int i = 0; i < 200000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        check(q, r, d, (int)seed);
+    }
+}
+
+// 把源码编译进内存并装载
+static JitModule* compile(const char* source) {
+    Parser* parser = parser_init(source);
+    ASTNode* ast = parse_program(parser);
+    if (parser->error_count > 0) {
+        fprintf(stderr, "parse failed\n");
+        return NULL;
+    }
+    fold_constants(ast);
+    sccp_optimize_program(ast, 0);
+    fold_constants(ast);
+
+    CodeGenerator* codegen = codegen_init(NULL);
+    codegen->optimize = 1;
+    codegen->program = asm_list_create();
+    generate_assembly(codegen, ast);
+
+    ObjectFile obj;
+    char error[256];
+    JitModule* module = NULL;
+    if (!x86_assemble(codegen->program, &obj, error, sizeof(error))) {
+        fprintf(stderr, "Assembler error: %s\n", error);
+    } else {
+        module = jit_load(&obj, error, sizeof(error));
+        if (!module) fprintf(stderr, "JIT error: %s\n", error);
+        obj_free(&obj);
+    }
+    codegen_free(codegen);
+    parser_free(parser);
+    return module;
+}
+
+int main(int argc, char* argv[]) {
+    int exhaustive = argc > 1 && strcmp(argv[1], "--exhaustive") == 0;
+    int divisors[512];
+    int count = 0;
+    if (exhaustive) {
+        for (size_t i = 0; i < sizeof(exhaustive_divisors) / sizeof(exhaustive_divisors[0]); i++) {
+            divisors[count++] = exhaustive_divisors[i];
+        }
+    } else {
+        for (int d = 1; d <= 200; d++) {
+            divisors[count++] = d;
+            divisors[count++] = -d;
+        }
+        for (size_t i = 0; i < sizeof(special_divisors) / sizeof(special_divisors[0]); i++) {
+            divisors[count++] = special_divisors[i];
+        }
+    }
+
+    size_t size = (size_t)count * 128 + 1;
+    char* source = malloc(size);
+    size_t len = 0;
+    source[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        len += snprintf(source + len, size - len,
+                        "int q%d(int x) { return x / %d; }\nint r%d(int x) { return x %% %d; }\n",
+                        i, divisors[i], i, divisors[i]);
+    }
+    JitModule* module = compile(source);
+    free(source);
+    if (!module) return 1;
+
+    for (int i = 0; i < count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "q%d", i);
+        IntFn q = (IntFn)jit_lookup(module, name);
+        snprintf(name, sizeof(name), "r%d", i);
+        IntFn r = (IntFn)jit_lookup(module, name);
+        if (!q || !r) {
+            fprintf(stderr, "missing function for divisor %d\n", divisors[i]);
+            failures++;
+            continue;
+        }
+        if (exhaustive) {
+            check_range(q, r, divisors[i], INT_MIN, INT_MAX);
+        } else {
+            check_sampled(q, r, divisors[i]);
+        }
+    }
+    jit_free(module);
+
+    printf("%d divisors checked, %d mismatches\n", count, failures);
+    return failures ? 1 : 0;
+}
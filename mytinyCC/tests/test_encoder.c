@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "x86.h"
+
+// 用内置汇编器把 .s 文件汇编成 .o，供 check_encoder.sh 与 GNU as 的结果比对
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.s> <output.o>\n", argv[0]);
+        return 2;
+    }
+    FILE* in = fopen(argv[1], "r");
+    if (!in) {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+    AsmList* list = asm_list_create();
+    char line[512];
+    while (fgets(line, sizeof(line), in)) {
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        asm_list_append_line(list, line);
+    }
+    fclose(in);
+
+    ObjectFile obj;
+    char error[256];
+    if (!x86_assemble(list, &obj, error, sizeof(error))) {
+        fprintf(stderr, "Assembler error: %s\n", error);
+        asm_list_free(list);
+        return 1;
+    }
+    FILE* out = fopen(argv[2], "wb");
+    int ok = out && elf_write_object(&obj, out);
+    if (out) fclose(out);
+    obj_free(&obj);
+    asm_list_free(list);
+    return ok ? 0 : 1;
+}